@@ -204,9 +204,10 @@ typedef struct ArrangerSelectionsAction
   Position pos;
 
   /** Used when splitting - these are the split
-   * ArrangerObject's. */
-  ArrangerObject * r1[800];
-  ArrangerObject * r2[800];
+   * ArrangerObject's (arrays of @ref num_split_objs
+   * objects). */
+  ArrangerObject ** r1;
+  ArrangerObject ** r2;
 
   /** Number of split objects inside r1 and r2
    * each. */
@@ -234,11 +235,12 @@ typedef struct ArrangerSelectionsAction
   AudioSelections *        audio_sel;
   AudioSelections *        audio_sel_after;
 
-  /* arranger objects that can be split */
-  ZRegion *  region_r1[800];
-  ZRegion *  region_r2[800];
-  MidiNote * mn_r1[800];
-  MidiNote * mn_r2[800];
+  /* arranger objects that can be split (arrays of
+   * num_split_objs objects) */
+  ZRegion **  region_r1;
+  ZRegion **  region_r2;
+  MidiNote ** mn_r1;
+  MidiNote ** mn_r2;
 
   /** Used for automation autofill action. */
   ZRegion * region_before;
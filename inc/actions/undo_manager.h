@@ -11,6 +11,7 @@
 #define __UNDO_UNDO_MANAGER_H__
 
 #include "actions/undo_stack.h"
+#include "project/autosave_journal.h"
 
 #include "zix/sem.h"
 
@@ -80,6 +81,20 @@ int undo_manager_perform (
   UndoableAction * action,
   GError **        error);
 
+/**
+ * Re-applies an action recorded in the autosave
+ * journal, updating the stacks the same way as when it
+ * was recorded.
+ *
+ * @return Non-zero if error.
+ */
+NONNULL_ARGS (1, 2)
+int undo_manager_replay (
+  UndoManager *     self,
+  UndoableAction *  action,
+  AutosaveJournalOp op,
+  GError **         error);
+
 /**
  * Second and last argument given must be a
  * GError **.
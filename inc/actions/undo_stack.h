@@ -31,16 +31,66 @@ typedef struct AudioClip AudioClip;
  * @{
  */
 
+/**
+ * An action moved out of memory by an UndoStack.
+ */
+typedef struct UndoStackSpilledAction
+{
+  /** Position of the compressed action in the spill
+   * file. */
+  gint64 offset;
+
+  /** Size of the compressed action. */
+  size_t size;
+
+  /** Pool IDs of the clips the action refers to (see
+   * undo_stack_contains_clip()). */
+  GArray * clip_pool_ids;
+} UndoStackSpilledAction;
+
 /**
  * Serializable stack for undoable actions.
  *
  * This is used for both undo and redo.
+ *
+ * Besides the maximum number of actions, the stack may
+ * have a memory budget. When the actions on the stack use
+ * more memory than that, the oldest ones are compressed
+ * and moved to a temporary file, and are moved back one
+ * at a time when the stack becomes empty. Spilled actions
+ * are not saved with the project.
  */
 typedef struct UndoStack
 {
   /** Actual stack used at runtime. */
   Stack * stack;
 
+  /**
+   * Approximate memory used by the actions in
+   * @ref stack (see undoable_action_get_size()).
+   */
+  size_t mem_used;
+
+  /**
+   * Memory the actions in @ref stack may use before the
+   * oldest ones are spilled, or 0 for no limit.
+   */
+  size_t mem_budget;
+
+  /**
+   * Actions spilled from the bottom of @ref stack, oldest
+   * first (UndoStackSpilledAction).
+   */
+  GArray * spilled;
+
+  /** Temporary file with the spilled actions, or NULL if
+   * not created yet. */
+  char * spill_path;
+
+  /** Bytes in the spill file no longer used by any
+   * spilled action. */
+  size_t spill_dead_size;
+
   /* the following are for serialization purposes only */
 
   ArrangerSelectionsAction ** as_actions;
@@ -117,8 +167,6 @@ undo_stack_get_total_cached_actions (UndoStack * self);
 
 #define undo_stack_is_empty(x) (stack_is_empty ((x)->stack))
 
-#define undo_stack_is_full(x) (stack_is_full ((x)->stack))
-
 #define undo_stack_peek(x) ((UndoableAction *) stack_peek ((x)->stack))
 
 #define undo_stack_peek_last(x) \
@@ -138,6 +186,31 @@ undo_stack_pop_last (UndoStack * self);
 
 /* --- end wrappers --- */
 
+/**
+ * Returns whether the stack has the maximum number of
+ * actions, including spilled ones.
+ */
+NONNULL bool
+undo_stack_is_full (UndoStack * self);
+
+/**
+ * Frees the oldest action, which is either spilled or at
+ * the bottom of the stack.
+ */
+NONNULL void
+undo_stack_remove_oldest (UndoStack * self);
+
+/**
+ * Calculates the memory used by the actions on the stack
+ * and spills the oldest ones if over budget.
+ *
+ * To be called after loading a project (the sizes of
+ * the actions are otherwise calculated when they are
+ * pushed).
+ */
+NONNULL void
+undo_stack_update_mem_used (UndoStack * self);
+
 bool
 undo_stack_contains_clip (UndoStack * self, AudioClip * clip);
 
@@ -110,6 +110,14 @@ typedef struct UndoableAction
    * To be set on the last action being performed.
    */
   int num_actions;
+
+  /**
+   * Approximate memory used by the action, set when it
+   * is pushed to an UndoStack with a memory budget.
+   *
+   * @see undoable_action_get_size().
+   */
+  size_t size;
 } UndoableAction;
 
 NONNULL void
@@ -192,6 +200,44 @@ int undoable_action_do (UndoableAction * self, GError ** error);
 NONNULL_ARGS (1)
 int undoable_action_undo (UndoableAction * self, GError ** error);
 
+/**
+ * Serializes the action into a JSON string.
+ *
+ * @param[out] len Length of the string.
+ *
+ * @return The string, to be free'd with free(), or NULL
+ *   if the action could not be serialized.
+ */
+NONNULL_ARGS (1, 2)
+char * undoable_action_serialize_to_json_str (
+  const UndoableAction * self,
+  size_t *               len,
+  GError **              error);
+
+/**
+ * Creates an action from a string returned by
+ * undoable_action_serialize_to_json_str().
+ *
+ * The action is initialized with
+ * undoable_action_init_loaded().
+ */
+NONNULL_ARGS (1)
+UndoableAction * undoable_action_new_from_json_str (
+  const char * str,
+  size_t       len,
+  GError **    error);
+
+/**
+ * Returns the approximate memory used by the action.
+ *
+ * This is the size of the serialized action, which
+ * contains everything the action keeps a copy of (eg,
+ * cloned objects), so it is only meant for comparing
+ * actions and budgeting.
+ */
+NONNULL size_t
+undoable_action_get_size (const UndoableAction * self);
+
 void
 undoable_action_free (UndoableAction * self);
 
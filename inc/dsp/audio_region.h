@@ -98,10 +98,30 @@ audio_region_update_channel_caches (
 /**
  * Returns the audio clip associated with the
  * Region.
+ *
+ * The frames of streamed clips are not loaded, so @ref
+ * AudioClip.frames may be NULL (see @ref
+ * AudioClip.stream). The clip metadata (number of
+ * frames, channels, etc.) is always available.
+ *
+ * @see audio_region_load_clip().
  */
 AudioClip *
 audio_region_get_clip (const ZRegion * self);
 
+/**
+ * Returns the audio clip associated with the Region
+ * with its frames loaded in memory.
+ *
+ * Streamed clips stop being streamed, so this should
+ * only be used by operations that edit or read the
+ * frames (not from the processing threads).
+ *
+ * @return The clip, or NULL if loading failed.
+ */
+AudioClip *
+audio_region_load_clip (const ZRegion * self, GError ** error);
+
 /**
  * Sets the clip ID on the region and updates any
  * references.
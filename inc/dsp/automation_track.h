@@ -52,6 +52,69 @@ typedef enum AutomationRecordMode
   NUM_AUTOMATION_RECORD_MODES,
 } AutomationRecordMode;
 
+/**
+ * Curve between an automation point and the next one,
+ * cached for playback.
+ */
+typedef struct AutomationSegment
+{
+  /** Region-local position of the automation point. */
+  signed_frame_t start_frames;
+
+  /** Region-local position of the next automation
+   * point. */
+  signed_frame_t end_frames;
+
+  /** Normalized value at the start. */
+  float start_val;
+
+  /** Normalized value at the end. */
+  float end_val;
+
+  /** Whether there is a next automation point (otherwise
+   * the start value is held). */
+  bool has_next;
+
+  CurveOptions curve_opts;
+} AutomationSegment;
+
+/**
+ * Segments of all the region snapshots of an automation
+ * track, so that values can be read during playback
+ * without searching for automation points.
+ */
+typedef struct AutomationSegmentCache
+{
+  /** Segments of each region, sorted by position. */
+  AutomationSegment * segments;
+  int                 num_segments;
+
+  /** Index of the first segment of each region snapshot
+   * (with an extra element at the end). */
+  int * region_offsets;
+
+  /** Index of the last segment used. */
+  int cursor;
+} AutomationSegmentCache;
+
+/**
+ * Regions of an automation track read by the engine during
+ * playback.
+ *
+ * Like TrackPlaybackSnapshot, published snapshots are
+ * never modified, except for the cursor of the segment
+ * cache which only the engine uses.
+ */
+typedef struct AutomationPlaybackSnapshot
+{
+  /** Region snapshots. */
+  ZRegion ** regions;
+  int        num_regions;
+
+  /** Segments of the region snapshots. */
+  AutomationSegmentCache * segment_cache;
+} AutomationPlaybackSnapshot;
+
 typedef struct AutomationTrack
 {
   /** Index in parent AutomationTracklist. */
@@ -68,9 +131,22 @@ typedef struct AutomationTrack
   int        num_regions;
   size_t     regions_size;
 
-  /** Snapshots used during playback TODO unimplemented. */
-  ZRegion ** region_snapshots;
-  int        num_region_snapshots;
+  /**
+   * Index of the region positions in ticks, used by the
+   * arranger for hit-testing.
+   *
+   * Built on demand and cleared when the regions change
+   * (see arranger_object_get_index()).
+   */
+  IntervalIndex * arranger_index;
+
+  /**
+   * Snapshot used during playback.
+   *
+   * Must be read with
+   * automation_track_get_playback_snapshot().
+   */
+  AutomationPlaybackSnapshot * playback_snapshot;
 
   /**
    * Whether visible or not.
@@ -372,6 +448,28 @@ automation_track_get_val_at_pos (
   bool              ends_after,
   bool              use_snapshots);
 
+/**
+ * Reads the normalized automation values at @p num_vals
+ * positions, @p step frames apart, starting at
+ * @p g_start_frames, from the segment cache of the region
+ * snapshots.
+ *
+ * Positions without automation are set to a negative
+ * value.
+ *
+ * @param ends_after See automation_track_get_val_at_pos().
+ *
+ * @return Whether any value was read.
+ */
+HOT NONNULL bool
+automation_track_get_normalized_vals_from_snapshots (
+  AutomationTrack * self,
+  signed_frame_t    g_start_frames,
+  nframes_t         step,
+  size_t            num_vals,
+  bool              ends_after,
+  float *           vals);
+
 /**
  * Returns the y pixels from the value based on the
  * allocation of the automation track.
@@ -397,6 +495,33 @@ automation_track_get_last_region (AutomationTrack * self);
 NONNULL void
 automation_track_set_caches (AutomationTrack * self, CacheTypes types);
 
+/**
+ * Takes a new snapshot of the regions read by the engine
+ * during playback and swaps it in, if any of them changed.
+ *
+ * See track_update_playback_snapshot().
+ *
+ * @param touched_ids Set of RegionIdentifier's of the
+ *   regions that changed, or NULL to take a new snapshot of
+ *   all the regions.
+ */
+void
+automation_track_update_playback_snapshot (
+  AutomationTrack * self,
+  GHashTable *      touched_ids);
+
+/**
+ * Returns the current playback snapshot.
+ *
+ * See track_get_playback_snapshot().
+ */
+static inline AutomationPlaybackSnapshot *
+automation_track_get_playback_snapshot (const AutomationTrack * self)
+{
+  return (AutomationPlaybackSnapshot *) g_atomic_pointer_get (
+    (AutomationPlaybackSnapshot **) &self->playback_snapshot);
+}
+
 NONNULL bool
 automation_track_contains_automation (const AutomationTrack * self);
 
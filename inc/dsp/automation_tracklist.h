@@ -62,6 +62,9 @@ typedef struct AutomationTracklist
   AutomationTrack ** ats_in_record_mode;
   int                num_ats_in_record_mode;
 
+  /** Allocated size of @ref ats_in_record_mode. */
+  size_t ats_in_record_mode_size;
+
   /**
    * Cache of visible automation tracks.
    */
@@ -276,6 +279,17 @@ automation_tracklist_print_regions (AutomationTracklist * self);
 NONNULL void
 automation_tracklist_set_caches (AutomationTracklist * self, CacheTypes types);
 
+/**
+ * Sets the caches of the automation tracks added since
+ * the caches were last set, while the engine may be
+ * processing the tracklist.
+ *
+ * The record mode cache is grown by publishing a copy,
+ * so the engine can keep reading the previous one.
+ */
+NONNULL void
+automation_tracklist_set_caches_of_new_ats (AutomationTracklist * self);
+
 NONNULL void
 automation_tracklist_free_members (AutomationTracklist * self);
 
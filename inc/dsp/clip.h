@@ -16,6 +16,10 @@
 #include "utils/types.h"
 #include "utils/yaml.h"
 
+typedef struct AudioClipStream   AudioClipStream;
+typedef struct AudioClipPeaks    AudioClipPeaks;
+typedef struct AudioClipPeaksJob AudioClipPeaksJob;
+
 /**
  * @addtogroup dsp
  *
@@ -42,6 +46,14 @@ typedef struct AudioClip
   /** Number of frames per channel. */
   unsigned_frame_t num_frames;
 
+  /**
+   * Number of frames per channel allocated in
+   * @ref AudioClip.frames and @ref AudioClip.ch_frames,
+   * if more than @ref AudioClip.num_frames (used while
+   * recording).
+   */
+  unsigned_frame_t frames_capacity;
+
   /**
    * Per-channel frames for convenience.
    */
@@ -95,6 +107,36 @@ typedef struct AudioClip
    * @see AudioClip.frames_written.
    */
   gint64 last_write;
+
+  /**
+   * Disk stream, if the clip is streamed from its file
+   * in the pool instead of being held in memory.
+   *
+   * @ref AudioClip.frames and @ref AudioClip.ch_frames
+   * are not loaded in this case until
+   * audio_clip_load_frames() is called.
+   */
+  AudioClipStream * stream;
+
+  /**
+   * Cache file the frames are mapped from, if loaded
+   * from the cache (see clip_cache.h).
+   *
+   * @ref AudioClip.frames and @ref AudioClip.ch_frames
+   * point into the (private) mapping in this case.
+   */
+  GMappedFile * mapped_file;
+
+  /**
+   * Peaks for drawing, or NULL if not generated yet (see
+   * clip_peaks.h).
+   *
+   * Set atomically by the job generating them.
+   */
+  AudioClipPeaks * peaks;
+
+  /** Job generating @ref AudioClip.peaks, if any. */
+  AudioClipPeaksJob * peaks_job;
 } AudioClip;
 
 static const cyaml_schema_field_t audio_clip_fields_schema[] = {
@@ -130,6 +172,31 @@ audio_clip_use_flac (BitDepth bd)
 COLD NONNULL bool
 audio_clip_init_loaded (AudioClip * self, GError ** error);
 
+/**
+ * Loads the frames of a streamed clip in memory and stops
+ * streaming it.
+ *
+ * Does nothing if the clip is not streamed.
+ */
+NONNULL bool
+audio_clip_load_frames (AudioClip * self, GError ** error);
+
+/**
+ * Frees the frames of the clip (and stops streaming it,
+ * if streamed).
+ */
+NONNULL void
+audio_clip_unload_frames (AudioClip * self);
+
+/**
+ * Stops generating the peaks of the clip and frees them.
+ *
+ * To be called before the frames of the clip are
+ * changed.
+ */
+NONNULL void
+audio_clip_discard_peaks (AudioClip * self);
+
 /**
  * Creates an audio clip from a file.
  *
@@ -156,8 +223,9 @@ audio_clip_new_from_float_array (
 /**
  * Create an audio clip while recording.
  *
- * The frames will keep getting reallocated until
- * the recording is finished.
+ * The frames will keep getting set with
+ * audio_clip_set_recorded_frames() until the
+ * recording is finished.
  *
  * @param nframes Number of frames to allocate. This
  *   should be the current cycle's frames when
@@ -169,6 +237,23 @@ audio_clip_new_recording (
   const unsigned_frame_t nframes,
   const char *           name);
 
+/**
+ * Sets the frames of a clip being recorded starting at
+ * @p start, growing the clip if needed.
+ *
+ * The clip's memory grows geometrically, so recording a
+ * long take does not reallocate the whole clip on each
+ * cycle.
+ *
+ * @param ch_bufs Per-channel frames.
+ */
+NONNULL void
+audio_clip_set_recorded_frames (
+  AudioClip *           self,
+  unsigned_frame_t      start,
+  const float * const * ch_bufs,
+  size_t                nframes);
+
 /**
  * Updates the channel caches.
  *
@@ -0,0 +1,115 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+/**
+ * \file
+ *
+ * On-disk cache of decoded pool clips.
+ *
+ * Decoding and resampling the files in the pool is slow,
+ * so after a clip is loaded its frames (already at the
+ * project's sample rate) are written to the project's
+ * cache directory, and subsequent loads memory-map them
+ * from there instead of decoding the file again.
+ *
+ * A cache file consists of an AudioClipCacheHeader
+ * followed by the interleaved frames and then the frames
+ * of each channel, each block aligned to
+ * AUDIO_CLIP_CACHE_ALIGNMENT bytes.
+ */
+
+#ifndef __AUDIO_CLIP_CACHE_H__
+#define __AUDIO_CLIP_CACHE_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "utils/types.h"
+
+#include <glib.h>
+
+typedef struct AudioClip AudioClip;
+
+/**
+ * @addtogroup dsp
+ *
+ * @{
+ */
+
+#define AUDIO_CLIP_CACHE_MAGIC "ZRCLPCAC"
+#define AUDIO_CLIP_CACHE_VERSION 1
+#define AUDIO_CLIP_CACHE_EXT "zcc"
+
+/** Alignment of the frame blocks in the file. */
+#define AUDIO_CLIP_CACHE_ALIGNMENT 64
+
+/**
+ * Header of a cache file.
+ */
+typedef struct AudioClipCacheHeader
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t channels;
+  uint64_t num_frames;
+  uint32_t samplerate;
+  uint32_t padding;
+
+  /** Size of the pool file the frames were decoded
+   * from. */
+  uint64_t src_size;
+
+  /** Modification time of the pool file, in seconds
+   * since the epoch. */
+  int64_t src_mtime;
+
+  uint8_t reserved[16];
+} AudioClipCacheHeader;
+
+/**
+ * Returns the path of the cache file for the clip with
+ * the given file hash at the given sample rate, or NULL
+ * if there is no project.
+ */
+NONNULL char *
+audio_clip_cache_get_path (const char * file_hash, int samplerate);
+
+/**
+ * Maps the cached frames of the clip, if a valid cache
+ * file exists for its file hash and sample rate.
+ *
+ * On success, @ref AudioClip.frames and
+ * @ref AudioClip.ch_frames point into the mapping (any
+ * previous frames are freed).
+ *
+ * @param src_path Path of the clip's file in the pool.
+ *
+ * @return Whether the clip was loaded from the cache.
+ */
+NONNULL bool
+audio_clip_cache_load (AudioClip * self, const char * src_path);
+
+/**
+ * Writes the clip's frames to the cache.
+ *
+ * @param src_path Path of the clip's file in the pool.
+ */
+NONNULL bool
+audio_clip_cache_store (
+  AudioClip *  self,
+  const char * src_path,
+  GError **    error);
+
+/**
+ * Removes cache files not in @p used_paths.
+ *
+ * @param used_paths Set of cache file paths to keep.
+ */
+NONNULL void
+audio_clip_cache_remove_unused (GHashTable * used_paths);
+
+/**
+ * @}
+ */
+
+#endif
@@ -0,0 +1,316 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+/**
+ * \file
+ *
+ * Multi-resolution peaks of audio clips.
+ *
+ * Drawing a waveform zoomed out needs the minimum and
+ * maximum of thousands of frames per pixel, so the
+ * peaks of each pool clip are precomputed at
+ * power-of-two decimations (a pyramid where each level
+ * has half the peaks of the previous one). The
+ * renderer picks the level closest to the number of
+ * frames per pixel and only looks at a peak or two per
+ * pixel.
+ *
+ * The peaks are generated in the background when a clip
+ * is added to the pool (streamed clips are read from
+ * their file in chunks) and are stored in the project's
+ * pool cache next to the decoded clips (see
+ * clip_cache.h), keyed by the clip's file hash and
+ * sample rate.
+ *
+ * A peaks file consists of an AudioClipPeaksHeader
+ * followed by the peaks of each level, each level
+ * holding the peaks of each channel one after another.
+ */
+
+#ifndef __AUDIO_CLIP_PEAKS_H__
+#define __AUDIO_CLIP_PEAKS_H__
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "utils/types.h"
+
+#include <glib.h>
+
+typedef struct AudioClip AudioClip;
+
+/**
+ * @addtogroup dsp
+ *
+ * @{
+ */
+
+#define AUDIO_CLIP_PEAKS_MAGIC "ZRCLPPKS"
+#define AUDIO_CLIP_PEAKS_VERSION 1
+#define AUDIO_CLIP_PEAKS_EXT "zpk"
+
+/** Frames per peak in the finest level (power of 2). */
+#define AUDIO_CLIP_PEAKS_BASE_FRAMES 256
+
+/** Frames processed at once when generating the peaks
+ * (a multiple of AUDIO_CLIP_PEAKS_BASE_FRAMES). */
+#define AUDIO_CLIP_PEAKS_CHUNK_FRAMES (1 << 16)
+
+/** Maximum number of levels. */
+#define AUDIO_CLIP_PEAKS_MAX_LEVELS 48
+
+/**
+ * Peak of a range of frames in one channel.
+ */
+typedef struct AudioClipPeak
+{
+  float min;
+  float max;
+  float rms;
+} AudioClipPeak;
+
+/**
+ * A level of the pyramid.
+ */
+typedef struct AudioClipPeaksLevel
+{
+  /** Frames covered by each peak (the last peak may
+   * cover less). */
+  unsigned_frame_t frames_per_peak;
+
+  /** Number of peaks per channel. */
+  size_t num_peaks;
+
+  /** Per-channel peaks. */
+  AudioClipPeak * ch_peaks[16];
+} AudioClipPeaksLevel;
+
+/**
+ * Peak pyramid of a clip.
+ */
+typedef struct AudioClipPeaks
+{
+  channels_t       channels;
+  unsigned_frame_t num_frames;
+
+  /** Levels from the finest to the coarsest (which has
+   * a single peak). */
+  AudioClipPeaksLevel levels[AUDIO_CLIP_PEAKS_MAX_LEVELS];
+  int                 num_levels;
+
+  /** All the peaks, either owned or pointing into
+   * @ref mapped_file. */
+  AudioClipPeak * data;
+
+  /** Peaks file the peaks are mapped from, if loaded
+   * from the cache. */
+  GMappedFile * mapped_file;
+} AudioClipPeaks;
+
+/**
+ * Header of a peaks file.
+ */
+typedef struct AudioClipPeaksHeader
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t channels;
+  uint64_t num_frames;
+  uint32_t base_frames;
+  uint32_t num_levels;
+  uint8_t  reserved[16];
+} AudioClipPeaksHeader;
+
+typedef enum AudioClipPeaksJobState
+{
+  AUDIO_CLIP_PEAKS_JOB_PENDING,
+  AUDIO_CLIP_PEAKS_JOB_RUNNING,
+  AUDIO_CLIP_PEAKS_JOB_CANCELLED,
+  AUDIO_CLIP_PEAKS_JOB_DONE,
+} AudioClipPeaksJobState;
+
+/**
+ * Background generation of the peaks of a clip.
+ *
+ * The job publishes the peaks to @ref AudioClip.peaks
+ * when done. The frames of the clip must not change
+ * while the job is running (see
+ * audio_clip_peaks_job_cancel() and
+ * audio_clip_peaks_job_lock_frames()).
+ *
+ * Jobs are reference-counted (see g_atomic_rc_box_new0())
+ * since both the clip and the thread pool hold them.
+ */
+typedef struct AudioClipPeaksJob
+{
+  AudioClip * clip;
+
+  /** File to read the frames from in chunks, for
+   * streamed clips, or NULL to use the clip's frames. */
+  char * filepath;
+
+  channels_t       channels;
+  unsigned_frame_t num_frames;
+
+  /** File hash and sample rate of the clip, used to
+   * find the peaks in the cache. */
+  char * file_hash;
+  int    samplerate;
+
+  /** An AudioClipPeaksJobState. */
+  volatile gint state;
+
+  /** Set to stop a running job early. */
+  volatile gint cancel;
+
+  /**
+   * Held while reading a chunk of the clip's frames.
+   *
+   * @see audio_clip_peaks_job_lock_frames().
+   */
+  GMutex frames_lock;
+
+  GMutex lock;
+  GCond  cond;
+} AudioClipPeaksJob;
+
+/**
+ * Returns the path of the peaks file for the clip with
+ * the given file hash at the given sample rate, or NULL
+ * if there is no project.
+ */
+NONNULL char *
+audio_clip_peaks_get_path (const char * file_hash, int samplerate);
+
+/**
+ * Creates an empty pyramid for the given number of
+ * frames.
+ */
+AudioClipPeaks *
+audio_clip_peaks_new (channels_t channels, unsigned_frame_t num_frames);
+
+/**
+ * Computes the finest level for the given frames.
+ *
+ * @param ch_frames Per-channel frames, starting at
+ *   @p start.
+ * @param start First frame, a multiple of
+ *   AUDIO_CLIP_PEAKS_BASE_FRAMES.
+ * @param nframes Number of frames, a multiple of
+ *   AUDIO_CLIP_PEAKS_BASE_FRAMES unless this is the end
+ *   of the clip.
+ */
+NONNULL void
+audio_clip_peaks_add_frames (
+  AudioClipPeaks *      self,
+  const float * const * ch_frames,
+  unsigned_frame_t      start,
+  size_t                nframes);
+
+/**
+ * Computes the other levels from the finest one.
+ *
+ * To be called after all the frames were added.
+ */
+NONNULL void
+audio_clip_peaks_finish (AudioClipPeaks * self);
+
+/**
+ * Returns the coarsest level with at most
+ * @p frames_per_pixel frames per peak, or NULL if
+ * @p frames_per_pixel is smaller than
+ * AUDIO_CLIP_PEAKS_BASE_FRAMES (the frames should be
+ * used directly in this case).
+ */
+NONNULL const AudioClipPeaksLevel *
+audio_clip_peaks_get_level (
+  const AudioClipPeaks * self,
+  double                 frames_per_pixel);
+
+/**
+ * Gets the minimum and maximum of the peaks in the given
+ * level covering [start, start + nframes).
+ */
+NONNULL void
+audio_clip_peaks_get_min_max (
+  const AudioClipPeaksLevel * level,
+  channels_t                  ch,
+  unsigned_frame_t            start,
+  unsigned_frame_t            nframes,
+  float *                     min,
+  float *                     max);
+
+/**
+ * Maps the peaks of the clip with the given file hash,
+ * if a valid peaks file exists.
+ *
+ * @return The peaks, or NULL if not found.
+ */
+NONNULL AudioClipPeaks *
+audio_clip_peaks_load (
+  const char *     file_hash,
+  int              samplerate,
+  channels_t       channels,
+  unsigned_frame_t num_frames);
+
+/**
+ * Writes the peaks to the cache.
+ */
+NONNULL_ARGS (1, 2)
+bool audio_clip_peaks_store (
+  const AudioClipPeaks * self,
+  const char *           file_hash,
+  int                    samplerate,
+  GError **              error);
+
+NONNULL void
+audio_clip_peaks_free (AudioClipPeaks * self);
+
+/**
+ * Creates a job for generating the peaks of the clip.
+ *
+ * Must be called from the GTK thread.
+ */
+NONNULL AudioClipPeaksJob *
+audio_clip_peaks_job_new (AudioClip * clip);
+
+/**
+ * Loads the peaks from the cache or generates them, and
+ * publishes them to the clip.
+ *
+ * To be called from a worker thread.
+ */
+NONNULL void
+audio_clip_peaks_job_run (AudioClipPeaksJob * self);
+
+/**
+ * Stops the job, waiting for it to finish if it already
+ * started.
+ *
+ * Must be called from the GTK thread.
+ */
+NONNULL void
+audio_clip_peaks_job_cancel (AudioClipPeaksJob * self);
+
+/**
+ * Keeps the job from reading the frames of the clip
+ * until audio_clip_peaks_job_unlock_frames() is called.
+ *
+ * To be used when the frames are moved around without
+ * changing them (otherwise the job should be
+ * cancelled).
+ */
+NONNULL void
+audio_clip_peaks_job_lock_frames (AudioClipPeaksJob * self);
+
+NONNULL void
+audio_clip_peaks_job_unlock_frames (AudioClipPeaksJob * self);
+
+NONNULL void
+audio_clip_peaks_job_unref (AudioClipPeaksJob * self);
+
+/**
+ * @}
+ */
+
+#endif
@@ -0,0 +1,333 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+/**
+ * \file
+ *
+ * Disk streaming for audio clips.
+ *
+ * A streamed clip is not held in memory. Instead, a
+ * background thread (see AudioClipStreamer) keeps
+ * read-ahead ring buffers filled from the clip's file,
+ * following the positions the engine reads from, and
+ * keeps a small pre-roll cache at positions playback is
+ * likely to jump to (region starts, loop starts and the
+ * playhead).
+ */
+
+#ifndef __AUDIO_CLIP_STREAM_H__
+#define __AUDIO_CLIP_STREAM_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "utils/types.h"
+
+#include <glib.h>
+
+typedef struct AudioFile         AudioFile;
+typedef struct AudioClipStreamer AudioClipStreamer;
+
+/**
+ * @addtogroup dsp
+ *
+ * @{
+ */
+
+/** Frames held by each ring buffer (power of 2). */
+#define AUDIO_CLIP_STREAM_RING_FRAMES (1 << 17)
+
+/** Frames read from the file at once. */
+#define AUDIO_CLIP_STREAM_CHUNK_FRAMES (1 << 13)
+
+/** Frames kept in the ring buffer behind the read
+ * position. */
+#define AUDIO_CLIP_STREAM_LOOKBEHIND_FRAMES (1 << 13)
+
+/** Frames cached at each pre-roll position. */
+#define AUDIO_CLIP_STREAM_PREROLL_FRAMES (1 << 15)
+
+/**
+ * Number of read-ahead buffers per clip.
+ *
+ * This is the number of positions in the same clip that
+ * can be played at the same time (eg, by regions in
+ * different tracks sharing the clip).
+ */
+#define AUDIO_CLIP_STREAM_NUM_CURSORS 2
+
+/** Clips shorter than this are always loaded in
+ * memory. */
+#define AUDIO_CLIP_STREAM_MIN_SECONDS 30
+
+/**
+ * Frames cached at a position in the clip.
+ */
+typedef struct AudioClipStreamPreroll
+{
+  /** First frame in the clip. */
+  unsigned_frame_t start;
+
+  /** Number of frames cached. */
+  unsigned_frame_t num_frames;
+
+  /** Per-channel frames. */
+  float ** ch_frames;
+} AudioClipStreamPreroll;
+
+/**
+ * An immutable set of pre-rolls, replaced as a whole
+ * when the positions change.
+ */
+typedef struct AudioClipStreamPrerollSet
+{
+  /** Pre-rolls sorted by start position. */
+  AudioClipStreamPreroll * prerolls;
+  int                      num_prerolls;
+
+  /** Engine cycle at which this set was replaced. */
+  uint64_t retire_cycle;
+} AudioClipStreamPrerollSet;
+
+/**
+ * A read-ahead ring buffer following one reader.
+ *
+ * The ring buffer holds the clip frames in
+ * [window_start, window_end). It is written only by the
+ * disk thread and read by the engine, which validates
+ * after copying that the frames were not overwritten in
+ * the meantime (see @ref seq).
+ */
+typedef struct AudioClipStreamCursor
+{
+  /** Reader following this cursor, or 0 if free. */
+  _Atomic uint64_t owner;
+
+  /** Last engine cycle the owner read in. */
+  _Atomic uint64_t last_cycle;
+
+  /**
+   * Position the owner is expected to read from next,
+   * or -1.
+   */
+  _Atomic int64_t play_pos;
+
+  /**
+   * Incremented before and after the window is moved
+   * to a new position, so it is odd while moving.
+   */
+  _Atomic uint64_t seq;
+
+  /** First clip frame in the ring buffer. */
+  _Atomic int64_t window_start;
+
+  /** One past the last clip frame in the ring
+   * buffer. */
+  _Atomic int64_t window_end;
+
+  /** Per-channel ring buffers. */
+  float ** ring;
+} AudioClipStreamCursor;
+
+/**
+ * Disk stream of an audio clip.
+ */
+typedef struct AudioClipStream
+{
+  /** Path of the file streamed. */
+  char * filepath;
+
+  /** The open file (only used by the disk thread). */
+  AudioFile * af;
+
+  channels_t       channels;
+  unsigned_frame_t num_frames;
+
+  AudioClipStreamCursor cursors[AUDIO_CLIP_STREAM_NUM_CURSORS];
+
+  /** Current pre-roll set. */
+  AudioClipStreamPrerollSet * _Atomic prerolls;
+
+  /**
+   * Pre-roll sets replaced but possibly still being
+   * read by the engine (only used by the disk thread).
+   */
+  GPtrArray * retired_prerolls;
+
+  /** Pre-roll positions requested by
+   * audio_clip_stream_set_anchors(). */
+  GArray * anchors;
+
+  /** Whether @ref anchors changed since the pre-rolls
+   * were last generated. */
+  bool anchors_changed;
+
+  /** Lock for @ref anchors. */
+  GMutex anchors_lock;
+
+  /** Interleaved buffer for reading from the file. */
+  float * read_buf;
+
+  /** Number of reads that could not be served. */
+  volatile gint num_misses;
+
+  /** Streamer this stream is registered to, if any. */
+  AudioClipStreamer * streamer;
+
+  /** Engine cycle at which this stream was retired by
+   * audio_clip_streamer_retire_stream(). */
+  uint64_t retire_cycle;
+} AudioClipStream;
+
+/**
+ * Background thread servicing streams.
+ */
+typedef struct AudioClipStreamer
+{
+  GThread * thread;
+
+  /** Registered streams. */
+  GPtrArray * streams;
+
+  /** Streams waiting to be freed. */
+  GPtrArray * retired_streams;
+
+  /** Lock for the stream arrays. */
+  GMutex lock;
+
+  /** Used to wake up the thread. */
+  GCond cond;
+
+  /**
+   * Stream being read from by the thread (without
+   * holding @ref lock), if any.
+   *
+   * Removing a stream waits until it is no longer
+   * being processed.
+   */
+  AudioClipStream * processing_stream;
+
+  /** Signaled when @ref processing_stream is done. */
+  GCond processing_done_cond;
+
+  /** Engine cycle counter. */
+  const uint_fast64_t * cycle;
+
+  volatile gint run;
+} AudioClipStreamer;
+
+/**
+ * Opens a stream for the given file.
+ */
+NONNULL_ARGS (1)
+AudioClipStream * audio_clip_stream_new (const char * filepath, GError ** error);
+
+/**
+ * Sets the positions to keep pre-rolls at.
+ *
+ * The pre-rolls are read by the disk thread, so reads at
+ * these positions may still miss right after this call.
+ *
+ * This must not be called from the realtime thread.
+ */
+NONNULL void
+audio_clip_stream_set_anchors (
+  AudioClipStream *        self,
+  const unsigned_frame_t * anchors,
+  int                      num_anchors);
+
+/**
+ * Reads frames into the given stereo buffers (mono clips
+ * are copied to both channels).
+ *
+ * The ring buffer of @p reader is moved to follow the
+ * position read, so that subsequent reads are served
+ * once the disk thread catches up.
+ *
+ * @param reader Non-zero ID of the reader (eg, the lane
+ *   playing the clip).
+ * @param cycle Current engine cycle.
+ *
+ * @return Whether the frames were available. If not, the
+ *   buffers are filled with silence.
+ */
+REALTIME
+HOT NONNULL bool
+audio_clip_stream_read (
+  AudioClipStream * self,
+  uint64_t          reader,
+  uint64_t          cycle,
+  unsigned_frame_t  start,
+  size_t            nframes,
+  float *           lbuf,
+  float *           rbuf);
+
+/**
+ * Reads from the file whatever the readers need.
+ *
+ * This is called periodically by the streamer thread.
+ *
+ * @param cycle Current engine cycle, used to decide when
+ *   replaced pre-rolls can be freed.
+ */
+NONNULL void
+audio_clip_stream_process (AudioClipStream * self, uint64_t cycle);
+
+/**
+ * Frees the stream, removing it from its streamer
+ * first.
+ */
+NONNULL void
+audio_clip_stream_free (AudioClipStream * self);
+
+/**
+ * Creates a streamer and starts its thread.
+ *
+ * @param cycle Pointer to the engine cycle counter.
+ */
+NONNULL AudioClipStreamer *
+audio_clip_streamer_new (const uint_fast64_t * cycle);
+
+NONNULL void
+audio_clip_streamer_add_stream (
+  AudioClipStreamer * self,
+  AudioClipStream *   stream);
+
+/**
+ * Removes the stream from the streamer without freeing
+ * it.
+ */
+NONNULL void
+audio_clip_streamer_remove_stream (
+  AudioClipStreamer * self,
+  AudioClipStream *   stream);
+
+/**
+ * Removes the stream from the streamer and frees it once
+ * the engine cannot be reading from it anymore.
+ */
+NONNULL void
+audio_clip_streamer_retire_stream (
+  AudioClipStreamer * self,
+  AudioClipStream *   stream);
+
+/**
+ * Wakes up the streamer thread.
+ */
+NONNULL void
+audio_clip_streamer_wake_up (AudioClipStreamer * self);
+
+/**
+ * Stops the thread and frees the streamer.
+ *
+ * Streams still registered are detached, not freed.
+ */
+NONNULL void
+audio_clip_streamer_free (AudioClipStreamer * self);
+
+/**
+ * @}
+ */
+
+#endif
@@ -202,6 +202,47 @@ engine_sample_rate_to_string (AudioEngineSamplerate sample_rate)
   return sample_rate_str[sample_rate];
 }
 
+/**
+ * Resolution at which automation is read during
+ * playback.
+ */
+typedef enum AudioEngineAutomationResolution
+{
+  /** Once at the start of each cycle. */
+  AUDIO_ENGINE_AUTOMATION_RESOLUTION_CYCLE,
+
+  /** Every 16 frames, interpolated in between. */
+  AUDIO_ENGINE_AUTOMATION_RESOLUTION_16_FRAMES,
+
+  /** Every frame. */
+  AUDIO_ENGINE_AUTOMATION_RESOLUTION_SAMPLE,
+} AudioEngineAutomationResolution;
+
+static const char * automation_resolution_str[] = {
+  N_ ("Once per cycle"),
+  N_ ("Every 16 samples"),
+  N_ ("Sample-accurate"),
+};
+
+/**
+ * Returns the number of frames between automation reads,
+ * or 0 if automation is read once per cycle.
+ */
+static inline nframes_t
+engine_automation_resolution_get_step (
+  AudioEngineAutomationResolution resolution)
+{
+  switch (resolution)
+    {
+    case AUDIO_ENGINE_AUTOMATION_RESOLUTION_16_FRAMES:
+      return 16;
+    case AUDIO_ENGINE_AUTOMATION_RESOLUTION_SAMPLE:
+      return 1;
+    default:
+      return 0;
+    }
+}
+
 typedef enum AudioBackend
 {
   AUDIO_BACKEND_DUMMY,
@@ -521,6 +562,18 @@ typedef struct AudioEngine
   /** 1 if currently exporting. */
   gint exporting;
 
+  /**
+   * Whether the export is rendered offline (see
+   * ExportSettings.offline_block_length).
+   *
+   * Meters, ring buffers read by the UI and MIDI activity
+   * are not updated while this is set.
+   */
+  bool rendering_offline;
+
+  /** Block length to restore after rendering offline. */
+  nframes_t block_length_before_offline;
+
   /** Send note off MIDI everywhere. */
   volatile gint panic;
 
@@ -636,6 +689,9 @@ typedef struct AudioEngine
   /** Pan algorithm */
   PanAlgorithm pan_algo;
 
+  /** Resolution at which automation is read. */
+  AudioEngineAutomationResolution automation_resolution;
+
   /** Time taken to process in the last cycle */
   gint64 last_time_taken;
 
@@ -762,6 +818,15 @@ typedef struct AudioEngine
   /** Whether the cycle is currently running. */
   volatile gint cycle_running;
 
+  /**
+   * Objects that the engine might still be reading, to be
+   * freed once it is done with them (see
+   * engine_retire_object()).
+   *
+   * Only accessed from the GUI thread.
+   */
+  GPtrArray * retired_objects;
+
   /** Whether the engine is already pre-set up. */
   bool pre_setup;
 
@@ -802,6 +867,13 @@ typedef struct AudioEngine
 void
 engine_realloc_port_buffers (AudioEngine * self, nframes_t buf_size);
 
+/**
+ * Inits after loading a project.
+ *
+ * This does not initialize the audio pool, which must be
+ * initialized with audio_pool_init_loaded() after
+ * engine_pre_setup() (since the sample rate may change).
+ */
 COLD NONNULL_ARGS (1) bool engine_init_loaded (
   AudioEngine * self,
   Project *     project,
@@ -849,6 +921,34 @@ engine_resume (AudioEngine * self, EngineState * state);
 void
 engine_wait_n_cycles (AudioEngine * self, int n);
 
+/**
+ * Frees @p obj with @p free_func once the engine is done
+ * reading it.
+ *
+ * To be called from the GUI thread after replacing the
+ * pointer the engine reads @p obj from, so that cycles
+ * starting afterwards cannot see @p obj anymore.
+ *
+ * @param self The engine that might be reading @p obj, or
+ *   NULL to free @p obj immediately.
+ */
+void
+engine_retire_object (
+  AudioEngine *  self,
+  void *         obj,
+  GDestroyNotify free_func);
+
+/**
+ * Frees the retired objects that the engine is done with.
+ *
+ * This is called periodically from the GUI thread.
+ *
+ * @param force Free all retired objects (only when the
+ *   engine is not processing).
+ */
+NONNULL void
+engine_free_retired_objects (AudioEngine * self, bool force);
+
 void
 engine_append_ports (AudioEngine * self, GPtrArray * ports);
 
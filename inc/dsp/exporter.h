@@ -11,6 +11,7 @@
 
 typedef struct EngineState  EngineState;
 typedef struct ProgressInfo ProgressInfo;
+typedef struct Track        Track;
 
 /**
  * @addtogroup dsp
@@ -18,6 +19,16 @@ typedef struct ProgressInfo ProgressInfo;
  * @{
  */
 
+/**
+ * Default block length to render exports with
+ * offline.
+ *
+ * Can be overridden with the
+ * ZRYTHM_EXPORT_BLOCK_LENGTH environment variable, up
+ * to LV2_PLUGIN_MAX_BLOCK_LENGTH.
+ */
+#define EXPORT_OFFLINE_BLOCK_LENGTH 4096
+
 /**
  * Export format.
  */
@@ -135,6 +146,27 @@ bounce_step_to_str (BounceStep bounce_step)
   return bounce_step_str[bounce_step];
 }
 
+/**
+ * A track exported to its own file during a
+ * single-pass stem export.
+ *
+ * @see ExportSettings.stems.
+ */
+typedef struct ExportStem
+{
+  /** Track whose output is exported. */
+  Track * track;
+
+  /** Absolute path for the stem file. */
+  char * file_uri;
+} ExportStem;
+
+ExportStem *
+export_stem_new (Track * track, const char * file_uri);
+
+void
+export_stem_free (ExportStem * self);
+
 /**
  * Export settings to be passed to the exporter to use.
  */
@@ -191,6 +223,36 @@ typedef struct ExportSettings
    * for progress calculation. */
   int num_files;
 
+  /**
+   * Stems (ExportStem) to export during a single
+   * render of the time range, or NULL.
+   *
+   * If set, the output of each stem's track at
+   * @ref ExportSettings.bounce_step is written to the
+   * stem's file instead of writing the master output to
+   * @ref ExportSettings.file_uri, and
+   * @ref ExportSettings.mode must be
+   * @ref EXPORT_MODE_FULL.
+   */
+  GPtrArray * stems;
+
+  /**
+   * If non-zero, the export is rendered offline in
+   * blocks of this many frames instead of the engine's
+   * block length, as fast as possible and without
+   * updating meters and other UI feedback.
+   *
+   * Only valid when passed to
+   * exporter_prepare_tracks_for_export().
+   */
+  nframes_t offline_block_length;
+
+  /**
+   * Audio duration rendered per second of processing
+   * (set after exporting audio).
+   */
+  double realtime_factor;
+
   ProgressInfo * progress_info;
 } ExportSettings;
 
@@ -226,6 +288,16 @@ export_settings_print (const ExportSettings * self);
 void
 export_settings_free (ExportSettings * self);
 
+/**
+ * Returns the block length to render exports with
+ * offline.
+ *
+ * This never exceeds the maximum block length LV2
+ * plugins are instantiated with.
+ */
+nframes_t
+exporter_get_offline_block_length (void);
+
 /**
  * This must be called on the main thread after the
  * intended tracks have been marked for bounce and
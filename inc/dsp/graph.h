@@ -37,6 +37,7 @@
 #include "utils/types.h"
 
 #include "zix/sem.h"
+#include <glib/gi18n.h>
 #include <pthread.h>
 
 typedef struct GraphNode               GraphNode;
@@ -51,6 +52,7 @@ typedef struct Position                Position;
 typedef struct GraphThread             GraphThread;
 typedef struct Router                  Router;
 typedef struct ModulatorMacroProcessor ModulatorMacroProcessor;
+typedef struct PortConnection          PortConnection;
 
 /**
  * @addtogroup dsp
@@ -64,6 +66,67 @@ typedef struct ModulatorMacroProcessor ModulatorMacroProcessor;
 
 #define MAX_GRAPH_THREADS 128
 
+/**
+ * Strategy used to distribute ready nodes to the
+ * graph threads.
+ */
+typedef enum GraphScheduler
+{
+  /** All threads pull from a single MPMC queue. */
+  GRAPH_SCHEDULER_SHARED_QUEUE,
+
+  /**
+   * Each thread pushes the nodes it triggers to its
+   * own deque and idle threads steal from the other
+   * threads' deques.
+   */
+  GRAPH_SCHEDULER_WORK_STEALING,
+} GraphScheduler;
+
+static const char * graph_scheduler_str[] = {
+  N_ ("Shared queue"),
+  N_ ("Work stealing"),
+};
+
+/**
+ * Scheduling statistics for a single cycle.
+ */
+typedef struct GraphCycleStats
+{
+  /** Nodes stolen from another thread's deque. */
+  guint num_steals;
+
+  /** Times a thread ran out of work and slept. */
+  guint num_idle;
+
+  /** Nodes processed. */
+  guint num_processed;
+
+  /** Number of threads that processed at least one
+   * node. */
+  guint num_active_threads;
+} GraphCycleStats;
+
+/**
+ * Sources and destinations of a port computed by
+ * graph_setup().
+ *
+ * These are moved to the port when the setup nodes
+ * become the current graph, so that the port's arrays
+ * are never modified while the engine may be reading
+ * them.
+ */
+typedef struct GraphPortConnections
+{
+  Port *            port;
+  Port **           srcs;
+  PortConnection ** src_connections;
+  int               num_srcs;
+  Port **           dests;
+  PortConnection ** dest_connections;
+  int               num_dests;
+} GraphPortConnections;
+
 /**
  * Graph.
  */
@@ -137,9 +200,70 @@ typedef struct Graph
   GraphNode ** setup_terminal_nodes;
   size_t       num_setup_terminal_nodes;
 
+  /** Connections of each port added by
+   * graph_setup(), see GraphPortConnections. */
+  GArray * setup_port_connections;
+
+  /** External output ports for the setup nodes. */
+  GPtrArray * setup_external_out_ports;
+
+  GraphNode * setup_bpm_node;
+  GraphNode * setup_beats_per_bar_node;
+  GraphNode * setup_beat_unit_node;
+
+  /** Static schedule for the setup nodes. */
+  GraphNode ** setup_static_schedule;
+  size_t       n_setup_static_schedule;
+  int          n_setup_static_schedule_levels;
+
+  /**
+   * Whether the setup nodes have the same nodes and
+   * edges as the current ones, in which case the
+   * current nodes are kept when applying the setup.
+   *
+   * Set by graph_prepare_setup().
+   */
+  bool setup_matches_current;
+
   /** Dummy member to make lookups work. */
   int initial_processor;
 
+  /**
+   * Static schedule for the current graph.
+   *
+   * All nodes in topological order, grouped by level
+   * (longest distance from an initial node) and sorted
+   * by critical path length inside each level.
+   *
+   * Built by graph_rechain() and never modified
+   * afterwards, so it can be run without the atomic
+   * reference counting of dynamic triggering.
+   */
+  GraphNode ** static_schedule;
+  size_t       n_static_schedule;
+
+  /** Number of levels in the static schedule. */
+  int n_static_schedule_levels;
+
+  /**
+   * Max cycle size in frames to run the static
+   * schedule for, if there are worker threads.
+   *
+   * When there are no worker threads the static
+   * schedule is always used.
+   */
+  nframes_t static_schedule_max_nframes;
+
+  /**
+   * Whether the current cycle should run the static
+   * schedule instead of triggering the nodes
+   * dynamically.
+   *
+   * Set by router_start_cycle() before posting
+   * callback_start.
+   */
+  bool run_static_schedule;
+
   /* ------------------------------------ */
 
   GraphThread * threads[MAX_GRAPH_THREADS];
@@ -158,11 +282,39 @@ typedef struct Graph
   /** Sample processor, if temporary graph for sample processor. */
   SampleProcessor * sample_processor;
 
+  /** Scheduler used by the graph threads. */
+  GraphScheduler scheduler;
+
+  /**
+   * Scheduling statistics of the last completed
+   * cycle.
+   *
+   * Written by the thread that reaches the last
+   * terminal node, only meant for diagnostics.
+   */
+  GraphCycleStats last_cycle_stats;
+
+  /** Sum of the statistics of all cycles since the
+   * graph was started. */
+  GraphCycleStats total_cycle_stats;
+
+  /** Number of cycles in @ref total_cycle_stats. */
+  guint64 num_cycles;
+
 } Graph;
 
 void
 graph_print (Graph * graph);
 
+/**
+ * Logs the scheduling statistics collected since the
+ * graph was started.
+ *
+ * Called when the graph is terminated.
+ */
+void
+graph_print_cycle_stats (const Graph * self);
+
 void
 graph_destroy (Graph * graph);
 
@@ -248,6 +400,55 @@ graph_update_latencies (Graph * self, bool use_setup_nodes);
 void
 graph_setup (Graph * self, const int drop_unnecessary_ports, const int rechain);
 
+/**
+ * Adds the graph nodes and connections to the setup
+ * nodes while the engine may be processing the current
+ * ones.
+ *
+ * Unlike graph_setup(), this does not reallocate the
+ * buffers of ports already in use and only sets the
+ * caches of tracks and plugins not in the current
+ * graph.
+ *
+ * The setup must then be prepared with
+ * graph_prepare_setup() and applied with
+ * graph_apply_setup() at a cycle boundary.
+ */
+NONNULL void
+graph_setup_while_running (Graph * self);
+
+/**
+ * Prepares the setup nodes to become the current graph.
+ *
+ * This builds their static schedule and compares them
+ * with the current nodes.
+ *
+ * @return Whether the setup can be applied without
+ *   allocating (ie, the trigger queues are large
+ *   enough).
+ */
+NONNULL bool
+graph_prepare_setup (Graph * self);
+
+/**
+ * Makes the prepared setup nodes the current graph.
+ *
+ * This only swaps pointers, so it can be called from
+ * the engine between cycles. The previous nodes are
+ * moved to the setup side and must be freed with
+ * graph_finish_setup().
+ */
+REALTIME
+NONNULL void
+graph_apply_setup (Graph * self);
+
+/**
+ * Frees the nodes and port connections replaced by
+ * graph_apply_setup().
+ */
+NONNULL void
+graph_finish_setup (Graph * self);
+
 /**
  * Adds a new connection for the given
  * src and dest ports and validates the graph.
@@ -264,6 +465,35 @@ graph_setup (Graph * self, const int drop_unnecessary_ports, const int rechain);
 bool
 graph_validate_with_connection (Graph * self, const Port * src, const Port * dest);
 
+/**
+ * Returns whether the static schedule can be used for
+ * a cycle of @p nframes frames.
+ */
+HOT bool
+graph_can_use_static_schedule (const Graph * self, nframes_t nframes);
+
+/**
+ * Waits for the next cycle to start.
+ *
+ * Cycles that request the static schedule are run
+ * inline by the calling thread, without waking up the
+ * other threads.
+ *
+ * @return False if the graph is terminating.
+ */
+HOT bool
+graph_wait_for_next_dynamic_cycle (Graph * self);
+
+/**
+ * Returns the graph thread at the given index, where
+ * the main thread is the last one.
+ */
+static inline GraphThread *
+graph_get_thread_at (const Graph * self, int idx)
+{
+  return idx < self->num_threads ? self->threads[idx] : self->main_thread;
+}
+
 /**
  * Starts as many threads as there are cores.
  *
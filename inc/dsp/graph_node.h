@@ -162,6 +162,18 @@ typedef struct GraphNode
   nframes_t route_playback_latency;
 
   GraphNodeType type;
+
+  /* --- used when building the static schedule --- */
+
+  /** Longest distance from an initial node. */
+  int sched_level;
+
+  /** Longest distance to a terminal node
+   * (including this node). */
+  int sched_critical_path;
+
+  /** Remaining unvisited parents. */
+  int sched_pending;
 } GraphNode;
 
 /**
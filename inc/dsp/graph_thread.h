@@ -47,7 +47,9 @@
 #  include <lsp-plug.in/dsp/dsp.h>
 #endif
 
-typedef struct Graph Graph;
+typedef struct Graph             Graph;
+typedef struct GraphNode         GraphNode;
+typedef struct WorkStealingDeque WorkStealingDeque;
 
 /**
  * @addtogroup dsp
@@ -70,6 +72,27 @@ typedef struct GraphThread
   /** Pointer back to the graph. */
   Graph * graph;
 
+  /**
+   * Nodes triggered by this thread, when using
+   * GRAPH_SCHEDULER_WORK_STEALING.
+   *
+   * Only this thread pushes/pops, other threads
+   * steal from the top.
+   */
+  WorkStealingDeque * deque;
+
+  /* --- per-cycle counters --- */
+
+  /** Number of nodes stolen from other threads. */
+  guint num_steals;
+
+  /** Number of times the thread ran out of work and
+   * went to sleep. */
+  guint num_idle;
+
+  /** Number of nodes processed. */
+  guint num_processed;
+
 #ifdef HAVE_LSP_DSP
   /** LSP DSP context. */
   lsp_dsp_context_t lsp_ctx;
@@ -86,6 +109,26 @@ typedef struct GraphThread
 GraphThread *
 graph_thread_new (const int id, const bool is_main, Graph * graph);
 
+/**
+ * Returns the GraphThread running in the calling
+ * thread, or NULL if the calling thread is not a graph
+ * thread.
+ */
+HOT GraphThread *
+graph_thread_get_current (void);
+
+/**
+ * Pushes a node that became ready to be processed
+ * to the queue of the current thread (or to the
+ * shared queue if not using the work-stealing
+ * scheduler).
+ */
+HOT void
+graph_thread_push_node (Graph * graph, GraphNode * node);
+
+void
+graph_thread_free (GraphThread * self);
+
 /**
  * @}
  */
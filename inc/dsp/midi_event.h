@@ -38,6 +38,10 @@ typedef struct ChordDescriptor ChordDescriptor;
 /** Max events to hold in queues. */
 #define MAX_MIDI_EVENTS 2560
 
+/** Max events from other threads pending to be picked
+ * up by the engine (power of 2). */
+#define MAX_EXTERNAL_MIDI_EVENTS 256
+
 /**
  * Timed MIDI event.
  */
@@ -72,17 +76,37 @@ typedef struct MidiEvents
   MidiEvent events[MAX_MIDI_EVENTS];
 
   /**
-   * For queueing events from the GUI or from hardware,
-   * since they run in different threads.
+   * Events queued by the engine for the next
+   * midi_events_dequeue().
    *
    * Engine will copy them to the unqueued MIDI events when
    * ready to be processed.
+   *
+   * @note Only the engine may access these. Other threads
+   *   must use midi_events_add_external_event().
    */
   MidiEvent    queued_events[MAX_MIDI_EVENTS];
   volatile int num_queued_events;
 
-  /** Semaphore for exclusive read/write. */
-  ZixSem access_sem;
+  /**
+   * Events from other threads (eg, the GUI), moved to
+   * @ref MidiEvents.queued_events by the engine in
+   * midi_events_dequeue().
+   *
+   * This is a single-producer single-consumer ring
+   * buffer so that the engine never waits for the other
+   * threads. Writers are serialized with
+   * @ref MidiEvents.external_write_lock.
+   */
+  MidiEvent     external_events[MAX_EXTERNAL_MIDI_EVENTS];
+  volatile gint external_write_idx;
+  volatile gint external_read_idx;
+
+  /** Non-zero while a writer is writing to
+   * @ref MidiEvents.external_events. */
+  volatile gint external_writing;
+
+  GMutex external_write_lock;
 
 } MidiEvents;
 
@@ -357,10 +381,98 @@ midi_events_panic_without_lock (MidiEvents * self, bool queued);
 
 /**
  * Must only be called from the UI thread.
+ *
+ * @param queued Whether to send the note offs through
+ *   the engine (see midi_events_add_external_event())
+ *   instead of adding them to the main events.
  */
 NONNULL void
 midi_events_panic (MidiEvents * self, bool queued);
 
+/**
+ * Adds an event from a thread other than the engine's
+ * (eg, the GUI or a MIDI input thread).
+ *
+ * The engine picks up the event in the next
+ * midi_events_dequeue() without waiting for the caller.
+ *
+ * @return Whether the event was added (false if too many
+ *   events are already pending).
+ */
+NONNULL bool
+midi_events_add_external_event (
+  MidiEvents *        self,
+  const midi_byte_t * buf,
+  size_t              buf_size,
+  midi_time_t         time);
+
+/**
+ * Adds a note on from a thread other than the engine's.
+ *
+ * @param channel MIDI channel starting from 1.
+ *
+ * @see midi_events_add_external_event().
+ */
+NONNULL bool
+midi_events_add_external_note_on (
+  MidiEvents * self,
+  midi_byte_t  channel,
+  midi_byte_t  note_pitch,
+  midi_byte_t  velocity,
+  midi_time_t  time);
+
+/**
+ * Adds a note off from a thread other than the engine's.
+ *
+ * @param channel MIDI channel starting from 1.
+ *
+ * @see midi_events_add_external_event().
+ */
+NONNULL bool
+midi_events_add_external_note_off (
+  MidiEvents * self,
+  midi_byte_t  channel,
+  midi_byte_t  note_pitch,
+  midi_time_t  time);
+
+/**
+ * Adds a note on for each note in the chord from a
+ * thread other than the engine's.
+ *
+ * @return Whether all the notes were added.
+ */
+NONNULL bool
+midi_events_add_external_note_ons_from_chord_descr (
+  MidiEvents *            self,
+  const ChordDescriptor * descr,
+  midi_byte_t             channel,
+  midi_byte_t             velocity,
+  midi_time_t             time);
+
+/**
+ * Adds a note off for each note in the chord from a
+ * thread other than the engine's.
+ *
+ * @return Whether all the notes were added.
+ */
+NONNULL bool
+midi_events_add_external_note_offs_from_chord_descr (
+  MidiEvents *            self,
+  const ChordDescriptor * descr,
+  midi_byte_t             channel,
+  midi_time_t             time);
+
+/**
+ * Returns the number of times the engine found another
+ * thread in the middle of adding an external event while
+ * dequeueing.
+ *
+ * The engine used to block in these cases, so this helps
+ * attribute xruns.
+ */
+int
+midi_events_get_num_external_contentions (void);
+
 NONNULL void
 midi_events_write_to_midi_file (
   const MidiEvents * self,
@@ -385,9 +497,12 @@ void
 midi_events_clear_duplicates (MidiEvents * midi_events, const int queued);
 
 /**
- * Copies the queue contents to the original struct
+ * Copies the queue contents (including events from other
+ * threads) to the original struct.
+ *
+ * This never blocks.
  */
-void
+REALTIME void
 midi_events_dequeue (MidiEvents * midi_events);
 
 /**
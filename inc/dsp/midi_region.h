@@ -31,6 +31,50 @@ typedef void                   MIDI_FILE;
  * @{
  */
 
+/**
+ * Note start/end points of a MIDI or chord region, sorted by
+ * position, used to find the notes starting or ending inside a
+ * cycle without going through all of them.
+ *
+ * Only generated for playback snapshots.
+ */
+typedef struct MidiNoteTimeline
+{
+  /** Indices of the notes (or chord objects) sorted by
+   * start position. */
+  int * start_idxs;
+
+  /** Start positions (region-local frames) in the same
+   * order as \ref MidiNoteTimeline.start_idxs. */
+  signed_frame_t * start_frames;
+
+  /** Indices of the notes (or chord objects) sorted by
+   * end position. */
+  int * end_idxs;
+
+  /** End positions in the same order as
+   * \ref MidiNoteTimeline.end_idxs. */
+  signed_frame_t * end_frames;
+
+  int num_notes;
+
+  /** Index in \ref MidiNoteTimeline.start_idxs of the
+   * next note to start. */
+  int start_cursor;
+
+  /** Index in \ref MidiNoteTimeline.end_idxs of the next
+   * note to end. */
+  int end_cursor;
+
+  /**
+   * Region-local position the cursors are valid for.
+   *
+   * If the next cycle does not start here (eg, after a seek
+   * or a loop) the cursors are looked up again.
+   */
+  signed_frame_t cursor_pos;
+} MidiNoteTimeline;
+
 /**
  * Creates a new ZRegion for MIDI notes.
  */
@@ -125,6 +169,18 @@ midi_region_start_unended_note (
 MidiNote *
 midi_region_pop_unended_note (ZRegion * self, int pitch);
 
+/**
+ * Generates the note timeline of a region snapshot used during
+ * playback.
+ *
+ * Must be called again if the notes change.
+ */
+NONNULL void
+midi_region_gen_note_timeline (ZRegion * self);
+
+NONNULL void
+midi_note_timeline_free (MidiNoteTimeline * self);
+
 /**
  * Fills MIDI event queue from the region.
  *
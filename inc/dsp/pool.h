@@ -13,7 +13,9 @@
 #include "dsp/clip.h"
 #include "utils/yaml.h"
 
-typedef struct Track Track;
+typedef struct Track             Track;
+typedef struct AudioClipStreamer AudioClipStreamer;
+typedef struct ProgressInfo      ProgressInfo;
 
 /**
  * @addtogroup dsp
@@ -57,6 +59,20 @@ typedef struct AudioPool
 
   /** Array sizes. */
   size_t clips_size;
+
+  /**
+   * Disk thread for streamed clips, created when the
+   * first streamed clip is loaded.
+   */
+  AudioClipStreamer * streamer;
+
+  /**
+   * Worker threads generating clip peaks, created when
+   * the first peaks are requested.
+   *
+   * @see audio_pool_gen_clip_peaks().
+   */
+  GThreadPool * peaks_thread_pool;
 } AudioPool;
 
 static const cyaml_schema_field_t audio_pool_fields_schema[] = {
@@ -72,9 +88,17 @@ static const cyaml_schema_value_t audio_pool_schema = {
 
 /**
  * Inits after loading a project.
+ *
+ * The clips are decoded in parallel.
+ *
+ * @param progress_info Optional progress info to report
+ *   progress to and check for cancellation.
  */
 bool
-audio_pool_init_loaded (AudioPool * self, GError ** error);
+audio_pool_init_loaded (
+  AudioPool *    self,
+  ProgressInfo * progress_info,
+  GError **      error);
 
 /**
  * Creates a new audio pool.
@@ -108,6 +132,18 @@ audio_pool_duplicate_clip (
   bool        write_file,
   GError **   error);
 
+/**
+ * Starts generating the peaks of the clip in the
+ * background (or loading them from the cache), replacing
+ * any previous peaks.
+ *
+ * This is done automatically for clips added to the
+ * pool, and must be called again after the frames of a
+ * clip are changed.
+ */
+NONNULL void
+audio_pool_gen_clip_peaks (AudioPool * self, AudioClip * clip);
+
 /**
  * Returns the clip for the given ID.
  */
@@ -167,6 +203,17 @@ audio_pool_gen_name_for_recording_clip (AudioPool * pool, Track * track, int lan
 bool
 audio_pool_reload_clip_frame_bufs (AudioPool * self, GError ** error);
 
+/**
+ * Updates the positions at which streamed clips keep
+ * pre-rolls (the clip and loop start of each region using
+ * them and the position under the playhead).
+ *
+ * This should be called when regions change or the
+ * playhead is moved.
+ */
+NONNULL void
+audio_pool_update_stream_anchors (AudioPool * self);
+
 /**
  * Writes all the clips to disk.
  *
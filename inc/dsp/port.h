@@ -312,6 +312,29 @@ typedef struct Port
    * reading automation. */
   bool value_changed_from_reading;
 
+  /**
+   * Real values read from automation for each frame of
+   * the cycle, when the engine reads automation more
+   * often than once per cycle.
+   *
+   * Only allocated for ports whose owner can apply them
+   * (currently track faders).
+   *
+   * @see port_get_automation_vals().
+   */
+  float * automation_vals;
+
+  /** Values read at each automation step. */
+  float * automation_step_vals;
+
+  /** Engine cycle \ref Port.automation_vals was filled
+   * in. */
+  uint_fast64_t automation_vals_cycle;
+
+  /** Start frame (with offset) \ref Port.automation_vals
+   * was filled for. */
+  unsigned_frame_t automation_vals_g_start;
+
   /**
    * Last timestamp the control changed.
    *
@@ -634,6 +657,14 @@ port_new_with_type_and_owner (
 NONNULL void
 port_allocate_bufs (Port * self);
 
+/**
+ * Allocates the buffers used during DSP only if they
+ * are not allocated yet, so that buffers the engine may
+ * be using are left alone.
+ */
+NONNULL void
+port_allocate_missing_bufs (Port * self);
+
 /**
  * Frees buffers.
  *
@@ -950,6 +981,17 @@ port_apply_fader (
     }
 }
 
+/**
+ * Returns the per-frame values read from automation for the
+ * given (sub)cycle, starting at the cycle's local offset,
+ * or NULL if automation was not read more than once in this
+ * cycle.
+ */
+NONNULL HOT const float *
+port_get_automation_vals (
+  const Port *                        self,
+  const EngineProcessTimeInfo * const time_nfo);
+
 /**
  * First sets port buf to 0, then sums the given port signal from its inputs.
  *
@@ -0,0 +1,201 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+/**
+ * \file
+ *
+ * Background writing of recorded audio.
+ *
+ * While recording, the recorded frames of each take are
+ * collected in fixed-size chunks that are handed to a
+ * disk thread, which appends them to the take's file in
+ * the pool. The file is kept open for the whole take, so
+ * each chunk only costs a write of its own frames
+ * instead of a rewrite of the file.
+ */
+
+#ifndef __AUDIO_RECORDING_DISK_WRITER_H__
+#define __AUDIO_RECORDING_DISK_WRITER_H__
+
+#include <stdbool.h>
+
+#include "utils/audio.h"
+#include "utils/types.h"
+
+#include <glib.h>
+
+/**
+ * @addtogroup dsp
+ *
+ * @{
+ */
+
+/** Frames per chunk. */
+#define RECORDING_DISK_WRITER_CHUNK_FRAMES (1 << 14)
+
+/** Maximum number of channels of a take. */
+#define RECORDING_DISK_WRITER_MAX_CHANNELS 2
+
+/** Number of chunks allocated in advance. */
+#define RECORDING_DISK_WRITER_NUM_CHUNKS 16
+
+/**
+ * Maximum time partially filled chunks are kept before
+ * being written, so that the file is never too far
+ * behind the recording.
+ */
+#define RECORDING_DISK_WRITER_MAX_DELAY_USEC (2 * 1000 * 1000)
+
+typedef struct RecordingTake RecordingTake;
+
+/**
+ * Interleaved frames to be appended to a take's file.
+ */
+typedef struct RecordingChunk
+{
+  /** Take the frames belong to. */
+  RecordingTake * take;
+
+  /** Interleaved frames. */
+  float * frames;
+
+  /** Number of frames (per channel) filled. */
+  size_t num_frames;
+
+  /** Whether to close the take's file after writing the
+   * frames. */
+  bool close;
+} RecordingChunk;
+
+/**
+ * A file being recorded to.
+ */
+typedef struct RecordingTake
+{
+  char *     filepath;
+  channels_t channels;
+  uint32_t   samplerate;
+  BitDepth   bit_depth;
+
+  /** SNDFILE (only used by the disk thread). */
+  void * sndfile;
+
+  /** Chunk being filled, if any (only used by the
+   * caller's thread). */
+  RecordingChunk * chunk;
+
+  /** Time the first frames of @ref chunk were added. */
+  gint64 chunk_start_time;
+
+  /** Frames added with recording_disk_writer_add_frames()
+   * (only used by the caller's thread). */
+  unsigned_frame_t frames_added;
+
+  /** Frames written to the file (protected by the
+   * writer's lock). */
+  unsigned_frame_t frames_written;
+
+  /** First error while writing, if any (protected by
+   * the writer's lock). */
+  GError * error;
+} RecordingTake;
+
+/**
+ * Disk thread writing recorded takes.
+ *
+ * Takes must be added to and finished from a single
+ * thread (the GTK thread).
+ */
+typedef struct RecordingDiskWriter
+{
+  GThread * thread;
+
+  /** Chunks waiting to be written. */
+  GQueue queue;
+
+  /** Chunks available for reuse. */
+  GPtrArray * free_chunks;
+
+  /** Takes being recorded. */
+  GPtrArray * takes;
+
+  /** Number of chunks queued or being written. */
+  guint num_pending;
+
+  /** Lock for the above (except @ref takes). */
+  GMutex lock;
+
+  /** Signaled when chunks are queued or written. */
+  GCond cond;
+
+  volatile gint run;
+} RecordingDiskWriter;
+
+/**
+ * Creates a writer and starts its thread.
+ */
+RecordingDiskWriter *
+recording_disk_writer_new (void);
+
+/**
+ * Starts a take writing to the given file.
+ *
+ * The file is created when the first frames are
+ * written.
+ */
+NONNULL RecordingTake *
+recording_disk_writer_start_take (
+  RecordingDiskWriter * self,
+  const char *          filepath,
+  channels_t            channels,
+  uint32_t              samplerate,
+  BitDepth              bit_depth);
+
+/**
+ * Appends frames to the take.
+ *
+ * Full chunks (and chunks that were not written for
+ * RECORDING_DISK_WRITER_MAX_DELAY_USEC) are queued for
+ * writing.
+ *
+ * @param ch_bufs Per-channel frames.
+ */
+NONNULL void
+recording_disk_writer_add_frames (
+  RecordingDiskWriter * self,
+  RecordingTake *       take,
+  const float * const * ch_bufs,
+  size_t                nframes);
+
+/**
+ * Queues the partially filled chunks of all takes and
+ * waits until everything queued is written.
+ */
+NONNULL void
+recording_disk_writer_flush (RecordingDiskWriter * self);
+
+/**
+ * Writes the remaining frames of the take, closes its
+ * file and frees the take.
+ *
+ * @return Whether all the frames of the take were
+ *   written successfully.
+ */
+NONNULL_ARGS (1, 2)
+bool recording_disk_writer_finish_take (
+  RecordingDiskWriter * self,
+  RecordingTake *       take,
+  GError **             error);
+
+/**
+ * Finishes all takes, stops the thread and frees the
+ * writer.
+ */
+NONNULL void
+recording_disk_writer_free (RecordingDiskWriter * self);
+
+/**
+ * @}
+ */
+
+#endif
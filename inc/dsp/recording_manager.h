@@ -14,9 +14,11 @@
 
 #include "zix/sem.h"
 
-typedef struct ObjectPool     ObjectPool;
-typedef struct TrackProcessor TrackProcessor;
-typedef struct MPMCQueue      MPMCQueue;
+typedef struct ObjectPool          ObjectPool;
+typedef struct TrackProcessor      TrackProcessor;
+typedef struct MPMCQueue           MPMCQueue;
+typedef struct RecordingDiskWriter RecordingDiskWriter;
+typedef struct AudioClip           AudioClip;
 
 /**
  * @addtogroup dsp
@@ -58,6 +60,16 @@ typedef struct RecordingManager
   /** Pending recorded automation points. */
   GPtrArray * pending_aps;
 
+  /** Disk thread writing the recorded audio to the
+   * pool. */
+  RecordingDiskWriter * disk_writer;
+
+  /**
+   * Takes being written by @ref disk_writer, keyed by
+   * the pool ID of the recorded clip.
+   */
+  GHashTable * takes;
+
   bool   currently_processing;
   ZixSem processing_sem;
 
@@ -96,6 +108,41 @@ recording_manager_handle_recording (
 int
 recording_manager_process_events (RecordingManager * self);
 
+/**
+ * Returns whether the given clip is being recorded, in
+ * which case its pool file is owned by the disk writer.
+ *
+ * Takes are only started and finished on the GTK thread,
+ * so this can be called from other threads while the
+ * GTK thread waits for them (eg, when writing the pool).
+ */
+bool
+recording_manager_is_recording_clip (
+  RecordingManager * self,
+  const AudioClip *  clip);
+
+/**
+ * Waits until everything recorded so far into the given
+ * clip is written to its file in the pool, if the clip
+ * is being recorded.
+ *
+ * Must be called from the GTK thread.
+ *
+ * @return Whether the clip is being recorded (in which
+ *   case its pool file is owned by the disk writer).
+ */
+bool
+recording_manager_flush_take (RecordingManager * self, AudioClip * clip);
+
+/**
+ * Waits until everything recorded so far is written to
+ * the pool.
+ *
+ * Must be called from the GTK thread.
+ */
+void
+recording_manager_flush_takes (RecordingManager * self);
+
 /**
  * Creates the event queue and starts the event loop.
  *
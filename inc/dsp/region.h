@@ -19,13 +19,16 @@
 
 #include <glib/gi18n.h>
 
-typedef struct Channel         Channel;
-typedef struct Track           Track;
-typedef struct MidiNote        MidiNote;
-typedef struct TrackLane       TrackLane;
-typedef struct RegionLinkGroup RegionLinkGroup;
-typedef struct Stretcher       Stretcher;
-typedef struct AudioClip       AudioClip;
+typedef struct Channel            Channel;
+typedef struct Track              Track;
+typedef struct MidiNote           MidiNote;
+typedef struct TrackLane          TrackLane;
+typedef struct RegionLinkGroup    RegionLinkGroup;
+typedef struct Stretcher          Stretcher;
+typedef struct AudioClip          AudioClip;
+typedef struct IntervalIndex      IntervalIndex;
+typedef struct MidiNoteTimeline   MidiNoteTimeline;
+typedef struct RegionContentCache RegionContentCache;
 
 /**
  * @addtogroup dsp
@@ -217,6 +220,26 @@ typedef struct ZRegion
 
   /* ==== CHORD REGION END ==== */
 
+  /**
+   * Note timeline used during playback (MIDI and chord
+   * regions).
+   *
+   * Only set on playback snapshots.
+   */
+  MidiNoteTimeline * note_timeline;
+
+  /**
+   * Snapshot of this region in the current playback
+   * snapshot of its track, if any.
+   *
+   * Only set on project regions. This is only compared
+   * against the snapshots of the previous playback snapshot
+   * and never dereferenced, since the snapshot might have
+   * been freed already (see
+   * region_gen_playback_snapshot()).
+   */
+  ZRegion * playback_snapshot;
+
   /**
    * Set to ON during bouncing if this
    * region should be included.
@@ -231,10 +254,9 @@ typedef struct ZRegion
    * following situations:
    *
    * 1. when hidden part of the region is revealed
-   *   (on x axis).
-   *   TODO max 140% of the region should be
-   *   cached (20% before and 20% after if before/
-   *   after is not fully visible)
+   *   (on x axis). Half the visible width is cached
+   *   before and after the visible part (see
+   *   @ref content_caches).
    * 2. when full rect (x/width) changes
    * 3. when a region marker is moved
    * 4. when the clip actually changes (use
@@ -273,6 +295,30 @@ typedef struct ZRegion
    * are used). */
   ArrangerObject last_positions_obj;
 
+  /**
+   * Index of the MIDI note positions in ticks, used by
+   * the editor for hit-testing.
+   *
+   * Built on demand and cleared when the notes change
+   * (see arranger_object_get_index()).
+   */
+  IntervalIndex * arranger_index;
+
+  /**
+   * Incremented when anything drawn inside the region
+   * that is not part of the region itself changes (eg,
+   * its notes or automation points).
+   *
+   * @see arranger_object_bump_content_version().
+   */
+  guint content_version;
+
+  /**
+   * Cached drawing of the contents of the main and lane
+   * counterparts of the region (see region_draw()).
+   */
+  RegionContentCache * content_caches[2];
+
   /* --- drawing caches end --- */
 
   int magic;
@@ -552,6 +598,39 @@ region_is_hit_by_range (
   const signed_frame_t gframes_end,
   const bool           end_inclusive);
 
+/**
+ * Generates an index of the positions (in frames) of
+ * the given regions, to be used for looking up the
+ * regions hit by a range without going through all of
+ * them.
+ *
+ * The indices in the query results refer to the
+ * position in @p regions.
+ */
+IntervalIndex *
+region_gen_interval_index (ZRegion ** regions, int num_regions);
+
+/**
+ * Returns a snapshot of the region to be used during
+ * playback.
+ *
+ * The region's snapshot in the previous playback snapshot
+ * is reused if it is in @p prev_snapshots and the region
+ * did not change since, in which case it is removed from
+ * @p prev_snapshots. Otherwise, a new snapshot is created.
+ *
+ * @param prev_snapshots Set of snapshots of the previous
+ *   playback snapshot not reused yet, or NULL to create a
+ *   new snapshot.
+ * @param touched_ids Set of RegionIdentifier's of the
+ *   regions that changed.
+ */
+NONNULL_ARGS (1) ZRegion *
+region_gen_playback_snapshot (
+  ZRegion *    self,
+  GHashTable * prev_snapshots,
+  GHashTable * touched_ids);
+
 /**
  * Returns the region at the given position in the
  * given Track.
@@ -99,6 +99,18 @@ region_identifier_copy (RegionIdentifier * dest, const RegionIdentifier * src)
 bool
 region_identifier_validate (RegionIdentifier * self);
 
+/**
+ * To be used as GHashFunc.
+ */
+NONNULL unsigned int
+region_identifier_get_hash (const void * self);
+
+/**
+ * To be used as GEqualFunc.
+ */
+NONNULL int
+region_identifier_is_equal_func (const void * a, const void * b);
+
 static inline const char *
 region_identifier_get_region_type_name (RegionType type)
 {
@@ -74,6 +74,23 @@ typedef struct EngineProcessTimeInfo EngineProcessTimeInfo;
 
 #define ROUTER (AUDIO_ENGINE->router)
 
+/**
+ * State of a graph rebuilt while the engine is
+ * running.
+ */
+typedef enum RouterGraphSwapState
+{
+  /** No rebuilt graph waiting. */
+  ROUTER_GRAPH_SWAP_NONE,
+
+  /** The setup nodes of the graph are ready to be
+   * applied at the start of the next cycle. */
+  ROUTER_GRAPH_SWAP_PENDING,
+
+  /** The engine is applying the setup nodes. */
+  ROUTER_GRAPH_SWAP_APPLYING,
+} RouterGraphSwapState;
+
 typedef struct Router
 {
   Graph * graph;
@@ -96,6 +113,19 @@ typedef struct Router
   /** Used when recalculating the graph. */
   ZixSem graph_access;
 
+  /**
+   * A RouterGraphSwapState.
+   *
+   * Set to pending by router_recalc_graph() after
+   * building the new graph in the background, and back
+   * to none by the engine once it switched to it.
+   */
+  volatile gint graph_swap_state;
+
+  /** Engine block length the port buffers were last
+   * allocated for. */
+  nframes_t block_length;
+
   bool callback_in_progress;
 
   /** Thread that calls kicks off the cycle. */
@@ -113,6 +143,9 @@ router_new (void);
 /**
  * Recalculates the process acyclic directed graph.
  *
+ * If the engine is running, the new graph is built in
+ * the background and swapped in between cycles.
+ *
  * @param soft If true, only readjusts latencies.
  */
 void
@@ -41,6 +41,7 @@ typedef struct Modulator                      Modulator;
 typedef struct Marker                         Marker;
 typedef struct PluginDescriptor               PluginDescriptor;
 typedef struct Tracklist                      Tracklist;
+typedef struct IntervalIndex                  IntervalIndex;
 typedef struct SupportedFile                  SupportedFile;
 typedef struct TracklistSelections            TracklistSelections;
 typedef enum PassthroughProcessorType         PassthroughProcessorType;
@@ -175,6 +176,28 @@ static const cyaml_strval_t track_type_strings[] = {
   { N_ ("Folder"),      TRACK_TYPE_FOLDER     },
 };
 
+/**
+ * Objects of a track read by the engine during playback.
+ *
+ * Published snapshots are never modified. Edits build a new
+ * snapshot that shares the lanes and regions that did not
+ * change with the current one and swap it in (see
+ * track_update_playback_snapshot()).
+ */
+typedef struct TrackPlaybackSnapshot
+{
+  /** Lane snapshots (see track_lane_gen_snapshot()). */
+  TrackLane ** lanes;
+  int          num_lanes;
+
+  /** Chord region snapshots. */
+  ZRegion ** chord_regions;
+  int        num_chord_regions;
+
+  /** Index of the chord region snapshot positions. */
+  IntervalIndex * chord_region_index;
+} TrackPlaybackSnapshot;
+
 /**
  * Track to be inserted into the Project's Tracklist.
  *
@@ -266,9 +289,12 @@ typedef struct Track
   int          num_lanes;
   size_t       lanes_size;
 
-  /** Snapshots used during playback. */
-  TrackLane ** lane_snapshots;
-  int          num_lane_snapshots;
+  /**
+   * Snapshot used during playback.
+   *
+   * Must be read with track_get_playback_snapshot().
+   */
+  TrackPlaybackSnapshot * playback_snapshot;
 
   /** MIDI channel (MIDI/Instrument track only). */
   uint8_t midi_ch;
@@ -353,9 +379,14 @@ typedef struct Track
   int        num_chord_regions;
   size_t     chord_regions_size;
 
-  /** Snapshots used during playback. */
-  ZRegion ** chord_region_snapshots;
-  int        num_chord_region_snapshots;
+  /**
+   * Index of the chord region positions in ticks, used by
+   * the arranger for hit-testing.
+   *
+   * Built on demand and cleared when the chord regions
+   * change (see arranger_object_get_index()).
+   */
+  IntervalIndex * chord_region_arranger_index;
 
   /**
    * ScaleObject's.
@@ -1438,6 +1469,36 @@ track_get_total_bars (Track * self, int * total_bars);
 void
 track_set_caches (Track * self, CacheTypes types);
 
+/**
+ * Takes a new snapshot of the objects of the track read by
+ * the engine during playback and swaps it in.
+ *
+ * This is safe while the engine is running. Snapshots of
+ * lanes and regions that did not change are shared with
+ * the previous snapshot, and the objects no longer used are
+ * freed once the engine is done with them (see
+ * engine_retire_object()).
+ *
+ * @param touched_ids Set of RegionIdentifier's of the
+ *   regions that changed, or NULL to take a new snapshot of
+ *   all the regions.
+ */
+void
+track_update_playback_snapshot (Track * self, GHashTable * touched_ids);
+
+/**
+ * Returns the current playback snapshot.
+ *
+ * The engine must only call this once per cycle and use
+ * the returned snapshot for the whole cycle.
+ */
+static inline const TrackPlaybackSnapshot *
+track_get_playback_snapshot (const Track * self)
+{
+  return (const TrackPlaybackSnapshot *) g_atomic_pointer_get (
+    (TrackPlaybackSnapshot **) &self->playback_snapshot);
+}
+
 /**
  * Called when track(s) are actually imported into the
  * project.
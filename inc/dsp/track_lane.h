@@ -82,6 +82,21 @@ typedef struct TrackLane
   /** Owner track. */
   Track * track;
 
+  /**
+   * Index of the region positions, only set on playback
+   * snapshots (see track_lane_gen_snapshot()).
+   */
+  IntervalIndex * region_index;
+
+  /**
+   * Index of the region positions in ticks, used by the
+   * arranger for hit-testing.
+   *
+   * Built on demand and cleared when the regions change
+   * (see arranger_object_get_index()).
+   */
+  IntervalIndex * arranger_index;
+
 } TrackLane;
 
 void
@@ -248,9 +263,22 @@ track_lane_calculate_lane_idx (const TrackLane * self);
 
 /**
  * Generate a snapshot for playback.
+ *
+ * @param regions Snapshots of the lane's regions (see
+ *   region_gen_playback_snapshot()).
  */
-TrackLane *
-track_lane_gen_snapshot (const TrackLane * self);
+NONNULL_ARGS (1) TrackLane *
+track_lane_gen_snapshot (
+  const TrackLane * self,
+  ZRegion **        regions,
+  int               num_regions);
+
+/**
+ * Frees a lane snapshot without freeing its regions, which
+ * may still be used by another snapshot.
+ */
+NONNULL void
+track_lane_free_snapshot_shallow (TrackLane * self);
 
 /**
  * Frees the TrackLane.
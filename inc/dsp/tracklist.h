@@ -47,6 +47,34 @@ typedef enum TracklistPinOption
   TRACKLIST_PIN_OPTION_BOTH,
 } TracklistPinOption;
 
+/**
+ * Slot in a TracklistNameIndex.
+ */
+typedef struct TracklistNameIndexSlot
+{
+  unsigned int name_hash;
+
+  /** Track, or NULL if the slot is empty. */
+  Track * track;
+} TracklistNameIndexSlot;
+
+/**
+ * Open-addressing table mapping track name hashes to
+ * tracks.
+ *
+ * The table is never modified after it is published: a
+ * new one replaces it when tracks are added, removed or
+ * renamed, so the engine can look tracks up without
+ * locking.
+ */
+typedef struct TracklistNameIndex
+{
+  /** Number of slots (a power of 2). */
+  unsigned int size;
+
+  TracklistNameIndexSlot slots[];
+} TracklistNameIndex;
+
 /**
  * The Tracklist contains all the tracks in the
  * Project.
@@ -121,6 +149,16 @@ typedef struct Tracklist
 
   /** Width of track widgets. */
   int width;
+
+  /**
+   * Index of the tracks by name hash, or NULL to search
+   * the tracks linearly.
+   *
+   * Must be accessed atomically.
+   *
+   * @see tracklist_update_name_index().
+   */
+  TracklistNameIndex * name_index;
 } Tracklist;
 
 /**
@@ -167,6 +205,16 @@ tracklist_find_track_by_name (Tracklist * self, const char * name);
 NONNULL OPTIMIZE_O3 Track *
 tracklist_find_track_by_name_hash (Tracklist * self, unsigned int hash);
 
+/**
+ * Rebuilds the index used by
+ * tracklist_find_track_by_name_hash().
+ *
+ * To be called from the GUI thread after tracks are
+ * added, removed or renamed.
+ */
+NONNULL void
+tracklist_update_name_index (Tracklist * self);
+
 NONNULL int
 tracklist_contains_master_track (Tracklist * self);
 
@@ -24,6 +24,7 @@ typedef struct ArrangerSelections             ArrangerSelections;
 typedef struct _ArrangerWidget                ArrangerWidget;
 typedef struct _ArrangerObjectWidget          ArrangerObjectWidget;
 typedef struct UndoableAction                 UndoableAction;
+typedef struct IntervalIndex                  IntervalIndex;
 typedef enum ArrangerSelectionsActionEditType ArrangerSelectionsActionEditType;
 
 /**
@@ -626,6 +627,51 @@ arranger_object_set_position (
   ArrangerObjectPositionType pos_type,
   const bool                 validate);
 
+/**
+ * Returns the index of the positions (in ticks) of the
+ * given objects, building it if needed.
+ *
+ * Used for hit-testing in the arrangers without going
+ * through all the objects. Only regions and MIDI notes
+ * are indexed (see arranger_object_invalidate_index()).
+ *
+ * The indices in the query results refer to the position
+ * in @p objs. Each interval also covers the object's
+ * transient, if any.
+ *
+ * @param index Index owned by the container of the
+ *   objects, or NULL if not built yet.
+ */
+NONNULL_ARGS (3)
+IntervalIndex * arranger_object_get_index (
+  ArrangerObject ** objs,
+  int               num_objs,
+  IntervalIndex **  index);
+
+/**
+ * Clears the index of the container the object belongs
+ * to (found by the object's identifier), so that it is
+ * rebuilt on the next hit test.
+ *
+ * To be called when the position of the object changes.
+ * Containers clear their own index when objects are
+ * added or removed.
+ */
+NONNULL void
+arranger_object_invalidate_index (const ArrangerObject * self);
+
+/**
+ * Marks the cached drawing of the region the object is
+ * drawn in (the object itself if it is a region) as
+ * outdated (see ZRegion.content_version).
+ *
+ * To be called when something that is drawn in the
+ * region changes. Changes to the region's own positions
+ * are detected when drawing.
+ */
+NONNULL void
+arranger_object_bump_content_version (const ArrangerObject * self);
+
 /**
  * Returns the type as a string.
  */
@@ -34,6 +34,74 @@
 #define REGION_NAME_BOX_PADDING 2
 #define REGION_NAME_BOX_CURVINESS 4.0
 
+/**
+ * What the cached contents of a region depend on.
+ *
+ * Compared with memcmp(), so it must be zeroed before
+ * being filled in.
+ */
+typedef struct RegionContentCacheKey
+{
+  /** See ZRegion.content_version. */
+  guint version;
+
+  /** Full rectangle size. */
+  int width;
+  int height;
+
+  /** Zoom level. */
+  double px_per_tick;
+  double frames_per_tick;
+
+  /** Positions in ticks, relative to the region's
+   * start except for the length (moving the region
+   * does not change its contents). */
+  double       length;
+  double       clip_start_pos;
+  double       loop_start_pos;
+  double       loop_end_pos;
+  double       fade_in_pos;
+  double       fade_out_pos;
+  CurveOptions fade_in_opts;
+  CurveOptions fade_out_opts;
+
+  /** Whether the notes are drawn in grey. */
+  bool grey_notes;
+
+  /* audio only */
+  UiDetail         detail;
+  const void *     clip;
+  const void *     peaks;
+  unsigned_frame_t num_frames;
+  gint64           last_clip_change;
+  bpm_t            bpm;
+  bool             musical_mode;
+  bool             stretching;
+  bool             hovered;
+} RegionContentCacheKey;
+
+/**
+ * Render node with the notes, automation curves or
+ * waveform of a region.
+ *
+ * The node is reused while its key does not change and
+ * the visible part of the region is inside the part that
+ * was rendered, so that redrawing the arranger (eg, when
+ * the playhead moves) does not rebuild the contents of
+ * every region.
+ */
+typedef struct RegionContentCache
+{
+  RegionContentCacheKey key;
+
+  /** Rendered part, relative to the region's start. */
+  int x;
+  int width;
+
+  /** The node, or NULL if nothing was drawn. */
+  GskRenderNode * node;
+} RegionContentCache;
+
 /**
  * Returns the lane rectangle for the region.
  */
@@ -49,4 +117,10 @@ region_get_lane_full_rect (ZRegion * self, GdkRectangle * rect);
 HOT void
 region_draw (ZRegion * self, GtkSnapshot * snapshot, GdkRectangle * rect);
 
+/**
+ * Frees the cached drawings of the region's contents.
+ */
+NONNULL void
+region_free_content_caches (ZRegion * self);
+
 #endif
@@ -182,4 +182,27 @@ chord_action_deserialize_from_json (
   ChordAction * action,
   GError **     error);
 
+/**
+ * Serializes the action according to its type.
+ */
+bool
+undoable_action_serialize_typed_to_json (
+  yyjson_mut_doc *       doc,
+  yyjson_mut_val *       action_obj,
+  const UndoableAction * action,
+  GError **              error);
+
+/**
+ * Creates an action of the type found in @p action_obj
+ * and deserializes it.
+ *
+ * @return The new action, or NULL if the type is not
+ *   known.
+ */
+UndoableAction *
+undoable_action_deserialize_typed_from_json (
+  yyjson_doc * doc,
+  yyjson_val * action_obj,
+  GError **    error);
+
 #endif // __IO_SERIALIZATION_ACTIONS_H__
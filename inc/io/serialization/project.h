@@ -16,6 +16,38 @@
 
 TYPEDEF_STRUCT (Project);
 
+/**
+ * Called with each chunk of serialized JSON.
+ *
+ * @return Whether the chunk was handled successfully.
+ */
+typedef bool (*ProjectSerializationChunkCallback) (
+  const char * chunk,
+  size_t       size,
+  void *       user_data,
+  GError **    error);
+
+/**
+ * Serializes the project in chunks.
+ *
+ * Each track and each other member of the project is
+ * serialized into its own document that is passed to @p cb
+ * and freed before the next one is serialized, so memory
+ * usage is bounded by the largest member. The concatenated
+ * chunks form the same JSON as
+ * project_serialize_to_json_str().
+ *
+ * @param with_undo_history Whether to include the undo
+ *   history (not needed for backups).
+ */
+bool
+project_serialize_to_json_chunks (
+  const Project *                   project,
+  bool                              with_undo_history,
+  ProjectSerializationChunkCallback cb,
+  void *                            user_data,
+  GError **                         error);
+
 char *
 project_serialize_to_json_str (const Project * project, GError ** error);
 
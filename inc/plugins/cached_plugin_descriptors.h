@@ -1,4 +1,4 @@
-// SPDX-FileCopyrightText: © 2020-2021 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-FileCopyrightText: © 2020-2024 Alexandros Theodotou <alex@zrythm.org>
 // SPDX-License-Identifier: LicenseRef-ZrythmLicense
 
 /**
@@ -10,8 +10,12 @@
 #ifndef __PLUGINS_CACHED_PLUGIN_DESCRIPTORS_H__
 #define __PLUGINS_CACHED_PLUGIN_DESCRIPTORS_H__
 
+#include <stdbool.h>
+#include <stdint.h>
+
 #include "plugins/plugin_descriptor.h"
-#include "utils/yaml.h"
+
+#include <glib.h>
 
 /**
  * @addtogroup plugins
@@ -19,58 +23,140 @@
  * @{
  */
 
-#define CACHED_PLUGIN_DESCRIPTORS_SCHEMA_VERSION 3
+#define CACHED_PLUGIN_DESCRIPTORS_MAGIC "ZRPLGDSC"
+#define CACHED_PLUGIN_DESCRIPTORS_SCHEMA_VERSION 5
+
+/** String table offset of a missing string. */
+#define CACHED_PLUGIN_DESCRIPTORS_NO_STRING UINT32_MAX
+
+/**
+ * Header of the cache file.
+ *
+ * The file consists of the header, followed by the
+ * records of the valid descriptors, the records of the
+ * blacklisted ones and a table of NUL-terminated strings
+ * the records refer to. Everything is in native byte
+ * order, since the cache is per machine.
+ */
+typedef struct CachedPluginDescriptorsHeader
+{
+  char     magic[8];
+  uint32_t version;
+  uint32_t num_descriptors;
+  uint32_t num_blacklisted;
+  uint32_t strings_size;
+  uint8_t  reserved[16];
+} CachedPluginDescriptorsHeader;
+
+/**
+ * A descriptor in the cache file.
+ *
+ * Strings are offsets in the string table, or
+ * CACHED_PLUGIN_DESCRIPTORS_NO_STRING.
+ */
+typedef struct CachedPluginDescriptorRecord
+{
+  uint32_t author;
+  uint32_t name;
+  uint32_t website;
+  uint32_t category_str;
+  uint32_t path;
+  uint32_t uri;
+  int32_t  category;
+  int32_t  num_audio_ins;
+  int32_t  num_midi_ins;
+  int32_t  num_audio_outs;
+  int32_t  num_midi_outs;
+  int32_t  num_ctrl_ins;
+  int32_t  num_ctrl_outs;
+  int32_t  num_cv_ins;
+  int32_t  num_cv_outs;
+  int32_t  arch;
+  int32_t  protocol;
+  int32_t  min_bridge_mode;
+  int32_t  has_custom_ui;
+  uint32_t ghash;
+  uint32_t reserved;
+  int64_t  unique_id;
+  int64_t  file_mtime;
+  int64_t  file_size;
+} CachedPluginDescriptorRecord;
+
+/**
+ * A cached descriptor, created from its record in the
+ * mapped file when first needed.
+ */
+typedef struct CachedPluginDescriptor
+{
+  /** Record in the mapped file, or NULL if not loaded
+   * from the file. */
+  const CachedPluginDescriptorRecord * record;
+
+  /** The descriptor, or NULL if not created yet. */
+  PluginDescriptor * descr;
+} CachedPluginDescriptor;
 
 /**
  * Descriptors to be cached.
+ *
+ * The cache file is mapped at startup and descriptors
+ * are only created from their records when looked up.
+ *
+ * The descriptors of plugins with a path are also indexed
+ * by path, and are only used while the modification time
+ * and size of the file match the ones recorded when
+ * caching.
  */
 typedef struct CachedPluginDescriptors
 {
-  /** Version of the file. */
-  int schema_version;
-
-  /** Valid descriptors. */
-  PluginDescriptor * descriptors[90000];
-  int                num_descriptors;
+  /** Valid descriptors (CachedPluginDescriptor). */
+  GPtrArray * descriptors;
 
   /** Blacklisted paths and hashes, to skip
-   * when scanning */
-  PluginDescriptor * blacklisted[90000];
-  int                num_blacklisted;
-} CachedPluginDescriptors;
+   * when scanning (CachedPluginDescriptor). */
+  GPtrArray * blacklisted;
+
+  /** Valid descriptors by path (path to GPtrArray of
+   * CachedPluginDescriptor). */
+  GHashTable * descriptors_by_path;
 
-static const cyaml_schema_field_t cached_plugin_descriptors_fields_schema[] = {
-  YAML_FIELD_INT (CachedPluginDescriptors, schema_version),
-  YAML_FIELD_FIXED_SIZE_PTR_ARRAY_VAR_COUNT (
-    CachedPluginDescriptors,
-    descriptors,
-    plugin_descriptor_schema),
-  YAML_FIELD_FIXED_SIZE_PTR_ARRAY_VAR_COUNT (
-    CachedPluginDescriptors,
-    blacklisted,
-    plugin_descriptor_schema),
+  /** Blacklisted descriptors by path. */
+  GHashTable * blacklisted_by_path;
 
-  CYAML_FIELD_END
-};
+  /** Cache file the records are in, if any. */
+  GMappedFile * mapped_file;
 
-static const cyaml_schema_value_t cached_plugin_descriptors_schema = {
-  YAML_VALUE_PTR (
-    CachedPluginDescriptors,
-    cached_plugin_descriptors_fields_schema),
-};
+  /** String table of @ref mapped_file. */
+  const char * strings;
+  size_t       strings_size;
+
+  /** Whether the cache changed since it was read or
+   * written. */
+  bool dirty;
+} CachedPluginDescriptors;
 
 /**
- * Reads the file and fills up the object.
+ * Maps the cache file, if valid, and indexes its
+ * records.
  */
 CachedPluginDescriptors *
 cached_plugin_descriptors_new (void);
 
+/**
+ * Writes the cache file, if the cache changed.
+ *
+ * All the descriptors are created from their records
+ * first, since the file they are mapped from is replaced.
+ */
 void
 cached_plugin_descriptors_serialize_to_file (CachedPluginDescriptors * self);
 
 /**
  * Returns if the plugin at the given path is
  * blacklisted or not.
+ *
+ * Plugins are no longer considered blacklisted once
+ * their file changes.
  */
 int
 cached_plugin_descriptors_is_blacklisted (
@@ -98,10 +184,15 @@ cached_plugin_descriptors_find (
 /**
  * Returns the PluginDescriptor's corresponding to
  * the .so/.dll file at the given path, if it
- * exists and the MD5 hash matches.
+ * exists and the file did not change since it was
+ * cached.
+ *
+ * The descriptors are created directly from the
+ * records in the mapped file, so the cached ones are
+ * not created.
  *
- * @note The returned array must be free'd but not
- *   the descriptors.
+ * @note The returned array and descriptors are owned
+ *   by the caller.
  *
  * @return NULL-terminated array.
  */
@@ -27,6 +27,12 @@ typedef struct PluginDescriptor PluginDescriptor;
  * @{
  */
 
+/**
+ * Time in ms after which a discovery process is killed
+ * (the plugin is then blacklisted).
+ */
+#  define Z_CARLA_DISCOVERY_TIMEOUT_MS 8000
+
 /**
  * Returns the absolute path to carla-discovery-*
  * as a newly allocated string.
@@ -93,6 +93,12 @@ typedef struct PluginDescriptor  PluginDescriptor;
 
 #define LV2_PARAM_MAX_STR_LEN 1200
 
+/**
+ * Maximum block length plugins are told they will be run
+ * with (bufsz:maxBlockLength).
+ */
+#define LV2_PLUGIN_MAX_BLOCK_LENGTH 4096
+
 #define lv2_plugin_is_in_active_project(self) \
   (plugin_is_in_active_project ((self)->plugin))
 
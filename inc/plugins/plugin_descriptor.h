@@ -235,6 +235,12 @@ typedef struct PluginDescriptor
    * using g_file_hash(). */
   unsigned int ghash;
 
+  /** Modification time (in seconds) and size of the file
+   * at @ref path when the descriptor was cached, used to
+   * check whether the cached descriptor is up to date. */
+  int64_t file_mtime;
+  int64_t file_size;
+
   /** Used in Gtk. */
   WrappedObjectWithChangeSignal * gobj;
 } PluginDescriptor;
@@ -262,6 +268,8 @@ static const cyaml_schema_field_t plugin_descriptor_fields_schema[] = {
   YAML_FIELD_ENUM (PluginDescriptor, min_bridge_mode, carla_bridge_mode_strings),
   YAML_FIELD_INT (PluginDescriptor, has_custom_ui),
   YAML_FIELD_UINT (PluginDescriptor, ghash),
+  YAML_FIELD_INT_OPT (PluginDescriptor, file_mtime),
+  YAML_FIELD_INT_OPT (PluginDescriptor, file_size),
 
   CYAML_FIELD_END
 };
@@ -33,6 +33,8 @@
 #include "gui/backend/timeline_selections.h"
 #include "gui/backend/tool.h"
 #include "plugins/plugin.h"
+#include "project/autosave_journal.h"
+#include "utils/compression.h"
 #include "zrythm.h"
 
 #include <gtk/gtk.h>
@@ -64,7 +66,9 @@ typedef struct TracklistSelections TracklistSelections;
 #define PROJECT_EXPORTS_DIR "exports"
 #define PROJECT_STEMS_DIR "stems"
 #define PROJECT_POOL_DIR "pool"
+#define PROJECT_CACHE_DIR "cache"
 #define PROJECT_FINISHED_FILE "FINISHED"
+#define PROJECT_AUTOSAVE_JOURNAL_FILE "autosave.journal"
 
 typedef enum ProjectPath
 {
@@ -92,7 +96,14 @@ typedef enum ProjectPath
 
   PROJECT_PATH_POOL,
 
+  /** Decoded clips (PROJECT_CACHE_DIR / "pool"). */
+  PROJECT_PATH_POOL_CACHE,
+
   PROJECT_PATH_FINISHED_FILE,
+
+  /** Journal of the actions since the last save (only
+   * in the main project directory). */
+  PROJECT_PATH_AUTOSAVE_JOURNAL,
 } ProjectPath;
 
 /**
@@ -302,6 +313,12 @@ typedef struct Project
    */
   UndoableAction * last_action_in_last_successful_autosave;
 
+  /**
+   * Journal of the actions done since the last save, or
+   * NULL if the project was not saved yet.
+   */
+  AutosaveJournal * autosave_journal;
+
   /** Used when deserializing projects. */
   int format_major;
   int format_minor;
@@ -312,7 +329,13 @@ typedef struct Project
  */
 typedef struct ProjectSaveData
 {
-  /** Project clone (with memcpy). */
+  /**
+   * Project to save (not owned).
+   *
+   * This is the project in use, which stays unchanged
+   * while it is being saved since the engine is paused and
+   * the undo manager is locked.
+   */
   Project * project;
 
   /** Full path to save to. */
@@ -320,7 +343,7 @@ typedef struct ProjectSaveData
 
   bool is_backup;
 
-  /** To be set to true when the thread finishes. */
+  /** To be set to true when the file is written. */
   bool finished;
 
   bool show_notification;
@@ -329,6 +352,24 @@ typedef struct ProjectSaveData
   bool has_error;
 
   ProgressInfo * progress_info;
+
+  /** Compressed project file being written. */
+  CompressionFileWriter * writer;
+
+  /**
+   * Serialized chunks (GBytes) to be compressed and
+   * written by the writer thread, when saving
+   * asynchronously.
+   *
+   * An empty chunk marks the end.
+   */
+  GAsyncQueue * chunks;
+
+  /** Number of chunks that can still be queued. */
+  ZixSem chunk_slots;
+
+  /** Error in the writer thread, if any. */
+  GError * write_error;
 } ProjectSaveData;
 
 ProjectSaveData *
@@ -362,8 +403,9 @@ project_init_common (Project * self);
  *   will be saved as <original filename>.bak<num>.
  * @param show_notification Show a notification
  *   in the UI that the project was saved.
- * @param async Save asynchronously in another
- *   thread.
+ * @param async Compress and write the file in
+ *   another thread while the project is being
+ *   serialized.
  *
  * @return Whether successful.
  */
@@ -462,17 +504,6 @@ project_get_existing_uncompressed_text (
 NONNULL bool
 project_has_unsaved_changes (const Project * self);
 
-/**
- * Deep-clones the given project.
- *
- * To be used during save on the main thread.
- *
- * @param for_backup Whether the resulting project
- *   is for a backup.
- */
-NONNULL Project *
-project_clone (const Project * src, bool for_backup, GError ** error);
-
 /**
  * Creates an empty project object.
  */
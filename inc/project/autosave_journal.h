@@ -0,0 +1,180 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+/**
+ * \file
+ *
+ * Journal of the actions done since the last save.
+ *
+ * Full backups are only written while the project is
+ * quiet (not while playing or recording), so the actions
+ * done in between are appended to a journal file in the
+ * project directory instead. The journal refers to a
+ * checkpoint (the main project file or a backup) and is
+ * replayed on top of it when the checkpoint is loaded
+ * again after a crash.
+ *
+ * The file contains one JSON object per line: a header
+ * with the checkpoint, followed by a record for each
+ * action done, undone or redone.
+ */
+
+#ifndef __PROJECT_AUTOSAVE_JOURNAL_H__
+#define __PROJECT_AUTOSAVE_JOURNAL_H__
+
+#include <stdbool.h>
+
+#include "utils/types.h"
+
+#include <glib.h>
+
+TYPEDEF_STRUCT (UndoableAction);
+TYPEDEF_STRUCT (UndoManager);
+
+/**
+ * @addtogroup project
+ *
+ * @{
+ */
+
+#define AUTOSAVE_JOURNAL_VERSION 1
+
+/**
+ * Number of records after which a full backup should be
+ * saved, so that the journal and the time needed to
+ * replay it stay small.
+ */
+#define AUTOSAVE_JOURNAL_MAX_RECORDS 256
+
+/**
+ * What happened to the action of a record.
+ */
+typedef enum AutosaveJournalOp
+{
+  /** The action was performed for the first time. */
+  AUTOSAVE_JOURNAL_OP_PERFORM,
+  /** The action was undone. */
+  AUTOSAVE_JOURNAL_OP_UNDO,
+  /** The action was redone. */
+  AUTOSAVE_JOURNAL_OP_REDO,
+} AutosaveJournalOp;
+
+typedef struct AutosaveJournal
+{
+  /** Path of the journal file. */
+  char * path;
+
+  /**
+   * Name of the backup directory the records apply to,
+   * or an empty string for the main project file.
+   */
+  char * checkpoint;
+
+  /** Records not written to the file yet. */
+  GString * pending;
+
+  /** Number of records since the checkpoint. */
+  int num_records;
+
+  /**
+   * Whether an action could not be recorded.
+   *
+   * Further records are dropped until the next
+   * checkpoint, since replaying them would be wrong.
+   */
+  bool broken;
+} AutosaveJournal;
+
+/**
+ * Creates a journal for the given checkpoint, replacing
+ * any existing journal file at @p path.
+ *
+ * @param checkpoint Name of the backup directory, or an
+ *   empty string for the main project file.
+ */
+NONNULL_ARGS (1, 2)
+AutosaveJournal * autosave_journal_new (
+  const char * path,
+  const char * checkpoint,
+  GError **    error);
+
+/**
+ * Serializes the action into a record.
+ *
+ * @return A newly allocated line, or NULL if the action
+ *   could not be serialized.
+ */
+NONNULL char *
+autosave_journal_serialize_action (
+  const UndoableAction * action,
+  AutosaveJournalOp      op);
+
+/**
+ * Appends a record from autosave_journal_serialize_action()
+ * to the journal (it is written on the next flush).
+ *
+ * @param record The record, ownership is transferred.
+ *   NULL marks the journal as broken.
+ */
+NONNULL_ARGS (1) void autosave_journal_append (
+  AutosaveJournal * self,
+  char *            record);
+
+/**
+ * Writes the pending records to the file.
+ */
+NONNULL_ARGS (1)
+bool autosave_journal_flush (AutosaveJournal * self, GError ** error);
+
+/**
+ * Returns whether a full backup should be saved to
+ * start a new journal.
+ */
+NONNULL bool
+autosave_journal_needs_compaction (const AutosaveJournal * self);
+
+/**
+ * Reads the records of the journal file at @p path.
+ *
+ * @param checkpoint The checkpoint that was loaded.
+ *
+ * @return The records, or NULL if there is no journal
+ *   for @p checkpoint.
+ */
+NONNULL GPtrArray *
+autosave_journal_read_records (const char * path, const char * checkpoint);
+
+/**
+ * Re-applies the records to the project, stopping at the
+ * first one that fails.
+ *
+ * The actions are recorded again in the project's
+ * journal, if any.
+ *
+ * @param[out] num_replayed Number of records replayed.
+ *
+ * @return Whether all records were replayed.
+ */
+NONNULL_ARGS (1, 2, 3)
+bool autosave_journal_replay_records (
+  GPtrArray *   records,
+  UndoManager * undo_manager,
+  int *         num_replayed,
+  GError **     error);
+
+/**
+ * Removes the journal file.
+ *
+ * To be called when the project is closed normally.
+ */
+NONNULL void
+autosave_journal_remove_file (AutosaveJournal * self);
+
+NONNULL void
+autosave_journal_free (AutosaveJournal * self);
+
+/**
+ * @}
+ */
+
+#endif
@@ -10,10 +10,18 @@
 #ifndef __UTILS_COMPRESSION_H__
 #define __UTILS_COMPRESSION_H__
 
+#include <stdbool.h>
+
 #include "utils/types.h"
 
 #include <glib.h>
 
+/**
+ * Writer that compresses the data written to it into a
+ * file incrementally.
+ */
+typedef struct CompressionFileWriter CompressionFileWriter;
+
 /**
  * Compresses a NULL-terminated string.
  */
@@ -26,4 +34,68 @@ compression_compress_to_base64_str (const char * src, GError ** error);
 char *
 compression_decompress_from_base64_str (const char * b64, GError ** error);
 
+/**
+ * Compresses the given data into a zstd frame.
+ *
+ * @param[out] dest_size Size of the compressed data.
+ *
+ * @return The compressed data, to be free'd with free(),
+ *   or NULL on error.
+ */
+char *
+compression_compress (
+  const char * src,
+  size_t       src_size,
+  size_t *     dest_size,
+  GError **    error);
+
+/**
+ * Decompresses a zstd frame whose size may not be known in
+ * advance (such as frames written by a
+ * CompressionFileWriter).
+ *
+ * @param[out] dest_size Size of the decompressed data.
+ *
+ * @return The decompressed data, to be free'd with free(),
+ *   or NULL on error.
+ */
+char *
+compression_decompress_stream (
+  const char * src,
+  size_t       src_size,
+  size_t *     dest_size,
+  GError **    error);
+
+/**
+ * Creates a writer that compresses the data written to it
+ * into the file at @p path.
+ *
+ * The data is written to a temporary file that replaces
+ * @p path only when the writer is closed successfully.
+ */
+CompressionFileWriter *
+compression_file_writer_new (const char * path, GError ** error);
+
+/**
+ * Compresses and writes the given data.
+ */
+bool
+compression_file_writer_write (
+  CompressionFileWriter * self,
+  const char *            data,
+  size_t                  size,
+  GError **               error);
+
+/**
+ * Finishes the compressed file and frees the writer.
+ *
+ * @param discard Whether to discard the file instead (eg,
+ *   on error).
+ */
+bool
+compression_file_writer_close (
+  CompressionFileWriter * self,
+  bool                    discard,
+  GError **               error);
+
 #endif // __UTILS_COMPRESSION_H__
@@ -0,0 +1,114 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+/**
+ * \file
+ *
+ * Static interval index.
+ *
+ * Intervals are sorted by start and stored as an
+ * implicit binary tree augmented with the max end of
+ * each subtree (see cgranges by Heng Li), so that
+ * overlap queries cost O(log n + hits) and the index is
+ * a single flat array.
+ */
+
+#ifndef __UTILS_INTERVAL_INDEX_H__
+#define __UTILS_INTERVAL_INDEX_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/**
+ * @addtogroup utils
+ *
+ * @{
+ */
+
+typedef struct IntervalIndexItem
+{
+  /** Start (inclusive). */
+  int64_t start;
+
+  /** End (exclusive). */
+  int64_t end;
+
+  /** Max end in the subtree rooted at this item. */
+  int64_t max_end;
+
+  /** Index of the object this interval refers to. */
+  int idx;
+} IntervalIndexItem;
+
+typedef struct IntervalIndex
+{
+  IntervalIndexItem * items;
+  size_t              num_items;
+  size_t              items_size;
+
+  /** Level of the root node. */
+  int root_level;
+
+  /**
+   * Buffer for query results, large enough to hold all
+   * the items so that querying does not allocate.
+   */
+  int * hits;
+
+  /**
+   * Free for use by the owner (eg, to tell whether the
+   * index is outdated).
+   */
+  unsigned int tag;
+} IntervalIndex;
+
+IntervalIndex *
+interval_index_new (size_t num_items);
+
+/**
+ * Adds an interval.
+ *
+ * interval_index_build() must be called after adding
+ * all intervals.
+ *
+ * @param start Start (inclusive).
+ * @param end End (inclusive).
+ * @param idx Index of the object the interval refers
+ *   to.
+ */
+NONNULL void
+interval_index_add (IntervalIndex * self, int64_t start, int64_t end, int idx);
+
+/**
+ * Sorts the intervals and builds the index.
+ */
+NONNULL void
+interval_index_build (IntervalIndex * self);
+
+/**
+ * Finds the intervals overlapping the given range
+ * (both ends inclusive).
+ *
+ * This does not allocate, but it uses a buffer owned by
+ * the index, so only one thread may query at a time.
+ *
+ * @param[out] hits Set to the indices of the objects
+ *   hit, sorted in ascending order.
+ *
+ * @return The number of hits.
+ */
+HOT NONNULL size_t
+interval_index_query (
+  IntervalIndex * self,
+  int64_t         start,
+  int64_t         end,
+  const int **    hits);
+
+NONNULL void
+interval_index_free (IntervalIndex * self);
+
+/**
+ * @}
+ */
+
+#endif
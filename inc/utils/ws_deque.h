@@ -0,0 +1,101 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+/**
+ * \file
+ *
+ * Chase-Lev work-stealing deque.
+ *
+ * Based on "Correct and Efficient Work-Stealing for Weak Memory Models"
+ * (Lê, Pop, Cohen, Zappa Nardelli, 2013).
+ *
+ * Only the owner thread may call ws_deque_push() and ws_deque_pop().
+ * Any other thread may call ws_deque_steal().
+ *
+ * The buffer does not grow during processing, so ws_deque_reserve() must be
+ * called beforehand (while no thread is accessing the deque) with the
+ * maximum number of elements that can be queued at once.
+ */
+
+#ifndef __UTILS_WS_DEQUE_H__
+#define __UTILS_WS_DEQUE_H__
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "utils/types.h"
+
+#include <glib.h>
+
+/**
+ * @addtogroup utils
+ *
+ * @{
+ */
+
+typedef struct WorkStealingDeque
+{
+  char             pad0[64];
+  atomic_llong     top;
+  char             pad1[64 - sizeof (atomic_llong)];
+  atomic_llong     bottom;
+  char             pad2[64 - sizeof (atomic_llong)];
+  void * _Atomic * buffer;
+  size_t           buffer_mask;
+} WorkStealingDeque;
+
+WorkStealingDeque *
+ws_deque_new (void);
+
+/**
+ * Makes sure the deque can hold at least @p buffer_size elements.
+ *
+ * Must not be called while other threads are accessing the deque.
+ */
+NONNULL void
+ws_deque_reserve (WorkStealingDeque * self, size_t buffer_size);
+
+NONNULL void
+ws_deque_clear (WorkStealingDeque * self);
+
+/**
+ * Pushes an element to the bottom of the deque (owner only).
+ *
+ * @return Whether the element was pushed (false if full).
+ */
+HOT NONNULL bool
+ws_deque_push (WorkStealingDeque * self, void * data);
+
+/**
+ * Pops an element from the bottom of the deque (owner only).
+ *
+ * @return Whether an element was popped.
+ */
+HOT NONNULL bool
+ws_deque_pop (WorkStealingDeque * self, void ** data);
+
+/**
+ * Steals an element from the top of the deque.
+ *
+ * @return Whether an element was stolen. This can
+ *   return false if another thread won the race for the
+ *   same element.
+ */
+HOT NONNULL bool
+ws_deque_steal (WorkStealingDeque * self, void ** data);
+
+/**
+ * Returns an approximate number of elements in the deque.
+ */
+NONNULL size_t
+ws_deque_size (WorkStealingDeque * self);
+
+NONNULL void
+ws_deque_free (WorkStealingDeque * self);
+
+/**
+ * @}
+ */
+
+#endif
@@ -8,6 +8,8 @@
 #include "dsp/chord_region.h"
 #include "dsp/chord_track.h"
 #include "dsp/marker_track.h"
+#include "dsp/pool.h"
+#include "dsp/region_link_group_manager.h"
 #include "dsp/router.h"
 #include "dsp/track.h"
 #include "gui/backend/arranger_selections.h"
@@ -195,6 +197,37 @@ set_split_objects (
     }
 }
 
+/**
+ * Frees the split objects and (re)allocates room for the
+ * given number of split objects.
+ */
+static void
+alloc_split_objects (ArrangerSelectionsAction * self, int num_split_objs)
+{
+  for (int i = 0; i < self->num_split_objs; i++)
+    {
+      object_free_w_func_and_null (arranger_object_free, self->r1[i]);
+      object_free_w_func_and_null (arranger_object_free, self->r2[i]);
+    }
+  g_free_and_null (self->r1);
+  g_free_and_null (self->r2);
+  g_free_and_null (self->region_r1);
+  g_free_and_null (self->region_r2);
+  g_free_and_null (self->mn_r1);
+  g_free_and_null (self->mn_r2);
+
+  self->num_split_objs = num_split_objs;
+  if (num_split_objs == 0)
+    return;
+
+  self->r1 = object_new_n ((size_t) num_split_objs, ArrangerObject *);
+  self->r2 = object_new_n ((size_t) num_split_objs, ArrangerObject *);
+  self->region_r1 = object_new_n ((size_t) num_split_objs, ZRegion *);
+  self->region_r2 = object_new_n ((size_t) num_split_objs, ZRegion *);
+  self->mn_r1 = object_new_n ((size_t) num_split_objs, MidiNote *);
+  self->mn_r2 = object_new_n ((size_t) num_split_objs, MidiNote *);
+}
+
 static void
 free_split_objects (ArrangerSelectionsAction * self, int i)
 {
@@ -222,6 +255,43 @@ _create_action (ArrangerSelections * sel)
   return self;
 }
 
+/**
+ * Frees the children of the regions in the given
+ * (owned) selections.
+ *
+ * Used for actions that only change the regions
+ * themselves, so that the history only keeps what
+ * changed instead of full copies of the regions.
+ */
+static void
+strip_region_children (ArrangerSelections * sel)
+{
+  if (!sel || sel->type != ARRANGER_SELECTIONS_TYPE_TIMELINE)
+    return;
+
+  TimelineSelections * tl_sel = (TimelineSelections *) sel;
+  for (int i = 0; i < tl_sel->num_regions; i++)
+    {
+      ZRegion * r = tl_sel->regions[i];
+      for (int j = 0; j < r->num_midi_notes; j++)
+        {
+          arranger_object_free ((ArrangerObject *) r->midi_notes[j]);
+        }
+      r->num_midi_notes = 0;
+      for (int j = 0; j < r->num_aps; j++)
+        {
+          arranger_object_free ((ArrangerObject *) r->aps[j]);
+        }
+      r->num_aps = 0;
+      r->last_recorded_ap = NULL;
+      for (int j = 0; j < r->num_chord_objects; j++)
+        {
+          arranger_object_free ((ArrangerObject *) r->chord_objects[j]);
+        }
+      r->num_chord_objects = 0;
+    }
+}
+
 static ArrangerSelections *
 get_actual_arranger_selections (ArrangerSelectionsAction * self)
 {
@@ -292,6 +362,9 @@ arranger_selections_action_new_move_or_duplicate (
   if (move)
     {
       self->type = AS_ACTION_MOVE;
+
+      /* moving only needs the regions themselves */
+      strip_region_children (self->sel);
     }
   else
     {
@@ -446,8 +519,6 @@ arranger_selections_action_new_edit (
 
   self->edit_type = type;
 
-  set_selections (self, sel_before, F_CLONE, F_NOT_IS_AFTER);
-
   if (sel_after)
     {
       set_selections (self, sel_after, F_CLONE, F_IS_AFTER);
@@ -465,6 +536,21 @@ arranger_selections_action_new_edit (
       set_selections (self, sel_before, F_CLONE, F_IS_AFTER);
     }
 
+  /* these only change the regions themselves */
+  switch (type)
+    {
+    case ARRANGER_SELECTIONS_ACTION_EDIT_NAME:
+    case ARRANGER_SELECTIONS_ACTION_EDIT_POS:
+    case ARRANGER_SELECTIONS_ACTION_EDIT_PRIMITIVE:
+    case ARRANGER_SELECTIONS_ACTION_EDIT_FADES:
+    case ARRANGER_SELECTIONS_ACTION_EDIT_MUTE:
+      strip_region_children (self->sel);
+      strip_region_children (self->sel_after);
+      break;
+    default:
+      break;
+    }
+
   if (!already_edited)
     {
       self->first_run = 0;
@@ -686,7 +772,7 @@ arranger_selections_action_new_split (
 
   GPtrArray * split_objs_arr = g_ptr_array_new ();
   arranger_selections_get_all_objects (self->sel, split_objs_arr);
-  self->num_split_objs = (int) split_objs_arr->len;
+  alloc_split_objects (self, (int) split_objs_arr->len);
   g_ptr_array_unref (split_objs_arr);
 
   self->pos = *pos;
@@ -870,6 +956,7 @@ arranger_selections_action_clone (const ArrangerSelectionsAction * src)
   self->str = g_strdup (src->str);
   self->pos = src->pos;
 
+  alloc_split_objects (self, src->num_split_objs);
   for (int i = 0; i < src->num_split_objs; i++)
     {
       g_return_val_if_fail (src->r1[i], NULL);
@@ -893,7 +980,6 @@ arranger_selections_action_clone (const ArrangerSelectionsAction * src)
           g_return_val_if_reached (NULL);
         }
     }
-  self->num_split_objs = src->num_split_objs;
 
   self->first_run = src->first_run;
   if (src->opts)
@@ -2191,6 +2277,14 @@ do_or_undo_edit (ArrangerSelectionsAction * self, const int _do, GError ** error
             (unsigned_frame_t) (end.frames - start.frames);
           g_return_val_if_fail (num_frames == src_clip->num_frames, -1);
 
+          GError * err = NULL;
+          if (!audio_clip_load_frames (src_clip, &err))
+            {
+              PROPAGATE_PREFIXED_ERROR (
+                error, err, "%s", "Failed to load source clip");
+              return -1;
+            }
+
           char * src_clip_path =
             audio_clip_get_path_in_pool (src_clip, F_NOT_BACKUP);
           g_message (
@@ -2200,8 +2294,7 @@ do_or_undo_edit (ArrangerSelectionsAction * self, const int _do, GError ** error
           g_free (src_clip_path);
 
           /* replace the frames in the region */
-          GError * err = NULL;
-          bool     success = audio_region_replace_frames (
+          bool success = audio_region_replace_frames (
             r, src_clip->frames, (size_t) start.frames, num_frames,
             F_NO_DUPLICATE_CLIP, &err);
           if (!success)
@@ -2245,6 +2338,7 @@ do_or_undo_edit (ArrangerSelectionsAction * self, const int _do, GError ** error
                   obj->clip_start_pos = own_dest_obj->clip_start_pos;
                   obj->loop_start_pos = own_dest_obj->loop_start_pos;
                   obj->loop_end_pos = own_dest_obj->loop_end_pos;
+                  arranger_object_invalidate_index (obj);
                   break;
                 case ARRANGER_SELECTIONS_ACTION_EDIT_FADES:
                   obj->fade_in_pos = own_dest_obj->fade_in_pos;
@@ -2295,6 +2389,7 @@ do_or_undo_edit (ArrangerSelectionsAction * self, const int _do, GError ** error
                   obj->clip_start_pos = own_dest_obj->clip_start_pos;
                   obj->loop_start_pos = own_dest_obj->loop_start_pos;
                   obj->loop_end_pos = own_dest_obj->loop_end_pos;
+                  arranger_object_invalidate_index (obj);
                   switch (obj->type)
                     {
                     case ARRANGER_OBJECT_TYPE_MIDI_NOTE:
@@ -2344,6 +2439,19 @@ do_or_undo_edit (ArrangerSelectionsAction * self, const int _do, GError ** error
         } /* endif audio function */
     }     /* endif not first run */
 
+  /* the objects are also edited directly before the
+   * first run, so mark the drawings of their regions as
+   * outdated in any case */
+  for (size_t i = 0; i < dest_objs_arr->len; i++)
+    {
+      ArrangerObject * obj = arranger_object_find (
+        (ArrangerObject *) g_ptr_array_index (dest_objs_arr, i));
+      if (obj)
+        {
+          arranger_object_bump_content_version (obj);
+        }
+    }
+
   update_region_link_groups (dest_objs_arr);
 
   g_ptr_array_unref (src_objs_arr);
@@ -2440,6 +2548,9 @@ do_or_undo_split (ArrangerSelectionsAction * self, const int _do, GError ** erro
   GPtrArray * objs_arr = g_ptr_array_new ();
   arranger_selections_get_all_objects (self->sel, objs_arr);
 
+  if (_do)
+    alloc_split_objects (self, (int) objs_arr->len);
+
   for (size_t i = 0; i < objs_arr->len; i++)
     {
       ArrangerObject * own_obj =
@@ -2514,10 +2625,8 @@ do_or_undo_split (ArrangerSelectionsAction * self, const int _do, GError ** erro
         }
     }
 
-  if (_do)
-    self->num_split_objs = (int) objs_arr->len;
-  else
-    self->num_split_objs = 0;
+  if (!_do)
+    alloc_split_objects (self, 0);
 
   g_ptr_array_unref (objs_arr);
 
@@ -2818,6 +2927,126 @@ do_or_undo_quantize (
   return 0;
 }
 
+/**
+ * Adds the identifier of @p id and of the regions linked
+ * to it to @p touched_ids, and their tracks to @p tracks.
+ */
+static void
+add_touched_region (
+  const RegionIdentifier * id,
+  GHashTable *             touched_ids,
+  GHashTable *             tracks)
+{
+  g_hash_table_add (touched_ids, (gpointer) id);
+  Track * track =
+    tracklist_find_track_by_name_hash (TRACKLIST, id->track_name_hash);
+  if (track)
+    g_hash_table_add (tracks, track);
+
+  /* linked regions change along with the region */
+  if (
+    id->link_group < 0
+    || id->link_group >= REGION_LINK_GROUP_MANAGER->num_groups)
+    return;
+
+  RegionLinkGroup * group = region_link_group_manager_get_group (
+    REGION_LINK_GROUP_MANAGER, id->link_group);
+  for (int i = 0; i < group->num_ids; i++)
+    {
+      const RegionIdentifier * linked_id = &group->ids[i];
+      g_hash_table_add (touched_ids, (gpointer) linked_id);
+      track = tracklist_find_track_by_name_hash (
+        TRACKLIST, linked_id->track_name_hash);
+      if (track)
+        g_hash_table_add (tracks, track);
+    }
+}
+
+static void
+add_touched_object (
+  ArrangerObject * obj,
+  GHashTable *     touched_ids,
+  GHashTable *     tracks)
+{
+  if (obj->type == ARRANGER_OBJECT_TYPE_REGION)
+    {
+      add_touched_region (&((ZRegion *) obj)->id, touched_ids, tracks);
+    }
+  else if (arranger_object_owned_by_region (obj))
+    {
+      add_touched_region (&obj->region_id, touched_ids, tracks);
+    }
+  else if (obj->type == ARRANGER_OBJECT_TYPE_SCALE_OBJECT)
+    {
+      g_hash_table_add (tracks, P_CHORD_TRACK);
+    }
+  else if (obj->type == ARRANGER_OBJECT_TYPE_MARKER)
+    {
+      g_hash_table_add (tracks, P_MARKER_TRACK);
+    }
+}
+
+/**
+ * Updates the playback snapshots of the tracks affected by
+ * the action.
+ *
+ * Only the regions touched by the action (or linked to
+ * them) are cloned again, so this is cheap enough to do
+ * while the engine is running.
+ */
+static void
+update_playback_snapshots (ArrangerSelectionsAction * self)
+{
+  GHashTable * touched_ids = g_hash_table_new (
+    region_identifier_get_hash, region_identifier_is_equal_func);
+  GHashTable * tracks = g_hash_table_new (NULL, NULL);
+
+  /* the identifiers are borrowed from these objects, so
+   * keep them around until the snapshots are updated */
+  GPtrArray * objs = g_ptr_array_new ();
+  arranger_selections_get_all_objects (self->sel, objs);
+  if (self->sel_after)
+    arranger_selections_get_all_objects (self->sel_after, objs);
+  ArrangerSelections * actual_sel = get_actual_arranger_selections (self);
+  if (actual_sel)
+    arranger_selections_get_all_objects (actual_sel, objs);
+  for (guint i = 0; i < objs->len; i++)
+    {
+      ArrangerObject * obj = (ArrangerObject *) g_ptr_array_index (objs, i);
+      add_touched_object (obj, touched_ids, tracks);
+    }
+
+  if (self->sel->type == ARRANGER_SELECTIONS_TYPE_AUDIO)
+    {
+      add_touched_region (
+        &((AudioSelections *) self->sel)->region_id, touched_ids, tracks);
+      add_touched_region (&AUDIO_SELECTIONS->region_id, touched_ids, tracks);
+    }
+
+  /* objects moved to other tracks may not be selected
+   * anymore, so check all tracks for new regions */
+  if (self->delta_tracks != 0 || self->target_port)
+    {
+      for (int i = 0; i < TRACKLIST->num_tracks; i++)
+        {
+          g_hash_table_add (tracks, TRACKLIST->tracks[i]);
+        }
+    }
+
+  GHashTableIter iter;
+  gpointer       key;
+  g_hash_table_iter_init (&iter, tracks);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      track_update_playback_snapshot ((Track *) key, touched_ids);
+    }
+  audio_pool_update_stream_anchors (AUDIO_POOL);
+
+  g_ptr_array_unref (objs);
+  g_hash_table_destroy (tracks);
+  g_hash_table_destroy (touched_ids);
+}
+
 static int
 do_or_undo (ArrangerSelectionsAction * self, bool _do, GError ** error)
 {
@@ -2866,7 +3095,7 @@ do_or_undo (ArrangerSelectionsAction * self, bool _do, GError ** error)
     }
 
   /* update playback caches */
-  tracklist_set_caches (TRACKLIST, CACHE_TYPE_PLAYBACK_SNAPSHOTS);
+  update_playback_snapshots (self);
 
   /* reset new_lane_created */
   for (int i = 0; i < TRACKLIST->num_tracks; i++)
@@ -2993,6 +3222,7 @@ void
 arranger_selections_action_free (ArrangerSelectionsAction * self)
 {
   object_free_w_func_and_null (arranger_selections_free_full, self->sel);
+  alloc_split_objects (self, 0);
 
   object_zero_and_free (self);
 }
@@ -8,6 +8,7 @@
 #include "gui/backend/event_manager.h"
 #include "gui/widgets/main_window.h"
 #include "project.h"
+#include "project/autosave_journal.h"
 #include "utils/error.h"
 #include "utils/objects.h"
 #include "utils/stack.h"
@@ -39,6 +40,8 @@ undo_manager_init_loaded (UndoManager * self)
   g_message ("%s: loading...", __func__);
   undo_stack_init_loaded (self->undo_stack);
   undo_stack_init_loaded (self->redo_stack);
+  undo_stack_update_mem_used (self->undo_stack);
+  undo_stack_update_mem_used (self->redo_stack);
   zix_sem_init (&self->action_sem, 1);
   g_message ("%s: done", __func__);
 }
@@ -70,14 +73,17 @@ undo_manager_new (void)
  *   otherwise NULL if undoing/redoing.
  * @param main_stack Undo stack if undoing, redo
  *   stack if doing.
+ * @param journal_op How to record the action in the
+ *   autosave journal.
  */
 static int
 do_or_undo_action (
-  UndoManager *    self,
-  UndoableAction * action,
-  UndoStack *      main_stack,
-  UndoStack *      opposite_stack,
-  GError **        error)
+  UndoManager *     self,
+  UndoableAction *  action,
+  UndoStack *       main_stack,
+  UndoStack *       opposite_stack,
+  AutosaveJournalOp journal_op,
+  GError **         error)
 {
   bool need_pop = false;
   if (!action)
@@ -94,6 +100,15 @@ do_or_undo_action (
       event_manager_process_now (EVENT_MANAGER);
     }
 
+  /* the journal needs the state the action is undone
+   * from, and the state after doing it otherwise */
+  AutosaveJournal * journal = PROJECT ? PROJECT->autosave_journal : NULL;
+  char *            journal_record = NULL;
+  if (journal && journal_op == AUTOSAVE_JOURNAL_OP_UNDO)
+    {
+      journal_record = autosave_journal_serialize_action (action, journal_op);
+    }
+
   int ret = 0;
   if (main_stack == self->undo_stack)
     {
@@ -106,6 +121,7 @@ do_or_undo_action (
   else
     {
       /* invalid stack */
+      g_free (journal_record);
       g_critical ("%s: invalid stack (err %d)", __func__, ret);
       return -1;
     }
@@ -113,6 +129,7 @@ do_or_undo_action (
   /* if error return */
   if (ret != 0)
     {
+      g_free (journal_record);
       zix_sem_post (&self->action_sem);
       g_warning ("%s: action not performed (err %d)", __func__, ret);
       return -1;
@@ -123,22 +140,25 @@ do_or_undo_action (
       undo_stack_pop (main_stack);
     }
 
+  if (journal)
+    {
+      if (journal_op != AUTOSAVE_JOURNAL_OP_UNDO)
+        {
+          journal_record =
+            autosave_journal_serialize_action (action, journal_op);
+        }
+      autosave_journal_append (journal, journal_record);
+    }
+
   /* if redo stack is locked don't alter it */
   if (self->redo_stack_locked && opposite_stack == self->redo_stack)
     return 0;
 
-  /* if the redo stack is full, delete the last
-   * element */
+  /* if the redo stack is full, delete the oldest
+   * action */
   if (undo_stack_is_full (opposite_stack))
     {
-      UndoableAction * action_to_delete =
-        (UndoableAction *) undo_stack_pop_last (opposite_stack);
-
-      /* TODO create functions to delete
-       * unnecessary files held by the action
-       * (eg, something that calls
-       * plugin_delete_state_files()) */
-      undoable_action_free (action_to_delete);
+      undo_stack_remove_oldest (opposite_stack);
     }
 
   /* push action to the redo stack */
@@ -181,7 +201,8 @@ undo_manager_undo (UndoManager * self, GError ** error)
 
       GError * err = NULL;
       ret = do_or_undo_action (
-        self, NULL, self->undo_stack, self->redo_stack, &err);
+        self, NULL, self->undo_stack, self->redo_stack,
+        AUTOSAVE_JOURNAL_OP_UNDO, &err);
       if (ret != 0)
         {
           PROPAGATE_PREFIXED_ERROR (
@@ -231,7 +252,8 @@ undo_manager_redo (UndoManager * self, GError ** error)
 
       GError * err = NULL;
       ret = do_or_undo_action (
-        self, NULL, self->redo_stack, self->undo_stack, &err);
+        self, NULL, self->redo_stack, self->undo_stack,
+        AUTOSAVE_JOURNAL_OP_REDO, &err);
       if (ret != 0)
         {
           PROPAGATE_PREFIXED_ERROR (
@@ -273,8 +295,9 @@ undo_manager_perform (UndoManager * self, UndoableAction * action, GError ** err
 
   /* if error return */
   GError * err = NULL;
-  int      ret =
-    do_or_undo_action (self, action, self->redo_stack, self->undo_stack, &err);
+  int      ret = do_or_undo_action (
+    self, action, self->redo_stack, self->undo_stack,
+    AUTOSAVE_JOURNAL_OP_PERFORM, &err);
   if (ret != 0)
     {
       PROPAGATE_PREFIXED_ERROR (
@@ -301,6 +324,62 @@ undo_manager_perform (UndoManager * self, UndoableAction * action, GError ** err
   return 0;
 }
 
+/**
+ * Re-applies an action recorded in the autosave
+ * journal, updating the stacks the same way as when it
+ * was recorded.
+ *
+ * @return Non-zero if error.
+ */
+int
+undo_manager_replay (
+  UndoManager *     self,
+  UndoableAction *  action,
+  AutosaveJournalOp op,
+  GError **         error)
+{
+  zix_sem_wait (&self->action_sem);
+
+  bool     undo = op == AUTOSAVE_JOURNAL_OP_UNDO;
+  GError * err = NULL;
+  int      ret = do_or_undo_action (
+    self, action, undo ? self->undo_stack : self->redo_stack,
+    undo ? self->redo_stack : self->undo_stack, op, &err);
+  if (ret != 0)
+    {
+      PROPAGATE_PREFIXED_ERROR (
+        error, err, "%s", _ ("Failed to replay action"));
+      return ret;
+    }
+
+  /* the replayed action replaces the one it was
+   * recorded from */
+  UndoStack * recorded_stack = NULL;
+  switch (op)
+    {
+    case AUTOSAVE_JOURNAL_OP_PERFORM:
+      if (!self->redo_stack_locked)
+        {
+          undo_stack_clear (self->redo_stack, true);
+        }
+      break;
+    case AUTOSAVE_JOURNAL_OP_UNDO:
+      recorded_stack = self->undo_stack;
+      break;
+    case AUTOSAVE_JOURNAL_OP_REDO:
+      recorded_stack = self->redo_stack;
+      break;
+    }
+  if (recorded_stack && !undo_stack_is_empty (recorded_stack))
+    {
+      undoable_action_free (undo_stack_pop (recorded_stack));
+    }
+
+  zix_sem_post (&self->action_sem);
+
+  return 0;
+}
+
 /**
  * Returns whether the given clip is used by any
  * stack.
@@ -1,15 +1,392 @@
 // SPDX-FileCopyrightText: © 2020-2022 Alexandros Theodotou <alex@zrythm.org>
 // SPDX-License-Identifier: LicenseRef-ZrythmLicense
 
+#include <stdio.h>
+
 #include "actions/undo_stack.h"
+#include "dsp/engine.h"
+#include "dsp/pool.h"
+#include "project.h"
 #include "settings/settings.h"
 #include "utils/arrays.h"
+#include "utils/compression.h"
+#include "utils/error.h"
+#include "utils/io.h"
 #include "utils/mem.h"
 #include "utils/objects.h"
 #include "utils/stack.h"
 #include "zrythm.h"
 #include "zrythm_app.h"
 
+#include <glib/gstdio.h>
+
+typedef enum
+{
+  Z_ACTIONS_UNDO_STACK_ERROR_FAILED,
+} ZActionsUndoStackError;
+
+#define Z_ACTIONS_UNDO_STACK_ERROR z_actions_undo_stack_error_quark ()
+GQuark
+z_actions_undo_stack_error_quark (void);
+G_DEFINE_QUARK (
+  z - actions - undo - stack - error - quark,
+  z_actions_undo_stack_error)
+
+/**
+ * Returns the memory budget from the settings, in bytes.
+ */
+static size_t
+get_mem_budget (void)
+{
+  if (ZRYTHM_TESTING)
+    return 0;
+
+  return (size_t) g_settings_get_uint (S_P_EDITING_UNDO, "undo-memory-budget")
+         * 1024 * 1024;
+}
+
+static guint
+get_num_spilled (const UndoStack * self)
+{
+  return self->spilled ? self->spilled->len : 0;
+}
+
+/**
+ * Returns the number of unused bytes the spill file may
+ * have before it is compacted.
+ */
+static size_t
+get_min_spill_dead_size (void)
+{
+  if (ZRYTHM_TESTING)
+    return 0;
+
+  return 4 * 1024 * 1024;
+}
+
+/**
+ * Rewrites the spill file with only the spilled actions
+ * still in use.
+ *
+ * On failure the old file is kept as is.
+ */
+static bool
+compact_spill_file (UndoStack * self, GError ** error)
+{
+  GError * err = NULL;
+  char *   new_path = NULL;
+  int fd = g_file_open_tmp ("zrythm-undo-XXXXXX", &new_path, &err);
+  if (fd < 0)
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, "Failed to create undo spill file");
+      return false;
+    }
+  g_close (fd, NULL);
+
+  guint    len = self->spilled->len;
+  gint64 * new_offsets = object_new_n (len, gint64);
+  FILE *   src = g_fopen (self->spill_path, "rb");
+  FILE *   dest = g_fopen (new_path, "wb");
+  bool     success = src != NULL && dest != NULL;
+  gint64   offset = 0;
+  for (guint i = 0; success && i < len; i++)
+    {
+      UndoStackSpilledAction * spilled =
+        &g_array_index (self->spilled, UndoStackSpilledAction, i);
+      char * data = g_malloc (spilled->size);
+      success =
+        fseek (src, (long) spilled->offset, SEEK_SET) == 0
+        && fread (data, 1, spilled->size, src) == spilled->size
+        && fwrite (data, 1, spilled->size, dest) == spilled->size;
+      g_free (data);
+      new_offsets[i] = offset;
+      offset += (gint64) spilled->size;
+    }
+  if (src)
+    {
+      fclose (src);
+    }
+  if (dest)
+    {
+      success = fclose (dest) == 0 && success;
+    }
+
+  if (!success)
+    {
+      io_remove (new_path);
+      g_set_error (
+        error, Z_ACTIONS_UNDO_STACK_ERROR, Z_ACTIONS_UNDO_STACK_ERROR_FAILED,
+        "Failed to compact undo spill file %s", self->spill_path);
+      g_free (new_path);
+      free (new_offsets);
+      return false;
+    }
+
+  for (guint i = 0; i < len; i++)
+    {
+      g_array_index (self->spilled, UndoStackSpilledAction, i).offset =
+        new_offsets[i];
+    }
+  free (new_offsets);
+  io_remove (self->spill_path);
+  g_free (self->spill_path);
+  self->spill_path = new_path;
+  self->spill_dead_size = 0;
+
+  return true;
+}
+
+/**
+ * Frees the spilled action at the given index.
+ */
+static void
+remove_spilled (UndoStack * self, guint idx)
+{
+  UndoStackSpilledAction * spilled =
+    &g_array_index (self->spilled, UndoStackSpilledAction, idx);
+  self->spill_dead_size += spilled->size;
+  g_array_unref (spilled->clip_pool_ids);
+  g_array_remove_index (self->spilled, idx);
+
+  if (!self->spill_path)
+    return;
+
+  /* start over with an empty file */
+  if (self->spilled->len == 0)
+    {
+      io_remove (self->spill_path);
+      g_free_and_null (self->spill_path);
+      self->spill_dead_size = 0;
+      return;
+    }
+
+  /* rewrite the file once most of it is unused */
+  size_t live_size = 0;
+  for (guint i = 0; i < self->spilled->len; i++)
+    {
+      live_size +=
+        g_array_index (self->spilled, UndoStackSpilledAction, i).size;
+    }
+  if (
+    self->spill_dead_size > live_size
+    && self->spill_dead_size >= get_min_spill_dead_size ())
+    {
+      GError * err = NULL;
+      if (!compact_spill_file (self, &err))
+        {
+          g_warning ("%s", err->message);
+          g_error_free (err);
+        }
+    }
+}
+
+/**
+ * Frees all the spilled actions.
+ */
+static void
+clear_spilled (UndoStack * self)
+{
+  for (guint i = 0; i < get_num_spilled (self); i++)
+    {
+      g_array_unref (
+        g_array_index (self->spilled, UndoStackSpilledAction, i)
+          .clip_pool_ids);
+    }
+  if (self->spilled)
+    {
+      g_array_set_size (self->spilled, 0);
+    }
+
+  if (self->spill_path)
+    {
+      io_remove (self->spill_path);
+      g_free_and_null (self->spill_path);
+    }
+  self->spill_dead_size = 0;
+}
+
+/**
+ * Compresses the action at the bottom of the stack,
+ * appends it to the spill file and frees it.
+ *
+ * @return Whether the action was spilled.
+ */
+static bool
+spill_oldest (UndoStack * self, GError ** error)
+{
+  UndoableAction * action = (UndoableAction *) self->stack->elements[0];
+
+  /* plugin states are only kept while plugins in memory
+   * refer to them (see plugin_get_all()) */
+  GPtrArray * plugins = g_ptr_array_new ();
+  undoable_action_get_plugins (action, plugins);
+  bool has_plugins = plugins->len > 0;
+  g_ptr_array_unref (plugins);
+  if (has_plugins)
+    {
+      g_set_error_literal (
+        error, Z_ACTIONS_UNDO_STACK_ERROR, Z_ACTIONS_UNDO_STACK_ERROR_FAILED,
+        "Action refers to plugin states");
+      return false;
+    }
+
+  GError * err = NULL;
+  size_t   json_len;
+  char *   json =
+    undoable_action_serialize_to_json_str (action, &json_len, &err);
+  if (!json)
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (error, err, "Failed to spill action");
+      return false;
+    }
+  size_t data_size;
+  char * data = compression_compress (json, json_len, &data_size, &err);
+  free (json);
+  if (!data)
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (error, err, "Failed to spill action");
+      return false;
+    }
+
+  if (!self->spill_path)
+    {
+      int fd =
+        g_file_open_tmp ("zrythm-undo-XXXXXX", &self->spill_path, &err);
+      if (fd < 0)
+        {
+          free (data);
+          PROPAGATE_PREFIXED_ERROR_LITERAL (
+            error, err, "Failed to create undo spill file");
+          return false;
+        }
+      g_close (fd, NULL);
+    }
+
+  FILE * f = g_fopen (self->spill_path, "ab");
+  bool   success = f != NULL && fseek (f, 0, SEEK_END) == 0;
+  long   offset = success ? ftell (f) : -1;
+  success =
+    success && offset >= 0 && fwrite (data, 1, data_size, f) == data_size;
+  if (f)
+    {
+      success = fclose (f) == 0 && success;
+    }
+  free (data);
+  if (!success)
+    {
+      g_set_error (
+        error, Z_ACTIONS_UNDO_STACK_ERROR, Z_ACTIONS_UNDO_STACK_ERROR_FAILED,
+        "Failed to write undo spill file %s", self->spill_path);
+      return false;
+    }
+
+  UndoStackSpilledAction spilled = {
+    .offset = offset,
+    .size = data_size,
+    .clip_pool_ids = g_array_new (false, false, sizeof (int)),
+  };
+  if (undoable_action_can_contain_clip (action) && AUDIO_ENGINE && AUDIO_POOL)
+    {
+      for (int i = 0; i < AUDIO_POOL->num_clips; i++)
+        {
+          AudioClip * clip = AUDIO_POOL->clips[i];
+          if (clip && undoable_action_contains_clip (action, clip))
+            {
+              g_array_append_val (spilled.clip_pool_ids, clip->pool_id);
+            }
+        }
+    }
+  if (!self->spilled)
+    {
+      self->spilled =
+        g_array_new (false, false, sizeof (UndoStackSpilledAction));
+    }
+  g_array_append_val (self->spilled, spilled);
+
+  undoable_action_free (undo_stack_pop_last (self));
+
+  return true;
+}
+
+/**
+ * Spills the oldest actions until the stack is within
+ * its memory budget.
+ */
+static void
+enforce_mem_budget (UndoStack * self)
+{
+  /* the newest action always stays in memory */
+  while (
+    self->mem_budget > 0 && self->mem_used > self->mem_budget
+    && stack_size (self->stack) > 1)
+    {
+      GError * err = NULL;
+      if (!spill_oldest (self, &err))
+        {
+          /* the spilled actions are older than this one
+           * so they can't be undone without it */
+          g_message (
+            "dropping the oldest undo history: %s", err->message);
+          g_error_free (err);
+          clear_spilled (self);
+          undoable_action_free (undo_stack_pop_last (self));
+        }
+    }
+}
+
+/**
+ * Moves the newest spilled action back to the (empty)
+ * stack.
+ */
+static void
+restore_newest_spilled (UndoStack * self)
+{
+  guint                    idx = self->spilled->len - 1;
+  UndoStackSpilledAction * spilled =
+    &g_array_index (self->spilled, UndoStackSpilledAction, idx);
+
+  char * data = g_malloc (spilled->size);
+  FILE * f = g_fopen (self->spill_path, "rb");
+  bool   success =
+    f != NULL && fseek (f, (long) spilled->offset, SEEK_SET) == 0
+    && fread (data, 1, spilled->size, f) == spilled->size;
+  if (f)
+    {
+      fclose (f);
+    }
+
+  UndoableAction * action = NULL;
+  GError *         err = NULL;
+  if (success)
+    {
+      size_t json_len;
+      char * json =
+        compression_decompress_stream (data, spilled->size, &json_len, &err);
+      if (json)
+        {
+          action = undoable_action_new_from_json_str (json, json_len, &err);
+          free (json);
+        }
+    }
+  g_free (data);
+  remove_spilled (self, idx);
+
+  if (!action)
+    {
+      g_warning (
+        "failed to restore spilled undo action, dropping the older "
+        "history: %s",
+        err ? err->message : "failed to read spill file");
+      if (err)
+        g_error_free (err);
+      clear_spilled (self);
+      return;
+    }
+
+  undo_stack_push (self, action);
+}
+
 NONNULL size_t
 undo_stack_get_total_cached_actions (UndoStack * self)
 {
@@ -86,6 +463,28 @@ undo_stack_init_loaded (UndoStack * self)
     self->stack->top + 1 == (int) undo_stack_get_total_cached_actions (self));
 }
 
+/**
+ * Calculates the memory used by the actions on the stack
+ * and spills the oldest ones if over budget.
+ */
+void
+undo_stack_update_mem_used (UndoStack * self)
+{
+  self->mem_budget = get_mem_budget ();
+  self->mem_used = 0;
+  if (self->mem_budget == 0)
+    return;
+
+  for (int i = 0; i <= self->stack->top; i++)
+    {
+      UndoableAction * ua = (UndoableAction *) self->stack->elements[i];
+      ua->size = undoable_action_get_size (ua);
+      self->mem_used += ua->size;
+    }
+
+  enforce_mem_budget (self);
+}
+
 UndoStack *
 undo_stack_new (void)
 {
@@ -100,6 +499,7 @@ undo_stack_new (void)
       : g_settings_get_int (S_P_EDITING_UNDO, "undo-stack-length");
   self->stack = stack_new (undo_stack_length);
   self->stack->top = -1;
+  self->mem_budget = get_mem_budget ();
 
   return self;
 }
@@ -208,6 +608,14 @@ undo_stack_push (UndoStack * self, UndoableAction * action)
       APPEND_ELEMENT (CHORD, Chord, chord);
       APPEND_ELEMENT (ARRANGER_SELECTIONS, ArrangerSelections, as);
     }
+
+  action->size = 0;
+  if (self->mem_budget > 0)
+    {
+      action->size = undoable_action_get_size (action);
+      self->mem_used += action->size;
+      enforce_mem_budget (self);
+    }
 }
 
 static bool
@@ -256,6 +664,8 @@ remove_action (UndoStack * self, UndoableAction * action)
       break;
     }
 
+  self->mem_used -= MIN (action->size, self->mem_used);
+
   /* re-set the indices */
   for (int i = 0; i <= g_atomic_int_get (&self->stack->top); i++)
     {
@@ -276,6 +686,12 @@ undo_stack_pop (UndoStack * self)
   int removed = remove_action (self, action);
   g_return_val_if_fail (removed, action);
 
+  /* bring back the next action to undo/redo */
+  if (undo_stack_is_empty (self) && get_num_spilled (self) > 0)
+    {
+      restore_newest_spilled (self);
+    }
+
   /* return it */
   return action;
 }
@@ -301,9 +717,53 @@ undo_stack_pop_last (UndoStack * self)
   return action;
 }
 
+/**
+ * Returns whether the stack has the maximum number of
+ * actions, including spilled ones.
+ */
+bool
+undo_stack_is_full (UndoStack * self)
+{
+  if (self->stack->max_length == -1)
+    return false;
+
+  return stack_size (self->stack) + (int) get_num_spilled (self)
+         >= self->stack->max_length;
+}
+
+/**
+ * Frees the oldest action, which is either spilled or at
+ * the bottom of the stack.
+ */
+void
+undo_stack_remove_oldest (UndoStack * self)
+{
+  if (get_num_spilled (self) > 0)
+    {
+      remove_spilled (self, 0);
+      return;
+    }
+
+  /* TODO create functions to delete unnecessary files
+   * held by the action (eg, something that calls
+   * plugin_delete_state_files()) */
+  undoable_action_free (undo_stack_pop_last (self));
+}
+
 bool
 undo_stack_contains_clip (UndoStack * self, AudioClip * clip)
 {
+  for (guint i = 0; i < get_num_spilled (self); i++)
+    {
+      UndoStackSpilledAction * spilled =
+        &g_array_index (self->spilled, UndoStackSpilledAction, i);
+      for (guint j = 0; j < spilled->clip_pool_ids->len; j++)
+        {
+          if (g_array_index (spilled->clip_pool_ids, int, j) == clip->pool_id)
+            return true;
+        }
+    }
+
   for (int i = 0; i <= self->stack->top; i++)
     {
       UndoableAction * ua = (UndoableAction *) self->stack->elements[i];
@@ -354,6 +814,7 @@ void
 undo_stack_clear (UndoStack * self, bool free)
 {
   g_debug ("clearing undo stack...");
+  clear_spilled (self);
   while (!undo_stack_is_empty (self))
     {
       UndoableAction * ua = undo_stack_pop (self);
@@ -369,6 +830,12 @@ undo_stack_free (UndoStack * self)
 {
   g_message ("%s: freeing...", __func__);
 
+  clear_spilled (self);
+  if (self->spilled)
+    {
+      g_array_unref (self->spilled);
+    }
+
   while (!undo_stack_is_empty (self))
     {
       UndoableAction * ua = undo_stack_pop (self);
@@ -8,13 +8,30 @@
 #include "actions/transport_action.h"
 #include "actions/undoable_action.h"
 #include "dsp/engine.h"
+#include "io/serialization/actions.h"
 #include "project.h"
+#include "utils/error.h"
 #include "utils/flags.h"
 #include "zrythm_app.h"
 
 #include <glib.h>
 #include <glib/gi18n.h>
 
+#include <yyjson.h>
+
+typedef enum
+{
+  Z_ACTIONS_UNDOABLE_ACTION_ERROR_FAILED,
+} ZActionsUndoableActionError;
+
+#define Z_ACTIONS_UNDOABLE_ACTION_ERROR \
+  z_actions_undoable_action_error_quark ()
+GQuark
+z_actions_undoable_action_error_quark (void);
+G_DEFINE_QUARK (
+  z - actions - undoable - action - error - quark,
+  z_actions_undoable_action_error)
+
 void
 undoable_action_init_loaded (UndoableAction * self)
 {
@@ -119,8 +136,13 @@ undoable_action_needs_pause (UndoableAction * self)
     {
     case UA_ARRANGER_SELECTIONS:
       {
-        /* always needs a pause to update the track playback snapshots */
-        return true;
+        /* edits inside regions only swap the playback
+         * snapshots of the affected tracks, but other edits
+         * may add or remove lanes or pool clips that the
+         * engine reads directly */
+        ArrangerSelectionsAction * action = (ArrangerSelectionsAction *) self;
+        return action->sel->type == ARRANGER_SELECTIONS_TYPE_TIMELINE
+               || action->sel->type == ARRANGER_SELECTIONS_TYPE_AUDIO;
       }
       break;
     case UA_TRACKLIST_SELECTIONS:
@@ -472,6 +494,81 @@ undoable_action_to_string (UndoableAction * ua)
 #undef STRINGIZE_UA
 }
 
+char *
+undoable_action_serialize_to_json_str (
+  const UndoableAction * self,
+  size_t *               len,
+  GError **              error)
+{
+  yyjson_mut_doc * doc = yyjson_mut_doc_new (NULL);
+  yyjson_mut_val * root = yyjson_mut_obj (doc);
+  yyjson_mut_doc_set_root (doc, root);
+
+  char *   json = NULL;
+  GError * err = NULL;
+  if (undoable_action_serialize_typed_to_json (doc, root, self, &err))
+    {
+      json = yyjson_mut_write (doc, YYJSON_WRITE_NOFLAG, len);
+    }
+  else
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, "Failed to serialize action");
+    }
+  yyjson_mut_doc_free (doc);
+
+  return json;
+}
+
+UndoableAction *
+undoable_action_new_from_json_str (
+  const char * str,
+  size_t       len,
+  GError **    error)
+{
+  yyjson_doc * doc = yyjson_read (str, len, 0);
+  yyjson_val * root = yyjson_doc_get_root (doc);
+  if (!root)
+    {
+      yyjson_doc_free (doc);
+      g_set_error_literal (
+        error, Z_ACTIONS_UNDOABLE_ACTION_ERROR,
+        Z_ACTIONS_UNDOABLE_ACTION_ERROR_FAILED, "Invalid action JSON");
+      return NULL;
+    }
+
+  GError *         err = NULL;
+  UndoableAction * self =
+    undoable_action_deserialize_typed_from_json (doc, root, &err);
+  yyjson_doc_free (doc);
+  if (!self)
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, "Failed to deserialize action");
+      return NULL;
+    }
+  undoable_action_init_loaded (self);
+
+  return self;
+}
+
+size_t
+undoable_action_get_size (const UndoableAction * self)
+{
+  size_t   len = 0;
+  GError * err = NULL;
+  char *   json = undoable_action_serialize_to_json_str (self, &len, &err);
+  if (!json)
+    {
+      g_warning ("%s", err->message);
+      g_error_free (err);
+      return 0;
+    }
+  free (json);
+
+  return len;
+}
+
 void
 undoable_action_free (UndoableAction * self)
 {
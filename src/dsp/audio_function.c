@@ -321,8 +321,9 @@ audio_function_apply (
   g_return_val_if_fail (r, false);
   Track * tr = arranger_object_get_track ((ArrangerObject *) r);
   g_return_val_if_fail (tr, false);
-  AudioClip * orig_clip = audio_region_get_clip (r);
-  g_return_val_if_fail (orig_clip, false);
+  AudioClip * orig_clip = audio_region_load_clip (r, error);
+  if (!orig_clip)
+    return false;
 
   Position init_pos;
   position_init (&init_pos);
@@ -6,8 +6,10 @@
 #include "dsp/audio_region.h"
 #include "dsp/channel.h"
 #include "dsp/clip.h"
+#include "dsp/clip_stream.h"
 #include "dsp/fade.h"
 #include "dsp/pool.h"
+#include "dsp/router.h"
 #include "dsp/stretcher.h"
 #include "dsp/tempo_track.h"
 #include "dsp/track.h"
@@ -118,7 +120,7 @@ audio_region_new (
     {
       self->pool_id = pool_id;
       clip = AUDIO_POOL->clips[pool_id];
-      g_return_val_if_fail (clip && clip->frames, NULL);
+      g_return_val_if_fail (clip && (clip->frames || clip->stream), NULL);
     }
 
   /* set end pos to sample end */
@@ -173,7 +175,33 @@ audio_region_get_clip (const ZRegion * self)
       clip = self->clip;
     }
 
-  g_return_val_if_fail (clip && clip->frames && clip->num_frames > 0, NULL);
+  g_return_val_if_fail (clip && clip->num_frames > 0, NULL);
+  g_return_val_if_fail (clip->frames || clip->stream, NULL);
+
+  return clip;
+}
+
+/**
+ * Returns the audio clip associated with the Region
+ * with its frames loaded in memory.
+ */
+AudioClip *
+audio_region_load_clip (const ZRegion * self, GError ** error)
+{
+  g_return_val_if_fail (
+    !(ROUTER && router_is_processing_thread (ROUTER)), NULL);
+
+  AudioClip * clip = audio_region_get_clip (self);
+  g_return_val_if_fail (clip, NULL);
+
+  GError * err = NULL;
+  if (!audio_clip_load_frames (clip, &err))
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, _ ("Failed to load audio clip"));
+      return NULL;
+    }
+  g_return_val_if_fail (clip->frames, NULL);
 
   return clip;
 }
@@ -209,8 +237,9 @@ audio_region_replace_frames (
   bool             duplicate_clip,
   GError **        error)
 {
-  AudioClip * clip = audio_region_get_clip (self);
-  g_return_val_if_fail (clip, false);
+  AudioClip * clip = audio_region_load_clip (self, error);
+  if (!clip)
+    return false;
 
   if (duplicate_clip)
     {
@@ -236,6 +265,7 @@ audio_region_replace_frames (
    * the actual file write is skipped to save time */
   g_free_and_null (clip->file_hash);
 
+  audio_clip_discard_peaks (clip);
   dsp_copy (
     &clip->frames[start_frame * clip->channels], frames,
     num_frames * clip->channels);
@@ -250,6 +280,11 @@ audio_region_replace_frames (
       return false;
     }
 
+  if (self->read_from_pool)
+    {
+      audio_pool_gen_clip_peaks (AUDIO_POOL, clip);
+    }
+
   self->last_clip_change = g_get_monotonic_time ();
 
   return true;
@@ -294,97 +329,26 @@ timestretch_buf (
 }
 
 /**
- * Fills audio data from the region.
+ * Fills the ports frame by frame, timestretching the clip.
  *
- * @note The caller already splits calls to this
- *   function at each sub-loop inside the region,
- *   so region loop related logic is not needed.
- *
- * @param time_nfo Time info. The start position
- *   is guaranteed to be in the region
- * @param stereo_ports StereoPorts to fill.
+ * @return Whether successful.
  */
-void
-audio_region_fill_stereo_ports (
+static bool
+fill_stereo_ports_w_timestretch (
   ZRegion *                           self,
+  Track *                             track,
+  AudioClip *                         clip,
   const EngineProcessTimeInfo * const time_nfo,
+  signed_frame_t                      r_local_frames_at_start,
+  double                              timestretch_ratio,
   StereoPorts *                       stereo_ports)
 {
-  ArrangerObject * r_obj = (ArrangerObject *) self;
-  AudioClip *      clip = audio_region_get_clip (self);
-  g_return_if_fail (clip);
-  Track * track = arranger_object_get_track (r_obj);
-
-  /* if timestretching in the timeline, skip processing */
-  if (
-    G_UNLIKELY (
-      ZRYTHM_HAVE_UI && MW_TIMELINE
-      && MW_TIMELINE->action == UI_OVERLAY_ACTION_STRETCHING_R))
-    {
-      dsp_fill (
-        &stereo_ports->l->buf[time_nfo->local_offset], DENORMAL_PREVENTION_VAL,
-        time_nfo->nframes);
-      dsp_fill (
-        &stereo_ports->r->buf[time_nfo->local_offset], DENORMAL_PREVENTION_VAL,
-        time_nfo->nframes);
-      return;
-    }
-
-  /* restretch if necessary */
-  Position g_start_pos;
-  position_from_frames (
-    &g_start_pos, (signed_frame_t) time_nfo->g_start_frame_w_offset);
-  bpm_t  cur_bpm = tempo_track_get_bpm_at_pos (P_TEMPO_TRACK, &g_start_pos);
-  double timestretch_ratio = 1.0;
-  bool   needs_rt_timestretch = false;
-  if (region_get_musical_mode (self) && !math_floats_equal (clip->bpm, cur_bpm))
-    {
-      needs_rt_timestretch = true;
-      timestretch_ratio = (double) cur_bpm / (double) clip->bpm;
-      g_message (
-        "timestretching: "
-        "(cur bpm %f clip bpm %f) %f",
-        (double) cur_bpm, (double) clip->bpm, timestretch_ratio);
-    }
-
   /* buffers after timestretch */
   float lbuf_after_ts[time_nfo->nframes];
   float rbuf_after_ts[time_nfo->nframes];
   dsp_fill (lbuf_after_ts, 0, time_nfo->nframes);
   dsp_fill (rbuf_after_ts, 0, time_nfo->nframes);
 
-#if 0
-  double r_local_ticks_at_start =
-    g_start_pos.ticks - self->base.pos.ticks;
-  double r_len =
-    arranger_object_get_length_in_ticks (r_obj);
-  double ratio =
-    r_local_ticks_at_start / r_len;
-  g_message ("ratio %f", ratio);
-#endif
-
-  signed_frame_t r_local_frames_at_start = region_timeline_frames_to_local (
-    self, (signed_frame_t) time_nfo->g_start_frame_w_offset, F_NORMALIZE);
-
-#if 0
-  Position r_local_pos_at_start;
-  position_from_frames (
-    &r_local_pos_at_start, r_local_frames_at_start);
-  Position r_local_pos_at_end;
-  position_from_frames (
-    &r_local_pos_at_end,
-    r_local_frames_at_start + time_nfo->nframes);
-
-  g_message ("region");
-  position_print_range (
-    &self->base.pos, &self->base.end_pos);
-  g_message ("g start pos");
-  position_print (&g_start_pos);
-  g_message ("region local pos start/end");
-  position_print_range (
-    &r_local_pos_at_start, &r_local_pos_at_end);
-#endif
-
   size_t    buff_index_start = (size_t) clip->num_frames + 16;
   size_t    buff_size = 0;
   nframes_t prev_offset = time_nfo->local_offset;
@@ -406,7 +370,7 @@ audio_region_fill_stereo_ports (
             ", nframes %u",
             r_local_pos, j, time_nfo->g_start_frame_w_offset,
             time_nfo->local_offset, time_nfo->nframes);
-          return;
+          return false;
         }
 
       ssize_t buff_index = r_local_pos;
@@ -419,59 +383,40 @@ audio_region_fill_stereo_ports (
 
       /* if we are starting at a new
        * point in the audio clip */
-      if (needs_rt_timestretch)
+      buff_index = (ssize_t) (buff_index * timestretch_ratio);
+      if (buff_index < (ssize_t) buff_index_start)
         {
-          buff_index = (ssize_t) (buff_index * timestretch_ratio);
-          if (buff_index < (ssize_t) buff_index_start)
-            {
-              g_message (
-                "buff index (%zd) < "
-                "buff index start (%zd)",
-                buff_index, buff_index_start);
-              /* set the start point (
-               * used when
-               * timestretching) */
-              buff_index_start = (size_t) buff_index;
-
-              /* timestretch the material
-               * up to this point */
-              if (buff_size > 0)
-                {
-                  g_message ("buff size (%zd) > 0", buff_size);
-                  STRETCH;
-                  prev_offset = current_local_frame;
-                }
-              buff_size = 0;
-            }
-          /* else if last sample */
-          else if (j == (time_nfo->nframes - 1))
+          g_message (
+            "buff index (%zd) < "
+            "buff index start (%zd)",
+            buff_index, buff_index_start);
+          /* set the start point (
+           * used when
+           * timestretching) */
+          buff_index_start = (size_t) buff_index;
+
+          /* timestretch the material
+           * up to this point */
+          if (buff_size > 0)
             {
+              g_message ("buff size (%zd) > 0", buff_size);
               STRETCH;
               prev_offset = current_local_frame;
             }
-          else
-            {
-              buff_size++;
-            }
+          buff_size = 0;
+        }
+      /* else if last sample */
+      else if (j == (time_nfo->nframes - 1))
+        {
+          STRETCH;
+          prev_offset = current_local_frame;
         }
-      /* else if no need for timestretch */
       else
         {
-          z_return_if_fail_cmp (buff_index, >=, 0);
-          if (G_UNLIKELY (buff_index >= (ssize_t) clip->num_frames))
-            {
-              g_critical (
-                "Buffer index %zd exceeds %zu "
-                "frames in clip '%s'",
-                buff_index, clip->num_frames, clip->name);
-              return;
-            }
-          lbuf_after_ts[j] = clip->ch_frames[0][buff_index];
-          rbuf_after_ts[j] =
-            clip->channels == 1
-              ? clip->ch_frames[0][buff_index]
-              : clip->ch_frames[1][buff_index];
+          buff_size++;
         }
+
+#undef STRETCH
     }
 
   /* apply gain */
@@ -489,6 +434,207 @@ audio_region_fill_stereo_ports (
     &stereo_ports->r->buf[time_nfo->local_offset], &rbuf_after_ts[0],
     time_nfo->nframes);
 
+  return true;
+}
+
+/**
+ * Copies a span of consecutive clip frames to @p dest,
+ * applying the gain.
+ */
+static inline void
+copy_span (float * dest, const float * src, float gain, size_t size)
+{
+  dsp_copy (dest, src, size);
+  if (!math_floats_equal (gain, 1.f))
+    {
+      dsp_mul_k2 (dest, gain, size);
+    }
+}
+
+/**
+ * Fills the ports by copying spans of consecutive clip
+ * frames (split at loop points and at the clip end) at
+ * once.
+ *
+ * @param stream Stream to read from, if the clip is
+ *   streamed.
+ *
+ * @return Whether successful.
+ */
+static bool
+fill_stereo_ports_in_spans (
+  ZRegion *                           self,
+  AudioClip *                         clip,
+  AudioClipStream *                   stream,
+  const EngineProcessTimeInfo * const time_nfo,
+  signed_frame_t                      r_local_frames_at_start,
+  StereoPorts *                       stereo_ports)
+{
+  ArrangerObject * r_obj = (ArrangerObject *) self;
+  float *          lbuf = &stereo_ports->l->buf[time_nfo->local_offset];
+  float *          rbuf = &stereo_ports->r->buf[time_nfo->local_offset];
+  const float *    src_l = clip->ch_frames[0];
+  const float *    src_r =
+    clip->channels == 1 ? clip->ch_frames[0] : clip->ch_frames[1];
+
+  /* silence before the region start */
+  unsigned_frame_t j = (unsigned_frame_t) MIN (
+    (r_local_frames_at_start < 0) ? -r_local_frames_at_start : 0,
+    (signed_frame_t) time_nfo->nframes);
+  dsp_fill (lbuf, 0, (size_t) j);
+  dsp_fill (rbuf, 0, (size_t) j);
+
+  const signed_frame_t loop_end_frames = r_obj->loop_end_pos.frames;
+  while (j < time_nfo->nframes)
+    {
+      const signed_frame_t g_frames =
+        (signed_frame_t) (time_nfo->g_start_frame_w_offset + j);
+      const signed_frame_t r_local_pos =
+        region_timeline_frames_to_local (self, g_frames, F_NORMALIZE);
+      if (r_local_pos < 0 || j > AUDIO_ENGINE->block_length)
+        {
+          g_critical (
+            "invalid r_local_pos %" PRId64 ", j %" PRIu64
+            ", "
+            "g_start_frames (with offset) %" PRIu64 ", cycle offset %" PRIu32
+            ", nframes %u",
+            r_local_pos, j, time_nfo->g_start_frame_w_offset,
+            time_nfo->local_offset, time_nfo->nframes);
+          return false;
+        }
+      if (G_UNLIKELY (r_local_pos >= (signed_frame_t) clip->num_frames))
+        {
+          g_critical (
+            "Buffer index %" PRId64 " exceeds %" PRIu64
+            " "
+            "frames in clip '%s'",
+            r_local_pos, clip->num_frames, clip->name);
+          return false;
+        }
+
+      /* find how many frames can be copied consecutively:
+       * until the loop end, the clip end or the region end
+       * (which is not normalized, see
+       * region_timeline_frames_to_local()) */
+      signed_frame_t span = (signed_frame_t) (time_nfo->nframes - j);
+      if (r_local_pos < loop_end_frames)
+        {
+          span = MIN (span, loop_end_frames - r_local_pos);
+        }
+      span = MIN (span, (signed_frame_t) clip->num_frames - r_local_pos);
+      if (g_frames < r_obj->end_pos.frames)
+        {
+          span = MIN (span, r_obj->end_pos.frames - g_frames);
+        }
+      else if (g_frames == r_obj->end_pos.frames)
+        {
+          span = 1;
+        }
+
+      if (stream)
+        {
+          /* the lane playing the region follows the
+           * stream */
+          uint64_t reader =
+            ((uint64_t) self->id.track_name_hash << 32)
+            | ((uint64_t) (uint32_t) self->id.lane_pos + 1);
+          audio_clip_stream_read (
+            stream, reader, (uint64_t) AUDIO_ENGINE->cycle,
+            (unsigned_frame_t) r_local_pos, (size_t) span, &lbuf[j], &rbuf[j]);
+          if (!math_floats_equal (self->gain, 1.f))
+            {
+              dsp_mul_k2 (&lbuf[j], self->gain, (size_t) span);
+              dsp_mul_k2 (&rbuf[j], self->gain, (size_t) span);
+            }
+        }
+      else
+        {
+          copy_span (&lbuf[j], &src_l[r_local_pos], self->gain, (size_t) span);
+          copy_span (&rbuf[j], &src_r[r_local_pos], self->gain, (size_t) span);
+        }
+
+      j += (unsigned_frame_t) span;
+    }
+
+  return true;
+}
+
+/**
+ * Fills audio data from the region.
+ *
+ * @note The caller already splits calls to this
+ *   function at each sub-loop inside the region,
+ *   so region loop related logic is not needed.
+ *
+ * @param time_nfo Time info. The start position
+ *   is guaranteed to be in the region
+ * @param stereo_ports StereoPorts to fill.
+ */
+void
+audio_region_fill_stereo_ports (
+  ZRegion *                           self,
+  const EngineProcessTimeInfo * const time_nfo,
+  StereoPorts *                       stereo_ports)
+{
+  ArrangerObject * r_obj = (ArrangerObject *) self;
+  AudioClip *      clip = audio_region_get_clip (self);
+  g_return_if_fail (clip);
+  Track * track = arranger_object_get_track (r_obj);
+
+  /* if timestretching in the timeline, skip processing */
+  if (
+    G_UNLIKELY (
+      ZRYTHM_HAVE_UI && MW_TIMELINE
+      && MW_TIMELINE->action == UI_OVERLAY_ACTION_STRETCHING_R))
+    {
+      dsp_fill (
+        &stereo_ports->l->buf[time_nfo->local_offset], DENORMAL_PREVENTION_VAL,
+        time_nfo->nframes);
+      dsp_fill (
+        &stereo_ports->r->buf[time_nfo->local_offset], DENORMAL_PREVENTION_VAL,
+        time_nfo->nframes);
+      return;
+    }
+
+  /* restretch if necessary */
+  Position g_start_pos;
+  position_from_frames (
+    &g_start_pos, (signed_frame_t) time_nfo->g_start_frame_w_offset);
+  bpm_t  cur_bpm = tempo_track_get_bpm_at_pos (P_TEMPO_TRACK, &g_start_pos);
+  double timestretch_ratio = 1.0;
+  bool   needs_rt_timestretch = false;
+  if (region_get_musical_mode (self) && !math_floats_equal (clip->bpm, cur_bpm))
+    {
+      needs_rt_timestretch = true;
+      timestretch_ratio = (double) cur_bpm / (double) clip->bpm;
+      g_message (
+        "timestretching: "
+        "(cur bpm %f clip bpm %f) %f",
+        (double) cur_bpm, (double) clip->bpm, timestretch_ratio);
+    }
+
+  signed_frame_t r_local_frames_at_start = region_timeline_frames_to_local (
+    self, (signed_frame_t) time_nfo->g_start_frame_w_offset, F_NORMALIZE);
+
+  /* streamed clips are played without timestretching */
+  AudioClipStream * stream = g_atomic_pointer_get (&clip->stream);
+  bool              success;
+  if (needs_rt_timestretch && !stream)
+    {
+      success = fill_stereo_ports_w_timestretch (
+        self, track, clip, time_nfo, r_local_frames_at_start,
+        timestretch_ratio, stereo_ports);
+    }
+  else
+    {
+      success = fill_stereo_ports_in_spans (
+        self, clip, stream, time_nfo, r_local_frames_at_start, stereo_ports);
+    }
+  if (!success)
+    {
+      return;
+    }
+
   /* apply fades */
   const signed_frame_t num_frames_in_fade_in_area = r_obj->fade_in_pos.frames;
   const signed_frame_t num_frames_in_fade_out_area =
@@ -583,8 +729,13 @@ audio_region_fill_stereo_ports (
 float
 audio_region_detect_bpm (ZRegion * self, GArray * candidates)
 {
-  AudioClip * clip = audio_region_get_clip (self);
-  g_return_val_if_fail (clip, 0.f);
+  GError *    err = NULL;
+  AudioClip * clip = audio_region_load_clip (self, &err);
+  if (!clip)
+    {
+      HANDLE_ERROR_LITERAL (err, _ ("Failed to detect BPM"));
+      return 0.f;
+    }
 
   return audio_detect_bpm (
     clip->ch_frames[0], (size_t) clip->num_frames,
@@ -187,6 +187,7 @@ automation_point_set_fvalue (
 
   ZRegion * region = arranger_object_get_region ((ArrangerObject *) self);
   g_return_if_fail (region);
+  region->content_version++;
 
   /* don't set value - wait for engine to process
    * it */
@@ -286,6 +287,7 @@ automation_point_set_curviness (
     return;
 
   self->curve_opts.curviness = curviness;
+  arranger_object_bump_content_version ((ArrangerObject *) self);
 }
 
 /**
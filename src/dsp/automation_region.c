@@ -106,6 +106,7 @@ automation_region_add_ap (ZRegion * self, AutomationPoint * ap, int pub_events)
   array_double_size_if_full (
     self->aps, self->num_aps, self->aps_size, AutomationPoint *);
   array_append (self->aps, self->num_aps, ap);
+  self->content_version++;
 
   /* re-sort */
   automation_region_force_sort (self);
@@ -222,6 +223,7 @@ automation_region_remove_ap (
     }
 
   array_delete (self->aps, self->num_aps, ap);
+  self->content_version++;
 
   if (!freeing_region)
     {
@@ -20,6 +20,7 @@
 #include "project.h"
 #include "utils/arrays.h"
 #include "utils/flags.h"
+#include "utils/interval_index.h"
 #include "utils/math.h"
 #include "utils/mem.h"
 #include "utils/objects.h"
@@ -213,6 +214,7 @@ automation_track_insert_region (AutomationTrack * self, ZRegion * region, int id
   self->num_regions++;
 
   self->regions[idx] = region;
+  object_free_w_func_and_null (interval_index_free, self->arranger_index);
   region_set_automation_track (region, self);
   region->id.idx = idx;
   region_update_identifier (region);
@@ -235,49 +237,94 @@ automation_track_get_automation_tracklist (AutomationTrack * self)
  *   the region surrounds \ref pos), otherwise
  *   get the region that ends last.
  */
-ZRegion *
-automation_track_get_region_before_pos (
-  const AutomationTrack * self,
-  const Position *        pos,
-  bool                    ends_after,
-  bool                    use_snapshots)
+static int
+get_region_idx_before_frames (
+  ZRegion ** const     regions,
+  const int            num_regions,
+  const signed_frame_t frames,
+  const bool           ends_after)
 {
-  ZRegion ** regions = use_snapshots ? self->region_snapshots : self->regions;
-  int        num_regions =
-    use_snapshots ? self->num_region_snapshots : self->num_regions;
   if (ends_after)
     {
       for (int i = num_regions - 1; i >= 0; i--)
         {
-          ZRegion *        region = regions[i];
-          ArrangerObject * r_obj = (ArrangerObject *) region;
-          if (
-            position_is_before_or_equal (&r_obj->pos, pos)
-            && position_is_after_or_equal (&r_obj->end_pos, pos))
-            return region;
+          const ArrangerObject * r_obj = (const ArrangerObject *) regions[i];
+          if (r_obj->pos.frames <= frames && r_obj->end_pos.frames >= frames)
+            return i;
         }
     }
   else
     {
       /* find latest region */
-      ZRegion * latest_r = NULL;
-      long      latest_distance = LONG_MIN;
+      int  latest_r_idx = -1;
+      long latest_distance = LONG_MIN;
       for (int i = num_regions - 1; i >= 0; i--)
         {
-          ZRegion *        region = regions[i];
-          ArrangerObject * r_obj = (ArrangerObject *) region;
-          long distance_from_r_end = r_obj->end_pos.frames - pos->frames;
+          const ArrangerObject * r_obj = (const ArrangerObject *) regions[i];
+          long distance_from_r_end = r_obj->end_pos.frames - frames;
           if (
-            position_is_before_or_equal (&r_obj->pos, pos)
+            r_obj->pos.frames <= frames
             && distance_from_r_end > latest_distance)
             {
               latest_distance = distance_from_r_end;
-              latest_r = region;
+              latest_r_idx = i;
             }
         }
-      return latest_r;
+      return latest_r_idx;
     }
-  return NULL;
+  return -1;
+}
+
+/**
+ * Same as get_region_idx_before_frames(), but also
+ * returns in @p next_change_frames the first frame after
+ * @p frames where a region starts or ends, so that the
+ * result can be reused for all frames before it.
+ */
+static int
+get_region_idx_before_frames_and_next_change (
+  ZRegion ** const     regions,
+  const int            num_regions,
+  const signed_frame_t frames,
+  const bool           ends_after,
+  signed_frame_t *     next_change_frames)
+{
+  signed_frame_t next_change = INT_FAST64_MAX;
+  for (int i = 0; i < num_regions; i++)
+    {
+      const ArrangerObject * r_obj = (const ArrangerObject *) regions[i];
+      if (r_obj->pos.frames > frames)
+        next_change = MIN (next_change, r_obj->pos.frames);
+      /* the latest region doesn't change when a region
+       * ends if ends_after is false */
+      if (ends_after && r_obj->end_pos.frames >= frames)
+        next_change = MIN (next_change, r_obj->end_pos.frames + 1);
+    }
+  *next_change_frames = next_change;
+
+  return get_region_idx_before_frames (
+    regions, num_regions, frames, ends_after);
+}
+
+ZRegion *
+automation_track_get_region_before_pos (
+  const AutomationTrack * self,
+  const Position *        pos,
+  bool                    ends_after,
+  bool                    use_snapshots)
+{
+  ZRegion ** regions = self->regions;
+  int        num_regions = self->num_regions;
+  if (use_snapshots)
+    {
+      const AutomationPlaybackSnapshot * snapshot =
+        automation_track_get_playback_snapshot (self);
+      regions = snapshot ? snapshot->regions : NULL;
+      num_regions = snapshot ? snapshot->num_regions : 0;
+    }
+  int idx =
+    get_region_idx_before_frames (regions, num_regions, pos->frames, ends_after);
+  return idx >= 0 ? regions[idx] : NULL;
 }
 
 /**
@@ -557,6 +604,7 @@ automation_track_remove_region (AutomationTrack * self, ZRegion * region)
     CLIP_EDITOR ? clip_editor_get_region (CLIP_EDITOR) : NULL;
 
   array_delete (self->regions, self->num_regions, region);
+  object_free_w_func_and_null (interval_index_free, self->arranger_index);
 
   for (int i = region->id.idx; i < self->num_regions; i++)
     {
@@ -729,6 +777,211 @@ automation_track_get_val_at_pos (
     }
 }
 
+static AutomationSegmentCache *
+segment_cache_new (ZRegion ** regions, int num_regions)
+{
+  AutomationSegmentCache * self = object_new (AutomationSegmentCache);
+
+  int num_segments = 0;
+  for (int i = 0; i < num_regions; i++)
+    {
+      num_segments += regions[i]->num_aps;
+    }
+
+  self->segments =
+    object_new_n ((size_t) MAX (num_segments, 1), AutomationSegment);
+  self->region_offsets = object_new_n ((size_t) num_regions + 1, int);
+  for (int i = 0; i < num_regions; i++)
+    {
+      ZRegion * r = regions[i];
+      self->region_offsets[i] = self->num_segments;
+      for (int j = 0; j < r->num_aps; j++)
+        {
+          AutomationPoint * ap = r->aps[j];
+          AutomationPoint * next_ap =
+            automation_region_get_next_ap (r, ap, false, false);
+          AutomationSegment * seg = &self->segments[self->num_segments++];
+          seg->start_frames = ((ArrangerObject *) ap)->pos.frames;
+          seg->start_val = ap->normalized_val;
+          seg->curve_opts = ap->curve_opts;
+          seg->has_next = next_ap != NULL;
+          if (next_ap)
+            {
+              seg->end_frames = ((ArrangerObject *) next_ap)->pos.frames;
+              seg->end_val = next_ap->normalized_val;
+            }
+          else
+            {
+              seg->end_frames = seg->start_frames;
+              seg->end_val = seg->start_val;
+            }
+        }
+    }
+  self->region_offsets[num_regions] = self->num_segments;
+
+  return self;
+}
+
+static void
+segment_cache_free (AutomationSegmentCache * self)
+{
+  object_zero_and_free (self->segments);
+  object_zero_and_free (self->region_offsets);
+
+  object_zero_and_free (self);
+}
+
+/**
+ * Returns the normalized value of the segment at the given
+ * region-local position (see automation_track_get_val_at_pos()).
+ */
+static inline float
+get_normalized_val_in_segment (
+  AutomationSegment * seg,
+  signed_frame_t      local_frames)
+{
+  if (!seg->has_next)
+    {
+      return seg->start_val;
+    }
+
+  /* ratio of how far in we are in the curve */
+  double         ratio;
+  signed_frame_t numerator = local_frames - seg->start_frames;
+  signed_frame_t denominator = seg->end_frames - seg->start_frames;
+  if (numerator == 0)
+    {
+      ratio = 0.0;
+    }
+  else if (G_UNLIKELY (denominator == 0))
+    {
+      ratio = 1.0;
+    }
+  else
+    {
+      ratio = (double) numerator / (double) denominator;
+    }
+  ratio = CLAMP (ratio, 0.0, 1.0);
+
+  const bool start_higher = seg->end_val < seg->start_val;
+  float      result =
+    (float) curve_get_normalized_y (ratio, &seg->curve_opts, start_higher);
+  result *= fabsf (seg->start_val - seg->end_val);
+  result += start_higher ? seg->end_val : seg->start_val;
+
+  return result;
+}
+
+/**
+ * Returns the index of the segment active at the given
+ * region-local position inside the segments of the given
+ * region, or -1 if none.
+ */
+static inline int
+find_segment (
+  AutomationSegmentCache * self,
+  int                      region_idx,
+  signed_frame_t           local_frames)
+{
+  const int first = self->region_offsets[region_idx];
+  const int last = self->region_offsets[region_idx + 1];
+
+  /* check the last segment used and the one after it
+   * first, since positions normally move forward */
+  for (int i = self->cursor; i <= self->cursor + 1; i++)
+    {
+      if (
+        i >= first && i < last
+        && self->segments[i].start_frames <= local_frames
+        && (i == last - 1 || self->segments[i + 1].start_frames > local_frames))
+        {
+          self->cursor = i;
+          return i;
+        }
+    }
+
+  /* find the last segment starting at or before the
+   * position */
+  int lo = first;
+  int hi = last;
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+      if (self->segments[mid].start_frames <= local_frames)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  if (lo == first)
+    {
+      return -1;
+    }
+
+  self->cursor = lo - 1;
+  return lo - 1;
+}
+
+bool
+automation_track_get_normalized_vals_from_snapshots (
+  AutomationTrack * self,
+  signed_frame_t    g_start_frames,
+  nframes_t         step,
+  size_t            num_vals,
+  bool              ends_after,
+  float *           vals)
+{
+  AutomationPlaybackSnapshot * snapshot =
+    automation_track_get_playback_snapshot (self);
+  AutomationSegmentCache * cache = snapshot ? snapshot->segment_cache : NULL;
+  bool                     found = false;
+
+  /* the region is only looked up again when a region
+   * starts or ends */
+  int            r_idx = -1;
+  signed_frame_t next_region_change = INT_FAST64_MIN;
+  for (size_t i = 0; i < num_vals; i++)
+    {
+      vals[i] = -1.f;
+      if (!cache)
+        continue;
+
+      const signed_frame_t g_frames =
+        g_start_frames + (signed_frame_t) i * (signed_frame_t) step;
+      if (g_frames >= next_region_change)
+        {
+          r_idx = get_region_idx_before_frames_and_next_change (
+            snapshot->regions, snapshot->num_regions, g_frames, ends_after,
+            &next_region_change);
+        }
+      if (r_idx < 0)
+        continue;
+
+      ZRegion *        r = snapshot->regions[r_idx];
+      ArrangerObject * r_obj = (ArrangerObject *) r;
+      if (arranger_object_get_muted (r_obj, true))
+        continue;
+
+      /* if region ends before pos, assume pos is the
+       * region's end pos */
+      signed_frame_t local_frames = region_timeline_frames_to_local (
+        r,
+        !ends_after && (r_obj->end_pos.frames < g_frames)
+          ? r_obj->end_pos.frames - 1
+          : g_frames,
+        F_NORMALIZE);
+
+      int seg_idx = find_segment (cache, r_idx, local_frames);
+      if (seg_idx < 0)
+        continue;
+
+      vals[i] =
+        get_normalized_val_in_segment (&cache->segments[seg_idx], local_frames);
+      found = true;
+    }
+
+  return found;
+}
+
 /**
  * Updates each position in each child of the
  * automation track recursively.
@@ -822,24 +1075,96 @@ automation_track_verify (AutomationTrack * self)
   return true;
 }
 
+/**
+ * Frees the snapshot, except the regions in it.
+ */
+static void
+playback_snapshot_free_shallow (AutomationPlaybackSnapshot * self)
+{
+  object_zero_and_free_if_nonnull (self->regions);
+  object_free_w_func_and_null (segment_cache_free, self->segment_cache);
+
+  object_zero_and_free (self);
+}
+
+static void
+playback_snapshot_free (AutomationPlaybackSnapshot * self)
+{
+  for (int i = 0; i < self->num_regions; i++)
+    {
+      object_free_w_func_and_null_cast (
+        arranger_object_free, ArrangerObject *, self->regions[i]);
+    }
+  playback_snapshot_free_shallow (self);
+}
+
+void
+automation_track_update_playback_snapshot (
+  AutomationTrack * self,
+  GHashTable *      touched_ids)
+{
+  AutomationPlaybackSnapshot * prev = self->playback_snapshot;
+
+  /* region snapshots of the current snapshot not reused
+   * yet */
+  GHashTable * prev_regions = g_hash_table_new (NULL, NULL);
+  for (int i = 0; prev && i < prev->num_regions; i++)
+    {
+      g_hash_table_add (prev_regions, prev->regions[i]);
+    }
+
+  ZRegion ** regions = object_new_n ((size_t) self->num_regions, ZRegion *);
+  bool       changed = !prev || prev->num_regions != self->num_regions;
+  for (int i = 0; i < self->num_regions; i++)
+    {
+      regions[i] = region_gen_playback_snapshot (
+        self->regions[i], touched_ids ? prev_regions : NULL, touched_ids);
+      changed = changed || regions[i] != prev->regions[i];
+    }
+
+  if (!changed)
+    {
+      object_zero_and_free_if_nonnull (regions);
+      g_hash_table_unref (prev_regions);
+      return;
+    }
+
+  AutomationPlaybackSnapshot * snapshot =
+    object_new (AutomationPlaybackSnapshot);
+  snapshot->regions = regions;
+  snapshot->num_regions = self->num_regions;
+  snapshot->segment_cache =
+    segment_cache_new (snapshot->regions, snapshot->num_regions);
+
+  g_atomic_pointer_set (&self->playback_snapshot, snapshot);
+
+  /* free the regions that were not reused and the previous
+   * snapshot once the engine is done with them */
+  Track *       track = self->atl ? self->atl->track : NULL;
+  AudioEngine * engine =
+    track && track_is_in_active_project (track) ? AUDIO_ENGINE : NULL;
+  GHashTableIter iter;
+  void *         r_obj;
+  g_hash_table_iter_init (&iter, prev_regions);
+  while (g_hash_table_iter_next (&iter, &r_obj, NULL))
+    {
+      engine_retire_object (
+        engine, r_obj, (GDestroyNotify) arranger_object_free);
+    }
+  g_hash_table_unref (prev_regions);
+  if (prev)
+    {
+      engine_retire_object (
+        engine, prev, (GDestroyNotify) playback_snapshot_free_shallow);
+    }
+}
+
 void
 automation_track_set_caches (AutomationTrack * self, CacheTypes types)
 {
   if (types & CACHE_TYPE_PLAYBACK_SNAPSHOTS)
     {
-      for (int i = 0; i < self->num_region_snapshots; i++)
-        {
-          arranger_object_free ((ArrangerObject *) self->region_snapshots[i]);
-        }
-      self->num_region_snapshots = 0;
-      self->region_snapshots = g_realloc_n (
-        self->region_snapshots, (size_t) self->num_regions, sizeof (ZRegion *));
-      for (int i = 0; i < self->num_regions; i++)
-        {
-          self->region_snapshots[i] = (ZRegion *) arranger_object_clone (
-            (ArrangerObject *) self->regions[i]);
-          self->num_region_snapshots++;
-        }
+      automation_track_update_playback_snapshot (self, NULL);
     }
 
   if (types & CACHE_TYPE_AUTOMATION_LANE_PORTS)
@@ -896,12 +1221,8 @@ automation_track_free (AutomationTrack * self)
         arranger_object_free, ArrangerObject *, self->regions[i]);
     }
   object_zero_and_free (self->regions);
-  for (int i = 0; i < self->num_region_snapshots; i++)
-    {
-      object_free_w_func_and_null_cast (
-        arranger_object_free, ArrangerObject *, self->region_snapshots[i]);
-    }
-  object_zero_and_free (self->region_snapshots);
+  object_free_w_func_and_null (interval_index_free, self->arranger_index);
+  object_free_w_func_and_null (playback_snapshot_free, self->playback_snapshot);
 
   port_identifier_free_members (&self->port_id);
 
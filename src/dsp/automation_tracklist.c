@@ -2,10 +2,12 @@
 // SPDX-License-Identifier: LicenseRef-ZrythmLicense
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "dsp/automation_track.h"
 #include "dsp/automation_tracklist.h"
 #include "dsp/channel.h"
+#include "dsp/engine.h"
 #include "dsp/track.h"
 #include "gui/backend/event.h"
 #include "gui/backend/event_manager.h"
@@ -735,6 +737,7 @@ automation_tracklist_set_caches (AutomationTracklist * self, CacheTypes types)
       self->ats_in_record_mode = g_realloc_n (
         self->ats_in_record_mode, (size_t) self->num_ats,
         sizeof (AutomationTrack *));
+      self->ats_in_record_mode_size = (size_t) self->num_ats;
       self->num_ats_in_record_mode = 0;
     }
 
@@ -753,6 +756,50 @@ automation_tracklist_set_caches (AutomationTracklist * self, CacheTypes types)
     }
 }
 
+void
+automation_tracklist_set_caches_of_new_ats (AutomationTracklist * self)
+{
+  Track * track = automation_tracklist_get_track (self);
+  g_return_if_fail (IS_TRACK_AND_NONNULL (track));
+
+  if (track_is_auditioner (track))
+    return;
+
+  /* new automation tracks don't have their port set
+   * yet */
+  for (int i = 0; i < self->num_ats; i++)
+    {
+      AutomationTrack * at = self->ats[i];
+      if (!at->port)
+        {
+          automation_track_set_caches (at, CACHE_TYPE_AUTOMATION_LANE_PORTS);
+        }
+    }
+
+  if (self->ats_in_record_mode_size >= (size_t) self->num_ats)
+    return;
+
+  /* the engine may be reading the current array, so
+   * publish a larger copy with the same entries and
+   * free the current one once the engine is done with
+   * it */
+  AutomationTrack ** ats_in_record_mode =
+    object_new_n ((size_t) self->num_ats, AutomationTrack *);
+  if (self->num_ats_in_record_mode > 0)
+    {
+      memcpy (
+        ats_in_record_mode, self->ats_in_record_mode,
+        (size_t) self->num_ats_in_record_mode * sizeof (AutomationTrack *));
+    }
+  AutomationTrack ** prev = self->ats_in_record_mode;
+  g_atomic_pointer_set (&self->ats_in_record_mode, ats_in_record_mode);
+  self->ats_in_record_mode_size = (size_t) self->num_ats;
+  if (prev)
+    {
+      engine_retire_object (AUDIO_ENGINE, prev, g_free);
+    }
+}
+
 void
 automation_tracklist_print_regions (AutomationTracklist * self)
 {
@@ -12,6 +12,7 @@
 #include "project.h"
 #include "utils/arrays.h"
 #include "utils/flags.h"
+#include "utils/interval_index.h"
 #include "utils/mem.h"
 #include "utils/objects.h"
 #include "zrythm_app.h"
@@ -61,6 +62,8 @@ chord_track_insert_chord_region (Track * self, ZRegion * region, int idx)
     }
   self->num_chord_regions++;
   self->chord_regions[idx] = region;
+  object_free_w_func_and_null (
+    interval_index_free, self->chord_region_arranger_index);
   region->id.idx = idx;
   region_update_identifier (region);
 }
@@ -226,6 +229,8 @@ chord_track_remove_region (ChordTrack * self, ZRegion * region)
   g_return_if_fail (IS_TRACK (self) && IS_REGION (region));
 
   array_delete (self->chord_regions, self->num_chord_regions, region);
+  object_free_w_func_and_null (
+    interval_index_free, self->chord_region_arranger_index);
 
   for (int i = region->id.idx; i < self->num_chord_regions; i++)
     {
@@ -4,11 +4,16 @@
 #include <stdlib.h>
 
 #include "dsp/clip.h"
+#include "dsp/clip_cache.h"
+#include "dsp/clip_peaks.h"
+#include "dsp/clip_stream.h"
 #include "dsp/engine.h"
+#include "dsp/recording_manager.h"
 #include "dsp/tempo_track.h"
 #include "gui/widgets/main_window.h"
 #include "io/audio_file.h"
 #include "project.h"
+#include "settings/settings.h"
 #include "utils/audio.h"
 #include "utils/debug.h"
 #include "utils/dsp.h"
@@ -22,6 +27,7 @@
 #include "utils/objects.h"
 #include "utils/resampler.h"
 #include "utils/string.h"
+#include "zrythm.h"
 #include "zrythm_app.h"
 
 #include <glib/gi18n.h>
@@ -49,6 +55,30 @@ _create (void)
   return self;
 }
 
+/**
+ * Copies the frames mapped from the cache to memory
+ * owned by the clip.
+ */
+static void
+detach_from_cache (AudioClip * self)
+{
+  if (!self->mapped_file)
+    return;
+
+  size_t ch_size = (size_t) self->num_frames;
+  size_t arr_size = ch_size * self->channels;
+  float * frames = object_new_n (arr_size, sample_t);
+  dsp_copy (frames, self->frames, arr_size);
+  self->frames = frames;
+  for (unsigned int i = 0; i < self->channels; i++)
+    {
+      float * ch_frames = object_new_n (ch_size, sample_t);
+      dsp_copy (ch_frames, self->ch_frames[i], ch_size);
+      self->ch_frames[i] = ch_frames;
+    }
+  g_clear_pointer (&self->mapped_file, g_mapped_file_unref);
+}
+
 /**
  * Updates the channel caches.
  *
@@ -63,7 +93,20 @@ audio_clip_update_channel_caches (AudioClip * self, size_t start_from)
   z_return_if_fail_cmp (self->channels, >, 0);
   z_return_if_fail_cmp (self->num_frames, >, 0);
 
+  /* callers changing the frames discard the peaks before,
+   * so only keep the job from reading the frames while
+   * they are moved */
+  AudioClipPeaksJob * peaks_job = self->peaks_job;
+  if (peaks_job)
+    {
+      audio_clip_peaks_job_lock_frames (peaks_job);
+    }
+
+  /* the mapping can't be reallocated */
+  detach_from_cache (self);
+
   /* copy the frames to the channel caches */
+  self->frames_capacity = 0;
   for (unsigned int i = 0; i < self->channels; i++)
     {
       self->ch_frames[i] = g_realloc (
@@ -73,12 +116,34 @@ audio_clip_update_channel_caches (AudioClip * self, size_t start_from)
           self->ch_frames[i][j] = self->frames[j * self->channels + i];
         }
     }
+
+  if (peaks_job)
+    {
+      audio_clip_peaks_job_unlock_frames (peaks_job);
+    }
 }
 
+/**
+ * Returns whether clips in the pool should be streamed
+ * from disk.
+ */
+static bool
+should_stream_clips (void)
+{
+  return ZRYTHM_TESTING
+           ? false
+           : g_settings_get_boolean (S_P_GENERAL_ENGINE, "stream-audio-clips");
+}
+
+/**
+ * @param stream Whether to stream the file instead of
+ *   reading it in memory, if possible.
+ */
 static bool
 audio_clip_init_from_file (
   AudioClip *  self,
   const char * full_path,
+  bool         stream,
   GError **    error)
 {
   g_return_val_if_fail (self, false);
@@ -86,6 +151,11 @@ audio_clip_init_from_file (
   self->samplerate = (int) AUDIO_ENGINE->sample_rate;
   g_return_val_if_fail (self->samplerate > 0, false);
 
+  if (self->mapped_file)
+    {
+      audio_clip_unload_frames (self);
+    }
+
   GError * err = NULL;
 
   /* read metadata */
@@ -115,6 +185,33 @@ audio_clip_init_from_file (
       self->bit_depth = BIT_DEPTH_32;
     }
 
+  g_free_and_null (self->name);
+  char * basename = g_path_get_basename (full_path);
+  self->name = io_file_strip_ext (basename);
+  g_free (basename);
+  self->bpm = tempo_track_get_current_bpm (P_TEMPO_TRACK);
+  self->use_flac = audio_clip_use_flac (self->bit_depth);
+
+  /* stream long clips that don't need resampling */
+  if (
+    stream && af->metadata.samplerate == self->samplerate
+    && self->num_frames
+         >= (unsigned_frame_t) AUDIO_CLIP_STREAM_MIN_SECONDS
+              * (unsigned_frame_t) self->samplerate)
+    {
+      self->stream = audio_clip_stream_new (full_path, &err);
+      if (self->stream)
+        {
+          object_free_w_func_and_null (audio_file_free, af);
+          return true;
+        }
+
+      g_warning (
+        "Failed to open stream for %s, loading it in memory instead: %s",
+        full_path, err->message);
+      g_clear_error (&err);
+    }
+
   /* read frames in file's sample rate */
   size_t arr_size = self->num_frames * self->channels;
   self->frames = g_realloc (self->frames, arr_size * sizeof (float));
@@ -162,12 +259,6 @@ audio_clip_init_from_file (
     }
   object_free_w_func_and_null (audio_file_free, af);
 
-  g_free_and_null (self->name);
-  char * basename = g_path_get_basename (full_path);
-  self->name = io_file_strip_ext (basename);
-  g_free (basename);
-  self->bpm = tempo_track_get_current_bpm (P_TEMPO_TRACK);
-  self->use_flac = audio_clip_use_flac (self->bit_depth);
   /*g_message (*/
   /*"\n\n num frames %ld \n\n", self->num_frames);*/
   audio_clip_update_channel_caches (self, 0);
@@ -186,9 +277,22 @@ audio_clip_init_loaded (AudioClip * self, GError ** error)
   char * filepath = audio_clip_get_path_in_pool_from_name (
     self->name, self->use_flac, F_NOT_BACKUP);
 
+  /* drop any previous stream (this may be called more
+   * than once during loading) */
+  audio_clip_discard_peaks (self);
+  object_free_w_func_and_null (audio_clip_stream_free, self->stream);
+
+  /* skip decoding if the frames are cached */
+  bool stream = should_stream_clips ();
+  if (!stream && filepath && audio_clip_cache_load (self, filepath))
+    {
+      g_free (filepath);
+      return true;
+    }
+
   bpm_t    bpm = self->bpm;
   GError * err = NULL;
-  bool     success = audio_clip_init_from_file (self, filepath, &err);
+  bool success = audio_clip_init_from_file (self, filepath, stream, &err);
   if (!success)
     {
       PROPAGATE_PREFIXED_ERROR_LITERAL (
@@ -197,11 +301,128 @@ audio_clip_init_loaded (AudioClip * self, GError ** error)
     }
   self->bpm = bpm;
 
+  /* cache the decoded frames for the next load and use
+   * the (shared) cached copy instead of the private one */
+  if (!self->stream && self->file_hash)
+    {
+      if (audio_clip_cache_store (self, filepath, &err))
+        {
+          audio_clip_cache_load (self, filepath);
+        }
+      else
+        {
+          g_message ("Failed to cache clip %s: %s", self->name, err->message);
+          g_clear_error (&err);
+        }
+    }
+
   g_free (filepath);
 
   return true;
 }
 
+/**
+ * Loads the frames of a streamed clip in memory and stops
+ * streaming it.
+ */
+bool
+audio_clip_load_frames (AudioClip * self, GError ** error)
+{
+  AudioClipStream * stream = self->stream;
+  if (!stream)
+    return true;
+
+  g_message ("loading frames of streamed clip %s", self->name);
+
+  /* the frames stay the same, so keep the peaks */
+  if (self->peaks_job)
+    {
+      audio_clip_peaks_job_cancel (self->peaks_job);
+      object_free_w_func_and_null (audio_clip_peaks_job_unref, self->peaks_job);
+    }
+  AudioClipPeaks * peaks = self->peaks;
+  self->peaks = NULL;
+
+  char *   name = g_strdup (self->name);
+  bpm_t    bpm = self->bpm;
+  GError * err = NULL;
+  bool     success =
+    audio_clip_init_from_file (self, stream->filepath, false, &err);
+  g_free_and_null (self->name);
+  self->name = name;
+  self->bpm = bpm;
+  if (peaks)
+    {
+      g_atomic_pointer_set (&self->peaks, peaks);
+    }
+  if (!success)
+    {
+      PROPAGATE_PREFIXED_ERROR (
+        error, err, _ ("Failed to load frames of clip %s"), self->name);
+      return false;
+    }
+
+  /* the engine may still be reading from the stream so
+   * let the streamer free it when done */
+  g_atomic_pointer_set (&self->stream, NULL);
+  if (stream->streamer)
+    {
+      audio_clip_streamer_retire_stream (stream->streamer, stream);
+    }
+  else
+    {
+      audio_clip_stream_free (stream);
+    }
+
+  return true;
+}
+
+/**
+ * Frees the frames of the clip (and stops streaming it,
+ * if streamed).
+ */
+void
+audio_clip_unload_frames (AudioClip * self)
+{
+  audio_clip_discard_peaks (self);
+  object_free_w_func_and_null (audio_clip_stream_free, self->stream);
+  if (self->mapped_file)
+    {
+      self->frames = NULL;
+      for (unsigned int i = 0; i < self->channels; i++)
+        {
+          self->ch_frames[i] = NULL;
+        }
+      g_clear_pointer (&self->mapped_file, g_mapped_file_unref);
+    }
+  else
+    {
+      object_zero_and_free_if_nonnull (self->frames);
+      for (unsigned int i = 0; i < self->channels; i++)
+        {
+          object_zero_and_free_if_nonnull (self->ch_frames[i]);
+        }
+    }
+  self->num_frames = 0;
+  self->frames_capacity = 0;
+}
+
+/**
+ * Stops generating the peaks of the clip and frees them.
+ */
+void
+audio_clip_discard_peaks (AudioClip * self)
+{
+  if (self->peaks_job)
+    {
+      audio_clip_peaks_job_cancel (self->peaks_job);
+      object_free_w_func_and_null (audio_clip_peaks_job_unref, self->peaks_job);
+    }
+
+  /* the job is done so it can't set this anymore */
+  object_free_w_func_and_null (audio_clip_peaks_free, self->peaks);
+}
+
 /**
  * Creates an audio clip from a file.
  *
@@ -213,7 +434,7 @@ audio_clip_new_from_file (const char * full_path, GError ** error)
   AudioClip * self = _create ();
 
   GError * err = NULL;
-  bool     success = audio_clip_init_from_file (self, full_path, &err);
+  bool     success = audio_clip_init_from_file (self, full_path, false, &err);
   if (!success)
     {
       audio_clip_free (self);
@@ -263,8 +484,9 @@ audio_clip_new_from_float_array (
 /**
  * Create an audio clip while recording.
  *
- * The frames will keep getting reallocated until
- * the recording is finished.
+ * The frames will keep getting set with
+ * audio_clip_set_recorded_frames() until the
+ * recording is finished.
  *
  * @param nframes Number of frames to allocate. This
  *   should be the current cycle's frames when
@@ -295,6 +517,62 @@ audio_clip_new_recording (
   return self;
 }
 
+/**
+ * Sets the frames of a clip being recorded starting at
+ * @p start, growing the clip if needed.
+ *
+ * @param ch_bufs Per-channel frames.
+ */
+void
+audio_clip_set_recorded_frames (
+  AudioClip *           self,
+  unsigned_frame_t      start,
+  const float * const * ch_bufs,
+  size_t                nframes)
+{
+  z_return_if_fail_cmp (self->channels, >, 0);
+  z_return_if_fail_cmp (start, <=, self->num_frames);
+
+  unsigned_frame_t end = start + nframes;
+  unsigned_frame_t capacity = MAX (self->frames_capacity, self->num_frames);
+  if (end > capacity || self->mapped_file)
+    {
+      AudioClipPeaksJob * peaks_job = self->peaks_job;
+      if (peaks_job)
+        {
+          audio_clip_peaks_job_lock_frames (peaks_job);
+        }
+
+      detach_from_cache (self);
+
+      /* grow by at least half the current size */
+      capacity = MAX (end, capacity + capacity / 2);
+      self->frames = g_realloc_n (
+        self->frames, (size_t) capacity * self->channels, sizeof (float));
+      for (unsigned int i = 0; i < self->channels; i++)
+        {
+          self->ch_frames[i] =
+            g_realloc_n (self->ch_frames[i], (size_t) capacity, sizeof (float));
+        }
+      self->frames_capacity = capacity;
+
+      if (peaks_job)
+        {
+          audio_clip_peaks_job_unlock_frames (peaks_job);
+        }
+    }
+
+  for (unsigned int i = 0; i < self->channels; i++)
+    {
+      dsp_copy (&self->ch_frames[i][start], ch_bufs[i], nframes);
+      for (size_t j = 0; j < nframes; j++)
+        {
+          self->frames[(start + j) * self->channels + i] = ch_bufs[i][j];
+        }
+    }
+  self->num_frames = MAX (self->num_frames, end);
+}
+
 /**
  * Gets the path of a clip matching \ref name from
  * the pool.
@@ -361,6 +639,19 @@ audio_clip_write_to_pool (
   g_return_val_if_fail (pool_clip, false);
   g_return_val_if_fail (pool_clip == self, false);
 
+  /* the disk writer keeps the pool file of a clip being
+   * recorded open and writes it (see
+   * recording_manager_flush_takes()) */
+  if (
+    !is_backup && RECORDING_MANAGER
+    && recording_manager_is_recording_clip (RECORDING_MANAGER, self))
+    {
+      g_message (
+        "clip %s (%d) is being recorded, skipping writing it to the pool",
+        self->name, self->pool_id);
+      return true;
+    }
+
   audio_pool_print (AUDIO_POOL);
   g_message (
     "attempting to write clip %s (%d) to pool...", self->name, self->pool_id);
@@ -503,6 +794,15 @@ audio_clip_write_to_file (
 {
   g_return_val_if_fail (self->samplerate > 0, false);
   g_return_val_if_fail (self->frames_written < SIZE_MAX, false);
+
+  GError * err = NULL;
+  if (!audio_clip_load_frames (self, &err))
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, _ ("Failed to write audio file"));
+      return false;
+    }
+
   size_t           before_frames = (size_t) self->frames_written;
   unsigned_frame_t ch_offset = parts ? self->frames_written : 0;
   unsigned_frame_t offset = ch_offset * self->channels;
@@ -521,8 +821,7 @@ audio_clip_write_to_file (
       z_return_val_if_fail_cmp (self->num_frames, <, SIZE_MAX, false);
       nframes = self->num_frames;
     }
-  GError * err = NULL;
-  bool     success = audio_write_raw_file (
+  bool success = audio_write_raw_file (
     &self->frames[offset], ch_offset, nframes, (uint32_t) self->samplerate,
     self->use_flac, self->bit_depth, self->channels, filepath, &err);
   if (!success)
@@ -788,11 +1087,7 @@ audio_clip_clone (AudioClip * src)
 void
 audio_clip_free (AudioClip * self)
 {
-  object_zero_and_free (self->frames);
-  for (unsigned int i = 0; i < self->channels; i++)
-    {
-      object_zero_and_free_if_nonnull (self->ch_frames[i]);
-    }
+  audio_clip_unload_frames (self);
   g_free_and_null (self->name);
   g_free_and_null (self->file_hash);
 
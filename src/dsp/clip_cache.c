@@ -0,0 +1,309 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include <stdio.h>
+#include <string.h>
+
+#include "dsp/clip.h"
+#include "dsp/clip_cache.h"
+#include "dsp/engine.h"
+#include "project.h"
+#include "utils/error.h"
+#include "utils/file.h"
+#include "utils/flags.h"
+#include "utils/io.h"
+#include "zrythm.h"
+
+#include <glib/gstdio.h>
+
+#ifndef _WIN32
+#  include <sys/mman.h>
+#endif
+
+typedef enum
+{
+  Z_AUDIO_CLIP_CACHE_ERROR_FAILED,
+} ZAudioClipCacheError;
+
+#define Z_AUDIO_CLIP_CACHE_ERROR z_audio_clip_cache_error_quark ()
+GQuark
+z_audio_clip_cache_error_quark (void);
+G_DEFINE_QUARK (
+  z - audio - clip - cache - error - quark,
+  z_audio_clip_cache_error)
+
+static inline size_t
+align_up (size_t size)
+{
+  return (size + AUDIO_CLIP_CACHE_ALIGNMENT - 1)
+         & ~((size_t) AUDIO_CLIP_CACHE_ALIGNMENT - 1);
+}
+
+static inline size_t
+get_interleaved_offset (void)
+{
+  return align_up (sizeof (AudioClipCacheHeader));
+}
+
+/**
+ * Returns the offset of the frames of channel @p ch, or
+ * the size of the file if @p ch is the number of
+ * channels.
+ */
+static inline size_t
+get_channel_offset (channels_t channels, unsigned_frame_t num_frames, int ch)
+{
+  size_t ch_size = (size_t) num_frames * sizeof (float);
+  return align_up (get_interleaved_offset () + ch_size * channels)
+         + (size_t) ch * align_up (ch_size);
+}
+
+/**
+ * Returns the path of the cache file for the clip with
+ * the given file hash at the given sample rate.
+ */
+char *
+audio_clip_cache_get_path (const char * file_hash, int samplerate)
+{
+  if (!PROJECT || !PROJECT->dir)
+    return NULL;
+
+  char * cache_dir =
+    project_get_path (PROJECT, PROJECT_PATH_POOL_CACHE, F_NOT_BACKUP);
+  char * basename = g_strdup_printf (
+    "%s-%d.%s", file_hash, samplerate, AUDIO_CLIP_CACHE_EXT);
+  char * path = g_build_filename (cache_dir, basename, NULL);
+  g_free (basename);
+  g_free (cache_dir);
+
+  return path;
+}
+
+static bool
+header_is_valid (
+  const AudioClipCacheHeader * header,
+  size_t                       file_size,
+  int                          samplerate,
+  const GStatBuf *             src_st)
+{
+  return memcmp (header->magic, AUDIO_CLIP_CACHE_MAGIC, sizeof (header->magic))
+           == 0
+         && header->version == AUDIO_CLIP_CACHE_VERSION
+         && header->samplerate == (uint32_t) samplerate
+         && header->channels > 0 && header->channels <= 16
+         && header->num_frames > 0
+         && header->src_size == (uint64_t) src_st->st_size
+         && header->src_mtime == (int64_t) src_st->st_mtime
+         && file_size
+              == get_channel_offset (
+                (channels_t) header->channels,
+                (unsigned_frame_t) header->num_frames, (int) header->channels);
+}
+
+/**
+ * Maps the cached frames of the clip, if a valid cache
+ * file exists for its file hash and sample rate.
+ */
+bool
+audio_clip_cache_load (AudioClip * self, const char * src_path)
+{
+  if (!self->file_hash)
+    return false;
+
+  int    samplerate = (int) AUDIO_ENGINE->sample_rate;
+  char * path = audio_clip_cache_get_path (self->file_hash, samplerate);
+  if (!path || !file_exists (path))
+    {
+      g_free (path);
+      return false;
+    }
+
+  GStatBuf src_st;
+  if (g_stat (src_path, &src_st) != 0)
+    {
+      g_free (path);
+      return false;
+    }
+
+  /* map privately so that in-place edits of the frames
+   * never reach the cache file */
+  GError *      err = NULL;
+  GMappedFile * mapped_file = g_mapped_file_new (path, true, &err);
+  if (!mapped_file)
+    {
+      g_message ("Failed to map clip cache %s: %s", path, err->message);
+      g_error_free (err);
+      g_free (path);
+      return false;
+    }
+
+  size_t size = g_mapped_file_get_length (mapped_file);
+  char * contents = g_mapped_file_get_contents (mapped_file);
+  const AudioClipCacheHeader * header =
+    (const AudioClipCacheHeader *) contents;
+  if (
+    size < sizeof (AudioClipCacheHeader)
+    || !header_is_valid (header, size, samplerate, &src_st))
+    {
+      g_message ("Ignoring stale clip cache %s", path);
+      g_mapped_file_unref (mapped_file);
+      g_free (path);
+      return false;
+    }
+
+#ifndef _WIN32
+  /* the engine reads these, so avoid page faults later
+   * if possible */
+  madvise (contents, size, MADV_WILLNEED);
+#endif
+
+  audio_clip_unload_frames (self);
+  self->mapped_file = mapped_file;
+  self->channels = (channels_t) header->channels;
+  self->num_frames = (unsigned_frame_t) header->num_frames;
+  self->samplerate = samplerate;
+  self->frames = (float *) &contents[get_interleaved_offset ()];
+  for (unsigned int i = 0; i < self->channels; i++)
+    {
+      self->ch_frames[i] = (float *) &contents[get_channel_offset (
+        self->channels, self->num_frames, (int) i)];
+    }
+
+  g_debug ("loaded clip %s from cache %s", self->name, path);
+  g_free (path);
+
+  return true;
+}
+
+/**
+ * Writes @p size bytes followed by padding up to the
+ * alignment.
+ */
+static bool
+write_block (FILE * f, const void * data, size_t size)
+{
+  static const char zeros[AUDIO_CLIP_CACHE_ALIGNMENT] = { 0 };
+  size_t            padding = align_up (size) - size;
+  return fwrite (data, 1, size, f) == size
+         && fwrite (zeros, 1, padding, f) == padding;
+}
+
+/**
+ * Writes the clip's frames to the cache.
+ */
+bool
+audio_clip_cache_store (
+  AudioClip *  self,
+  const char * src_path,
+  GError **    error)
+{
+  g_return_val_if_fail (self->frames && self->num_frames > 0, false);
+  g_return_val_if_fail (self->file_hash, false);
+
+  GStatBuf src_st;
+  if (g_stat (src_path, &src_st) != 0)
+    {
+      g_set_error (
+        error, Z_AUDIO_CLIP_CACHE_ERROR, Z_AUDIO_CLIP_CACHE_ERROR_FAILED,
+        "Failed to stat %s", src_path);
+      return false;
+    }
+
+  char * path = audio_clip_cache_get_path (self->file_hash, self->samplerate);
+  if (!path)
+    {
+      g_set_error_literal (
+        error, Z_AUDIO_CLIP_CACHE_ERROR, Z_AUDIO_CLIP_CACHE_ERROR_FAILED,
+        "No project to cache the clip in");
+      return false;
+    }
+
+  GError * err = NULL;
+  char *   dir = g_path_get_dirname (path);
+  bool     success = io_mkdir (dir, &err);
+  g_free (dir);
+  if (!success)
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, "Failed to create the clip cache directory");
+      g_free (path);
+      return false;
+    }
+
+  AudioClipCacheHeader header = {
+    .version = AUDIO_CLIP_CACHE_VERSION,
+    .channels = self->channels,
+    .num_frames = self->num_frames,
+    .samplerate = (uint32_t) self->samplerate,
+    .src_size = (uint64_t) src_st.st_size,
+    .src_mtime = (int64_t) src_st.st_mtime,
+  };
+  memcpy (header.magic, AUDIO_CLIP_CACHE_MAGIC, sizeof (header.magic));
+
+  /* write to a temporary file first so that a partially
+   * written file is never picked up */
+  char * tmp_path = g_strdup_printf ("%s.tmp", path);
+  FILE * f = g_fopen (tmp_path, "wb");
+  success = f != NULL;
+  if (success)
+    {
+      size_t ch_size = (size_t) self->num_frames * sizeof (float);
+      success =
+        write_block (f, &header, sizeof (header))
+        && write_block (f, self->frames, ch_size * self->channels);
+      for (unsigned int i = 0; success && i < self->channels; i++)
+        {
+          success = write_block (f, self->ch_frames[i], ch_size);
+        }
+      success = fclose (f) == 0 && success;
+    }
+  if (success)
+    {
+      success = g_rename (tmp_path, path) == 0;
+    }
+  if (!success)
+    {
+      g_set_error (
+        error, Z_AUDIO_CLIP_CACHE_ERROR, Z_AUDIO_CLIP_CACHE_ERROR_FAILED,
+        "Failed to write clip cache %s", path);
+      io_remove (tmp_path);
+    }
+
+  g_free (tmp_path);
+  g_free (path);
+
+  return success;
+}
+
+/**
+ * Removes cache files not in @p used_paths.
+ */
+void
+audio_clip_cache_remove_unused (GHashTable * used_paths)
+{
+  if (!PROJECT || !PROJECT->dir)
+    return;
+
+  char * cache_dir =
+    project_get_path (PROJECT, PROJECT_PATH_POOL_CACHE, F_NOT_BACKUP);
+  GDir * dir = g_dir_open (cache_dir, 0, NULL);
+  if (!dir)
+    {
+      g_free (cache_dir);
+      return;
+    }
+
+  const char * basename;
+  while ((basename = g_dir_read_name (dir)))
+    {
+      char * path = g_build_filename (cache_dir, basename, NULL);
+      if (!g_hash_table_contains (used_paths, path))
+        {
+          io_remove (path);
+        }
+      g_free (path);
+    }
+
+  g_dir_close (dir);
+  g_free (cache_dir);
+}
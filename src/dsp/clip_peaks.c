@@ -0,0 +1,663 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "dsp/clip.h"
+#include "dsp/clip_peaks.h"
+#include "dsp/clip_stream.h"
+#include "io/audio_file.h"
+#include "project.h"
+#include "utils/error.h"
+#include "utils/flags.h"
+#include "utils/io.h"
+#include "utils/objects.h"
+
+#include <glib/gstdio.h>
+
+typedef enum
+{
+  Z_AUDIO_CLIP_PEAKS_ERROR_FAILED,
+} ZAudioClipPeaksError;
+
+#define Z_AUDIO_CLIP_PEAKS_ERROR z_audio_clip_peaks_error_quark ()
+GQuark
+z_audio_clip_peaks_error_quark (void);
+G_DEFINE_QUARK (
+  z - audio - clip - peaks - error - quark,
+  z_audio_clip_peaks_error)
+
+/**
+ * Returns the path of the peaks file for the clip with
+ * the given file hash at the given sample rate.
+ */
+char *
+audio_clip_peaks_get_path (const char * file_hash, int samplerate)
+{
+  if (!PROJECT || !PROJECT->dir)
+    return NULL;
+
+  char * cache_dir =
+    project_get_path (PROJECT, PROJECT_PATH_POOL_CACHE, F_NOT_BACKUP);
+  char * basename = g_strdup_printf (
+    "%s-%d.%s", file_hash, samplerate, AUDIO_CLIP_PEAKS_EXT);
+  char * path = g_build_filename (cache_dir, basename, NULL);
+  g_free (basename);
+  g_free (cache_dir);
+
+  return path;
+}
+
+/**
+ * Sets up the levels for the clip size and returns the
+ * total number of peaks per channel.
+ */
+static size_t
+init_levels (AudioClipPeaks * self)
+{
+  size_t total = 0;
+  self->num_levels = 0;
+  unsigned_frame_t frames_per_peak = AUDIO_CLIP_PEAKS_BASE_FRAMES;
+  while (self->num_levels < AUDIO_CLIP_PEAKS_MAX_LEVELS)
+    {
+      AudioClipPeaksLevel * level = &self->levels[self->num_levels++];
+      level->frames_per_peak = frames_per_peak;
+      level->num_peaks =
+        (size_t) ((self->num_frames + frames_per_peak - 1) / frames_per_peak);
+      total += level->num_peaks;
+      if (level->num_peaks <= 1)
+        break;
+
+      frames_per_peak *= 2;
+    }
+
+  return total;
+}
+
+/**
+ * Points the levels to their peaks in @ref
+ * AudioClipPeaks.data.
+ */
+static void
+set_level_pointers (AudioClipPeaks * self)
+{
+  AudioClipPeak * peaks = self->data;
+  for (int i = 0; i < self->num_levels; i++)
+    {
+      AudioClipPeaksLevel * level = &self->levels[i];
+      for (channels_t ch = 0; ch < self->channels; ch++)
+        {
+          level->ch_peaks[ch] = peaks;
+          peaks += level->num_peaks;
+        }
+    }
+}
+
+/**
+ * Creates an empty pyramid for the given number of
+ * frames.
+ */
+AudioClipPeaks *
+audio_clip_peaks_new (channels_t channels, unsigned_frame_t num_frames)
+{
+  g_return_val_if_fail (channels > 0 && channels <= 16, NULL);
+  g_return_val_if_fail (num_frames > 0, NULL);
+
+  AudioClipPeaks * self = object_new (AudioClipPeaks);
+  self->channels = channels;
+  self->num_frames = num_frames;
+  size_t num_peaks = init_levels (self);
+  self->data = object_new_n (num_peaks * channels, AudioClipPeak);
+  set_level_pointers (self);
+
+  return self;
+}
+
+/**
+ * Computes the finest level for the given frames.
+ */
+void
+audio_clip_peaks_add_frames (
+  AudioClipPeaks *      self,
+  const float * const * ch_frames,
+  unsigned_frame_t      start,
+  size_t                nframes)
+{
+  g_return_if_fail (start % AUDIO_CLIP_PEAKS_BASE_FRAMES == 0);
+  g_return_if_fail (start + nframes <= self->num_frames);
+
+  AudioClipPeaksLevel * level = &self->levels[0];
+  for (channels_t ch = 0; ch < self->channels; ch++)
+    {
+      AudioClipPeak * peak =
+        &level->ch_peaks[ch][start / AUDIO_CLIP_PEAKS_BASE_FRAMES];
+      for (size_t offset = 0; offset < nframes;
+           offset += AUDIO_CLIP_PEAKS_BASE_FRAMES)
+        {
+          const float * frames = &ch_frames[ch][offset];
+          size_t n = MIN (AUDIO_CLIP_PEAKS_BASE_FRAMES, nframes - offset);
+          float  min = frames[0];
+          float  max = frames[0];
+          float  sum_sq = 0.f;
+          for (size_t i = 0; i < n; i++)
+            {
+              min = MIN (min, frames[i]);
+              max = MAX (max, frames[i]);
+              sum_sq += frames[i] * frames[i];
+            }
+          peak->min = min;
+          peak->max = max;
+          peak->rms = sqrtf (sum_sq / (float) n);
+          peak++;
+        }
+    }
+}
+
+/**
+ * Returns the number of frames covered by the peak at
+ * @p idx in the given level.
+ */
+static inline unsigned_frame_t
+get_peak_frames (
+  const AudioClipPeaks *      self,
+  const AudioClipPeaksLevel * level,
+  size_t                      idx)
+{
+  unsigned_frame_t start = (unsigned_frame_t) idx * level->frames_per_peak;
+  return MIN (level->frames_per_peak, self->num_frames - start);
+}
+
+/**
+ * Computes the other levels from the finest one.
+ */
+void
+audio_clip_peaks_finish (AudioClipPeaks * self)
+{
+  for (int i = 1; i < self->num_levels; i++)
+    {
+      const AudioClipPeaksLevel * prev = &self->levels[i - 1];
+      AudioClipPeaksLevel *       level = &self->levels[i];
+      for (channels_t ch = 0; ch < self->channels; ch++)
+        {
+          const AudioClipPeak * src = prev->ch_peaks[ch];
+          AudioClipPeak *       dest = level->ch_peaks[ch];
+          for (size_t j = 0; j < level->num_peaks; j++)
+            {
+              const AudioClipPeak * a = &src[j * 2];
+              if (j * 2 + 1 >= prev->num_peaks)
+                {
+                  dest[j] = *a;
+                  continue;
+                }
+
+              /* weigh the RMS by the frames covered since
+               * the last peak may cover less */
+              const AudioClipPeak * b = &src[j * 2 + 1];
+              float a_frames = (float) get_peak_frames (self, prev, j * 2);
+              float b_frames = (float) get_peak_frames (self, prev, j * 2 + 1);
+              dest[j].min = MIN (a->min, b->min);
+              dest[j].max = MAX (a->max, b->max);
+              dest[j].rms = sqrtf (
+                (a->rms * a->rms * a_frames + b->rms * b->rms * b_frames)
+                / (a_frames + b_frames));
+            }
+        }
+    }
+}
+
+/**
+ * Returns the coarsest level with at most
+ * @p frames_per_pixel frames per peak.
+ */
+const AudioClipPeaksLevel *
+audio_clip_peaks_get_level (
+  const AudioClipPeaks * self,
+  double                 frames_per_pixel)
+{
+  const AudioClipPeaksLevel * ret = NULL;
+  for (int i = 0; i < self->num_levels; i++)
+    {
+      const AudioClipPeaksLevel * level = &self->levels[i];
+      if ((double) level->frames_per_peak > frames_per_pixel)
+        break;
+
+      ret = level;
+    }
+
+  return ret;
+}
+
+/**
+ * Gets the minimum and maximum of the peaks in the given
+ * level covering [start, start + nframes).
+ */
+void
+audio_clip_peaks_get_min_max (
+  const AudioClipPeaksLevel * level,
+  channels_t                  ch,
+  unsigned_frame_t            start,
+  unsigned_frame_t            nframes,
+  float *                     min,
+  float *                     max)
+{
+  size_t           last_peak = level->num_peaks - 1;
+  unsigned_frame_t end = start + MAX (nframes, 1) - 1;
+  size_t first = MIN ((size_t) (start / level->frames_per_peak), last_peak);
+  size_t last = MIN ((size_t) (end / level->frames_per_peak), last_peak);
+
+  const AudioClipPeak * peaks = level->ch_peaks[ch];
+  *min = peaks[first].min;
+  *max = peaks[first].max;
+  for (size_t i = first + 1; i <= last; i++)
+    {
+      *min = MIN (*min, peaks[i].min);
+      *max = MAX (*max, peaks[i].max);
+    }
+}
+
+/**
+ * Maps the peaks of the clip with the given file hash,
+ * if a valid peaks file exists.
+ */
+AudioClipPeaks *
+audio_clip_peaks_load (
+  const char *     file_hash,
+  int              samplerate,
+  channels_t       channels,
+  unsigned_frame_t num_frames)
+{
+  char * path = audio_clip_peaks_get_path (file_hash, samplerate);
+  if (!path || !g_file_test (path, G_FILE_TEST_EXISTS))
+    {
+      g_free (path);
+      return NULL;
+    }
+
+  GError *      err = NULL;
+  GMappedFile * mapped_file = g_mapped_file_new (path, false, &err);
+  if (!mapped_file)
+    {
+      g_message ("Failed to map clip peaks %s: %s", path, err->message);
+      g_error_free (err);
+      g_free (path);
+      return NULL;
+    }
+
+  AudioClipPeaks * self = object_new (AudioClipPeaks);
+  self->channels = channels;
+  self->num_frames = num_frames;
+  size_t num_peaks = init_levels (self);
+
+  size_t size = g_mapped_file_get_length (mapped_file);
+  char * contents = g_mapped_file_get_contents (mapped_file);
+  const AudioClipPeaksHeader * header =
+    (const AudioClipPeaksHeader *) contents;
+  if (
+    size < sizeof (AudioClipPeaksHeader)
+    || memcmp (header->magic, AUDIO_CLIP_PEAKS_MAGIC, sizeof (header->magic))
+         != 0
+    || header->version != AUDIO_CLIP_PEAKS_VERSION
+    || header->channels != channels || header->num_frames != num_frames
+    || header->base_frames != AUDIO_CLIP_PEAKS_BASE_FRAMES
+    || header->num_levels != (uint32_t) self->num_levels
+    || size
+         != sizeof (AudioClipPeaksHeader)
+              + num_peaks * channels * sizeof (AudioClipPeak))
+    {
+      g_message ("Ignoring stale clip peaks %s", path);
+      g_mapped_file_unref (mapped_file);
+      object_zero_and_free (self);
+      g_free (path);
+      return NULL;
+    }
+
+  self->mapped_file = mapped_file;
+  self->data = (AudioClipPeak *) &contents[sizeof (AudioClipPeaksHeader)];
+  set_level_pointers (self);
+  g_free (path);
+
+  return self;
+}
+
+/**
+ * Writes the peaks to the cache.
+ */
+bool
+audio_clip_peaks_store (
+  const AudioClipPeaks * self,
+  const char *           file_hash,
+  int                    samplerate,
+  GError **              error)
+{
+  char * path = audio_clip_peaks_get_path (file_hash, samplerate);
+  if (!path)
+    {
+      g_set_error_literal (
+        error, Z_AUDIO_CLIP_PEAKS_ERROR, Z_AUDIO_CLIP_PEAKS_ERROR_FAILED,
+        "No project to store the peaks in");
+      return false;
+    }
+
+  GError * err = NULL;
+  char *   dir = g_path_get_dirname (path);
+  bool     success = io_mkdir (dir, &err);
+  g_free (dir);
+  if (!success)
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, "Failed to create the clip cache directory");
+      g_free (path);
+      return false;
+    }
+
+  AudioClipPeaksHeader header = {
+    .version = AUDIO_CLIP_PEAKS_VERSION,
+    .channels = self->channels,
+    .num_frames = self->num_frames,
+    .base_frames = AUDIO_CLIP_PEAKS_BASE_FRAMES,
+    .num_levels = (uint32_t) self->num_levels,
+  };
+  memcpy (header.magic, AUDIO_CLIP_PEAKS_MAGIC, sizeof (header.magic));
+
+  size_t num_peaks = 0;
+  for (int i = 0; i < self->num_levels; i++)
+    {
+      num_peaks += self->levels[i].num_peaks;
+    }
+  size_t data_size = num_peaks * self->channels * sizeof (AudioClipPeak);
+
+  /* write to a temporary file first so that a partially
+   * written file is never picked up */
+  char * tmp_path = g_strdup_printf ("%s.tmp", path);
+  FILE * f = g_fopen (tmp_path, "wb");
+  success = f != NULL;
+  if (success)
+    {
+      success =
+        fwrite (&header, 1, sizeof (header), f) == sizeof (header)
+        && fwrite (self->data, 1, data_size, f) == data_size;
+      success = fclose (f) == 0 && success;
+    }
+  if (success)
+    {
+      success = g_rename (tmp_path, path) == 0;
+    }
+  if (!success)
+    {
+      g_set_error (
+        error, Z_AUDIO_CLIP_PEAKS_ERROR, Z_AUDIO_CLIP_PEAKS_ERROR_FAILED,
+        "Failed to write clip peaks %s", path);
+      io_remove (tmp_path);
+    }
+
+  g_free (tmp_path);
+  g_free (path);
+
+  return success;
+}
+
+void
+audio_clip_peaks_free (AudioClipPeaks * self)
+{
+  if (self->mapped_file)
+    {
+      g_mapped_file_unref (self->mapped_file);
+    }
+  else
+    {
+      object_zero_and_free_if_nonnull (self->data);
+    }
+
+  object_zero_and_free (self);
+}
+
+/**
+ * Creates a job for generating the peaks of the clip.
+ */
+AudioClipPeaksJob *
+audio_clip_peaks_job_new (AudioClip * clip)
+{
+  AudioClipPeaksJob * self = g_atomic_rc_box_new0 (AudioClipPeaksJob);
+  self->clip = clip;
+  if (clip->stream)
+    {
+      self->filepath = g_strdup (clip->stream->filepath);
+    }
+  self->channels = clip->channels;
+  self->num_frames = clip->num_frames;
+  self->file_hash = g_strdup (clip->file_hash);
+  self->samplerate = clip->samplerate;
+  self->state = AUDIO_CLIP_PEAKS_JOB_PENDING;
+  g_mutex_init (&self->frames_lock);
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+
+  return self;
+}
+
+/**
+ * Generates the peaks from the clip's frames or its
+ * file.
+ *
+ * @return The peaks, or NULL if failed or cancelled.
+ */
+static AudioClipPeaks *
+generate_peaks (AudioClipPeaksJob * self, GError ** error)
+{
+  AudioFile * af = NULL;
+  float *     read_buf = NULL;
+  float *     ch_bufs[16] = { 0 };
+  GError *    err = NULL;
+  if (self->filepath)
+    {
+      af = audio_file_new (self->filepath);
+      if (!audio_file_read_metadata (af, &err))
+        {
+          audio_file_free (af);
+          PROPAGATE_PREFIXED_ERROR (
+            error, err, "Error reading metadata from %s", self->filepath);
+          return NULL;
+        }
+      if (
+        (channels_t) af->metadata.channels != self->channels
+        || (unsigned_frame_t) af->metadata.num_frames < self->num_frames)
+        {
+          audio_file_free (af);
+          g_set_error (
+            error, Z_AUDIO_CLIP_PEAKS_ERROR, Z_AUDIO_CLIP_PEAKS_ERROR_FAILED,
+            "%s does not match the clip", self->filepath);
+          return NULL;
+        }
+      read_buf = object_new_n (
+        (size_t) AUDIO_CLIP_PEAKS_CHUNK_FRAMES * self->channels, float);
+      for (channels_t ch = 0; ch < self->channels; ch++)
+        {
+          ch_bufs[ch] = object_new_n (AUDIO_CLIP_PEAKS_CHUNK_FRAMES, float);
+        }
+    }
+
+  AudioClipPeaks * peaks =
+    audio_clip_peaks_new (self->channels, self->num_frames);
+  bool success = true;
+  for (unsigned_frame_t start = 0; start < self->num_frames;
+       start += AUDIO_CLIP_PEAKS_CHUNK_FRAMES)
+    {
+      if (g_atomic_int_get (&self->cancel))
+        {
+          success = false;
+          break;
+        }
+
+      size_t nframes =
+        (size_t) MIN (AUDIO_CLIP_PEAKS_CHUNK_FRAMES, self->num_frames - start);
+      const float * ch_frames[16];
+      if (af)
+        {
+          success = audio_file_read_samples (
+            af, true, read_buf, (size_t) start, nframes, &err);
+          if (!success)
+            {
+              PROPAGATE_PREFIXED_ERROR (
+                error, err, "Error reading frames from %s", self->filepath);
+              break;
+            }
+          for (channels_t ch = 0; ch < self->channels; ch++)
+            {
+              for (size_t i = 0; i < nframes; i++)
+                {
+                  ch_bufs[ch][i] = read_buf[i * self->channels + ch];
+                }
+              ch_frames[ch] = ch_bufs[ch];
+            }
+        }
+      else
+        {
+          g_mutex_lock (&self->frames_lock);
+          for (channels_t ch = 0; ch < self->channels; ch++)
+            {
+              ch_frames[ch] = &self->clip->ch_frames[ch][start];
+            }
+          audio_clip_peaks_add_frames (peaks, ch_frames, start, nframes);
+          g_mutex_unlock (&self->frames_lock);
+          continue;
+        }
+      audio_clip_peaks_add_frames (peaks, ch_frames, start, nframes);
+    }
+
+  if (af)
+    {
+      if (!audio_file_finish (af, &err))
+        {
+          g_message ("Failed to close %s: %s", self->filepath, err->message);
+          g_clear_error (&err);
+        }
+      audio_file_free (af);
+      object_zero_and_free (read_buf);
+      for (channels_t ch = 0; ch < self->channels; ch++)
+        {
+          object_zero_and_free (ch_bufs[ch]);
+        }
+    }
+
+  if (!success)
+    {
+      audio_clip_peaks_free (peaks);
+      return NULL;
+    }
+
+  audio_clip_peaks_finish (peaks);
+
+  return peaks;
+}
+
+/**
+ * Loads the peaks from the cache or generates them, and
+ * publishes them to the clip.
+ */
+void
+audio_clip_peaks_job_run (AudioClipPeaksJob * self)
+{
+  if (!g_atomic_int_compare_and_exchange (
+        &self->state, AUDIO_CLIP_PEAKS_JOB_PENDING,
+        AUDIO_CLIP_PEAKS_JOB_RUNNING))
+    return;
+
+  AudioClipPeaks * peaks = NULL;
+  if (self->file_hash)
+    {
+      peaks = audio_clip_peaks_load (
+        self->file_hash, self->samplerate, self->channels, self->num_frames);
+    }
+  if (!peaks)
+    {
+      GError * err = NULL;
+      peaks = generate_peaks (self, &err);
+      if (!peaks && err)
+        {
+          g_message (
+            "Failed to generate peaks of clip %s: %s", self->clip->name,
+            err->message);
+          g_clear_error (&err);
+        }
+      if (
+        peaks && self->file_hash
+        && !audio_clip_peaks_store (
+          peaks, self->file_hash, self->samplerate, &err))
+        {
+          g_message (
+            "Failed to store peaks of clip %s: %s", self->clip->name,
+            err->message);
+          g_clear_error (&err);
+        }
+    }
+
+  if (peaks && !g_atomic_int_get (&self->cancel))
+    {
+      g_atomic_pointer_set (&self->clip->peaks, peaks);
+    }
+  else if (peaks)
+    {
+      audio_clip_peaks_free (peaks);
+    }
+
+  g_mutex_lock (&self->lock);
+  g_atomic_int_set (&self->state, AUDIO_CLIP_PEAKS_JOB_DONE);
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+/**
+ * Stops the job, waiting for it to finish if it already
+ * started.
+ */
+void
+audio_clip_peaks_job_cancel (AudioClipPeaksJob * self)
+{
+  if (g_atomic_int_compare_and_exchange (
+        &self->state, AUDIO_CLIP_PEAKS_JOB_PENDING,
+        AUDIO_CLIP_PEAKS_JOB_CANCELLED))
+    return;
+
+  /* running jobs check this between chunks */
+  g_atomic_int_set (&self->cancel, 1);
+  g_mutex_lock (&self->lock);
+  while (g_atomic_int_get (&self->state) == AUDIO_CLIP_PEAKS_JOB_RUNNING)
+    {
+      g_cond_wait (&self->cond, &self->lock);
+    }
+  g_mutex_unlock (&self->lock);
+}
+
+/**
+ * Keeps the job from reading the frames of the clip.
+ */
+void
+audio_clip_peaks_job_lock_frames (AudioClipPeaksJob * self)
+{
+  g_mutex_lock (&self->frames_lock);
+}
+
+void
+audio_clip_peaks_job_unlock_frames (AudioClipPeaksJob * self)
+{
+  g_mutex_unlock (&self->frames_lock);
+}
+
+static void
+job_clear (void * data)
+{
+  AudioClipPeaksJob * self = (AudioClipPeaksJob *) data;
+  g_free_and_null (self->filepath);
+  g_free_and_null (self->file_hash);
+  g_mutex_clear (&self->frames_lock);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+}
+
+void
+audio_clip_peaks_job_unref (AudioClipPeaksJob * self)
+{
+  g_atomic_rc_box_release_full (self, job_clear);
+}
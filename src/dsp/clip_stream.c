@@ -0,0 +1,713 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include <stdlib.h>
+
+#include "dsp/clip_stream.h"
+#include "io/audio_file.h"
+#include "utils/dsp.h"
+#include "utils/error.h"
+#include "utils/objects.h"
+
+#define RING_MASK ((unsigned_frame_t) AUDIO_CLIP_STREAM_RING_FRAMES - 1)
+
+/** Interval at which the streamer thread checks the
+ * streams. */
+#define STREAMER_INTERVAL_USEC 5000
+
+static float **
+ch_bufs_new (channels_t channels, size_t nframes)
+{
+  float ** bufs = object_new_n (channels, float *);
+  for (channels_t i = 0; i < channels; i++)
+    {
+      bufs[i] = object_new_n (nframes, float);
+    }
+  return bufs;
+}
+
+static void
+ch_bufs_free (float ** bufs, channels_t channels)
+{
+  for (channels_t i = 0; i < channels; i++)
+    {
+      free (bufs[i]);
+    }
+  free (bufs);
+}
+
+static void
+preroll_set_free (AudioClipStreamPrerollSet * set, channels_t channels)
+{
+  for (int i = 0; i < set->num_prerolls; i++)
+    {
+      ch_bufs_free (set->prerolls[i].ch_frames, channels);
+    }
+  free (set->prerolls);
+  free (set);
+}
+
+/**
+ * Opens a stream for the given file.
+ */
+AudioClipStream *
+audio_clip_stream_new (const char * filepath, GError ** error)
+{
+  AudioFile * af = audio_file_new (filepath);
+  GError *    err = NULL;
+  if (!audio_file_read_metadata (af, &err))
+    {
+      audio_file_free (af);
+      PROPAGATE_PREFIXED_ERROR (
+        error, err, "Error reading metadata from %s", filepath);
+      return NULL;
+    }
+
+  AudioClipStream * self = object_new (AudioClipStream);
+  self->filepath = g_strdup (filepath);
+  self->af = af;
+  self->channels = (channels_t) af->metadata.channels;
+  self->num_frames = (unsigned_frame_t) af->metadata.num_frames;
+  self->read_buf =
+    object_new_n ((size_t) AUDIO_CLIP_STREAM_CHUNK_FRAMES * self->channels, float);
+  self->retired_prerolls = g_ptr_array_new ();
+  self->anchors = g_array_new (false, false, sizeof (unsigned_frame_t));
+  g_mutex_init (&self->anchors_lock);
+
+  for (int i = 0; i < AUDIO_CLIP_STREAM_NUM_CURSORS; i++)
+    {
+      AudioClipStreamCursor * cursor = &self->cursors[i];
+      cursor->ring = ch_bufs_new (self->channels, AUDIO_CLIP_STREAM_RING_FRAMES);
+      atomic_init (&cursor->owner, 0);
+      atomic_init (&cursor->last_cycle, 0);
+      atomic_init (&cursor->play_pos, -1);
+      atomic_init (&cursor->seq, 0);
+      atomic_init (&cursor->window_start, 0);
+      atomic_init (&cursor->window_end, 0);
+    }
+
+  AudioClipStreamPrerollSet * set = object_new (AudioClipStreamPrerollSet);
+  atomic_init (&self->prerolls, set);
+
+  return self;
+}
+
+/**
+ * Sets the positions to keep pre-rolls at.
+ */
+void
+audio_clip_stream_set_anchors (
+  AudioClipStream *        self,
+  const unsigned_frame_t * anchors,
+  int                      num_anchors)
+{
+  g_mutex_lock (&self->anchors_lock);
+  g_array_set_size (self->anchors, 0);
+  g_array_append_vals (self->anchors, anchors, (guint) num_anchors);
+  self->anchors_changed = true;
+  g_mutex_unlock (&self->anchors_lock);
+
+  if (self->streamer)
+    {
+      audio_clip_streamer_wake_up (self->streamer);
+    }
+}
+
+/**
+ * Reads @p nframes frames starting at @p start from the
+ * file into the given per-channel buffers.
+ */
+static bool
+read_from_file (
+  AudioClipStream * self,
+  unsigned_frame_t  start,
+  size_t            nframes,
+  float **          dest,
+  size_t            dest_offset,
+  unsigned_frame_t  dest_mask)
+{
+  GError * err = NULL;
+  bool     success = audio_file_read_samples (
+    self->af, true, self->read_buf, (size_t) start, nframes, &err);
+  if (!success)
+    {
+      /* this runs in the disk thread so only log it */
+      g_warning (
+        "Failed to read from streamed clip %s: %s", self->filepath,
+        err->message);
+      g_error_free (err);
+      return false;
+    }
+
+  for (channels_t ch = 0; ch < self->channels; ch++)
+    {
+      float * ch_dest = dest[ch];
+      for (size_t i = 0; i < nframes; i++)
+        {
+          ch_dest[(dest_offset + i) & dest_mask] =
+            self->read_buf[i * self->channels + ch];
+        }
+    }
+
+  return true;
+}
+
+static int
+frames_cmp (const void * a, const void * b)
+{
+  unsigned_frame_t frames_a = *(const unsigned_frame_t *) a;
+  unsigned_frame_t frames_b = *(const unsigned_frame_t *) b;
+  return frames_a < frames_b ? -1 : (frames_a > frames_b ? 1 : 0);
+}
+
+/**
+ * Generates a pre-roll set from the current anchors.
+ */
+static AudioClipStreamPrerollSet *
+gen_preroll_set (AudioClipStream * self)
+{
+  g_mutex_lock (&self->anchors_lock);
+  GArray * anchors = g_array_copy (self->anchors);
+  self->anchors_changed = false;
+  g_mutex_unlock (&self->anchors_lock);
+
+  g_array_sort (anchors, frames_cmp);
+
+  AudioClipStreamPrerollSet * set = object_new (AudioClipStreamPrerollSet);
+  set->prerolls = object_new_n (MAX (anchors->len, 1), AudioClipStreamPreroll);
+  for (guint i = 0; i < anchors->len; i++)
+    {
+      unsigned_frame_t start = g_array_index (anchors, unsigned_frame_t, i);
+      if (start >= self->num_frames)
+        break;
+
+      /* skip anchors already covered by the previous
+       * pre-roll */
+      if (set->num_prerolls > 0)
+        {
+          AudioClipStreamPreroll * prev =
+            &set->prerolls[set->num_prerolls - 1];
+          if (start < prev->start + prev->num_frames)
+            continue;
+        }
+
+      AudioClipStreamPreroll * preroll = &set->prerolls[set->num_prerolls];
+      preroll->start = start;
+      preroll->num_frames =
+        MIN (AUDIO_CLIP_STREAM_PREROLL_FRAMES, self->num_frames - start);
+      preroll->ch_frames =
+        ch_bufs_new (self->channels, (size_t) preroll->num_frames);
+      bool success = true;
+      for (unsigned_frame_t j = 0; j < preroll->num_frames && success;
+           j += AUDIO_CLIP_STREAM_CHUNK_FRAMES)
+        {
+          size_t nframes =
+            MIN (AUDIO_CLIP_STREAM_CHUNK_FRAMES, preroll->num_frames - j);
+          success = read_from_file (
+            self, start + j, nframes, preroll->ch_frames, (size_t) j,
+            UINT64_MAX);
+        }
+      if (!success)
+        {
+          ch_bufs_free (preroll->ch_frames, self->channels);
+          continue;
+        }
+      set->num_prerolls++;
+    }
+  g_array_free (anchors, true);
+
+  return set;
+}
+
+/**
+ * Refills the ring buffer of the given cursor from its
+ * play position.
+ */
+static void
+process_cursor (AudioClipStream * self, AudioClipStreamCursor * cursor)
+{
+  int64_t pos = atomic_load_explicit (&cursor->play_pos, memory_order_acquire);
+  if (pos < 0 || pos >= (int64_t) self->num_frames)
+    return;
+
+  int64_t start =
+    atomic_load_explicit (&cursor->window_start, memory_order_relaxed);
+  int64_t end = atomic_load_explicit (&cursor->window_end, memory_order_relaxed);
+
+  /* move the window if the reader jumped */
+  if (pos < start || pos > end)
+    {
+      atomic_fetch_add_explicit (&cursor->seq, 1, memory_order_relaxed);
+      atomic_thread_fence (memory_order_release);
+      atomic_store_explicit (&cursor->window_start, pos, memory_order_relaxed);
+      atomic_store_explicit (&cursor->window_end, pos, memory_order_relaxed);
+      atomic_fetch_add_explicit (&cursor->seq, 1, memory_order_release);
+      start = pos;
+      end = pos;
+    }
+
+  /* drop the frames already read (except a few) to make
+   * room for new ones */
+  int64_t new_start = MAX (start, pos - AUDIO_CLIP_STREAM_LOOKBEHIND_FRAMES);
+  int64_t target_end =
+    MIN ((int64_t) self->num_frames, new_start + AUDIO_CLIP_STREAM_RING_FRAMES);
+  if (end >= target_end)
+    return;
+
+  if (new_start != start)
+    {
+      /* publish the new start before overwriting the
+       * dropped frames, so that readers detect it */
+      atomic_store_explicit (
+        &cursor->window_start, new_start, memory_order_relaxed);
+      atomic_thread_fence (memory_order_release);
+    }
+
+  while (end < target_end)
+    {
+      size_t nframes =
+        (size_t) MIN (AUDIO_CLIP_STREAM_CHUNK_FRAMES, target_end - end);
+      if (!read_from_file (
+            self, (unsigned_frame_t) end, nframes, cursor->ring, (size_t) end,
+            RING_MASK))
+        {
+          return;
+        }
+      end += (int64_t) nframes;
+      atomic_store_explicit (&cursor->window_end, end, memory_order_release);
+
+      /* start over if the reader jumped elsewhere */
+      int64_t cur_pos =
+        atomic_load_explicit (&cursor->play_pos, memory_order_acquire);
+      if (cur_pos < new_start || cur_pos > end)
+        {
+          return;
+        }
+    }
+}
+
+/**
+ * Reads from the file whatever the readers need.
+ */
+void
+audio_clip_stream_process (AudioClipStream * self, uint64_t cycle)
+{
+  /* free replaced pre-rolls the engine is done with */
+  for (guint i = 0; i < self->retired_prerolls->len;)
+    {
+      AudioClipStreamPrerollSet * set =
+        g_ptr_array_index (self->retired_prerolls, i);
+      if (cycle >= set->retire_cycle + 2)
+        {
+          preroll_set_free (set, self->channels);
+          g_ptr_array_remove_index_fast (self->retired_prerolls, i);
+        }
+      else
+        {
+          i++;
+        }
+    }
+
+  if (self->anchors_changed)
+    {
+      AudioClipStreamPrerollSet * set = gen_preroll_set (self);
+      AudioClipStreamPrerollSet * prev =
+        atomic_exchange_explicit (&self->prerolls, set, memory_order_acq_rel);
+      prev->retire_cycle = cycle;
+      g_ptr_array_add (self->retired_prerolls, prev);
+    }
+
+  for (int i = 0; i < AUDIO_CLIP_STREAM_NUM_CURSORS; i++)
+    {
+      process_cursor (self, &self->cursors[i]);
+    }
+}
+
+static inline void
+copy_to_stereo (
+  const AudioClipStream * self,
+  float * const *         src,
+  size_t                  src_offset,
+  size_t                  nframes,
+  float *                 lbuf,
+  float *                 rbuf)
+{
+  dsp_copy (lbuf, &src[0][src_offset], nframes);
+  dsp_copy (rbuf, &src[self->channels > 1 ? 1 : 0][src_offset], nframes);
+}
+
+static bool
+read_from_prerolls (
+  AudioClipStream * self,
+  unsigned_frame_t  start,
+  size_t            nframes,
+  float *           lbuf,
+  float *           rbuf)
+{
+  const AudioClipStreamPrerollSet * set =
+    atomic_load_explicit (&self->prerolls, memory_order_acquire);
+  for (int i = 0; i < set->num_prerolls; i++)
+    {
+      const AudioClipStreamPreroll * preroll = &set->prerolls[i];
+      if (preroll->start > start)
+        break;
+
+      if (start + nframes <= preroll->start + preroll->num_frames)
+        {
+          copy_to_stereo (
+            self, preroll->ch_frames, (size_t) (start - preroll->start),
+            nframes, lbuf, rbuf);
+          return true;
+        }
+    }
+
+  return false;
+}
+
+static bool
+read_from_cursor (
+  AudioClipStream *       self,
+  AudioClipStreamCursor * cursor,
+  unsigned_frame_t        start,
+  size_t                  nframes,
+  float *                 lbuf,
+  float *                 rbuf)
+{
+  uint64_t seq = atomic_load_explicit (&cursor->seq, memory_order_acquire);
+  if (seq & 1)
+    return false;
+
+  int64_t window_start =
+    atomic_load_explicit (&cursor->window_start, memory_order_acquire);
+  int64_t window_end =
+    atomic_load_explicit (&cursor->window_end, memory_order_acquire);
+  if (
+    (int64_t) start < window_start
+    || (int64_t) (start + nframes) > window_end)
+    {
+      return false;
+    }
+
+  /* copy, wrapping around the end of the ring */
+  size_t offset = (size_t) (start & RING_MASK);
+  size_t first_part = MIN (nframes, AUDIO_CLIP_STREAM_RING_FRAMES - offset);
+  copy_to_stereo (self, cursor->ring, offset, first_part, lbuf, rbuf);
+  if (first_part < nframes)
+    {
+      copy_to_stereo (
+        self, cursor->ring, 0, nframes - first_part, &lbuf[first_part],
+        &rbuf[first_part]);
+    }
+
+  /* make sure the frames were not overwritten while
+   * copying */
+  atomic_thread_fence (memory_order_acquire);
+  return atomic_load_explicit (&cursor->seq, memory_order_relaxed) == seq
+         && atomic_load_explicit (&cursor->window_start, memory_order_relaxed)
+              <= (int64_t) start;
+}
+
+/**
+ * Returns the cursor following @p reader, claiming a free
+ * one or taking over one that was not read from recently
+ * if needed.
+ */
+static AudioClipStreamCursor *
+get_cursor (AudioClipStream * self, uint64_t reader, uint64_t cycle)
+{
+  for (int i = 0; i < AUDIO_CLIP_STREAM_NUM_CURSORS; i++)
+    {
+      AudioClipStreamCursor * cursor = &self->cursors[i];
+      if (atomic_load_explicit (&cursor->owner, memory_order_relaxed) == reader)
+        return cursor;
+    }
+
+  AudioClipStreamCursor * lru = NULL;
+  uint64_t                lru_cycle = UINT64_MAX;
+  for (int i = 0; i < AUDIO_CLIP_STREAM_NUM_CURSORS; i++)
+    {
+      AudioClipStreamCursor * cursor = &self->cursors[i];
+      uint64_t                owner =
+        atomic_load_explicit (&cursor->owner, memory_order_relaxed);
+      uint64_t last_cycle =
+        atomic_load_explicit (&cursor->last_cycle, memory_order_relaxed);
+      if (owner == 0)
+        {
+          lru = cursor;
+          break;
+        }
+      /* don't take over cursors read from in this or the
+       * previous cycle */
+      if (last_cycle + 1 < cycle && last_cycle < lru_cycle)
+        {
+          lru = cursor;
+          lru_cycle = last_cycle;
+        }
+    }
+  if (!lru)
+    return NULL;
+
+  uint64_t prev_owner = atomic_load_explicit (&lru->owner, memory_order_relaxed);
+  if (!atomic_compare_exchange_strong_explicit (
+        &lru->owner, &prev_owner, reader, memory_order_acq_rel,
+        memory_order_relaxed))
+    {
+      return NULL;
+    }
+
+  return lru;
+}
+
+/**
+ * Reads frames into the given stereo buffers.
+ */
+bool
+audio_clip_stream_read (
+  AudioClipStream * self,
+  uint64_t          reader,
+  uint64_t          cycle,
+  unsigned_frame_t  start,
+  size_t            nframes,
+  float *           lbuf,
+  float *           rbuf)
+{
+  /* the pre-rolls and any ring buffer holding the frames
+   * can serve the read */
+  bool success = read_from_prerolls (self, start, nframes, lbuf, rbuf);
+  for (int i = 0; !success && i < AUDIO_CLIP_STREAM_NUM_CURSORS; i++)
+    {
+      success =
+        read_from_cursor (self, &self->cursors[i], start, nframes, lbuf, rbuf);
+    }
+
+  /* let the disk thread know where to read next */
+  AudioClipStreamCursor * cursor = get_cursor (self, reader, cycle);
+  if (cursor)
+    {
+      atomic_store_explicit (&cursor->last_cycle, cycle, memory_order_relaxed);
+      atomic_store_explicit (
+        &cursor->play_pos, (int64_t) (start + nframes), memory_order_release);
+    }
+
+  if (!success)
+    {
+      dsp_fill (lbuf, 0.f, nframes);
+      dsp_fill (rbuf, 0.f, nframes);
+      g_atomic_int_inc (&self->num_misses);
+    }
+
+  return success;
+}
+
+/**
+ * Frees the stream, removing it from its streamer
+ * first.
+ */
+void
+audio_clip_stream_free (AudioClipStream * self)
+{
+  if (self->streamer)
+    {
+      audio_clip_streamer_remove_stream (self->streamer, self);
+    }
+
+  for (int i = 0; i < AUDIO_CLIP_STREAM_NUM_CURSORS; i++)
+    {
+      ch_bufs_free (self->cursors[i].ring, self->channels);
+    }
+  preroll_set_free (
+    atomic_load_explicit (&self->prerolls, memory_order_relaxed),
+    self->channels);
+  for (guint i = 0; i < self->retired_prerolls->len; i++)
+    {
+      preroll_set_free (
+        g_ptr_array_index (self->retired_prerolls, i), self->channels);
+    }
+  g_ptr_array_unref (self->retired_prerolls);
+  g_array_free (self->anchors, true);
+  g_mutex_clear (&self->anchors_lock);
+
+  GError * err = NULL;
+  if (!audio_file_finish (self->af, &err))
+    {
+      g_warning (
+        "Failed to close streamed clip %s: %s", self->filepath, err->message);
+      g_error_free (err);
+    }
+  object_free_w_func_and_null (audio_file_free, self->af);
+  g_free_and_null (self->filepath);
+  object_zero_and_free (self->read_buf);
+
+  object_zero_and_free (self);
+}
+
+static gpointer
+streamer_thread (gpointer data)
+{
+  AudioClipStreamer * self = (AudioClipStreamer *) data;
+
+  GPtrArray * streams = g_ptr_array_new ();
+  g_mutex_lock (&self->lock);
+  while (g_atomic_int_get (&self->run))
+    {
+      uint64_t cycle = (uint64_t) *self->cycle;
+
+      /* read from the files without holding the lock so
+       * that other threads (eg, the GTK thread updating
+       * the anchors) don't wait for the disk */
+      g_ptr_array_set_size (streams, 0);
+      g_ptr_array_extend (streams, self->streams, NULL, NULL);
+      for (guint i = 0; i < streams->len; i++)
+        {
+          AudioClipStream * stream = g_ptr_array_index (streams, i);
+
+          /* skip streams removed while reading from
+           * the previous one */
+          if (!g_ptr_array_find (self->streams, stream, NULL))
+            continue;
+
+          self->processing_stream = stream;
+          g_mutex_unlock (&self->lock);
+
+          audio_clip_stream_process (stream, cycle);
+
+          g_mutex_lock (&self->lock);
+          self->processing_stream = NULL;
+          g_cond_broadcast (&self->processing_done_cond);
+        }
+
+      for (guint i = 0; i < self->retired_streams->len;)
+        {
+          AudioClipStream * stream = g_ptr_array_index (self->retired_streams, i);
+          if (cycle >= stream->retire_cycle + 2)
+            {
+              audio_clip_stream_free (stream);
+              g_ptr_array_remove_index_fast (self->retired_streams, i);
+            }
+          else
+            {
+              i++;
+            }
+        }
+
+      g_cond_wait_until (
+        &self->cond, &self->lock,
+        g_get_monotonic_time () + STREAMER_INTERVAL_USEC);
+    }
+  g_mutex_unlock (&self->lock);
+  g_ptr_array_unref (streams);
+
+  return NULL;
+}
+
+/**
+ * Creates a streamer and starts its thread.
+ */
+AudioClipStreamer *
+audio_clip_streamer_new (const uint_fast64_t * cycle)
+{
+  AudioClipStreamer * self = object_new (AudioClipStreamer);
+
+  self->cycle = cycle;
+  self->streams = g_ptr_array_new ();
+  self->retired_streams = g_ptr_array_new ();
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+  g_cond_init (&self->processing_done_cond);
+  g_atomic_int_set (&self->run, 1);
+  self->thread = g_thread_new ("clip_streamer", streamer_thread, self);
+
+  return self;
+}
+
+void
+audio_clip_streamer_add_stream (
+  AudioClipStreamer * self,
+  AudioClipStream *   stream)
+{
+  g_return_if_fail (!stream->streamer);
+
+  g_mutex_lock (&self->lock);
+  g_ptr_array_add (self->streams, stream);
+  stream->streamer = self;
+  g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+/**
+ * Removes the stream from the streamer without freeing
+ * it.
+ *
+ * Waits until the thread is done reading into the
+ * stream.
+ */
+void
+audio_clip_streamer_remove_stream (
+  AudioClipStreamer * self,
+  AudioClipStream *   stream)
+{
+  g_mutex_lock (&self->lock);
+  g_ptr_array_remove_fast (self->streams, stream);
+  stream->streamer = NULL;
+  while (self->processing_stream == stream)
+    {
+      g_cond_wait (&self->processing_done_cond, &self->lock);
+    }
+  g_mutex_unlock (&self->lock);
+}
+
+/**
+ * Removes the stream from the streamer and frees it once
+ * the engine cannot be reading from it anymore.
+ */
+void
+audio_clip_streamer_retire_stream (
+  AudioClipStreamer * self,
+  AudioClipStream *   stream)
+{
+  g_mutex_lock (&self->lock);
+  g_ptr_array_remove_fast (self->streams, stream);
+  stream->streamer = NULL;
+  stream->retire_cycle = (uint64_t) *self->cycle;
+  g_ptr_array_add (self->retired_streams, stream);
+  g_mutex_unlock (&self->lock);
+}
+
+/**
+ * Wakes up the streamer thread.
+ */
+void
+audio_clip_streamer_wake_up (AudioClipStreamer * self)
+{
+  g_mutex_lock (&self->lock);
+  g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+/**
+ * Stops the thread and frees the streamer.
+ */
+void
+audio_clip_streamer_free (AudioClipStreamer * self)
+{
+  g_atomic_int_set (&self->run, 0);
+  audio_clip_streamer_wake_up (self);
+  g_thread_join (self->thread);
+
+  for (guint i = 0; i < self->retired_streams->len; i++)
+    {
+      audio_clip_stream_free (g_ptr_array_index (self->retired_streams, i));
+    }
+  g_ptr_array_unref (self->retired_streams);
+  for (guint i = 0; i < self->streams->len; i++)
+    {
+      AudioClipStream * stream = g_ptr_array_index (self->streams, i);
+      stream->streamer = NULL;
+    }
+  g_ptr_array_unref (self->streams);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+  g_cond_clear (&self->processing_done_cond);
+
+  object_zero_and_free (self);
+}
@@ -252,6 +252,8 @@ engine_process_events (AudioEngine * self)
       return G_SOURCE_CONTINUE;
     }
 
+  engine_free_retired_objects (self, false);
+
   self->last_events_process_started = g_get_monotonic_time ();
 
   /*g_debug ("PROCESS EVENTS");*/
@@ -649,6 +651,7 @@ init_common (AudioEngine * self)
 {
   self->metronome = metronome_new ();
   self->router = router_new ();
+  self->retired_objects = g_ptr_array_new ();
 
   /* get audio backend */
   AudioBackend ab_code = AUDIO_BACKEND_DUMMY;
@@ -803,6 +806,11 @@ init_common (AudioEngine * self)
     ZRYTHM_TESTING
       ? PAN_ALGORITHM_SINE_LAW
       : (PanAlgorithm) g_settings_get_enum (S_P_DSP_PAN, "pan-algorithm");
+  self->automation_resolution =
+    ZRYTHM_TESTING
+      ? AUDIO_ENGINE_AUTOMATION_RESOLUTION_CYCLE
+      : (AudioEngineAutomationResolution) g_settings_get_enum (
+        S_P_GENERAL_ENGINE, "automation-resolution");
 
   /* set a temporary buffer sizes */
   if (self->block_length == 0)
@@ -835,14 +843,8 @@ engine_init_loaded (AudioEngine * self, Project * project, GError ** error)
 
   self->project = project;
 
-  GError * err = NULL;
-  bool     success = audio_pool_init_loaded (self->pool, &err);
-  if (!success)
-    {
-      PROPAGATE_PREFIXED_ERROR_LITERAL (
-        error, err, "Failed to initialize audio pool");
-      return false;
-    }
+  /* the pool is initialized by the caller once the
+   * sample rate is known */
 
   Track * tempo_track = NULL;
   if (project)
@@ -1107,6 +1109,65 @@ engine_wait_n_cycles (AudioEngine * self, int n)
     }
 }
 
+/**
+ * An object retired with engine_retire_object().
+ */
+typedef struct RetiredObject
+{
+  void *         obj;
+  GDestroyNotify free_func;
+
+  /** Engine cycle when the object was retired. */
+  uint64_t retire_cycle;
+} RetiredObject;
+
+void
+engine_retire_object (
+  AudioEngine *  self,
+  void *         obj,
+  GDestroyNotify free_func)
+{
+  if (!self || !self->retired_objects)
+    {
+      free_func (obj);
+      return;
+    }
+
+  RetiredObject * retired = object_new (RetiredObject);
+  retired->obj = obj;
+  retired->free_func = free_func;
+  retired->retire_cycle = (uint64_t) self->cycle;
+  g_ptr_array_add (self->retired_objects, retired);
+}
+
+void
+engine_free_retired_objects (AudioEngine * self, bool force)
+{
+  if (!self->retired_objects)
+    return;
+
+  /* cycles started after an object was retired cannot see
+   * it, so it can be freed once the cycle that was running
+   * when it was retired is over, or if no cycle is running
+   * now */
+  const bool     cycle_running = g_atomic_int_get (&self->cycle_running);
+  const uint64_t cycle = (uint64_t) self->cycle;
+  for (guint i = 0; i < self->retired_objects->len;)
+    {
+      RetiredObject * retired = g_ptr_array_index (self->retired_objects, i);
+      if (force || !cycle_running || cycle >= retired->retire_cycle + 2)
+        {
+          retired->free_func (retired->obj);
+          object_zero_and_free (retired);
+          g_ptr_array_remove_index_fast (self->retired_objects, i);
+        }
+      else
+        {
+          i++;
+        }
+    }
+}
+
 /**
  * Activates the audio engine to start processing
  * and receiving events.
@@ -2184,6 +2245,12 @@ engine_free (AudioEngine * self)
 
   object_free_w_func_and_null (port_free, self->midi_clock_out);
 
+  if (self->retired_objects)
+    {
+      engine_free_retired_objects (self, true);
+      g_ptr_array_unref (self->retired_objects);
+    }
+
   object_zero_and_free (self);
 
   g_debug ("finished freeing engine");
@@ -11,6 +11,7 @@
 #  include "dsp/engine.h"
 #  include "dsp/engine_jack.h"
 #  include "dsp/ext_port.h"
+#  include "dsp/midi_event.h"
 #  include "dsp/port.h"
 #  include "dsp/router.h"
 #  include "dsp/tempo_track.h"
@@ -294,6 +295,9 @@ xrun_cb (AudioEngine * self)
         _("XRUN occurred - check your JACK "
         "configuration"));
 #  endif
+      g_debug (
+        "XRUN (external MIDI event contentions so far: %d)",
+        midi_events_get_num_external_contentions ());
       self->last_xrun_notification = cur_time;
     }
 
@@ -13,18 +13,24 @@
 #  include "dsp/engine_jack.h"
 #endif
 #include "dsp/exporter.h"
+#include "dsp/fader.h"
 #include "dsp/marker_track.h"
 #include "dsp/master_track.h"
 #include "dsp/midi_event.h"
 #include "dsp/position.h"
 #include "dsp/router.h"
 #include "dsp/tempo_track.h"
+#include "dsp/track.h"
+#include "dsp/track_processor.h"
 #include "dsp/transport.h"
 #include "gui/widgets/main_window.h"
+#include "plugins/lv2_plugin.h"
+#include "plugins/plugin.h"
 #include "project.h"
 #include "settings/settings.h"
 #include "utils/debug.h"
 #include "utils/dsp.h"
+#include "utils/env.h"
 #include "utils/error.h"
 #include "utils/flags.h"
 #include "utils/io.h"
@@ -42,6 +48,8 @@
 
 #define AMPLITUDE (1.0 * 0x7F000000)
 
+#define EXPORT_CHANNELS 2
+
 static const char * pretty_formats[] = {
   "AIFF",       "AU",  "CAF", "FLAC", "MP3",         "OGG (Vorbis)",
   "OGG (OPUS)", "RAW", "WAV", "W64",  "MIDI Type 0", "MIDI Type 1",
@@ -111,6 +119,452 @@ static void get_export_time_range (
     }
 }
 
+/**
+ * Opens the file to export to and sets its metadata.
+ *
+ * @param sfinfo Format to open the file with (not
+ *   modified).
+ *
+ * @return The file, or NULL if failed (in which case
+ *   the progress info is marked as completed with an
+ *   error).
+ */
+static SNDFILE *
+open_export_file (
+  ExportSettings * info,
+  const char *     file_uri,
+  const SF_INFO *  sfinfo)
+{
+  ProgressInfo * pinfo = info->progress_info;
+
+  char *   dir = io_get_dir (file_uri);
+  GError * err = NULL;
+  bool     success = io_mkdir (dir, &err);
+  if (!success)
+    {
+      char * err_str = g_strdup_printf (
+        _ ("Failed to create directory %s: %s"), dir, err->message);
+      progress_info_mark_completed (
+        pinfo, PROGRESS_COMPLETED_HAS_ERROR, err_str);
+      g_free (err_str);
+      g_error_free (err);
+      g_free (dir);
+      return NULL;
+    }
+  g_free (dir);
+  SF_INFO   file_sfinfo = *sfinfo;
+  SNDFILE * sndfile = sf_open (file_uri, SFM_WRITE, &file_sfinfo);
+
+  if (!sndfile)
+    {
+      int          error = sf_error (NULL);
+      const char * error_str = sf_error_number (error);
+
+      char * err_str = g_strdup_printf (
+        _ ("Couldn't open SNDFILE %s:\n%d: %s"), file_uri, error, error_str);
+      progress_info_mark_completed (
+        pinfo, PROGRESS_COMPLETED_HAS_ERROR, err_str);
+      g_free (err_str);
+
+      return NULL;
+    }
+  if (file_sfinfo.format != sfinfo->format)
+    {
+      char * err_str = g_strdup_printf (
+        _ ("Invalid SNDFILE format %s: 0x%08X != 0x%08X"), file_uri,
+        file_sfinfo.format, sfinfo->format);
+      progress_info_mark_completed (
+        pinfo, PROGRESS_COMPLETED_HAS_ERROR, err_str);
+      g_free (err_str);
+      sf_close (sndfile);
+
+      return NULL;
+    }
+
+  sf_set_string (sndfile, SF_STR_TITLE, PROJECT->title);
+  sf_set_string (sndfile, SF_STR_SOFTWARE, PROGRAM_NAME);
+  sf_set_string (sndfile, SF_STR_ARTIST, info->artist);
+  sf_set_string (sndfile, SF_STR_TITLE, info->title);
+  sf_set_string (sndfile, SF_STR_GENRE, info->genre);
+
+  return sndfile;
+}
+
+/**
+ * Frames collected for each stem before they are
+ * handed to a worker thread for encoding.
+ */
+#define STEM_CHUNK_FRAMES (1 << 13)
+
+/**
+ * Stem being written during a single-pass stem export.
+ */
+typedef struct StemWriter
+{
+  const ExportStem * stem;
+
+  /** Ports tapped for the stem's output. */
+  Port * l;
+  Port * r;
+
+  SNDFILE * sndfile;
+
+  /** Interleaved frames being collected by the render
+   * thread. */
+  float * fill_buf;
+  size_t  num_fill_frames;
+
+  /** Interleaved frames being encoded by a worker
+   * thread. */
+  float * encode_buf;
+  size_t  num_encode_frames;
+
+  Ditherer ditherer;
+
+  /** Max amplitude above 0 dB detected, if any. */
+  float clip_amp;
+
+  /** Error while encoding, if any. */
+  char * error;
+} StemWriter;
+
+/**
+ * Encodes the stems of a single-pass stem export.
+ *
+ * While the render thread collects the next chunk of
+ * each stem, the previous chunks are dithered and
+ * encoded in parallel by a thread pool (one task per
+ * stem, so each file is only written by one thread at a
+ * time).
+ */
+typedef struct StemEncoder
+{
+  ExportSettings * info;
+
+  StemWriter * writers;
+  size_t       num_writers;
+
+  /** Frames per chunk. */
+  size_t chunk_frames;
+
+  GThreadPool * pool;
+
+  /** Number of stems being encoded. */
+  guint num_pending;
+
+  GMutex lock;
+  GCond  cond;
+} StemEncoder;
+
+/**
+ * Returns the ports to tap for the track's output at
+ * the given step.
+ */
+static bool
+get_stem_ports (Track * track, BounceStep step, Port ** l, Port ** r)
+{
+  if (
+    !track_type_has_channel (track->type)
+    || track->out_signal_type != TYPE_AUDIO)
+    return false;
+
+  Channel * ch = track->channel;
+  switch (step)
+    {
+    case BOUNCE_STEP_BEFORE_INSERTS:
+      if (track->type == TRACK_TYPE_INSTRUMENT)
+        {
+          if (!ch->instrument)
+            return false;
+          *l = ch->instrument->l_out;
+          *r = ch->instrument->r_out;
+        }
+      else
+        {
+          if (!track->processor || !track->processor->stereo_out)
+            return false;
+          *l = track->processor->stereo_out->l;
+          *r = track->processor->stereo_out->r;
+        }
+      break;
+    case BOUNCE_STEP_PRE_FADER:
+      *l = ch->prefader->stereo_out->l;
+      *r = ch->prefader->stereo_out->r;
+      break;
+    case BOUNCE_STEP_POST_FADER:
+      *l = ch->stereo_out->l;
+      *r = ch->stereo_out->r;
+      break;
+    }
+
+  return *l && *r;
+}
+
+/**
+ * Dithers and writes the chunk being encoded.
+ *
+ * @note Runs in a worker thread.
+ */
+static void
+encode_stem_chunk (StemWriter * writer, StemEncoder * self)
+{
+  const ExportSettings * info = self->info;
+  float *                buf = writer->encode_buf;
+  size_t                 nframes = writer->num_encode_frames;
+
+  /* clipping detection */
+  float max_amp = dsp_abs_max (buf, nframes * EXPORT_CHANNELS);
+  if (max_amp > 1.f && max_amp > writer->clip_amp)
+    {
+      writer->clip_amp = max_amp;
+    }
+
+  if (info->dither)
+    {
+      ditherer_process (&writer->ditherer, buf, nframes, EXPORT_CHANNELS);
+    }
+
+  sf_count_t written_frames =
+    sf_writef_float (writer->sndfile, buf, (sf_count_t) nframes);
+  if (written_frames != (sf_count_t) nframes && !writer->error)
+    {
+      writer->error = g_strdup_printf (
+        _ ("Export failed: %ld frames written (expected %zu)"),
+        written_frames, nframes);
+    }
+
+  g_mutex_lock (&self->lock);
+  self->num_pending--;
+  g_cond_signal (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+/**
+ * Waits until the chunks being encoded are written.
+ *
+ * @return Whether all stems were written successfully
+ *   so far.
+ */
+static bool
+stem_encoder_wait (StemEncoder * self)
+{
+  g_mutex_lock (&self->lock);
+  while (self->num_pending > 0)
+    {
+      g_cond_wait (&self->cond, &self->lock);
+    }
+  g_mutex_unlock (&self->lock);
+
+  for (size_t i = 0; i < self->num_writers; i++)
+    {
+      StemWriter * writer = &self->writers[i];
+      if (writer->error)
+        {
+          progress_info_mark_completed (
+            self->info->progress_info, PROGRESS_COMPLETED_HAS_ERROR,
+            writer->error);
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/**
+ * Hands the collected chunks to the worker threads.
+ *
+ * @return Whether the previous chunks were written
+ *   successfully.
+ */
+static bool
+stem_encoder_submit (StemEncoder * self)
+{
+  if (!stem_encoder_wait (self))
+    return false;
+
+  if (self->num_writers == 0 || self->writers[0].num_fill_frames == 0)
+    return true;
+
+  self->num_pending = (guint) self->num_writers;
+  for (size_t i = 0; i < self->num_writers; i++)
+    {
+      StemWriter * writer = &self->writers[i];
+      float *      tmp = writer->encode_buf;
+      writer->encode_buf = writer->fill_buf;
+      writer->num_encode_frames = writer->num_fill_frames;
+      writer->fill_buf = tmp;
+      writer->num_fill_frames = 0;
+      g_thread_pool_push (self->pool, writer, NULL);
+    }
+
+  return true;
+}
+
+static void
+stem_encoder_free (StemEncoder * self)
+{
+  g_thread_pool_free (self->pool, false, true);
+
+  for (size_t i = 0; i < self->num_writers; i++)
+    {
+      StemWriter * writer = &self->writers[i];
+      if (writer->sndfile)
+        {
+          sf_close (writer->sndfile);
+        }
+      g_free (writer->fill_buf);
+      g_free (writer->encode_buf);
+      g_free (writer->error);
+    }
+  g_free (self->writers);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  object_zero_and_free (self);
+}
+
+/**
+ * Opens the files of all stems.
+ *
+ * @return The encoder, or NULL if failed (in which case
+ *   the progress info is marked as completed with an
+ *   error).
+ */
+static StemEncoder *
+stem_encoder_new (ExportSettings * info, const SF_INFO * sfinfo)
+{
+  g_return_val_if_fail (info->mode == EXPORT_MODE_FULL, NULL);
+
+  StemEncoder * self = object_new (StemEncoder);
+  self->info = info;
+  self->chunk_frames = MAX (STEM_CHUNK_FRAMES, AUDIO_ENGINE->block_length);
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+  self->pool = g_thread_pool_new (
+    (GFunc) encode_stem_chunk, self,
+    (int) MAX (1, MIN (g_get_num_processors (), info->stems->len)),
+    F_NOT_EXCLUSIVE, NULL);
+  self->writers = object_new_n (info->stems->len, StemWriter);
+
+  for (guint i = 0; i < info->stems->len; i++)
+    {
+      const ExportStem * stem = g_ptr_array_index (info->stems, i);
+      StemWriter *       writer = &self->writers[self->num_writers++];
+      writer->stem = stem;
+      if (!get_stem_ports (
+            stem->track, info->bounce_step, &writer->l, &writer->r))
+        {
+          char * err_str = g_strdup_printf (
+            _ ("Track %s has no audio output to export"), stem->track->name);
+          progress_info_mark_completed (
+            info->progress_info, PROGRESS_COMPLETED_HAS_ERROR, err_str);
+          g_free (err_str);
+          stem_encoder_free (self);
+          return NULL;
+        }
+
+      writer->sndfile = open_export_file (info, stem->file_uri, sfinfo);
+      if (!writer->sndfile)
+        {
+          stem_encoder_free (self);
+          return NULL;
+        }
+
+      writer->fill_buf =
+        object_new_n (self->chunk_frames * EXPORT_CHANNELS, float);
+      writer->encode_buf =
+        object_new_n (self->chunk_frames * EXPORT_CHANNELS, float);
+      if (info->dither)
+        {
+          ditherer_reset (
+            &writer->ditherer, audio_bit_depth_enum_to_int (info->depth));
+        }
+    }
+
+  return self;
+}
+
+/**
+ * Collects the frames of the current cycle from the
+ * tapped ports of each stem.
+ *
+ * @return Whether the stems were written successfully
+ *   so far.
+ */
+static bool
+stem_encoder_add_frames (StemEncoder * self, nframes_t nframes)
+{
+  if (
+    self->num_writers > 0
+    && self->writers[0].num_fill_frames + nframes > self->chunk_frames)
+    {
+      if (!stem_encoder_submit (self))
+        return false;
+    }
+
+  for (size_t i = 0; i < self->num_writers; i++)
+    {
+      StemWriter * writer = &self->writers[i];
+      float *      dest =
+        &writer->fill_buf[writer->num_fill_frames * EXPORT_CHANNELS];
+      const float * l = writer->l->buf;
+      const float * r = writer->r->buf;
+      for (nframes_t j = 0; j < nframes; j++)
+        {
+          dest[j * 2] = l[j];
+          dest[j * 2 + 1] = r[j];
+        }
+      writer->num_fill_frames += nframes;
+    }
+
+  return true;
+}
+
+/**
+ * Writes the remaining frames and closes the files.
+ *
+ * @return Whether all stems were written successfully.
+ */
+static bool
+stem_encoder_finish (StemEncoder * self)
+{
+  bool success = stem_encoder_submit (self) && stem_encoder_wait (self);
+
+  for (size_t i = 0; i < self->num_writers; i++)
+    {
+      StemWriter * writer = &self->writers[i];
+      int          ret = sf_close (writer->sndfile);
+      writer->sndfile = NULL;
+      if (ret != 0 && success)
+        {
+          char * err_str = g_strdup_printf (
+            _ ("Failed to close %s: %s"), writer->stem->file_uri,
+            sf_error_number (ret));
+          progress_info_mark_completed (
+            self->info->progress_info, PROGRESS_COMPLETED_HAS_ERROR, err_str);
+          g_free (err_str);
+          success = false;
+        }
+    }
+
+  return success;
+}
+
+/**
+ * Returns the max amplitude above 0 dB detected in any
+ * stem, or 0 if none clipped.
+ */
+static float
+stem_encoder_get_clip_amp (StemEncoder * self)
+{
+  float clip_amp = 0.f;
+  for (size_t i = 0; i < self->num_writers; i++)
+    {
+      clip_amp = MAX (clip_amp, self->writers[i].clip_amp);
+    }
+  return clip_amp;
+}
+
 static int
 export_audio (ExportSettings * info)
 {
@@ -118,8 +572,6 @@ export_audio (ExportSettings * info)
 
   ProgressInfo * pinfo = info->progress_info;
 
-#define EXPORT_CHANNELS 2
-
   int type_major = 0;
 
   switch (info->format)
@@ -231,49 +683,21 @@ export_audio (ExportSettings * info)
       return -1;
     }
 
-  char *   dir = io_get_dir (info->file_uri);
-  GError * err = NULL;
-  bool     success = io_mkdir (dir, &err);
-  if (!success)
-    {
-      g_warning ("Failed to create directory %s: %s", dir, err->message);
-      return -1;
-    }
-  g_free (dir);
-  SNDFILE * sndfile = sf_open (info->file_uri, SFM_WRITE, &sfinfo);
-
-  if (!sndfile)
+  SNDFILE *     sndfile = NULL;
+  StemEncoder * stem_encoder = NULL;
+  if (info->stems)
     {
-      int          error = sf_error (NULL);
-      const char * error_str = sf_error_number (error);
-
-      char * err_str = g_strdup_printf (
-        _ ("Couldn't open SNDFILE %s:\n%d: %s"), info->file_uri, error,
-        error_str);
-      progress_info_mark_completed (
-        pinfo, PROGRESS_COMPLETED_HAS_ERROR, err_str);
-      g_free (err_str);
-
-      return -1;
+      stem_encoder = stem_encoder_new (info, &sfinfo);
+      if (!stem_encoder)
+        return -1;
     }
-  if (sfinfo.format != (type_major | type_minor))
+  else
     {
-      char * err_str = g_strdup_printf (
-        _ ("Invalid SNDFILE format %s: 0x%08X != 0x%08X"), info->file_uri,
-        sfinfo.format, type_major | type_minor);
-      progress_info_mark_completed (
-        pinfo, PROGRESS_COMPLETED_HAS_ERROR, err_str);
-      g_free (err_str);
-
-      return -1;
+      sndfile = open_export_file (info, info->file_uri, &sfinfo);
+      if (!sndfile)
+        return -1;
     }
 
-  sf_set_string (sndfile, SF_STR_TITLE, PROJECT->title);
-  sf_set_string (sndfile, SF_STR_SOFTWARE, PROGRAM_NAME);
-  sf_set_string (sndfile, SF_STR_ARTIST, info->artist);
-  sf_set_string (sndfile, SF_STR_TITLE, info->title);
-  sf_set_string (sndfile, SF_STR_GENRE, info->genre);
-
   Position prev_playhead_pos;
   position_set_to_pos (&prev_playhead_pos, &TRANSPORT->playhead_pos);
   transport_set_playhead_pos (TRANSPORT, &start_pos);
@@ -330,6 +754,8 @@ export_audio (ExportSettings * info)
   float        out_ptr[out_ptr_sz];
   bool         clipped = false;
   float        clip_amp = 0.f;
+  bool         stems_failed = false;
+  const gint64 render_start_time = g_get_monotonic_time ();
   do
     {
       /* calculate number of frames to process this time */
@@ -350,85 +776,100 @@ export_audio (ExportSettings * info)
       router_start_cycle (ROUTER, time_nfo);
       engine_post_process (AUDIO_ENGINE, nframes, nframes);
 
-      /* by this time, the Master channel should have its Stereo Out ports
-       * filled - pass its buffers to the output */
-      float tmp_l[nframes];
-      float tmp_r[nframes];
-      /*
-       * bypass gcc analyzer bug
-       * https://gcc.gnu.org/bugzilla/show_bug.cgi?id=109789
-       */
-      dsp_fill (tmp_l, 0.f, nframes);
-      dsp_fill (tmp_r, 0.f, nframes);
-      for (nframes_t i = 0; i < nframes; i++)
+      if (stem_encoder)
         {
-          tmp_l[i] = P_MASTER_TRACK->channel->stereo_out->l->buf[i];
-          tmp_r[i] = P_MASTER_TRACK->channel->stereo_out->r->buf[i];
-          out_ptr[i * 2] = tmp_l[i];
-          out_ptr[i * 2 + 1] = tmp_r[i];
-        }
-
-      /* clipping detection */
-      float max_amp = dsp_abs_max (tmp_l, nframes);
-      if (max_amp > 1.f && max_amp > clip_amp)
-        {
-          clip_amp = max_amp;
-          clipped = true;
+          /* the tapped ports of each stem are filled by now */
+          if (!stem_encoder_add_frames (stem_encoder, nframes))
+            {
+              stems_failed = true;
+              break;
+            }
         }
-      max_amp = dsp_abs_max (tmp_r, nframes);
-      if (max_amp > 1.f && max_amp > clip_amp)
+      else
         {
-          clip_amp = max_amp;
-          clipped = true;
-        }
+          /* by this time, the Master channel should have its Stereo Out ports
+           * filled - pass its buffers to the output */
+          float tmp_l[nframes];
+          float tmp_r[nframes];
+          /*
+           * bypass gcc analyzer bug
+           * https://gcc.gnu.org/bugzilla/show_bug.cgi?id=109789
+           */
+          dsp_fill (tmp_l, 0.f, nframes);
+          dsp_fill (tmp_r, 0.f, nframes);
+          for (nframes_t i = 0; i < nframes; i++)
+            {
+              tmp_l[i] = P_MASTER_TRACK->channel->stereo_out->l->buf[i];
+              tmp_r[i] = P_MASTER_TRACK->channel->stereo_out->r->buf[i];
+              out_ptr[i * 2] = tmp_l[i];
+              out_ptr[i * 2 + 1] = tmp_r[i];
+            }
 
-      /* apply dither */
-      if (info->dither)
-        {
-          ditherer_process (&ditherer, out_ptr, nframes, 2);
-        }
+          /* clipping detection */
+          float max_amp = dsp_abs_max (tmp_l, nframes);
+          if (max_amp > 1.f && max_amp > clip_amp)
+            {
+              clip_amp = max_amp;
+              clipped = true;
+            }
+          max_amp = dsp_abs_max (tmp_r, nframes);
+          if (max_amp > 1.f && max_amp > clip_amp)
+            {
+              clip_amp = max_amp;
+              clipped = true;
+            }
+
+          /* apply dither */
+          if (info->dither)
+            {
+              ditherer_process (&ditherer, out_ptr, nframes, 2);
+            }
 
-      /* no seek needed */
-      (void) covered_frames; /* avoid unused warning */
+          /* no seek needed */
+          (void) covered_frames; /* avoid unused warning */
 #if 0
-      /* seek to the write position in the file */
-      if (covered_frames != 0)
-        {
-          sf_count_t seek_cnt =
-            sf_seek (sndfile, covered_frames, SEEK_SET | SFM_WRITE);
-          /*g_debug ("seek count: %ld", seek_cnt);*/
-
-          /* note: FLAC returns -1
-           * see https://github.com/libsndfile/libsndfile/issues/34#issuecomment-19867245
-           * although it says it's fixed, this error still appears in 1.2.2 */
-          if (seek_cnt < 0)
+          /* seek to the write position in the file */
+          if (covered_frames != 0)
             {
+              sf_count_t seek_cnt =
+                sf_seek (sndfile, covered_frames, SEEK_SET | SFM_WRITE);
+              /*g_debug ("seek count: %ld", seek_cnt);*/
+
+              /* note: FLAC returns -1
+               * see
+               * https://github.com/libsndfile/libsndfile/issues/34#issuecomment-19867245
+               * although it says it's fixed, this error still appears in
+               * 1.2.2 */
+              if (seek_cnt < 0)
+                {
+                  char * err_str = g_strdup_printf (
+                    _ ("Export failed: Error seeking file at %ld"),
+                    covered_frames);
+                  progress_info_mark_completed (
+                    pinfo, PROGRESS_COMPLETED_HAS_ERROR, err_str);
+                  g_free (err_str);
+                  return -1;
+                }
+            }
+#endif
+
+          /* write the frames for the current cycle */
+          sf_count_t written_frames =
+            sf_writef_float (sndfile, out_ptr, nframes);
+          if (written_frames != nframes)
+            {
+              written_frames = sf_writef_float (sndfile, out_ptr, nframes);
               char * err_str = g_strdup_printf (
-                _ ("Export failed: Error seeking file at %ld"),
-                covered_frames);
+                _ ("Export failed: %ld frames written (expected %d)"),
+                written_frames, nframes);
               progress_info_mark_completed (
                 pinfo, PROGRESS_COMPLETED_HAS_ERROR, err_str);
               g_free (err_str);
               return -1;
             }
+          /*g_debug ("wrote %d frames (total %ld)", nframes, covered_frames +
+           * nframes);*/
         }
-#endif
-
-      /* write the frames for the current cycle */
-      sf_count_t written_frames = sf_writef_float (sndfile, out_ptr, nframes);
-      if (written_frames != nframes)
-        {
-          written_frames = sf_writef_float (sndfile, out_ptr, nframes);
-          char * err_str = g_strdup_printf (
-            _ ("Export failed: %ld frames written (expected %d)"),
-            written_frames, nframes);
-          progress_info_mark_completed (
-            pinfo, PROGRESS_COMPLETED_HAS_ERROR, err_str);
-          g_free (err_str);
-          return -1;
-        }
-      /*g_debug ("wrote %d frames (total %ld)", nframes, covered_frames +
-       * nframes);*/
 
       covered_frames += nframes;
       covered_ticks += AUDIO_ENGINE->ticks_per_frame * nframes;
@@ -457,7 +898,7 @@ export_audio (ExportSettings * info)
     TRANSPORT->playhead_pos.ticks < end_pos.ticks
     && !progress_info_pending_cancellation (pinfo));
 
-  if (!progress_info_pending_cancellation (pinfo))
+  if (!progress_info_pending_cancellation (pinfo) && !stems_failed)
     {
       g_warn_if_fail (
         math_floats_equal_epsilon (covered_ticks, total_ticks, 1.0));
@@ -465,6 +906,16 @@ export_audio (ExportSettings * info)
 
   /* TODO silence output */
 
+  const gint64 render_usec = g_get_monotonic_time () - render_start_time;
+  info->realtime_factor =
+    ((double) covered_frames / (double) AUDIO_ENGINE->sample_rate)
+    / ((double) MAX (render_usec, 1) / 1000000.0);
+  g_message (
+    "rendered %" PRId64 " frames in %.2f seconds with block length %u "
+    "(%.1fx realtime)",
+    (int64_t) covered_frames, (double) render_usec / 1000000.0,
+    AUDIO_ENGINE->block_length, info->realtime_factor);
+
   progress_info_update_progress (pinfo, 1.0, NULL);
 
   /* set jack freewheeling mode and transport type */
@@ -488,25 +939,58 @@ export_audio (ExportSettings * info)
     TRANSPORT, &prev_playhead_pos, F_PANIC, F_NO_SET_CUE_POINT,
     F_NO_PUBLISH_EVENTS);
 
-  sf_close (sndfile);
+  if (stem_encoder)
+    {
+      if (!stems_failed)
+        {
+          stems_failed = !stem_encoder_finish (stem_encoder);
+        }
+      clip_amp = stem_encoder_get_clip_amp (stem_encoder);
+      clipped = clip_amp > 0.f;
+      object_free_w_func_and_null (stem_encoder_free, stem_encoder);
 
-  /* if cancelled, delete */
-  if (progress_info_pending_cancellation (pinfo))
+      /* if failed or cancelled, delete */
+      if (stems_failed || progress_info_pending_cancellation (pinfo))
+        {
+          for (guint i = 0; i < info->stems->len; i++)
+            {
+              const ExportStem * stem = g_ptr_array_index (info->stems, i);
+              io_remove (stem->file_uri);
+            }
+        }
+      if (stems_failed)
+        {
+          return -1;
+        }
+    }
+  else
     {
-      io_remove (info->file_uri);
+      sf_close (sndfile);
+
+      /* if cancelled, delete */
+      if (progress_info_pending_cancellation (pinfo))
+        {
+          io_remove (info->file_uri);
+        }
     }
 
   /* if cancelled, delete */
   if (progress_info_pending_cancellation (pinfo))
     {
-      g_message ("cancelled export to %s", info->file_uri);
+      if (info->stems)
+        g_message ("cancelled export of %u stems", info->stems->len);
+      else
+        g_message ("cancelled export to %s", info->file_uri);
 
       progress_info_mark_completed (pinfo, PROGRESS_COMPLETED_CANCELLED, NULL);
       return 0;
     }
   else
     {
-      g_message ("successfully exported to %s", info->file_uri);
+      if (info->stems)
+        g_message ("successfully exported %u stems", info->stems->len);
+      else
+        g_message ("successfully exported to %s", info->file_uri);
 
       if (clipped)
         {
@@ -611,6 +1095,22 @@ export_settings_new (void)
   return self;
 }
 
+ExportStem *
+export_stem_new (Track * track, const char * file_uri)
+{
+  ExportStem * self = object_new (ExportStem);
+  self->track = track;
+  self->file_uri = g_strdup (file_uri);
+  return self;
+}
+
+void
+export_stem_free (ExportStem * self)
+{
+  g_free_and_null (self->file_uri);
+  object_zero_and_free (self);
+}
+
 /**
  * Sets the defaults for bouncing.
  *
@@ -670,6 +1170,8 @@ export_settings_set_bounce_defaults (
       : g_settings_get_enum (S_UI, "bounce-step");
   self->bounce_with_parents =
     ZRYTHM_TESTING ? true : g_settings_get_boolean (S_UI, "bounce-with-parents");
+  self->offline_block_length =
+    ZRYTHM_TESTING ? 0 : exporter_get_offline_block_length ();
 
   if (filepath)
     {
@@ -687,6 +1189,21 @@ export_settings_set_bounce_defaults (
     }
 }
 
+/**
+ * Returns the block length to render exports with
+ * offline.
+ *
+ * This never exceeds the maximum block length LV2
+ * plugins are instantiated with.
+ */
+nframes_t
+exporter_get_offline_block_length (void)
+{
+  int block_length = env_get_int (
+    "ZRYTHM_EXPORT_BLOCK_LENGTH", EXPORT_OFFLINE_BLOCK_LENGTH);
+  return (nframes_t) CLAMP (block_length, 1, LV2_PLUGIN_MAX_BLOCK_LENGTH);
+}
+
 /**
  * This must be called on the main thread after the
  * intended tracks have been marked for bounce and
@@ -711,6 +1228,21 @@ exporter_prepare_tracks_for_export (
   AUDIO_ENGINE->preparing_to_export = false;
   TRANSPORT->loop = false;
 
+  if (settings->offline_block_length > 0)
+    {
+      /* render in larger blocks */
+      AUDIO_ENGINE->rendering_offline = true;
+      AUDIO_ENGINE->block_length_before_offline = AUDIO_ENGINE->block_length;
+      if (settings->offline_block_length != AUDIO_ENGINE->block_length)
+        {
+          g_message (
+            "rendering offline with block length %u",
+            settings->offline_block_length);
+          engine_realloc_port_buffers (
+            AUDIO_ENGINE, settings->offline_block_length);
+        }
+    }
+
   g_message ("deactivating and reactivating plugins");
 
   /* deactivate and activate all plugins to make
@@ -803,6 +1335,19 @@ exporter_post_export (
       router_recalc_graph (ROUTER, F_NOT_SOFT);
     }
 
+  /* restore the block length */
+  if (AUDIO_ENGINE->rendering_offline)
+    {
+      AUDIO_ENGINE->rendering_offline = false;
+      if (
+        AUDIO_ENGINE->block_length
+        != AUDIO_ENGINE->block_length_before_offline)
+        {
+          engine_realloc_port_buffers (
+            AUDIO_ENGINE, AUDIO_ENGINE->block_length_before_offline);
+        }
+    }
+
   /* reset "bounce to master" on each track */
   for (int j = 0; j < TRACKLIST->num_tracks; j++)
     {
@@ -875,12 +1420,14 @@ export_settings_print (const ExportSettings * self)
     "bounce step: %s\n"
     "dither: %d\n"
     "file: %s\n"
-    "num files: %d\n",
+    "num files: %d\n"
+    "num stems: %u\n",
     export_format_to_pretty_str (self->format), self->artist, self->title,
     self->genre, audio_bit_depth_enum_to_int (self->depth), time_range,
     export_mode_to_str (self->mode), self->disable_after_bounce,
     self->bounce_with_parents, bounce_step_to_str (self->bounce_step),
-    self->dither, self->file_uri, self->num_files);
+    self->dither, self->file_uri, self->num_files,
+    self->stems ? self->stems->len : 0);
 }
 
 static void
@@ -890,6 +1437,7 @@ export_settings_free_members (ExportSettings * self)
   g_free_and_null (self->title);
   g_free_and_null (self->genre);
   g_free_and_null (self->file_uri);
+  object_free_w_func_and_null (g_ptr_array_unref, self->stems);
   object_free_w_func_and_null (progress_info_free, self->progress_info);
 }
 
@@ -956,9 +1504,12 @@ exporter_create_audio_track_after_bounce (
 int
 exporter_export (ExportSettings * info)
 {
-  g_return_val_if_fail (info && info->file_uri, -1);
+  g_return_val_if_fail (info && (info->file_uri || info->stems), -1);
 
-  g_message ("exporting to %s", info->file_uri);
+  if (info->stems)
+    g_message ("exporting %u stems", info->stems->len);
+  else
+    g_message ("exporting to %s", info->file_uri);
 
   export_settings_print (info);
 
@@ -982,6 +1533,7 @@ exporter_export (ExportSettings * info)
   int ret = 0;
   if (info->format == EXPORT_FORMAT_MIDI0 || info->format == EXPORT_FORMAT_MIDI1)
     {
+      g_return_val_if_fail (!info->stems, -1);
       ret = export_midi (info);
     }
   else
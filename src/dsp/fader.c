@@ -1077,17 +1077,52 @@ fader_process (Fader * self, const EngineProcessTimeInfo * const time_nfo)
           float pan = port_get_control_value (self->balance, 0);
           float amp = port_get_control_value (self->amp, 0);
 
+          /* values read from automation during this cycle,
+           * if automation is read more than once per cycle */
+          const float * pan_vals =
+            port_get_automation_vals (self->balance, time_nfo);
+          const float * amp_vals =
+            port_get_automation_vals (self->amp, time_nfo);
+
           float calc_l, calc_r;
           balance_control_get_calc_lr (
             BALANCE_CONTROL_ALGORITHM_LINEAR, pan, &calc_l, &calc_r);
-
-          /* apply fader and pan */
-          dsp_mul_k2 (
-            &self->stereo_out->l->buf[time_nfo->local_offset], amp * calc_l,
-            time_nfo->nframes);
-          dsp_mul_k2 (
-            &self->stereo_out->r->buf[time_nfo->local_offset], amp * calc_r,
-            time_nfo->nframes);
+          if (pan_vals)
+            {
+              /* apply fader and pan per frame */
+              float * l = &self->stereo_out->l->buf[time_nfo->local_offset];
+              float * r = &self->stereo_out->r->buf[time_nfo->local_offset];
+              for (nframes_t i = 0; i < time_nfo->nframes; i++)
+                {
+                  const float cur_amp = amp_vals ? amp_vals[i] : amp;
+                  balance_control_get_calc_lr (
+                    BALANCE_CONTROL_ALGORITHM_LINEAR, pan_vals[i], &calc_l,
+                    &calc_r);
+                  l[i] *= cur_amp * calc_l;
+                  r[i] *= cur_amp * calc_r;
+                }
+            }
+          else if (amp_vals)
+            {
+              /* apply fader per frame and pan */
+              float * l = &self->stereo_out->l->buf[time_nfo->local_offset];
+              float * r = &self->stereo_out->r->buf[time_nfo->local_offset];
+              for (nframes_t i = 0; i < time_nfo->nframes; i++)
+                {
+                  l[i] *= amp_vals[i] * calc_l;
+                  r[i] *= amp_vals[i] * calc_r;
+                }
+            }
+          else
+            {
+              /* apply fader and pan */
+              dsp_mul_k2 (
+                &self->stereo_out->l->buf[time_nfo->local_offset],
+                amp * calc_l, time_nfo->nframes);
+              dsp_mul_k2 (
+                &self->stereo_out->r->buf[time_nfo->local_offset],
+                amp * calc_r, time_nfo->nframes);
+            }
 
           /* make mono if mono compat enabled */
           if (control_port_is_toggled (self->mono_compat_enabled))
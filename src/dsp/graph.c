@@ -23,6 +23,7 @@
  * ---
  */
 
+#include "dsp/automation_tracklist.h"
 #include "dsp/control_room.h"
 #include "dsp/engine.h"
 #include "dsp/fader.h"
@@ -37,6 +38,7 @@
 #include "dsp/tracklist.h"
 #include "plugins/plugin.h"
 #include "project.h"
+#include "settings/settings.h"
 #include "utils/arrays.h"
 #include "utils/audio.h"
 #include "utils/env.h"
@@ -46,6 +48,130 @@
 #include "utils/objects.h"
 #include "utils/stoat.h"
 #include "utils/string.h"
+#include "utils/ws_deque.h"
+#include "zrythm.h"
+
+/**
+ * Stores the statistics of a completed cycle.
+ */
+static void
+add_cycle_stats (Graph * self, const GraphCycleStats * stats)
+{
+  self->last_cycle_stats = *stats;
+  self->total_cycle_stats.num_steals += stats->num_steals;
+  self->total_cycle_stats.num_idle += stats->num_idle;
+  self->total_cycle_stats.num_processed += stats->num_processed;
+  self->total_cycle_stats.num_active_threads += stats->num_active_threads;
+  self->num_cycles++;
+}
+
+/**
+ * Collects the per-thread scheduling counters into
+ * Graph.last_cycle_stats and resets them.
+ *
+ * Must only be called when all other threads are
+ * idle.
+ */
+static void
+collect_cycle_stats (Graph * self)
+{
+  GraphCycleStats stats = { 0 };
+  for (int i = 0; i <= self->num_threads; i++)
+    {
+      GraphThread * thread = graph_get_thread_at (self, i);
+      if (!thread)
+        continue;
+
+      stats.num_steals += thread->num_steals;
+      stats.num_idle += thread->num_idle;
+      stats.num_processed += thread->num_processed;
+      if (thread->num_processed > 0)
+        stats.num_active_threads++;
+
+      thread->num_steals = 0;
+      thread->num_idle = 0;
+      thread->num_processed = 0;
+    }
+  add_cycle_stats (self, &stats);
+}
+
+/**
+ * Runs all the nodes in the static schedule in order
+ * on the calling thread.
+ */
+HOT static void
+run_static_schedule (Graph * self)
+{
+  EngineProcessTimeInfo time_nfo = self->router->time_nfo;
+  for (size_t i = 0; i < self->n_static_schedule; i++)
+    {
+      graph_node_process (self->static_schedule[i], time_nfo);
+    }
+
+  GraphCycleStats stats = {
+    .num_processed = (guint) self->n_static_schedule,
+    .num_active_threads = 1,
+  };
+  add_cycle_stats (self, &stats);
+}
+
+/**
+ * Logs the scheduling statistics collected since the
+ * graph was started.
+ */
+void
+graph_print_cycle_stats (const Graph * self)
+{
+  if (self->num_cycles == 0)
+    {
+      g_message ("graph scheduling stats: no cycles processed");
+      return;
+    }
+
+  const GraphCycleStats * total = &self->total_cycle_stats;
+  const double            num_cycles = (double) self->num_cycles;
+  g_message (
+    "graph scheduling stats (%s, %d threads) over %" G_GUINT64_FORMAT
+    " cycles: %.1f nodes, %.2f active threads, %.2f steals, "
+    "%.2f idle waits per cycle",
+    graph_scheduler_str[self->scheduler], self->num_threads, self->num_cycles,
+    (double) total->num_processed / num_cycles,
+    (double) total->num_active_threads / num_cycles,
+    (double) total->num_steals / num_cycles,
+    (double) total->num_idle / num_cycles);
+}
+
+bool
+graph_can_use_static_schedule (const Graph * self, nframes_t nframes)
+{
+  if (self->n_static_schedule == 0)
+    return false;
+
+  /* keep all DSP threads busy when rendering offline */
+  if (self->num_threads > 0 && AUDIO_ENGINE->rendering_offline)
+    return false;
+
+  return self->num_threads == 0
+         || nframes <= self->static_schedule_max_nframes;
+}
+
+bool
+graph_wait_for_next_dynamic_cycle (Graph * self)
+{
+  for (;;)
+    {
+      zix_sem_wait (&self->callback_start);
+
+      if (g_atomic_int_get (&self->terminate))
+        return false;
+
+      if (!self->run_static_schedule)
+        return true;
+
+      run_static_schedule (self);
+      zix_sem_post (&self->callback_done);
+    }
+}
 
 /**
  * Called from a terminal node (from the Graph worked-thread)
@@ -76,13 +202,13 @@ graph_on_reached_terminal_node (Graph * self)
       while (g_atomic_int_get (&self->idle_thread_cnt) != self->num_threads)
         sched_yield ();
 
+      collect_cycle_stats (self);
+
       if (g_atomic_int_get (&self->terminate))
         return;
 
       /* now wait for the next cycle to begin */
-      zix_sem_wait (&self->callback_start);
-
-      if (g_atomic_int_get (&self->terminate))
+      if (!graph_wait_for_next_dynamic_cycle (self))
         return;
 
       /* reset terminal reference count */
@@ -92,9 +218,7 @@ graph_on_reached_terminal_node (Graph * self)
       /* and start the initial nodes */
       for (size_t i = 0; i < self->n_init_triggers; ++i)
         {
-          g_atomic_int_inc (&self->trigger_queue_size);
-          mpmc_queue_push_back_node (
-            self->trigger_queue, self->init_trigger_list[i]);
+          graph_thread_push_node (self, self->init_trigger_list[i]);
         }
       /* continue in worker-thread */
     }
@@ -148,66 +272,333 @@ is_valid (Graph * self)
   return true;
 }
 
+static void
+free_port_connections (GraphPortConnections * conns)
+{
+  object_zero_and_free (conns->srcs);
+  object_zero_and_free (conns->src_connections);
+  object_zero_and_free (conns->dests);
+  object_zero_and_free (conns->dest_connections);
+}
+
 static void
 clear_setup (Graph * self)
 {
   g_hash_table_remove_all (self->setup_graph_nodes);
   self->num_setup_init_triggers = 0;
   self->num_setup_terminal_nodes = 0;
+
+  for (guint i = 0; i < self->setup_port_connections->len; i++)
+    {
+      free_port_connections (&g_array_index (
+        self->setup_port_connections, GraphPortConnections, i));
+    }
+  g_array_set_size (self->setup_port_connections, 0);
+
+  object_free_w_func_and_null (
+    g_ptr_array_unref, self->setup_external_out_ports);
+  self->setup_bpm_node = NULL;
+  self->setup_beats_per_bar_node = NULL;
+  self->setup_beat_unit_node = NULL;
+
+  object_zero_and_free (self->setup_static_schedule);
+  self->n_setup_static_schedule = 0;
+  self->n_setup_static_schedule_levels = 0;
+  self->setup_matches_current = false;
 }
 
+static int
+static_schedule_cmp (const void * a, const void * b)
+{
+  const GraphNode * node_a = *(GraphNode * const *) a;
+  const GraphNode * node_b = *(GraphNode * const *) b;
+  if (node_a->sched_level != node_b->sched_level)
+    return node_a->sched_level - node_b->sched_level;
+
+  /* longer chains first */
+  if (node_a->sched_critical_path != node_b->sched_critical_path)
+    return node_b->sched_critical_path - node_a->sched_critical_path;
+
+  return node_a->id - node_b->id;
+}
+
+/**
+ * Builds Graph.setup_static_schedule from the setup
+ * nodes.
+ */
 static void
-graph_rechain (Graph * self)
+build_static_schedule (Graph * self)
 {
-  /*g_warn_if_fail (*/
-  /*g_atomic_int_get (*/
-  /*&self->terminal_refcnt) == 0);*/
-  g_warn_if_fail (g_atomic_int_get (&self->trigger_queue_size) == 0);
+  object_zero_and_free (self->setup_static_schedule);
+  self->n_setup_static_schedule = 0;
+  self->n_setup_static_schedule_levels = 0;
+
+  size_t num_nodes = (size_t) g_hash_table_size (self->setup_graph_nodes);
+  if (num_nodes == 0)
+    return;
+
+  GraphNode ** order = object_new_n (num_nodes, GraphNode *);
+  size_t       num_ordered = 0;
 
-  /* --- swap setup nodes with graph nodes --- */
-  g_return_if_fail (self->graph_nodes && self->setup_graph_nodes);
-  GHashTable * tmp =
-    g_hash_table_new_full (g_direct_hash, g_direct_equal, NULL, NULL);
   GHashTableIter iter;
   gpointer       key, value;
-  g_hash_table_iter_init (&iter, self->graph_nodes);
+  g_hash_table_iter_init (&iter, self->setup_graph_nodes);
   while (g_hash_table_iter_next (&iter, &key, &value))
     {
-      g_hash_table_insert (tmp, key, value);
+      GraphNode * node = (GraphNode *) value;
+      node->sched_level = 0;
+      node->sched_critical_path = 0;
+      node->sched_pending = node->init_refcount;
+      if (node->init_refcount == 0)
+        {
+          order[num_ordered++] = node;
+        }
+    }
+
+  /* topological sort (Kahn), using the order array as
+   * the queue */
+  for (size_t i = 0; i < num_ordered; i++)
+    {
+      GraphNode * node = order[i];
+      for (int j = 0; j < node->n_childnodes; j++)
+        {
+          GraphNode * child = node->childnodes[j];
+          child->sched_level = MAX (child->sched_level, node->sched_level + 1);
+          if (--child->sched_pending == 0)
+            {
+              order[num_ordered++] = child;
+            }
+        }
+    }
+
+  if (num_ordered != num_nodes)
+    {
+      g_warning (
+        "graph has a cycle (%zu/%zu nodes ordered), "
+        "not using static schedule",
+        num_ordered, num_nodes);
+      free (order);
+      return;
+    }
+
+  /* calculate critical paths in reverse topological
+   * order */
+  int max_level = 0;
+  for (size_t i = num_ordered; i-- > 0;)
+    {
+      GraphNode * node = order[i];
+      int         max_child_path = 0;
+      for (int j = 0; j < node->n_childnodes; j++)
+        {
+          max_child_path =
+            MAX (max_child_path, node->childnodes[j]->sched_critical_path);
+        }
+      node->sched_critical_path = max_child_path + 1;
+      max_level = MAX (max_level, node->sched_level);
     }
-  g_hash_table_steal_all (self->graph_nodes);
 
+  qsort (order, num_ordered, sizeof (GraphNode *), static_schedule_cmp);
+
+  self->setup_static_schedule = order;
+  self->n_setup_static_schedule = num_ordered;
+  self->n_setup_static_schedule_levels = max_level + 1;
+}
+
+/**
+ * Returns whether the setup nodes have the same nodes
+ * and edges as the current ones.
+ *
+ * Nodes are created in the same order for the same
+ * graph, so nodes are matched by their key and ID.
+ */
+static bool
+setup_matches_current (Graph * self)
+{
+  if (
+    g_hash_table_size (self->setup_graph_nodes)
+      != g_hash_table_size (self->graph_nodes)
+    || self->num_setup_init_triggers != self->n_init_triggers
+    || self->num_setup_terminal_nodes != (size_t) self->n_terminal_nodes)
+    return false;
+
+  GHashTableIter iter;
+  gpointer       key, value;
   g_hash_table_iter_init (&iter, self->setup_graph_nodes);
   while (g_hash_table_iter_next (&iter, &key, &value))
     {
-      g_hash_table_insert (self->graph_nodes, key, value);
+      GraphNode * setup_node = (GraphNode *) value;
+      GraphNode * node =
+        (GraphNode *) g_hash_table_lookup (self->graph_nodes, key);
+      if (
+        !node || node->type != setup_node->type || node->id != setup_node->id
+        || node->init_refcount != setup_node->init_refcount
+        || node->n_childnodes != setup_node->n_childnodes)
+        return false;
+
+      for (int i = 0; i < node->n_childnodes; i++)
+        {
+          if (node->childnodes[i]->id != setup_node->childnodes[i]->id)
+            return false;
+        }
     }
-  g_hash_table_steal_all (self->setup_graph_nodes);
 
-  g_hash_table_iter_init (&iter, tmp);
-  while (g_hash_table_iter_next (&iter, &key, &value))
+  return true;
+}
+
+/**
+ * Returns whether the trigger queues can hold all the
+ * setup nodes.
+ */
+static bool
+queues_can_hold_setup (Graph * self)
+{
+  size_t num_nodes = (size_t) g_hash_table_size (self->setup_graph_nodes);
+  if (self->trigger_queue->buffer_mask + 1 < num_nodes)
+    return false;
+
+  for (int i = 0; i <= self->num_threads; i++)
     {
-      g_hash_table_insert (self->setup_graph_nodes, key, value);
+      GraphThread * thread = graph_get_thread_at (self, i);
+      if (thread && thread->deque->buffer_mask + 1 < num_nodes)
+        return false;
     }
-  g_hash_table_unref (tmp);
 
-  /* --- end --- */
+  return true;
+}
+
+bool
+graph_prepare_setup (Graph * self)
+{
+  self->setup_matches_current = setup_matches_current (self);
+  if (self->setup_matches_current)
+    {
+      /* keep the current nodes, only their latencies
+       * may have changed */
+      GHashTableIter iter;
+      gpointer       key, value;
+      g_hash_table_iter_init (&iter, self->setup_graph_nodes);
+      while (g_hash_table_iter_next (&iter, &key, &value))
+        {
+          GraphNode * setup_node = (GraphNode *) value;
+          GraphNode * node =
+            (GraphNode *) g_hash_table_lookup (self->graph_nodes, key);
+          node->playback_latency = setup_node->playback_latency;
+          node->route_playback_latency = setup_node->route_playback_latency;
+        }
+      g_message ("graph unchanged, reusing the current nodes");
+      return true;
+    }
+
+  build_static_schedule (self);
+  g_message (
+    "built static schedule with %zu nodes in %d levels",
+    self->n_setup_static_schedule, self->n_setup_static_schedule_levels);
+
+  return queues_can_hold_setup (self);
+}
+
+void
+graph_apply_setup (Graph * self)
+{
+  /* move the new connections to the ports and keep the
+   * previous ones to be freed */
+  for (guint i = 0; i < self->setup_port_connections->len; i++)
+    {
+      GraphPortConnections * conns = &g_array_index (
+        self->setup_port_connections, GraphPortConnections, i);
+      Port * port = conns->port;
+
+      Port **           srcs = port->srcs;
+      PortConnection ** src_connections = port->src_connections;
+      int               num_srcs = port->num_srcs;
+      port->srcs = conns->srcs;
+      port->src_connections = conns->src_connections;
+      port->num_srcs = conns->num_srcs;
+      port->srcs_size = (size_t) conns->num_srcs;
+      conns->srcs = srcs;
+      conns->src_connections = src_connections;
+      conns->num_srcs = num_srcs;
+
+      Port **           dests = port->dests;
+      PortConnection ** dest_connections = port->dest_connections;
+      int               num_dests = port->num_dests;
+      port->dests = conns->dests;
+      port->dest_connections = conns->dest_connections;
+      port->num_dests = conns->num_dests;
+      port->dests_size = (size_t) conns->num_dests;
+      conns->dests = dests;
+      conns->dest_connections = dest_connections;
+      conns->num_dests = num_dests;
+    }
 
-  array_dynamic_swap (
-    &self->init_trigger_list, &self->n_init_triggers,
-    &self->setup_init_trigger_list, &self->num_setup_init_triggers);
-  array_dynamic_swap (
-    &self->terminal_nodes, &self->n_terminal_nodes, &self->setup_terminal_nodes,
-    &self->num_setup_terminal_nodes);
+  GPtrArray * external_out_ports = self->external_out_ports;
+  self->external_out_ports = self->setup_external_out_ports;
+  self->setup_external_out_ports = external_out_ports;
+
+  if (self->setup_matches_current)
+    return;
+
+  GHashTable * graph_nodes = self->graph_nodes;
+  self->graph_nodes = self->setup_graph_nodes;
+  self->setup_graph_nodes = graph_nodes;
+
+  GraphNode ** init_trigger_list = self->init_trigger_list;
+  size_t       n_init_triggers = self->n_init_triggers;
+  self->init_trigger_list = self->setup_init_trigger_list;
+  self->n_init_triggers = self->num_setup_init_triggers;
+  self->setup_init_trigger_list = init_trigger_list;
+  self->num_setup_init_triggers = n_init_triggers;
+
+  GraphNode ** terminal_nodes = self->terminal_nodes;
+  gint         n_terminal_nodes = self->n_terminal_nodes;
+  self->terminal_nodes = self->setup_terminal_nodes;
+  self->n_terminal_nodes = (gint) self->num_setup_terminal_nodes;
+  self->setup_terminal_nodes = terminal_nodes;
+  self->num_setup_terminal_nodes = (size_t) n_terminal_nodes;
+
+  GraphNode ** static_schedule = self->static_schedule;
+  self->static_schedule = self->setup_static_schedule;
+  self->n_static_schedule = self->n_setup_static_schedule;
+  self->n_static_schedule_levels = self->n_setup_static_schedule_levels;
+  self->setup_static_schedule = static_schedule;
+
+  self->bpm_node = self->setup_bpm_node;
+  self->beats_per_bar_node = self->setup_beats_per_bar_node;
+  self->beat_unit_node = self->setup_beat_unit_node;
 
-  /*self->n_terminal_nodes =*/
-  /*(int) self->num_setup_terminal_nodes;*/
   g_atomic_int_set (&self->terminal_refcnt, (guint) self->n_terminal_nodes);
+}
+
+void
+graph_finish_setup (Graph * self)
+{
+  clear_setup (self);
+}
+
+static void
+graph_rechain (Graph * self)
+{
+  /*g_warn_if_fail (*/
+  /*g_atomic_int_get (*/
+  /*&self->terminal_refcnt) == 0);*/
+  g_warn_if_fail (g_atomic_int_get (&self->trigger_queue_size) == 0);
+
+  graph_prepare_setup (self);
+  graph_apply_setup (self);
 
   mpmc_queue_reserve (
     self->trigger_queue, (size_t) g_hash_table_size (self->graph_nodes));
+  for (int i = 0; i <= self->num_threads; i++)
+    {
+      GraphThread * thread = graph_get_thread_at (self, i);
+      if (thread)
+        {
+          ws_deque_reserve (
+            thread->deque, (size_t) g_hash_table_size (self->graph_nodes));
+        }
+    }
 
-  clear_setup (self);
+  graph_finish_setup (self);
 }
 
 static void
@@ -304,13 +695,23 @@ graph_destroy (Graph * self)
 /**
  * Add the port to the nodes.
  *
+ * The port's sources and destinations are collected in
+ * Graph.setup_port_connections.
+ *
  * @param drop_if_unnecessary Drops the port
  *   if it doesn't connect anywhere.
+ * @param reallocate_bufs Whether to reallocate the
+ *   port's buffers, otherwise they are only allocated
+ *   if missing.
  *
  * @return The graph node, if created.
  */
 static GraphNode *
-add_port (Graph * self, Port * port, const bool drop_if_unnecessary)
+add_port (
+  Graph *    self,
+  Port *     port,
+  const bool drop_if_unnecessary,
+  const bool reallocate_bufs)
 {
   PortOwnerType owner = port->id.owner_type;
 
@@ -326,55 +727,64 @@ add_port (Graph * self, Port * port, const bool drop_if_unnecessary)
       g_return_val_if_fail (IS_TRACK_AND_NONNULL (port->track), NULL);
     }
 
-  /* reset port sources/dests */
-  GPtrArray * srcs = g_ptr_array_new ();
-  int         num_srcs = port_connections_manager_get_sources_or_dests (
+  /* collect port sources/dests (they are moved to the
+   * port when rechaining) */
+  GraphPortConnections conns = { .port = port };
+  GPtrArray *          srcs = g_ptr_array_new ();
+  conns.num_srcs = port_connections_manager_get_sources_or_dests (
     PORT_CONNECTIONS_MGR, srcs, &port->id, true);
-  port->srcs_size = (size_t) num_srcs;
-  port->srcs = object_realloc_n (port->srcs, 0, port->srcs_size, Port *);
-  port->src_connections = object_realloc_n (
-    port->src_connections, 0, port->srcs_size, PortConnection *);
+  conns.srcs = object_new_n ((size_t) conns.num_srcs, Port *);
+  conns.src_connections =
+    object_new_n ((size_t) conns.num_srcs, PortConnection *);
 #if 0
-  if (num_srcs > 0)
+  if (conns.num_srcs > 0)
     g_debug (
       "%d sources for %s",
-      num_srcs, port->id.label);
+      conns.num_srcs, port->id.label);
 #endif
-  for (int i = 0; i < num_srcs; i++)
+  for (int i = 0; i < conns.num_srcs; i++)
     {
       PortConnection * conn = (PortConnection *) g_ptr_array_index (srcs, i);
 
-      port->srcs[i] = port_find_from_identifier (conn->src_id);
-      g_return_val_if_fail (port->srcs[i], NULL);
-      port->src_connections[i] = conn;
+      conns.srcs[i] = port_find_from_identifier (conn->src_id);
+      conns.src_connections[i] = conn;
     }
-  port->num_srcs = num_srcs;
   g_ptr_array_unref (srcs);
 
   GPtrArray * dests = g_ptr_array_new ();
-  int         num_dests = port_connections_manager_get_sources_or_dests (
+  conns.num_dests = port_connections_manager_get_sources_or_dests (
     PORT_CONNECTIONS_MGR, dests, &port->id, false);
-  port->dests_size = (size_t) num_dests;
-  port->dests = object_realloc_n (port->dests, 0, port->dests_size, Port *);
-  port->dest_connections = object_realloc_n (
-    port->dest_connections, 0, port->dests_size, PortConnection *);
+  conns.dests = object_new_n ((size_t) conns.num_dests, Port *);
+  conns.dest_connections =
+    object_new_n ((size_t) conns.num_dests, PortConnection *);
 #if 0
-  if (num_dests > 0)
+  if (conns.num_dests > 0)
     g_debug (
       "%d dests for %s",
-      num_dests, port->id.label);
+      conns.num_dests, port->id.label);
 #endif
-  for (int i = 0; i < num_dests; i++)
+  for (int i = 0; i < conns.num_dests; i++)
     {
       PortConnection * conn = (PortConnection *) g_ptr_array_index (dests, i);
 
-      port->dests[i] = port_find_from_identifier (conn->dest_id);
-      g_return_val_if_fail (port->dests[i], NULL);
-      port->dest_connections[i] = conn;
+      conns.dests[i] = port_find_from_identifier (conn->dest_id);
+      conns.dest_connections[i] = conn;
     }
-  port->num_dests = num_dests;
   g_ptr_array_unref (dests);
 
+  bool found_all = true;
+  for (int i = 0; i < conns.num_srcs; i++)
+    found_all = found_all && conns.srcs[i];
+  for (int i = 0; i < conns.num_dests; i++)
+    found_all = found_all && conns.dests[i];
+  if (!found_all)
+    {
+      free_port_connections (&conns);
+      g_return_val_if_reached (NULL);
+    }
+
+  g_array_append_val (self->setup_port_connections, conns);
+
   /* skip unnecessary control ports */
   if (
     drop_if_unnecessary && port->id.type == TYPE_CONTROL
@@ -382,7 +792,7 @@ add_port (Graph * self, Port * port, const bool drop_if_unnecessary)
     {
       AutomationTrack * found_at = port->at;
       g_return_val_if_fail (found_at, NULL);
-      if (found_at->num_regions == 0 && port->num_srcs == 0)
+      if (found_at->num_regions == 0 && conns.num_srcs == 0)
         {
           return NULL;
         }
@@ -390,7 +800,7 @@ add_port (Graph * self, Port * port, const bool drop_if_unnecessary)
 
   /* drop ports without sources and dests */
   if (
-    drop_if_unnecessary && port->num_dests == 0 && port->num_srcs == 0
+    drop_if_unnecessary && conns.num_dests == 0 && conns.num_srcs == 0
     && owner != PORT_OWNER_TYPE_PLUGIN && owner != PORT_OWNER_TYPE_FADER
     && owner != PORT_OWNER_TYPE_TRACK_PROCESSOR && owner != PORT_OWNER_TYPE_TRACK
     && owner != PORT_OWNER_TYPE_MODULATOR_MACRO_PROCESSOR
@@ -404,7 +814,10 @@ add_port (Graph * self, Port * port, const bool drop_if_unnecessary)
   else
     {
       /* allocate buffers to be used during DSP */
-      port_allocate_bufs (port);
+      if (reallocate_bufs)
+        port_allocate_bufs (port);
+      else
+        port_allocate_missing_bufs (port);
       return graph_create_node (self, ROUTE_NODE_TYPE_PORT, port);
     }
 }
@@ -413,13 +826,14 @@ add_port (Graph * self, Port * port, const bool drop_if_unnecessary)
  * Connect the port as a node.
  */
 static void
-connect_port (Graph * self, Port * port)
+connect_port (Graph * self, const GraphPortConnections * conns)
 {
+  Port *      port = conns->port;
   GraphNode * node = graph_find_node_from_port (self, port);
   GraphNode * node2;
-  for (int j = 0; j < port->num_srcs; j++)
+  for (int j = 0; j < conns->num_srcs; j++)
     {
-      Port * src = port->srcs[j];
+      Port * src = conns->srcs[j];
       node2 = graph_find_node_from_port (self, src);
       g_warn_if_fail (node);
       g_warn_if_fail (node2);
@@ -429,9 +843,9 @@ connect_port (Graph * self, Port * port)
 #endif
       graph_node_connect (node2, node);
     }
-  for (int j = 0; j < port->num_dests; j++)
+  for (int j = 0; j < conns->num_dests; j++)
     {
-      Port * dest = port->dests[j];
+      Port * dest = conns->dests[j];
       node2 = graph_find_node_from_port (self, dest);
       g_warn_if_fail (node);
       g_warn_if_fail (node2);
@@ -509,20 +923,69 @@ graph_update_latencies (Graph * self, bool use_setup_nodes)
     graph_get_max_route_playback_latency (self, use_setup_nodes), 0);
 }
 
-/*
- * Adds the graph nodes and connections, then
- * rechains.
+/**
+ * Sets the caches of tracks and plugins not in the
+ * current graph, and of automation tracks added to
+ * tracks in it.
  *
- * @param drop_unnecessary_ports Drops any ports
- *   that don't connect anywhere.
- * @param rechain Whether to rechain or not. If
- *   we are just validating this should be 0.
+ * The caches of objects the engine may be processing
+ * are left alone.
  */
-void
-graph_setup (Graph * self, const int drop_unnecessary_ports, const int rechain)
+static void
+set_caches_of_new_objects (Graph * self)
+{
+  for (int i = 0; i < TRACKLIST->num_tracks; i++)
+    {
+      Track * tr = TRACKLIST->tracks[i];
+      if (!graph_find_node_from_track (self, tr, false))
+        {
+          track_set_caches (
+            tr,
+            CACHE_TYPE_PLUGIN_PORTS | CACHE_TYPE_AUTOMATION_LANE_RECORD_MODES
+              | CACHE_TYPE_AUTOMATION_LANE_PORTS);
+          continue;
+        }
+
+      /* automation tracks of new plugins */
+      AutomationTracklist * atl = track_get_automation_tracklist (tr);
+      if (atl)
+        {
+          automation_tracklist_set_caches_of_new_ats (atl);
+        }
+
+      if (!tr->channel)
+        continue;
+
+      Plugin * pls[120];
+      int      num_pls = channel_get_plugins (tr->channel, pls);
+      for (int j = 0; j < num_pls; j++)
+        {
+          if (!g_hash_table_contains (self->graph_nodes, pls[j]))
+            {
+              plugin_set_caches (pls[j]);
+            }
+        }
+    }
+  clip_editor_set_caches (CLIP_EDITOR);
+}
+
+/**
+ * Adds the graph nodes and connections to the setup
+ * nodes.
+ *
+ * @param while_running Whether the engine may be
+ *   processing the current nodes.
+ */
+static void
+setup (
+  Graph *    self,
+  const bool drop_unnecessary_ports,
+  const bool while_running)
 {
   GraphNode *node, *node2;
 
+  clear_setup (self);
+
   /* ========================
    * first add all the nodes
    * ======================== */
@@ -622,8 +1085,7 @@ graph_setup (Graph * self, const int drop_unnecessary_ports, const int rechain)
         }
     }
 
-  object_free_w_func_and_null (g_ptr_array_unref, self->external_out_ports);
-  self->external_out_ports = g_ptr_array_new ();
+  self->setup_external_out_ports = g_ptr_array_new ();
 
   /* add ports */
   Port *      port;
@@ -644,10 +1106,11 @@ graph_setup (Graph * self, const int drop_unnecessary_ports, const int rechain)
 
       if (port->id.flow == FLOW_OUTPUT && port_is_exposed_to_backend (port))
         {
-          g_ptr_array_add (self->external_out_ports, port);
+          g_ptr_array_add (self->setup_external_out_ports, port);
         }
 
-      GraphNode * port_node = add_port (self, port, drop_unnecessary_ports);
+      GraphNode * port_node =
+        add_port (self, port, drop_unnecessary_ports, !while_running);
       (void) port_node;
 #if 0
       if (port_node)
@@ -825,29 +1288,29 @@ graph_setup (Graph * self, const int drop_unnecessary_ports, const int rechain)
         }
       if (tr->type == TRACK_TYPE_TEMPO)
         {
-          self->bpm_node = NULL;
-          self->beats_per_bar_node = NULL;
-          self->beat_unit_node = NULL;
+          self->setup_bpm_node = NULL;
+          self->setup_beats_per_bar_node = NULL;
+          self->setup_beat_unit_node = NULL;
 
           port = tr->bpm_port;
           node2 = graph_find_node_from_port (self, port);
           if (node2 || !drop_unnecessary_ports)
             {
-              self->bpm_node = node2;
+              self->setup_bpm_node = node2;
               graph_node_connect (node2, node);
             }
           port = tr->beats_per_bar_port;
           node2 = graph_find_node_from_port (self, port);
           if (node2 || !drop_unnecessary_ports)
             {
-              self->beats_per_bar_node = node2;
+              self->setup_beats_per_bar_node = node2;
               graph_node_connect (node2, node);
             }
           port = tr->beat_unit_port;
           node2 = graph_find_node_from_port (self, port);
           if (node2 || !drop_unnecessary_ports)
             {
-              self->beat_unit_node = node2;
+              self->setup_beat_unit_node = node2;
               graph_node_connect (node2, node);
             }
           graph_node_connect (node, initial_processor_node);
@@ -1050,19 +1513,11 @@ graph_setup (Graph * self, const int drop_unnecessary_ports, const int rechain)
         }
     }
 
-  for (size_t i = 0; i < ports->len; i++)
+  for (guint i = 0; i < self->setup_port_connections->len; i++)
     {
-      port = g_ptr_array_index (ports, i);
-      if (G_UNLIKELY (port->deleting))
-        continue;
-      if (port->id.owner_type == PORT_OWNER_TYPE_PLUGIN)
-        {
-          Plugin * port_pl = port_get_plugin (port, 1);
-          if (G_UNLIKELY (port_pl->deleting))
-            continue;
-        }
-
-      connect_port (self, port);
+      connect_port (
+        self, &g_array_index (
+                self->setup_port_connections, GraphPortConnections, i));
     }
 
   /* ========================
@@ -1114,6 +1569,10 @@ graph_setup (Graph * self, const int drop_unnecessary_ports, const int rechain)
     {
       tracklist_set_caches (SAMPLE_PROCESSOR->tracklist, CACHE_TYPE_ALL);
     }
+  else if (while_running)
+    {
+      set_caches_of_new_objects (self);
+    }
   else
     {
       clip_editor_set_caches (CLIP_EDITOR);
@@ -1123,11 +1582,34 @@ graph_setup (Graph * self, const int drop_unnecessary_ports, const int rechain)
   /*graph_print (self);*/
 
   g_ptr_array_unref (ports);
+}
+
+/*
+ * Adds the graph nodes and connections, then
+ * rechains.
+ *
+ * @param drop_unnecessary_ports Drops any ports
+ *   that don't connect anywhere.
+ * @param rechain Whether to rechain or not. If
+ *   we are just validating this should be 0.
+ */
+void
+graph_setup (Graph * self, const int drop_unnecessary_ports, const int rechain)
+{
+  setup (self, drop_unnecessary_ports, false);
 
   if (rechain)
     graph_rechain (self);
 }
 
+void
+graph_setup_while_running (Graph * self)
+{
+  g_return_if_fail (!self->sample_processor);
+
+  setup (self, true, true);
+}
+
 /**
  * Adds a new connection for the given
  * src and dest ports and validates the graph.
@@ -1247,11 +1729,27 @@ graph_new_full (Router * router, SampleProcessor * sample_processor)
     g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) graph_node_free);
   self->setup_graph_nodes = g_hash_table_new_full (
     g_direct_hash, g_direct_equal, NULL, (GDestroyNotify) graph_node_free);
+  self->setup_port_connections =
+    g_array_new (false, true, sizeof (GraphPortConnections));
 
   zix_sem_init (&self->callback_start, 0);
   zix_sem_init (&self->callback_done, 0);
   zix_sem_init (&self->trigger, 0);
 
+  GraphScheduler scheduler =
+    ZRYTHM_TESTING
+      ? GRAPH_SCHEDULER_SHARED_QUEUE
+      : (GraphScheduler) g_settings_get_enum (
+        S_P_GENERAL_ENGINE, "graph-scheduler");
+  self->scheduler = (GraphScheduler) CLAMP (
+    env_get_int ("ZRYTHM_GRAPH_SCHEDULER", (int) scheduler),
+    GRAPH_SCHEDULER_SHARED_QUEUE, GRAPH_SCHEDULER_WORK_STEALING);
+  g_message (
+    "using graph scheduler: %s", graph_scheduler_str[self->scheduler]);
+
+  self->static_schedule_max_nframes = (nframes_t) MAX (
+    env_get_int ("ZRYTHM_GRAPH_STATIC_SCHEDULE_MAX_FRAMES", 0), 0);
+
   g_atomic_int_set (&self->terminal_refcnt, 0);
   g_atomic_int_set (&self->terminate, 0);
   g_atomic_int_set (&self->idle_thread_cnt, 0);
@@ -1304,12 +1802,14 @@ graph_terminate (Graph * self)
       g_return_if_fail (self->threads[i]);
       void * status;
       pthread_join (self->threads[i]->pthread, &status);
-      self->threads[i] = NULL;
+      object_free_w_func_and_null (graph_thread_free, self->threads[i]);
     }
   g_return_if_fail (self->main_thread);
   void * status;
   pthread_join (self->main_thread->pthread, &status);
-  self->main_thread = NULL;
+  object_free_w_func_and_null (graph_thread_free, self->main_thread);
+
+  graph_print_cycle_stats (self);
 
   g_message ("graph terminated");
 }
@@ -1469,11 +1969,16 @@ graph_free (Graph * self)
 {
   g_debug ("%s: freeing...", __func__);
 
+  clear_setup (self);
+  object_free_w_func_and_null (g_array_unref, self->setup_port_connections);
+
   object_free_w_func_and_null (g_hash_table_unref, self->graph_nodes);
   object_zero_and_free (self->init_trigger_list);
   object_free_w_func_and_null (g_hash_table_unref, self->setup_graph_nodes);
   object_zero_and_free (self->setup_init_trigger_list);
   object_zero_and_free (self->terminal_nodes);
+  object_zero_and_free (self->setup_terminal_nodes);
+  object_zero_and_free (self->static_schedule);
 
   object_free_w_func_and_null (g_ptr_array_unref, self->external_out_ports);
 
@@ -8,6 +8,7 @@
 #include "dsp/fader.h"
 #include "dsp/graph.h"
 #include "dsp/graph_node.h"
+#include "dsp/graph_thread.h"
 #include "dsp/master_track.h"
 #include "dsp/midi_event.h"
 #include "dsp/port.h"
@@ -375,7 +376,11 @@ graph_node_process (GraphNode * node, EngineProcessTimeInfo time_nfo)
     }
 
 node_process_finish:
-  if (node->graph->router->callback_in_progress)
+  /* when running the static schedule the order is
+   * already known, so don't trigger the child nodes */
+  if (
+    node->graph->router->callback_in_progress
+    && !node->graph->run_static_schedule)
     {
       on_node_finish (node);
     }
@@ -397,9 +402,8 @@ graph_node_trigger (GraphNode * self)
       /* all nodes that feed this node have
        * completed, so this node be processed
        * now. */
-      g_atomic_int_inc (&self->graph->trigger_queue_size);
       /*g_message ("triggering node, pushing back");*/
-      mpmc_queue_push_back_node (self->graph->trigger_queue, self);
+      graph_thread_push_node (self->graph, self);
     }
 }
 
@@ -52,6 +52,10 @@
 
 #include "zrythm-config.h"
 
+#ifdef HAVE_C11_THREADS
+#  include <threads.h>
+#endif
+
 #ifndef _WOE32
 #  include <sys/resource.h>
 #endif
@@ -75,6 +79,7 @@
 #include "utils/mpmc_queue.h"
 #include "utils/objects.h"
 #include "utils/ui.h"
+#include "utils/ws_deque.h"
 #include "zrythm_app.h"
 
 #ifdef HAVE_JACK
@@ -86,6 +91,83 @@
 /* uncomment to show debug messages */
 /*#define DEBUG_THREADS 1*/
 
+#ifdef HAVE_C11_THREADS
+static thread_local GraphThread * current_thread = NULL;
+#endif
+
+GraphThread *
+graph_thread_get_current (void)
+{
+#ifdef HAVE_C11_THREADS
+  return current_thread;
+#else
+  return NULL;
+#endif
+}
+
+void
+graph_thread_push_node (Graph * graph, GraphNode * node)
+{
+  g_atomic_int_inc (&graph->trigger_queue_size);
+
+  if (graph->scheduler == GRAPH_SCHEDULER_WORK_STEALING)
+    {
+      GraphThread * thread = graph_thread_get_current ();
+      if (
+        G_LIKELY (thread && thread->graph == graph)
+        && ws_deque_push (thread->deque, node))
+        {
+          return;
+        }
+    }
+
+  /* not called from a graph thread (or the deque is
+   * full) - use the shared queue */
+  mpmc_queue_push_back_node (graph->trigger_queue, node);
+}
+
+/**
+ * Tries to find a node to process.
+ *
+ * With the work-stealing scheduler, this pops from
+ * the thread's own deque, then tries to steal from
+ * the other threads and finally checks the shared
+ * queue.
+ */
+HOT static bool
+dequeue_node (GraphThread * thread, GraphNode ** node)
+{
+  Graph * graph = thread->graph;
+  if (graph->scheduler != GRAPH_SCHEDULER_WORK_STEALING)
+    {
+      return mpmc_queue_dequeue_node (graph->trigger_queue, node);
+    }
+
+  if (ws_deque_pop (thread->deque, (void **) node))
+    {
+      return true;
+    }
+
+  /* start from the next thread so that victims are
+   * spread evenly */
+  int num_total_threads = graph->num_threads + 1;
+  int self_idx = thread->id == -1 ? graph->num_threads : thread->id;
+  for (int i = 1; i < num_total_threads; i++)
+    {
+      GraphThread * victim =
+        graph_get_thread_at (graph, (self_idx + i) % num_total_threads);
+      if (
+        victim && victim->deque
+        && ws_deque_steal (victim->deque, (void **) node))
+        {
+          thread->num_steals++;
+          return true;
+        }
+    }
+
+  return mpmc_queue_dequeue_node (graph->trigger_queue, node);
+}
+
 OPTIMIZE (O3)
 static void *
 dsp_worker_thread (void * arg)
@@ -98,6 +180,10 @@ dsp_worker_thread (void * arg)
    * allocation is done later on */
   g_thread_self ();
 
+#ifdef HAVE_C11_THREADS
+  current_thread = thread;
+#endif
+
   g_message (
     "WORKER THREAD %d created (num threads %d)", thread->id, graph->num_threads);
 
@@ -131,7 +217,7 @@ dsp_worker_thread (void * arg)
           goto terminate_thread;
         }
 
-      if (mpmc_queue_dequeue_node (graph->trigger_queue, &to_run))
+      if (dequeue_node (thread, &to_run))
         {
           g_warn_if_fail (to_run);
 #ifdef DEBUG_THREADS
@@ -165,6 +251,7 @@ dsp_worker_thread (void * arg)
       while (!to_run)
         {
           /* wait for work, fall asleep */
+          thread->num_idle++;
           g_atomic_int_inc (&graph->idle_thread_cnt);
           int idle_thread_cnt = g_atomic_int_get (&graph->idle_thread_cnt);
 #ifdef DEBUG_THREADS
@@ -202,7 +289,7 @@ dsp_worker_thread (void * arg)
 #endif
 
           /* try to find some work to do */
-          mpmc_queue_dequeue_node (graph->trigger_queue, &to_run);
+          dequeue_node (thread, &to_run);
         }
 
       /* this thread has now claimed the graph node for
@@ -211,6 +298,7 @@ dsp_worker_thread (void * arg)
 #ifdef DEBUG_THREADS
       g_message ("[%d]: running node", thread->id);
 #endif
+      thread->num_processed++;
       graph_node_process (to_run, graph->router->time_nfo);
     }
 
@@ -233,6 +321,10 @@ main_thread (void * arg)
   GraphThread * thread = (GraphThread *) arg;
   Graph *       self = thread->graph;
 
+#ifdef HAVE_C11_THREADS
+  current_thread = thread;
+#endif
+
   /* Wait until all worker threads are active */
   while (g_atomic_int_get (&self->idle_thread_cnt) != self->num_threads)
     {
@@ -240,7 +332,10 @@ main_thread (void * arg)
     }
 
   /* wait for initial process callback */
-  zix_sem_wait (&self->callback_start);
+  if (!graph_wait_for_next_dynamic_cycle (self))
+    {
+      return dsp_worker_thread (thread);
+    }
 
   /* first time setup */
 
@@ -257,10 +352,8 @@ main_thread (void * arg)
    * Graph_reached_terminal_node)*/
   for (size_t i = 0; i < self->n_init_triggers; ++i)
     {
-      g_atomic_int_inc (&self->trigger_queue_size);
       /*g_message ("[main] pushing back node %d during bootstrap", i);*/
-      mpmc_queue_push_back_node (
-        self->trigger_queue, self->init_trigger_list[i]);
+      graph_thread_push_node (self, self->init_trigger_list[i]);
     }
 
   /* after setup, the main-thread just becomes
@@ -382,6 +475,12 @@ graph_thread_new (const int id, const bool is_main, Graph * graph)
   self->id = id;
   self->graph = graph;
 
+  /* the deque must be large enough to hold all the
+   * nodes since it does not grow while processing */
+  self->deque = ws_deque_new ();
+  ws_deque_reserve (
+    self->deque, (size_t) g_hash_table_size (graph->graph_nodes));
+
   pthread_attr_t attributes;
   pthread_attr_init (&attributes);
   int res;
@@ -595,3 +694,11 @@ dbus_fail_handling:
 
   return self;
 }
+
+void
+graph_thread_free (GraphThread * self)
+{
+  object_free_w_func_and_null (ws_deque_free, self->deque);
+
+  object_zero_and_free (self);
+}
@@ -39,6 +39,7 @@
 #include "dsp/router.h"
 #include "dsp/transport.h"
 #include "project.h"
+#include "utils/flags.h"
 #include "utils/objects.h"
 #include "zrythm_app.h"
 
@@ -294,9 +295,6 @@ midi_events_clear (MidiEvents * self, int queued)
 int
 midi_events_check_for_note_on (MidiEvents * self, int note, int queued)
 {
-  /*g_message ("waiting check note on");*/
-  zix_sem_wait (&self->access_sem);
-
   MidiEvent * ev;
   for (int i = 0; i < queued ? self->num_queued_events : self->num_events; i++)
     {
@@ -311,9 +309,6 @@ midi_events_check_for_note_on (MidiEvents * self, int note, int queued)
         return 1;
     }
 
-  zix_sem_post (&self->access_sem);
-  /*g_message ("posted check note on");*/
-
   return 0;
 }
 
@@ -324,9 +319,6 @@ midi_events_check_for_note_on (MidiEvents * self, int note, int queued)
 int
 midi_events_delete_note_on (MidiEvents * self, int note, int queued)
 {
-  /*g_message ("waiting delete note on");*/
-  zix_sem_wait (&self->access_sem);
-
   MidiEvent *ev, *ev2, *next_ev;
   int        match = 0;
   for (
@@ -363,8 +355,6 @@ midi_events_delete_note_on (MidiEvents * self, int note, int queued)
         }
     }
 
-  zix_sem_post (&self->access_sem);
-
   return match;
 }
 
@@ -376,8 +366,11 @@ midi_events_init (MidiEvents * self)
 {
   self->num_events = 0;
   self->num_queued_events = 0;
+  self->external_write_idx = 0;
+  self->external_read_idx = 0;
+  self->external_writing = 0;
 
-  zix_sem_init (&self->access_sem, 1);
+  g_mutex_init (&self->external_write_lock);
 }
 
 /**
@@ -427,15 +420,62 @@ midi_events_has_note_on (MidiEvents * self, int check_main, int check_queued)
   return 0;
 }
 
+/** Number of times the engine found another thread
+ * adding an external event while dequeueing. */
+static volatile gint num_external_contentions = 0;
+
+/**
+ * Returns the number of times the engine found another
+ * thread in the middle of adding an external event while
+ * dequeueing.
+ */
+int
+midi_events_get_num_external_contentions (void)
+{
+  return g_atomic_int_get (&num_external_contentions);
+}
+
+/**
+ * Moves the events added by other threads to the queued
+ * events.
+ */
+REALTIME
+static void
+dequeue_external_events (MidiEvents * self)
+{
+  if (G_UNLIKELY (g_atomic_int_get (&self->external_writing)))
+    {
+      /* the events being written are picked up in the
+       * next cycle */
+      g_atomic_int_inc (&num_external_contentions);
+    }
+
+  guint read_idx = (guint) g_atomic_int_get (&self->external_read_idx);
+  guint write_idx = (guint) g_atomic_int_get (&self->external_write_idx);
+  if (read_idx == write_idx)
+    return;
+
+  for (; read_idx != write_idx && self->num_queued_events < MAX_MIDI_EVENTS;
+       read_idx++)
+    {
+      midi_event_copy (
+        &self->queued_events[self->num_queued_events++],
+        &self->external_events[read_idx & (MAX_EXTERNAL_MIDI_EVENTS - 1)]);
+    }
+  g_atomic_int_set (&self->external_read_idx, (gint) read_idx);
+
+  midi_events_sort (self, F_QUEUED);
+}
+
 /**
- * Copies the queue contents to the original struct
+ * Copies the queue contents (including events from other
+ * threads) to the original struct.
  */
 REALTIME
 NONNULL void
 midi_events_dequeue (MidiEvents * self)
 {
-  /*g_message ("waiting dequeue");*/
-  zix_sem_wait (&self->access_sem);
+  dequeue_external_events (self);
 
   MidiEvent *ev, *q_ev;
   for (int i = 0; i < self->num_queued_events; i++)
@@ -448,9 +488,6 @@ midi_events_dequeue (MidiEvents * self)
 
   self->num_events = self->num_queued_events;
   self->num_queued_events = 0;
-
-  zix_sem_post (&self->access_sem);
-  /*g_message ("posted dequeue");*/
 }
 
 /**
@@ -507,12 +544,150 @@ midi_events_panic (MidiEvents * self, bool queued)
       g_return_if_fail (g_thread_self () == zrythm_app->gtk_thread);
     }
 
-  while (zix_sem_try_wait (&self->access_sem) != ZIX_STATUS_SUCCESS)
+  if (!queued)
+    {
+      midi_events_panic_without_lock (self, false);
+      return;
+    }
+
+  for (midi_byte_t i = 1; i < 17; i++)
+    {
+      midi_byte_t buf[3] = {
+        (midi_byte_t) (MIDI_CH1_CTRL_CHANGE | (i - 1)), MIDI_ALL_NOTES_OFF, 0x00
+      };
+      midi_events_add_external_event (self, buf, 3, 0);
+    }
+}
+
+/**
+ * Adds an event from a thread other than the engine's.
+ */
+bool
+midi_events_add_external_event (
+  MidiEvents *        self,
+  const midi_byte_t * buf,
+  size_t              buf_size,
+  midi_time_t         time)
+{
+  g_return_val_if_fail (buf_size > 0 && buf_size <= 3, false);
+
+  g_mutex_lock (&self->external_write_lock);
+  g_atomic_int_inc (&self->external_writing);
+
+  guint write_idx = (guint) g_atomic_int_get (&self->external_write_idx);
+  guint read_idx = (guint) g_atomic_int_get (&self->external_read_idx);
+  bool  has_space = write_idx - read_idx < MAX_EXTERNAL_MIDI_EVENTS;
+  if (has_space)
+    {
+      MidiEvent * ev =
+        &self->external_events[write_idx & (MAX_EXTERNAL_MIDI_EVENTS - 1)];
+      memset (ev, 0, sizeof (MidiEvent));
+      ev->time = time;
+      ev->systime = g_get_monotonic_time ();
+      memcpy (ev->raw_buffer, buf, buf_size);
+      ev->raw_buffer_sz = buf_size;
+
+      /* publish the event */
+      g_atomic_int_set (&self->external_write_idx, (gint) (write_idx + 1));
+    }
+
+  g_atomic_int_add (&self->external_writing, -1);
+  g_mutex_unlock (&self->external_write_lock);
+
+  if (!has_space)
+    {
+      g_message ("too many pending MIDI events, dropping event");
+    }
+
+  return has_space;
+}
+
+/**
+ * Adds a note on from a thread other than the engine's.
+ */
+bool
+midi_events_add_external_note_on (
+  MidiEvents * self,
+  midi_byte_t  channel,
+  midi_byte_t  note_pitch,
+  midi_byte_t  velocity,
+  midi_time_t  time)
+{
+  g_return_val_if_fail (channel > 0, false);
+  midi_byte_t buf[3] = {
+    (midi_byte_t) (MIDI_CH1_NOTE_ON | (channel - 1)), note_pitch, velocity
+  };
+  return midi_events_add_external_event (self, buf, 3, time);
+}
+
+/**
+ * Adds a note off from a thread other than the engine's.
+ */
+bool
+midi_events_add_external_note_off (
+  MidiEvents * self,
+  midi_byte_t  channel,
+  midi_byte_t  note_pitch,
+  midi_time_t  time)
+{
+  g_return_val_if_fail (channel > 0, false);
+  midi_byte_t buf[3] = {
+    (midi_byte_t) (MIDI_CH1_NOTE_OFF | (channel - 1)), note_pitch, 90
+  };
+  return midi_events_add_external_event (self, buf, 3, time);
+}
+
+/**
+ * Adds a note on for each note in the chord from a
+ * thread other than the engine's.
+ */
+bool
+midi_events_add_external_note_ons_from_chord_descr (
+  MidiEvents *            self,
+  const ChordDescriptor * descr,
+  midi_byte_t             channel,
+  midi_byte_t             velocity,
+  midi_time_t             time)
+{
+  bool success = true;
+  for (int i = 0; i < CHORD_DESCRIPTOR_MAX_NOTES; i++)
+    {
+      if (descr->notes[i])
+        {
+          success =
+            midi_events_add_external_note_on (
+              self, channel, (midi_byte_t) (i + 36), velocity, time)
+            && success;
+        }
+    }
+
+  return success;
+}
+
+/**
+ * Adds a note off for each note in the chord from a
+ * thread other than the engine's.
+ */
+bool
+midi_events_add_external_note_offs_from_chord_descr (
+  MidiEvents *            self,
+  const ChordDescriptor * descr,
+  midi_byte_t             channel,
+  midi_time_t             time)
+{
+  bool success = true;
+  for (int i = 0; i < CHORD_DESCRIPTOR_MAX_NOTES; i++)
     {
-      g_usleep (10);
+      if (descr->notes[i])
+        {
+          success =
+            midi_events_add_external_note_off (
+              self, channel, (midi_byte_t) (i + 36), time)
+            && success;
+        }
     }
-  midi_events_panic_without_lock (self, queued);
-  zix_sem_post (&self->access_sem);
+
+  return success;
 }
 
 void
@@ -1121,7 +1296,7 @@ midi_events_clear_duplicates (MidiEvents * self, const int queued)
 void
 midi_events_free (MidiEvents * self)
 {
-  zix_sem_destroy (&self->access_sem);
+  g_mutex_clear (&self->external_write_lock);
 
   object_zero_and_free (self);
 }
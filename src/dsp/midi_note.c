@@ -106,13 +106,15 @@ midi_note_listen (MidiNote * mn, bool listen)
           /*g_message (*/
           /*"%s: adding note off for %" PRIu8,*/
           /*__func__, mn->last_listened_val);*/
-          midi_events_add_note_off (events, 1, mn->last_listened_val, 0, 1);
+          midi_events_add_external_note_off (
+            events, 1, mn->last_listened_val, 0);
 
           /* create note on at the new value */
           /*g_message (*/
           /*"%s: adding note on for %" PRIu8,*/
           /*__func__, mn->val);*/
-          midi_events_add_note_on (events, 1, mn->val, mn->vel->vel, 0, 1);
+          midi_events_add_external_note_on (
+            events, 1, mn->val, mn->vel->vel, 0);
           mn->last_listened_val = mn->val;
         }
       /* if note is on and pitch is the same */
@@ -127,7 +129,8 @@ midi_note_listen (MidiNote * mn, bool listen)
           /*g_message (*/
           /*"%s: adding note on for %" PRIu8,*/
           /*__func__, mn->val);*/
-          midi_events_add_note_on (events, 1, mn->val, mn->vel->vel, 0, 1);
+          midi_events_add_external_note_on (
+            events, 1, mn->val, mn->vel->vel, 0);
           mn->last_listened_val = mn->val;
           mn->currently_listened = 1;
         }
@@ -139,7 +142,7 @@ midi_note_listen (MidiNote * mn, bool listen)
       /*g_message (*/
       /*"%s: adding note off for %" PRIu8,*/
       /*__func__, mn->last_listened_val);*/
-      midi_events_add_note_off (events, 1, mn->last_listened_val, 0, 1);
+      midi_events_add_external_note_off (events, 1, mn->last_listened_val, 0);
       mn->currently_listened = 0;
       mn->last_listened_val = 255;
     }
@@ -244,14 +247,13 @@ midi_note_set_val (MidiNote * midi_note, const uint8_t val)
 
       MidiEvents * midi_events = track->processor->piano_roll->midi_events;
 
-      zix_sem_wait (&midi_events->access_sem);
       uint8_t midi_ch = midi_region_get_midi_ch (region);
-      midi_events_add_note_off (
-        midi_events, midi_ch, midi_note->val, 0, F_QUEUED);
-      zix_sem_post (&midi_events->access_sem);
+      midi_events_add_external_note_off (
+        midi_events, midi_ch, midi_note->val, 0);
     }
 
   midi_note->val = val;
+  arranger_object_bump_content_version ((ArrangerObject *) midi_note);
 }
 
 /**
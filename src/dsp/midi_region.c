@@ -53,6 +53,7 @@
 #include "project.h"
 #include "utils/arrays.h"
 #include "utils/flags.h"
+#include "utils/interval_index.h"
 #include "utils/math.h"
 #include "utils/mem.h"
 #include "utils/objects.h"
@@ -160,6 +161,8 @@ midi_region_insert_midi_note (
   array_double_size_if_full (
     self->midi_notes, self->num_midi_notes, self->midi_notes_size, MidiNote *);
   array_insert (self->midi_notes, self->num_midi_notes, idx, midi_note);
+  object_free_w_func_and_null (interval_index_free, self->arranger_index);
+  self->content_version++;
 
   for (int i = idx; i < self->num_midi_notes; i++)
     {
@@ -301,6 +304,8 @@ midi_region_remove_midi_note (
     }
 
   array_delete (region->midi_notes, region->num_midi_notes, midi_note);
+  object_free_w_func_and_null (interval_index_free, region->arranger_index);
+  region->content_version++;
 
   for (int i = 0; i < region->num_midi_notes; i++)
     {
@@ -1038,6 +1043,270 @@ send_note_offs (
     }
 }
 
+/**
+ * Returns the end position of the given note or chord object
+ * in frames.
+ */
+static inline signed_frame_t
+get_note_end_frames (const ArrangerObject * mn_obj, bool is_chord)
+{
+  return is_chord
+           ? math_round_double_to_signed_frame_t (
+             mn_obj->pos.frames
+             + TRANSPORT->ticks_per_beat * AUDIO_ENGINE->frames_per_tick)
+           : mn_obj->end_pos.frames;
+}
+
+static inline ArrangerObject *
+get_note_obj (const ZRegion * self, bool is_chord, int idx)
+{
+  return is_chord
+           ? (ArrangerObject *) self->chord_objects[idx]
+           : (ArrangerObject *) self->midi_notes[idx];
+}
+
+typedef struct NoteTimelineEntry
+{
+  signed_frame_t frames;
+  int            idx;
+} NoteTimelineEntry;
+
+static int
+note_timeline_entry_cmp (const void * _a, const void * _b)
+{
+  const NoteTimelineEntry * a = (const NoteTimelineEntry *) _a;
+  const NoteTimelineEntry * b = (const NoteTimelineEntry *) _b;
+  if (a->frames != b->frames)
+    return a->frames < b->frames ? -1 : 1;
+  return a->idx - b->idx;
+}
+
+void
+midi_region_gen_note_timeline (ZRegion * self)
+{
+  object_free_w_func_and_null (midi_note_timeline_free, self->note_timeline);
+
+  const bool is_chord = self->id.type == REGION_TYPE_CHORD;
+  const int  num_notes =
+    is_chord ? self->num_chord_objects : self->num_midi_notes;
+
+  MidiNoteTimeline * timeline = object_new (MidiNoteTimeline);
+  timeline->num_notes = num_notes;
+  timeline->cursor_pos = -1;
+  const size_t num_alloc = (size_t) MAX (num_notes, 1);
+  timeline->start_idxs = object_new_n (num_alloc, int);
+  timeline->start_frames = object_new_n (num_alloc, signed_frame_t);
+  timeline->end_idxs = object_new_n (num_alloc, int);
+  timeline->end_frames = object_new_n (num_alloc, signed_frame_t);
+
+  NoteTimelineEntry * entries = object_new_n (num_alloc, NoteTimelineEntry);
+
+  /* start points */
+  for (int i = 0; i < num_notes; i++)
+    {
+      entries[i].frames = get_note_obj (self, is_chord, i)->pos.frames;
+      entries[i].idx = i;
+    }
+  qsort (
+    entries, (size_t) num_notes, sizeof (NoteTimelineEntry),
+    note_timeline_entry_cmp);
+  for (int i = 0; i < num_notes; i++)
+    {
+      timeline->start_frames[i] = entries[i].frames;
+      timeline->start_idxs[i] = entries[i].idx;
+    }
+
+  /* end points */
+  for (int i = 0; i < num_notes; i++)
+    {
+      entries[i].frames =
+        get_note_end_frames (get_note_obj (self, is_chord, i), is_chord);
+      entries[i].idx = i;
+    }
+  qsort (
+    entries, (size_t) num_notes, sizeof (NoteTimelineEntry),
+    note_timeline_entry_cmp);
+  for (int i = 0; i < num_notes; i++)
+    {
+      timeline->end_frames[i] = entries[i].frames;
+      timeline->end_idxs[i] = entries[i].idx;
+    }
+
+  free (entries);
+
+  self->note_timeline = timeline;
+}
+
+/**
+ * Returns the index of the first element in @p frames that is
+ * greater than or equal to @p pos.
+ */
+static inline int
+find_first_at_or_after (
+  const signed_frame_t * frames,
+  int                    num_frames,
+  signed_frame_t         pos)
+{
+  int lo = 0;
+  int hi = num_frames;
+  while (lo < hi)
+    {
+      int mid = lo + (hi - lo) / 2;
+      if (frames[mid] < pos)
+        lo = mid + 1;
+      else
+        hi = mid;
+    }
+  return lo;
+}
+
+static inline void
+add_note_on (
+  ZRegion *        self,
+  ArrangerObject * mn_obj,
+  bool             is_chord,
+  midi_time_t      _time,
+  MidiEvents *     midi_events)
+{
+  if (is_chord)
+    {
+      ChordDescriptor * descr =
+        chord_object_get_chord_descriptor ((ChordObject *) mn_obj);
+      midi_events_add_note_ons_from_chord_descr (
+        midi_events, descr, 1, VELOCITY_DEFAULT, _time, F_QUEUED);
+    }
+  else
+    {
+      MidiNote * mn = (MidiNote *) mn_obj;
+      midi_events_add_note_on (
+        midi_events, midi_region_get_midi_ch (self), mn->val, mn->vel->vel,
+        _time, F_QUEUED);
+    }
+}
+
+static inline void
+add_note_off (
+  ZRegion *        self,
+  ArrangerObject * mn_obj,
+  bool             is_chord,
+  midi_time_t      _time,
+  MidiEvents *     midi_events)
+{
+  if (is_chord)
+    {
+      ChordDescriptor * descr =
+        chord_object_get_chord_descriptor ((ChordObject *) mn_obj);
+      for (int l = 0; l < CHORD_DESCRIPTOR_MAX_NOTES; l++)
+        {
+          if (descr->notes[l])
+            {
+              midi_events_add_note_off (
+                midi_events, 1, l + 36, _time, F_QUEUED);
+            }
+        }
+    }
+  else
+    {
+      MidiNote * mn = (MidiNote *) mn_obj;
+      midi_events_add_note_off (
+        midi_events, midi_region_get_midi_ch (self), mn->val, _time, F_QUEUED);
+    }
+}
+
+/**
+ * Returns the MIDI time of a note off for a note ending at
+ * @p end_frames.
+ */
+static inline midi_time_t
+get_note_off_time (
+  const EngineProcessTimeInfo * const time_nfo,
+  signed_frame_t                      r_local_pos,
+  signed_frame_t                      end_frames)
+{
+  midi_time_t _time =
+    (midi_time_t) (time_nfo->local_offset + (end_frames - r_local_pos));
+
+  /* note actually ends 1 frame before the end point, not at
+   * the end point */
+  if (_time > 0)
+    {
+      _time--;
+    }
+
+  return _time;
+}
+
+/**
+ * Fills the events using the note timeline, only visiting the
+ * notes starting or ending inside the cycle.
+ */
+static void
+fill_midi_events_from_timeline (
+  ZRegion *                           self,
+  const EngineProcessTimeInfo * const time_nfo,
+  bool                                is_chord,
+  signed_frame_t                      r_local_pos,
+  MidiEvents *                        midi_events)
+{
+  MidiNoteTimeline *   timeline = self->note_timeline;
+  const signed_frame_t cycle_end =
+    r_local_pos + (signed_frame_t) time_nfo->nframes;
+
+  /* look up the cursors again if not continuing from the
+   * previous cycle (seek or loop) */
+  if (r_local_pos != timeline->cursor_pos)
+    {
+      timeline->start_cursor = find_first_at_or_after (
+        timeline->start_frames, timeline->num_notes, r_local_pos);
+      timeline->end_cursor = find_first_at_or_after (
+        timeline->end_frames, timeline->num_notes, r_local_pos);
+    }
+
+  /* objects starting inside the current range */
+  int i;
+  for (i = timeline->start_cursor;
+       i < timeline->num_notes && timeline->start_frames[i] < cycle_end; i++)
+    {
+      const signed_frame_t start_frames = timeline->start_frames[i];
+      if (start_frames < 0)
+        continue;
+
+      ArrangerObject * mn_obj =
+        get_note_obj (self, is_chord, timeline->start_idxs[i]);
+      if (arranger_object_get_muted (mn_obj, false))
+        continue;
+
+      midi_time_t _time =
+        (midi_time_t) (time_nfo->local_offset + (start_frames - r_local_pos));
+      add_note_on (self, mn_obj, is_chord, _time, midi_events);
+    }
+  timeline->start_cursor = i;
+
+  /* objects ending within the cycle (inclusive of the cycle
+   * end) */
+  for (i = timeline->end_cursor;
+       i < timeline->num_notes && timeline->end_frames[i] <= cycle_end; i++)
+    {
+      const signed_frame_t end_frames = timeline->end_frames[i];
+
+      /* notes ending exactly at the cycle end are also
+       * checked in the next cycle */
+      if (end_frames < cycle_end)
+        timeline->end_cursor = i + 1;
+
+      ArrangerObject * mn_obj =
+        get_note_obj (self, is_chord, timeline->end_idxs[i]);
+      if (arranger_object_get_muted (mn_obj, false))
+        continue;
+
+      add_note_off (
+        self, mn_obj, is_chord,
+        get_note_off_time (time_nfo, r_local_pos, end_frames), midi_events);
+    }
+
+  timeline->cursor_pos = cycle_end;
+}
+
 void
 midi_region_fill_midi_events (
   ZRegion *                           self,
@@ -1074,28 +1343,20 @@ midi_region_fill_midi_events (
     }
 #endif
 
+  const bool is_chord = track->type == TRACK_TYPE_CHORD;
+
+  if (self->note_timeline)
+    {
+      fill_midi_events_from_timeline (
+        self, time_nfo, is_chord, r_local_pos, midi_events);
+      return;
+    }
+
   /* go through each note */
-  int num_objs =
-    track->type == TRACK_TYPE_CHORD
-      ? self->num_chord_objects
-      : self->num_midi_notes;
+  int num_objs = is_chord ? self->num_chord_objects : self->num_midi_notes;
   for (int i = 0; i < num_objs; i++)
     {
-      ArrangerObject *  mn_obj = NULL;
-      MidiNote *        mn = NULL;
-      ChordObject *     co = NULL;
-      ChordDescriptor * descr = NULL;
-      if (track->type == TRACK_TYPE_CHORD)
-        {
-          co = self->chord_objects[i];
-          descr = chord_object_get_chord_descriptor (co);
-          mn_obj = (ArrangerObject *) co;
-        }
-      else
-        {
-          mn = self->midi_notes[i];
-          mn_obj = (ArrangerObject *) mn;
-        }
+      ArrangerObject * mn_obj = get_note_obj (self, is_chord, i);
       if (arranger_object_get_muted (mn_obj, false))
         {
           continue;
@@ -1112,25 +1373,10 @@ midi_region_fill_midi_events (
                            + (mn_obj->pos.frames - r_local_pos));
           /*g_message ("normal note on at %u", time);*/
 
-          if (mn)
-            {
-              midi_events_add_note_on (
-                midi_events, midi_region_get_midi_ch (self), mn->val,
-                mn->vel->vel, _time, F_QUEUED);
-            }
-          else if (co)
-            {
-              midi_events_add_note_ons_from_chord_descr (
-                midi_events, descr, 1, VELOCITY_DEFAULT, _time, F_QUEUED);
-            }
+          add_note_on (self, mn_obj, is_chord, _time, midi_events);
         }
 
-      signed_frame_t mn_obj_end_frames =
-        (track->type == TRACK_TYPE_CHORD
-           ? math_round_double_to_signed_frame_t (
-             mn_obj->pos.frames
-             + TRANSPORT->ticks_per_beat * AUDIO_ENGINE->frames_per_tick)
-           : mn_obj->end_pos.frames);
+      signed_frame_t mn_obj_end_frames = get_note_end_frames (mn_obj, is_chord);
 
       /* if note ends within the cycle */
       if (
@@ -1138,16 +1384,7 @@ midi_region_fill_midi_events (
         && (mn_obj_end_frames <= (r_local_pos + time_nfo->nframes)))
         {
           midi_time_t _time =
-            (midi_time_t) (time_nfo->local_offset
-                           + (mn_obj_end_frames - r_local_pos));
-
-          /* note actually ends 1 frame before
-           * the end point, not at the end
-           * point */
-          if (_time > 0)
-            {
-              _time--;
-            }
+            get_note_off_time (time_nfo, r_local_pos, mn_obj_end_frames);
 
 #if 0
           if (time_nfo->g_start_frame_w_offset == 0)
@@ -1158,23 +1395,7 @@ midi_region_fill_midi_events (
             }
 #endif
 
-          if (mn)
-            {
-              midi_events_add_note_off (
-                midi_events, midi_region_get_midi_ch (self), mn->val, _time,
-                F_QUEUED);
-            }
-          else if (co)
-            {
-              for (int l = 0; l < CHORD_DESCRIPTOR_MAX_NOTES; l++)
-                {
-                  if (descr->notes[l])
-                    {
-                      midi_events_add_note_off (
-                        midi_events, 1, l + 36, _time, F_QUEUED);
-                    }
-                }
-            }
+          add_note_off (self, mn_obj, is_chord, _time, midi_events);
         }
     } /* foreach midi note */
 }
@@ -1224,6 +1445,20 @@ midi_region_get_velocities_in_range (
     }
 }
 
+/**
+ * Frees the note timeline and its arrays.
+ */
+void
+midi_note_timeline_free (MidiNoteTimeline * self)
+{
+  object_zero_and_free (self->start_idxs);
+  object_zero_and_free (self->start_frames);
+  object_zero_and_free (self->end_idxs);
+  object_zero_and_free (self->end_frames);
+
+  object_zero_and_free (self);
+}
+
 /**
  * Frees members only but not the midi region itself.
  *
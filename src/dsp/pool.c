@@ -5,9 +5,14 @@
 
 #include "actions/undo_manager.h"
 #include "dsp/clip.h"
+#include "dsp/clip_cache.h"
+#include "dsp/clip_peaks.h"
+#include "dsp/clip_stream.h"
+#include "dsp/engine.h"
 #include "dsp/pool.h"
 #include "dsp/track.h"
 #include "dsp/tracklist.h"
+#include "dsp/transport.h"
 #include "project.h"
 #include "utils/arrays.h"
 #include "utils/error.h"
@@ -16,34 +21,247 @@
 #include "utils/io.h"
 #include "utils/mem.h"
 #include "utils/objects.h"
+#include "utils/progress_info.h"
 #include "utils/string.h"
 
 #include <glib/gi18n.h>
 #include <gtk/gtk.h>
 
+/**
+ * Registers the stream of the clip if it is streamed.
+ */
+static void
+register_clip_stream (AudioPool * self, AudioClip * clip)
+{
+  if (!clip->stream)
+    return;
+
+  if (!self->streamer)
+    {
+      self->streamer = audio_clip_streamer_new (&AUDIO_ENGINE->cycle);
+    }
+  audio_clip_streamer_add_stream (self->streamer, clip->stream);
+}
+
+typedef struct InitClipData
+{
+  AudioClip * clip;
+
+  /** To be set after initializing the clip. */
+  bool     successful;
+  bool     cancelled;
+  GError * error;
+} InitClipData;
+
+typedef struct InitClipsContext
+{
+  /** Optional progress info to report to. */
+  ProgressInfo * progress_info;
+
+  /** Number of clips initialized so far. */
+  volatile gint num_done;
+
+  int num_clips;
+} InitClipsContext;
+
+/**
+ * Thread for decoding an audio clip after loading.
+ *
+ * To be used as a GThreadFunc.
+ */
+static void
+init_clip_thread (void * data, void * user_data)
+{
+  InitClipData *     init_clip_data = (InitClipData *) data;
+  InitClipsContext * ctx = (InitClipsContext *) user_data;
+  AudioClip *        clip = init_clip_data->clip;
+
+  if (
+    ctx->progress_info && progress_info_pending_cancellation (ctx->progress_info))
+    {
+      init_clip_data->cancelled = true;
+      return;
+    }
+
+  init_clip_data->successful =
+    audio_clip_init_loaded (clip, &init_clip_data->error);
+
+  int num_done = g_atomic_int_add (&ctx->num_done, 1) + 1;
+  if (ctx->progress_info)
+    {
+      char * msg = g_strdup_printf (_ ("Loaded audio clip '%s'"), clip->name);
+      progress_info_update_progress (
+        ctx->progress_info, (double) num_done / (double) ctx->num_clips, msg);
+      g_free (msg);
+    }
+}
+
+static void
+init_clip_data_free (void * data)
+{
+  InitClipData * self = (InitClipData *) data;
+  if (self->error)
+    g_error_free (self->error);
+  object_zero_and_free (self);
+}
+
+/**
+ * Decodes the given clips in a thread pool.
+ *
+ * If more than one clip fails, the error of the first
+ * one (in the given order) is returned.
+ *
+ * @param clips Clips to initialize.
+ * @param progress_info Optional progress info to report
+ *   progress to and check for cancellation.
+ */
+static bool
+init_loaded_clips (
+  AudioPool *    self,
+  GPtrArray *    clips,
+  ProgressInfo * progress_info,
+  GError **      error)
+{
+  if (clips->len == 0)
+    return true;
+
+  InitClipsContext ctx = {
+    .progress_info = progress_info,
+    .num_done = 0,
+    .num_clips = (int) clips->len,
+  };
+
+  GError *      err = NULL;
+  GThreadPool * thread_pool = g_thread_pool_new (
+    init_clip_thread, &ctx, (int) MIN (g_get_num_processors (), clips->len),
+    F_NOT_EXCLUSIVE, &err);
+  if (err)
+    {
+      PROPAGATE_PREFIXED_ERROR (
+        error, err, "%s", "Failed to create thread pool");
+      return false;
+    }
+
+  GPtrArray * clip_data_arr =
+    g_ptr_array_new_full (clips->len, init_clip_data_free);
+  for (guint i = 0; i < clips->len; i++)
+    {
+      InitClipData * data = object_new (InitClipData);
+      data->clip = (AudioClip *) g_ptr_array_index (clips, i);
+      g_ptr_array_add (clip_data_arr, data);
+
+      g_thread_pool_push (thread_pool, data, NULL);
+    }
+
+  g_debug ("waiting for %u clips to be decoded...", clips->len);
+  g_thread_pool_free (thread_pool, false, true);
+  g_debug ("done");
+
+  bool success = true;
+  for (guint i = 0; i < clip_data_arr->len; i++)
+    {
+      InitClipData * clip_data =
+        (InitClipData *) g_ptr_array_index (clip_data_arr, i);
+      if (clip_data->cancelled)
+        {
+          g_set_error_literal (
+            error, G_IO_ERROR, G_IO_ERROR_CANCELLED,
+            _ ("Loading audio clips was cancelled"));
+          success = false;
+          break;
+        }
+      if (!clip_data->successful)
+        {
+          PROPAGATE_PREFIXED_ERROR (
+            error, clip_data->error, _ ("Failed to initialize audio clip '%s'"),
+            clip_data->clip->name);
+          clip_data->error = NULL;
+          success = false;
+          break;
+        }
+    }
+
+  /* streams must be registered from this thread */
+  for (guint i = 0; i < clip_data_arr->len; i++)
+    {
+      InitClipData * clip_data =
+        (InitClipData *) g_ptr_array_index (clip_data_arr, i);
+      if (clip_data->successful)
+        {
+          register_clip_stream (self, clip_data->clip);
+          audio_pool_gen_clip_peaks (self, clip_data->clip);
+        }
+    }
+
+  g_ptr_array_unref (clip_data_arr);
+
+  return success;
+}
+
+/**
+ * Removes cached frames of clips no longer in the pool
+ * (or cached at a different sample rate).
+ */
+static void
+remove_unused_cache_files (AudioPool * self)
+{
+  GHashTable * used_paths =
+    g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  for (int i = 0; i < self->num_clips; i++)
+    {
+      AudioClip * clip = self->clips[i];
+      if (!clip || !clip->file_hash)
+        continue;
+
+      char * path = audio_clip_cache_get_path (
+        clip->file_hash, (int) AUDIO_ENGINE->sample_rate);
+      if (path)
+        {
+          g_hash_table_add (used_paths, path);
+        }
+      path = audio_clip_peaks_get_path (
+        clip->file_hash, (int) AUDIO_ENGINE->sample_rate);
+      if (path)
+        {
+          g_hash_table_add (used_paths, path);
+        }
+    }
+  audio_clip_cache_remove_unused (used_paths);
+  g_hash_table_destroy (used_paths);
+}
+
 /**
  * Inits after loading a project.
+ *
+ * The clips are decoded in parallel.
+ *
+ * @param progress_info Optional progress info to report
+ *   progress to and check for cancellation.
  */
 bool
-audio_pool_init_loaded (AudioPool * self, GError ** error)
+audio_pool_init_loaded (
+  AudioPool *    self,
+  ProgressInfo * progress_info,
+  GError **      error)
 {
   self->clips_size = (size_t) self->num_clips;
 
+  GPtrArray * clips = g_ptr_array_new ();
   for (int i = 0; i < self->num_clips; i++)
     {
       AudioClip * clip = self->clips[i];
       if (clip)
         {
-          GError * err = NULL;
-          bool     success = audio_clip_init_loaded (clip, &err);
-          if (!success)
-            {
-              PROPAGATE_PREFIXED_ERROR (
-                error, err, "Failed to initialize audio clip '%s'", clip->name);
-              return false;
-            }
+          g_ptr_array_add (clips, clip);
         }
     }
+  bool success = init_loaded_clips (self, clips, progress_info, error);
+  g_ptr_array_unref (clips);
+  if (!success)
+    return false;
+
+  remove_unused_cache_files (self);
+
   return true;
 }
 
@@ -190,9 +408,49 @@ audio_pool_add_clip (AudioPool * self, AudioClip * clip)
 
   audio_pool_print (self);
 
+  audio_pool_gen_clip_peaks (self, clip);
+
   return clip->pool_id;
 }
 
+static void
+gen_peaks_thread (void * data, void * user_data)
+{
+  AudioClipPeaksJob * job = (AudioClipPeaksJob *) data;
+  audio_clip_peaks_job_run (job);
+  audio_clip_peaks_job_unref (job);
+}
+
+/**
+ * Starts generating the peaks of the clip in the
+ * background.
+ */
+void
+audio_pool_gen_clip_peaks (AudioPool * self, AudioClip * clip)
+{
+  audio_clip_discard_peaks (clip);
+  if (clip->num_frames == 0 || clip->channels == 0)
+    return;
+
+  if (!self->peaks_thread_pool)
+    {
+      GError * err = NULL;
+      self->peaks_thread_pool = g_thread_pool_new (
+        gen_peaks_thread, NULL, (int) g_get_num_processors (), F_NOT_EXCLUSIVE,
+        &err);
+      if (!self->peaks_thread_pool)
+        {
+          g_warning ("Failed to create thread pool: %s", err->message);
+          g_error_free (err);
+          return;
+        }
+    }
+
+  clip->peaks_job = audio_clip_peaks_job_new (clip);
+  g_thread_pool_push (
+    self->peaks_thread_pool, g_atomic_rc_box_acquire (clip->peaks_job), NULL);
+}
+
 /**
  * Returns the clip for the given ID.
  */
@@ -231,6 +489,14 @@ audio_pool_duplicate_clip (
   AudioClip * clip = audio_pool_get_clip (self, clip_id);
   g_return_val_if_fail (clip, -1);
 
+  GError * err = NULL;
+  if (!audio_clip_load_frames (clip, &err))
+    {
+      PROPAGATE_PREFIXED_ERROR (
+        error, err, "%s", "Failed to load clip to duplicate");
+      return -1;
+    }
+
   AudioClip * new_clip = audio_clip_new_from_float_array (
     clip->frames, clip->num_frames, clip->channels, clip->bit_depth, clip->name);
   audio_pool_add_clip (self, new_clip);
@@ -242,8 +508,7 @@ audio_pool_duplicate_clip (
 
   if (write_file)
     {
-      GError * err = NULL;
-      bool     success =
+      bool success =
         audio_clip_write_to_pool (new_clip, F_NO_PARTS, F_NOT_BACKUP, &err);
       if (!success)
         {
@@ -378,6 +643,7 @@ audio_pool_remove_unused (AudioPool * self, bool backup)
 bool
 audio_pool_reload_clip_frame_bufs (AudioPool * self, GError ** error)
 {
+  GPtrArray * clips_to_load = g_ptr_array_new ();
   for (int i = 0; i < self->num_clips; i++)
     {
       AudioClip * clip = self->clips[i];
@@ -389,25 +655,88 @@ audio_pool_reload_clip_frame_bufs (AudioPool * self, GError ** error)
       if (in_use && clip->num_frames == 0)
         {
           /* load from the file */
-          GError * err = NULL;
-          bool     success = audio_clip_init_loaded (clip, &err);
-          if (!success)
-            {
-              PROPAGATE_PREFIXED_ERROR (
-                error, err, _ ("Failed to initialize audio clip '%s'"),
-                clip->name);
-              return false;
-            }
+          g_ptr_array_add (clips_to_load, clip);
         }
       else if (!in_use && clip->num_frames > 0)
         {
           /* unload frames */
-          clip->num_frames = 0;
-          free (clip->frames);
-          clip->frames = NULL;
+          audio_clip_unload_frames (clip);
         }
     }
-  return true;
+
+  bool success = init_loaded_clips (self, clips_to_load, NULL, error);
+  g_ptr_array_unref (clips_to_load);
+  return success;
+}
+
+/**
+ * Updates the positions at which streamed clips keep
+ * pre-rolls.
+ */
+void
+audio_pool_update_stream_anchors (AudioPool * self)
+{
+  if (!self->streamer)
+    return;
+
+  GArray ** anchors = object_new_n ((size_t) self->num_clips, GArray *);
+  for (int i = 0; i < self->num_clips; i++)
+    {
+      AudioClip * clip = self->clips[i];
+      if (clip && clip->stream)
+        {
+          anchors[i] = g_array_new (false, false, sizeof (unsigned_frame_t));
+        }
+    }
+
+  for (int i = 0; i < TRACKLIST->num_tracks; i++)
+    {
+      Track * track = TRACKLIST->tracks[i];
+      if (track->type != TRACK_TYPE_AUDIO)
+        continue;
+
+      for (int j = 0; j < track->num_lanes; j++)
+        {
+          TrackLane * lane = track->lanes[j];
+          for (int k = 0; k < lane->num_regions; k++)
+            {
+              ZRegion * r = lane->regions[k];
+              if (
+                r->pool_id < 0 || r->pool_id >= self->num_clips
+                || !anchors[r->pool_id])
+                continue;
+
+              ArrangerObject * r_obj = (ArrangerObject *) r;
+              unsigned_frame_t frames[] = {
+                (unsigned_frame_t) MAX (r_obj->clip_start_pos.frames, 0),
+                (unsigned_frame_t) MAX (r_obj->loop_start_pos.frames, 0),
+              };
+              g_array_append_vals (
+                anchors[r->pool_id], frames, G_N_ELEMENTS (frames));
+
+              if (region_is_hit (r, PLAYHEAD->frames, true))
+                {
+                  signed_frame_t local_frames = region_timeline_frames_to_local (
+                    r, PLAYHEAD->frames, F_NORMALIZE);
+                  unsigned_frame_t playhead_frames =
+                    (unsigned_frame_t) MAX (local_frames, 0);
+                  g_array_append_val (anchors[r->pool_id], playhead_frames);
+                }
+            }
+        }
+    }
+
+  for (int i = 0; i < self->num_clips; i++)
+    {
+      if (!anchors[i])
+        continue;
+
+      audio_clip_stream_set_anchors (
+        self->clips[i]->stream, (unsigned_frame_t *) anchors[i]->data,
+        (int) anchors[i]->len);
+      g_array_free (anchors[i], true);
+    }
+  free (anchors);
 }
 
 typedef struct WriteClipData
@@ -575,5 +904,17 @@ audio_pool_free (AudioPool * self)
     }
   object_zero_and_free (self->clips);
 
+  /* the clips above unregister their streams when
+   * freed */
+  object_free_w_func_and_null (audio_clip_streamer_free, self->streamer);
+
+  /* the clips above cancelled their jobs, so this only
+   * waits for the queue to drain */
+  if (self->peaks_thread_pool)
+    {
+      g_thread_pool_free (self->peaks_thread_pool, false, true);
+      self->peaks_thread_pool = NULL;
+    }
+
   object_zero_and_free (self);
 }
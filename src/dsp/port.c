@@ -8,6 +8,7 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "dsp/automation_track.h"
 #include "dsp/channel.h"
 #include "dsp/clip.h"
 #include "dsp/control_port.h"
@@ -31,6 +32,7 @@
 #include "plugins/plugin.h"
 #include "project.h"
 #include "utils/arrays.h"
+#include "utils/debug.h"
 #include "utils/dsp.h"
 #include "utils/error.h"
 #include "utils/flags.h"
@@ -88,9 +90,62 @@ port_allocate_bufs (Port * self)
         self->buf = object_new_n (max, float);
         self->last_buf_sz = max;
       }
+      break;
+    case TYPE_CONTROL:
+      if (
+        AUDIO_ENGINE->automation_resolution
+          != AUDIO_ENGINE_AUTOMATION_RESOLUTION_CYCLE
+        && self->id.flags & PORT_FLAG_AUTOMATABLE
+        && self->id.owner_type == PORT_OWNER_TYPE_FADER
+        && self->id.flow == FLOW_INPUT)
+        {
+          object_zero_and_free (self->automation_vals);
+          object_zero_and_free (self->automation_step_vals);
+          size_t max = MAX (AUDIO_ENGINE->block_length, 1);
+          self->automation_vals = object_new_n (max, float);
+          /* one value per frame plus the end point */
+          self->automation_step_vals = object_new_n (max + 1, float);
+          self->automation_vals_cycle = UINT_FAST64_MAX;
+        }
+      break;
+    default:
+      break;
+    }
+}
+
+/**
+ * Allocates the buffers used during DSP only if they
+ * are not allocated yet.
+ */
+void
+port_allocate_missing_bufs (Port * self)
+{
+  bool missing = false;
+  switch (self->id.type)
+    {
+    case TYPE_EVENT:
+      missing = !self->midi_events || !self->midi_ring;
+      break;
+    case TYPE_AUDIO:
+    case TYPE_CV:
+      missing = !self->buf || !self->audio_ring;
+      break;
+    case TYPE_CONTROL:
+      missing =
+        AUDIO_ENGINE->automation_resolution
+          != AUDIO_ENGINE_AUTOMATION_RESOLUTION_CYCLE
+        && self->id.flags & PORT_FLAG_AUTOMATABLE
+        && self->id.owner_type == PORT_OWNER_TYPE_FADER
+        && self->id.flow == FLOW_INPUT && !self->automation_vals;
+      break;
     default:
       break;
     }
+
+  if (missing)
+    {
+      port_allocate_bufs (self);
+    }
 }
 
 /**
@@ -106,6 +161,8 @@ port_free_bufs (Port * self)
   object_free_w_func_and_null (zix_ring_free, self->midi_ring);
   object_free_w_func_and_null (zix_ring_free, self->audio_ring);
   object_zero_and_free (self->buf);
+  object_zero_and_free (self->automation_vals);
+  object_zero_and_free (self->automation_step_vals);
 }
 
 /**
@@ -2290,6 +2347,82 @@ stereo_ports_new_generic (
   return ports;
 }
 
+const float *
+port_get_automation_vals (
+  const Port *                        self,
+  const EngineProcessTimeInfo * const time_nfo)
+{
+  if (
+    self->automation_vals && self->automation_vals_cycle == AUDIO_ENGINE->cycle
+    && self->automation_vals_g_start == time_nfo->g_start_frame_w_offset)
+    {
+      return &self->automation_vals[time_nfo->local_offset];
+    }
+
+  return NULL;
+}
+
+/**
+ * Reads the automation every @p step frames in the cycle
+ * into \ref Port.automation_vals, interpolating in between,
+ * and sets the control value to the value at the start of
+ * the cycle.
+ */
+static void
+read_automation_vals (
+  Port *                              port,
+  AutomationTrack *                   at,
+  const EngineProcessTimeInfo * const time_nfo,
+  const nframes_t                     step,
+  const bool                          ends_after)
+{
+  /* values at each step, including the end of the cycle */
+  const size_t num_steps = (time_nfo->nframes + step - 1) / step + 1;
+  float *      step_vals = port->automation_step_vals;
+  if (!automation_track_get_normalized_vals_from_snapshots (
+        at, (signed_frame_t) time_nfo->g_start_frame_w_offset, step,
+        num_steps, ends_after, step_vals))
+    {
+      return;
+    }
+
+  if (step_vals[0] >= 0.f)
+    {
+      control_port_set_val_from_normalized (port, step_vals[0], true);
+      port->value_changed_from_reading = true;
+    }
+
+  /* convert to real values (keep the current value where
+   * there is no automation) */
+  for (size_t i = 0; i < num_steps; i++)
+    {
+      step_vals[i] =
+        step_vals[i] >= 0.f
+          ? control_port_normalized_val_to_real (port, step_vals[i])
+          : port->control;
+    }
+
+  float * vals = &port->automation_vals[time_nfo->local_offset];
+  if (step == 1)
+    {
+      dsp_copy (vals, step_vals, time_nfo->nframes);
+    }
+  else
+    {
+      const float inv_step = 1.f / (float) step;
+      for (nframes_t i = 0; i < time_nfo->nframes; i++)
+        {
+          const size_t idx = i / step;
+          const float  frac = (float) (i % step) * inv_step;
+          vals[i] =
+            step_vals[idx] + (step_vals[idx + 1] - step_vals[idx]) * frac;
+        }
+    }
+
+  port->automation_vals_cycle = AUDIO_ENGINE->cycle;
+  port->automation_vals_g_start = time_nfo->g_start_frame_w_offset;
+}
+
 void
 port_process (Port * port, const EngineProcessTimeInfo time_nfo, const bool noroll)
 {
@@ -2576,8 +2709,11 @@ port_process (Port * port, const EngineProcessTimeInfo time_nfo, const bool noro
             }
         }
 
-      /* send UI notification */
-      if (port->midi_events->num_events > 0)
+      /* send UI notification (not needed when rendering
+       * offline) */
+      if (
+        port->midi_events->num_events > 0
+        && !AUDIO_ENGINE->rendering_offline)
         {
 #if 0
           g_message (
@@ -2594,7 +2730,9 @@ port_process (Port * port, const EngineProcessTimeInfo time_nfo, const bool noro
             }
         }
 
-      if (time_nfo.local_offset + time_nfo.nframes == AUDIO_ENGINE->block_length)
+      if (
+        time_nfo.local_offset + time_nfo.nframes == AUDIO_ENGINE->block_length
+        && !AUDIO_ENGINE->rendering_offline)
         {
           MidiEvents * events = port->midi_events;
           if (port->write_ring_buffers)
@@ -2624,6 +2762,15 @@ port_process (Port * port, const EngineProcessTimeInfo time_nfo, const bool noro
       break;
     case TYPE_AUDIO:
     case TYPE_CV:
+      /* the buffers are reallocated when the graph is
+       * recalculated, so this catches block length
+       * changes without a recalc */
+      if (ZRYTHM_TESTING)
+        {
+          z_return_if_fail_cmp (
+            time_nfo.local_offset + time_nfo.nframes, <=, port->last_buf_sz);
+        }
+
       if (noroll)
         {
           dsp_fill (
@@ -2738,7 +2885,9 @@ port_process (Port * port, const EngineProcessTimeInfo time_nfo, const bool noro
             }
         }
 
-      if (time_nfo.local_offset + time_nfo.nframes == AUDIO_ENGINE->block_length)
+      if (
+        time_nfo.local_offset + time_nfo.nframes == AUDIO_ENGINE->block_length
+        && !AUDIO_ENGINE->rendering_offline)
         {
           size_t size = sizeof (float) * (size_t) AUDIO_ENGINE->block_length;
           size_t write_space_avail = zix_ring_write_space (port->audio_ring);
@@ -2756,7 +2905,7 @@ port_process (Port * port, const EngineProcessTimeInfo time_nfo, const bool noro
       /* if track output (to be shown on mixer) */
       if (
         owner_type == PORT_OWNER_TYPE_CHANNEL && is_stereo_port
-        && id.flow == FLOW_OUTPUT)
+        && id.flow == FLOW_OUTPUT && !AUDIO_ENGINE->rendering_offline)
         {
           g_return_if_fail (IS_TRACK_AND_NONNULL (track));
           Channel * ch = track->channel;
@@ -2924,10 +3073,6 @@ port_process (Port * port, const EngineProcessTimeInfo time_nfo, const bool noro
           && automation_track_should_read_automation (
             at, AUDIO_ENGINE->timestamp_start))
           {
-            Position pos;
-            position_from_frames (
-              &pos, (signed_frame_t) time_nfo.g_start_frame_w_offset);
-
             /* if playhead pos changed manually recently or transport is
              * rolling, we will force the last known automation point value
              * regardless of whether there is a region at current pos */
@@ -2935,17 +3080,27 @@ port_process (Port * port, const EngineProcessTimeInfo time_nfo, const bool noro
               TRANSPORT_IS_ROLLING
               || (TRANSPORT->last_manual_playhead_change - AUDIO_ENGINE->last_timestamp_start > 0);
 
-            /* if there was an automation event at the playhead position, set
-             * val and flag */
-            AutomationPoint * ap = automation_track_get_ap_before_pos (
-              at, &pos, !can_read_previous_automation, Z_F_USE_SNAPSHOTS);
-            if (ap)
+            /* read automation more than once in this cycle if
+             * the port can use it and nothing else modulates it */
+            const nframes_t step = engine_automation_resolution_get_step (
+              AUDIO_ENGINE->automation_resolution);
+            if (step > 0 && port->automation_vals && port->num_srcs == 0)
               {
-                float val = automation_track_get_val_at_pos (
-                  at, &pos, true, !can_read_previous_automation,
-                  Z_F_USE_SNAPSHOTS);
-                control_port_set_val_from_normalized (port, val, true);
-                port->value_changed_from_reading = true;
+                read_automation_vals (
+                  port, at, &time_nfo, step, !can_read_previous_automation);
+              }
+            /* otherwise if there was an automation event at the
+             * playhead position, set val and flag */
+            else
+              {
+                float val;
+                if (automation_track_get_normalized_vals_from_snapshots (
+                      at, (signed_frame_t) time_nfo.g_start_frame_w_offset,
+                      0, 1, !can_read_previous_automation, &val))
+                  {
+                    control_port_set_val_from_normalized (port, val, true);
+                    port->value_changed_from_reading = true;
+                  }
               }
           }
 
@@ -0,0 +1,438 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include "zrythm-config.h"
+
+#include <string.h>
+
+#include "dsp/recording_disk_writer.h"
+#include "utils/objects.h"
+
+#include <glib/gi18n.h>
+
+#include <sndfile.h>
+
+typedef enum
+{
+  Z_DSP_RECORDING_DISK_WRITER_ERROR_FAILED,
+} ZDspRecordingDiskWriterError;
+
+#define Z_DSP_RECORDING_DISK_WRITER_ERROR \
+  z_dsp_recording_disk_writer_error_quark ()
+GQuark
+z_dsp_recording_disk_writer_error_quark (void);
+G_DEFINE_QUARK (
+  z - dsp - recording - disk - writer - error - quark,
+  z_dsp_recording_disk_writer_error)
+
+static RecordingChunk *
+chunk_new (void)
+{
+  RecordingChunk * chunk = object_new (RecordingChunk);
+  chunk->frames = object_new_n (
+    RECORDING_DISK_WRITER_CHUNK_FRAMES * RECORDING_DISK_WRITER_MAX_CHANNELS,
+    float);
+  return chunk;
+}
+
+static void
+chunk_free (RecordingChunk * chunk)
+{
+  g_free (chunk->frames);
+  object_zero_and_free (chunk);
+}
+
+/**
+ * Opens the take's file for writing.
+ *
+ * @note Runs in the disk thread.
+ */
+static bool
+open_take (RecordingTake * take, GError ** error)
+{
+  SF_INFO info;
+  memset (&info, 0, sizeof (info));
+  info.channels = (int) take->channels;
+  info.samplerate = (int) take->samplerate;
+  int type_minor = 0;
+  switch (take->bit_depth)
+    {
+    case BIT_DEPTH_16:
+      type_minor = SF_FORMAT_PCM_16;
+      break;
+    case BIT_DEPTH_24:
+      type_minor = SF_FORMAT_PCM_24;
+      break;
+    case BIT_DEPTH_32:
+      type_minor = SF_FORMAT_PCM_32;
+      break;
+    }
+  info.format = SF_FORMAT_WAV | type_minor;
+
+  SNDFILE * sndfile = sf_open (take->filepath, SFM_WRITE, &info);
+  if (!sndfile)
+    {
+      g_set_error (
+        error, Z_DSP_RECORDING_DISK_WRITER_ERROR,
+        Z_DSP_RECORDING_DISK_WRITER_ERROR_FAILED,
+        _ ("Error opening sndfile: %s"), sf_strerror (NULL));
+      return false;
+    }
+  sf_set_string (sndfile, SF_STR_SOFTWARE, PROGRAM_NAME);
+
+  /* keep the header valid after each write so that the
+   * file can be read while recording */
+  sf_command (sndfile, SFC_SET_UPDATE_HEADER_AUTO, NULL, SF_TRUE);
+
+  take->sndfile = sndfile;
+  return true;
+}
+
+/**
+ * Writes the chunk to its take's file.
+ *
+ * @note Runs in the disk thread.
+ */
+static bool
+write_chunk (RecordingChunk * chunk, GError ** error)
+{
+  RecordingTake * take = chunk->take;
+  if (chunk->num_frames > 0 && !take->sndfile)
+    {
+      if (!open_take (take, error))
+        return false;
+    }
+
+  if (chunk->num_frames > 0)
+    {
+      sf_count_t written = sf_writef_float (
+        take->sndfile, chunk->frames, (sf_count_t) chunk->num_frames);
+      if (written != (sf_count_t) chunk->num_frames)
+        {
+          g_set_error (
+            error, Z_DSP_RECORDING_DISK_WRITER_ERROR,
+            Z_DSP_RECORDING_DISK_WRITER_ERROR_FAILED,
+            _ ("Failed to write to %s: %s"), take->filepath,
+            sf_strerror (take->sndfile));
+          return false;
+        }
+    }
+
+  if (chunk->close && take->sndfile)
+    {
+      int ret = sf_close (take->sndfile);
+      take->sndfile = NULL;
+      if (ret != 0)
+        {
+          g_set_error (
+            error, Z_DSP_RECORDING_DISK_WRITER_ERROR,
+            Z_DSP_RECORDING_DISK_WRITER_ERROR_FAILED,
+            _ ("Failed to close %s: %s"), take->filepath,
+            sf_error_number (ret));
+          return false;
+        }
+    }
+
+  return true;
+}
+
+static gpointer
+writer_thread (gpointer data)
+{
+  RecordingDiskWriter * self = (RecordingDiskWriter *) data;
+
+  g_mutex_lock (&self->lock);
+  while (g_atomic_int_get (&self->run) || !g_queue_is_empty (&self->queue))
+    {
+      RecordingChunk * chunk = g_queue_pop_head (&self->queue);
+      if (!chunk)
+        {
+          g_cond_wait (&self->cond, &self->lock);
+          continue;
+        }
+
+      RecordingTake * take = chunk->take;
+      bool            failed = take->error != NULL;
+      g_mutex_unlock (&self->lock);
+
+      /* skip the remaining chunks of a failed take, but
+       * still close its file */
+      GError * err = NULL;
+      bool     success = true;
+      if (!failed)
+        {
+          success = write_chunk (chunk, &err);
+        }
+      else if (chunk->close && take->sndfile)
+        {
+          sf_close (take->sndfile);
+          take->sndfile = NULL;
+        }
+
+      g_mutex_lock (&self->lock);
+      if (success && !failed)
+        {
+          take->frames_written += chunk->num_frames;
+        }
+      else if (!failed)
+        {
+          g_warning ("%s", err->message);
+          take->error = err;
+        }
+      chunk->take = NULL;
+      chunk->num_frames = 0;
+      chunk->close = false;
+      g_ptr_array_add (self->free_chunks, chunk);
+      self->num_pending--;
+      g_cond_broadcast (&self->cond);
+    }
+  g_mutex_unlock (&self->lock);
+
+  return NULL;
+}
+
+/**
+ * Creates a writer and starts its thread.
+ */
+RecordingDiskWriter *
+recording_disk_writer_new (void)
+{
+  RecordingDiskWriter * self = object_new (RecordingDiskWriter);
+
+  g_queue_init (&self->queue);
+  self->free_chunks =
+    g_ptr_array_new_full (RECORDING_DISK_WRITER_NUM_CHUNKS, NULL);
+  for (int i = 0; i < RECORDING_DISK_WRITER_NUM_CHUNKS; i++)
+    {
+      g_ptr_array_add (self->free_chunks, chunk_new ());
+    }
+  self->takes = g_ptr_array_new ();
+  g_mutex_init (&self->lock);
+  g_cond_init (&self->cond);
+  g_atomic_int_set (&self->run, 1);
+  self->thread = g_thread_new ("recording_disk_writer", writer_thread, self);
+
+  return self;
+}
+
+/**
+ * Starts a take writing to the given file.
+ */
+RecordingTake *
+recording_disk_writer_start_take (
+  RecordingDiskWriter * self,
+  const char *          filepath,
+  channels_t            channels,
+  uint32_t              samplerate,
+  BitDepth              bit_depth)
+{
+  g_return_val_if_fail (
+    channels > 0 && channels <= RECORDING_DISK_WRITER_MAX_CHANNELS, NULL);
+
+  RecordingTake * take = object_new (RecordingTake);
+  take->filepath = g_strdup (filepath);
+  take->channels = channels;
+  take->samplerate = samplerate;
+  take->bit_depth = bit_depth;
+  g_ptr_array_add (self->takes, take);
+
+  return take;
+}
+
+/**
+ * Returns a free chunk, allocating one if all of them
+ * are in use.
+ */
+static RecordingChunk *
+get_free_chunk (RecordingDiskWriter * self)
+{
+  RecordingChunk * chunk = NULL;
+  g_mutex_lock (&self->lock);
+  if (self->free_chunks->len > 0)
+    {
+      chunk = g_ptr_array_steal_index_fast (
+        self->free_chunks, self->free_chunks->len - 1);
+    }
+  g_mutex_unlock (&self->lock);
+
+  if (!chunk)
+    {
+      g_debug ("all recording chunks in use, allocating a new one");
+      chunk = chunk_new ();
+    }
+
+  return chunk;
+}
+
+/**
+ * Queues the chunk being filled, if any.
+ */
+static void
+queue_chunk (RecordingDiskWriter * self, RecordingTake * take, bool close)
+{
+  RecordingChunk * chunk = take->chunk;
+  if (!chunk)
+    {
+      if (!close)
+        return;
+
+      chunk = get_free_chunk (self);
+    }
+  chunk->take = take;
+  chunk->close = close;
+  take->chunk = NULL;
+
+  g_mutex_lock (&self->lock);
+  g_queue_push_tail (&self->queue, chunk);
+  self->num_pending++;
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+}
+
+/**
+ * Appends frames to the take.
+ */
+void
+recording_disk_writer_add_frames (
+  RecordingDiskWriter * self,
+  RecordingTake *       take,
+  const float * const * ch_bufs,
+  size_t                nframes)
+{
+  take->frames_added += nframes;
+
+  size_t processed = 0;
+  while (processed < nframes)
+    {
+      if (!take->chunk)
+        {
+          take->chunk = get_free_chunk (self);
+          take->chunk->take = take;
+          take->chunk_start_time = g_get_monotonic_time ();
+        }
+
+      RecordingChunk * chunk = take->chunk;
+      size_t           to_copy = MIN (
+        nframes - processed,
+        RECORDING_DISK_WRITER_CHUNK_FRAMES - chunk->num_frames);
+      float * dest = &chunk->frames[chunk->num_frames * take->channels];
+      for (size_t i = 0; i < to_copy; i++)
+        {
+          for (channels_t j = 0; j < take->channels; j++)
+            {
+              dest[i * take->channels + j] = ch_bufs[j][processed + i];
+            }
+        }
+      chunk->num_frames += to_copy;
+      processed += to_copy;
+
+      if (chunk->num_frames == RECORDING_DISK_WRITER_CHUNK_FRAMES)
+        {
+          queue_chunk (self, take, false);
+        }
+    }
+
+  if (
+    take->chunk
+    && g_get_monotonic_time () - take->chunk_start_time
+         > RECORDING_DISK_WRITER_MAX_DELAY_USEC)
+    {
+      queue_chunk (self, take, false);
+    }
+}
+
+/**
+ * Waits until all the chunks queued are written.
+ */
+static void
+wait_for_pending (RecordingDiskWriter * self)
+{
+  g_mutex_lock (&self->lock);
+  while (self->num_pending > 0)
+    {
+      g_cond_wait (&self->cond, &self->lock);
+    }
+  g_mutex_unlock (&self->lock);
+}
+
+/**
+ * Queues the partially filled chunks of all takes and
+ * waits until everything queued is written.
+ */
+void
+recording_disk_writer_flush (RecordingDiskWriter * self)
+{
+  for (guint i = 0; i < self->takes->len; i++)
+    {
+      queue_chunk (self, g_ptr_array_index (self->takes, i), false);
+    }
+  wait_for_pending (self);
+}
+
+/**
+ * Writes the remaining frames of the take, closes its
+ * file and frees the take.
+ */
+bool
+recording_disk_writer_finish_take (
+  RecordingDiskWriter * self,
+  RecordingTake *       take,
+  GError **             error)
+{
+  queue_chunk (self, take, true);
+  wait_for_pending (self);
+
+  g_ptr_array_remove_fast (self->takes, take);
+
+  bool success = take->error == NULL;
+  if (!success)
+    {
+      g_propagate_error (error, take->error);
+      take->error = NULL;
+    }
+  else
+    {
+      g_debug (
+        "finished take %s (%" UNSIGNED_FRAME_FORMAT " frames)", take->filepath,
+        take->frames_written);
+    }
+
+  g_free (take->filepath);
+  object_zero_and_free (take);
+
+  return success;
+}
+
+/**
+ * Finishes all takes, stops the thread and frees the
+ * writer.
+ */
+void
+recording_disk_writer_free (RecordingDiskWriter * self)
+{
+  while (self->takes->len > 0)
+    {
+      RecordingTake * take =
+        g_ptr_array_index (self->takes, self->takes->len - 1);
+      GError * err = NULL;
+      if (!recording_disk_writer_finish_take (self, take, &err))
+        {
+          g_warning ("Failed to finish take: %s", err->message);
+          g_error_free (err);
+        }
+    }
+  g_ptr_array_unref (self->takes);
+
+  g_mutex_lock (&self->lock);
+  g_atomic_int_set (&self->run, 0);
+  g_cond_broadcast (&self->cond);
+  g_mutex_unlock (&self->lock);
+  g_thread_join (self->thread);
+
+  g_ptr_array_set_free_func (self->free_chunks, (GDestroyNotify) chunk_free);
+  g_ptr_array_unref (self->free_chunks);
+  g_mutex_clear (&self->lock);
+  g_cond_clear (&self->cond);
+
+  object_zero_and_free (self);
+}
@@ -10,6 +10,8 @@
 #include "dsp/clip.h"
 #include "dsp/control_port.h"
 #include "dsp/engine.h"
+#include "dsp/pool.h"
+#include "dsp/recording_disk_writer.h"
 #include "dsp/recording_event.h"
 #include "dsp/recording_manager.h"
 #include "dsp/track.h"
@@ -59,6 +61,58 @@ add_recorded_id (RecordingManager * self, ZRegion * region)
   self->num_recorded_ids++;
 }
 
+/**
+ * Returns the take writing the given recorded clip to the
+ * pool, starting it if needed.
+ */
+static RecordingTake *
+get_or_start_take (RecordingManager * self, AudioClip * clip)
+{
+  RecordingTake * take =
+    g_hash_table_lookup (self->takes, GINT_TO_POINTER (clip->pool_id));
+  if (take)
+    return take;
+
+  char * path = audio_clip_get_path_in_pool (clip, F_NOT_BACKUP);
+  g_return_val_if_fail (path, NULL);
+  take = recording_disk_writer_start_take (
+    self->disk_writer, path, clip->channels, (uint32_t) clip->samplerate,
+    clip->bit_depth);
+  g_free (path);
+  g_return_val_if_fail (take, NULL);
+  g_hash_table_insert (self->takes, GINT_TO_POINTER (clip->pool_id), take);
+
+  return take;
+}
+
+/**
+ * Finishes writing the recorded clip to the pool.
+ */
+static bool
+finish_take (RecordingManager * self, AudioClip * clip, GError ** error)
+{
+  RecordingTake * take =
+    g_hash_table_lookup (self->takes, GINT_TO_POINTER (clip->pool_id));
+  if (!take)
+    {
+      /* nothing was recorded into the clip yet */
+      return audio_clip_write_to_pool (clip, true, F_NOT_BACKUP, error);
+    }
+
+  g_hash_table_remove (self->takes, GINT_TO_POINTER (clip->pool_id));
+  GError * err = NULL;
+  if (!recording_disk_writer_finish_take (self->disk_writer, take, &err))
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, "Failed to write recorded audio");
+      return false;
+    }
+  clip->frames_written = clip->num_frames;
+  clip->last_write = g_get_monotonic_time ();
+
+  return true;
+}
+
 static void
 free_temp_selections (RecordingManager * self)
 {
@@ -136,21 +190,23 @@ handle_stop_recording (RecordingManager * self, bool is_automation)
       HANDLE_ERROR (err, "%s", _ ("Failed to create recorded regions"));
     }
 
-  /* update frame caches and write audio clips to
-   * pool */
+  /* finish writing audio clips to pool */
   for (int i = 0; i < self->num_recorded_ids; i++)
     {
       ZRegion * r = region_find (&self->recorded_ids[i]);
       if (r->id.type == REGION_TYPE_AUDIO)
         {
           AudioClip * clip = audio_region_get_clip (r);
-          bool        success =
-            audio_clip_write_to_pool (clip, true, F_NOT_BACKUP, &err);
+          bool        success = finish_take (self, clip, &err);
           if (!success)
             {
               HANDLE_ERROR (
                 err, "%s", "Failed to write audio region clip to pool");
             }
+          if (r->read_from_pool)
+            {
+              audio_pool_gen_clip_peaks (AUDIO_POOL, clip);
+            }
         }
     }
 
@@ -873,67 +929,30 @@ handle_audio_event (RecordingManager * self, RecordingEvent * ev)
 
   signed_frame_t r_obj_len_frames = (r_obj->end_pos.frames - r_obj->pos.frames);
   z_return_if_fail_cmp (r_obj_len_frames, >=, 0);
-  clip->num_frames = (unsigned_frame_t) r_obj_len_frames;
-  clip->frames = (sample_t *) realloc (
-    clip->frames,
-    (size_t) (clip->num_frames * (long) clip->channels) * sizeof (sample_t));
-#if 0
-  region->frames =
-    (sample_t *) realloc (
-      region->frames,
-      (size_t)
-      (clip->num_frames *
-         (long) clip->channels) *
-      sizeof (sample_t));
-  region->num_frames = (size_t) clip->num_frames;
-  dsp_copy (
-    &region->frames[0], &clip->frames[0],
-    (size_t) clip->num_frames * clip->channels);
-#endif
 
   position_from_frames (
     &r_obj->loop_end_pos, r_obj->end_pos.frames - r_obj->pos.frames);
 
   r_obj->fade_out_pos = r_obj->loop_end_pos;
 
-  /* handle the samples normally */
-  nframes_t cur_local_offset = 0;
-  for (
-    signed_frame_t i = (signed_frame_t) start_frames - r_obj->pos.frames;
-    i < (signed_frame_t) end_frames - r_obj->pos.frames; i++)
-    {
-      z_return_if_fail_cmp (i, >=, 0);
-      z_return_if_fail_cmp (i, <, (signed_frame_t) clip->num_frames);
-      g_warn_if_fail (
-        cur_local_offset >= ev->local_offset
-        && cur_local_offset < ev->local_offset + ev->nframes);
-
-      /* set clip frames */
-      clip->frames[i * clip->channels] = ev->lbuf[cur_local_offset];
-      clip->frames[i * clip->channels + 1] = ev->rbuf[cur_local_offset];
-
-      cur_local_offset++;
-    }
-
-  audio_clip_update_channel_caches (clip, (size_t) clip->frames_written);
-
-  /* write to pool if 2 seconds passed since last
-   * write */
-  gint64 cur_time = g_get_monotonic_time ();
-  gint64 nano_sec_to_wait = 2 * 1000 * 1000;
-  if (ZRYTHM_TESTING)
-    {
-      nano_sec_to_wait = 20 * 1000;
-    }
-  if ((cur_time - clip->last_write) > nano_sec_to_wait)
-    {
-      GError * err = NULL;
-      bool success = audio_clip_write_to_pool (clip, true, F_NOT_BACKUP, &err);
-      if (!success)
-        {
-          HANDLE_ERROR (err, "%s", "Failed to write audio clip to pool");
-        }
-    }
+  /* set clip frames */
+  signed_frame_t clip_start =
+    (signed_frame_t) start_frames - r_obj->pos.frames;
+  z_return_if_fail_cmp (clip_start, >=, 0);
+  const float * ch_bufs[] = {
+    &ev->lbuf[ev->local_offset],
+    &ev->rbuf[ev->local_offset],
+  };
+  audio_clip_discard_peaks (clip);
+  audio_clip_set_recorded_frames (
+    clip, (unsigned_frame_t) clip_start, ch_bufs, ev->nframes);
+
+  /* hand the frames to the disk thread */
+  RecordingTake * take = get_or_start_take (self, clip);
+  g_return_if_fail (take);
+  z_return_if_fail_cmp ((unsigned_frame_t) clip_start, ==, take->frames_added);
+  recording_disk_writer_add_frames (
+    self->disk_writer, take, ch_bufs, ev->nframes);
 
 #if 0
   g_message (
@@ -1481,6 +1500,48 @@ return_to_pool:
   return G_SOURCE_CONTINUE;
 }
 
+/**
+ * Returns whether the given clip is being recorded, in
+ * which case its pool file is owned by the disk writer.
+ */
+bool
+recording_manager_is_recording_clip (
+  RecordingManager * self,
+  const AudioClip *  clip)
+{
+  return g_hash_table_contains (self->takes, GINT_TO_POINTER (clip->pool_id));
+}
+
+/**
+ * Waits until everything recorded so far into the given
+ * clip is written to its file in the pool, if the clip
+ * is being recorded.
+ *
+ * @return Whether the clip is being recorded.
+ */
+bool
+recording_manager_flush_take (RecordingManager * self, AudioClip * clip)
+{
+  if (!recording_manager_is_recording_clip (self, clip))
+    return false;
+
+  recording_disk_writer_flush (self->disk_writer);
+  return true;
+}
+
+/**
+ * Waits until everything recorded so far is written to
+ * the pool.
+ */
+void
+recording_manager_flush_takes (RecordingManager * self)
+{
+  if (g_hash_table_size (self->takes) == 0)
+    return;
+
+  recording_disk_writer_flush (self->disk_writer);
+}
+
 /**
  * Creates the event queue and starts the event loop.
  *
@@ -1500,6 +1561,9 @@ recording_manager_new (void)
   self->event_queue = mpmc_queue_new ();
   mpmc_queue_reserve (self->event_queue, max_events);
 
+  self->disk_writer = recording_disk_writer_new ();
+  self->takes = g_hash_table_new (NULL, NULL);
+
   zix_sem_init (&self->processing_sem, 1);
   self->source_id =
     g_timeout_add (12, (GSourceFunc) recording_manager_process_events, self);
@@ -1527,6 +1591,8 @@ recording_manager_free (RecordingManager * self)
   free_temp_selections (self);
 
   object_free_w_func_and_null (g_ptr_array_unref, self->pending_aps);
+  object_free_w_func_and_null (g_hash_table_unref, self->takes);
+  object_free_w_func_and_null (recording_disk_writer_free, self->disk_writer);
 
   object_zero_and_free (self);
 
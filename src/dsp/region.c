@@ -42,6 +42,7 @@
 #include "utils/debug.h"
 #include "utils/error.h"
 #include "utils/flags.h"
+#include "utils/interval_index.h"
 #include "utils/objects.h"
 #include "utils/yaml.h"
 #include "zrythm_app.h"
@@ -1192,6 +1193,49 @@ region_is_hit_by_range (
     }
 }
 
+IntervalIndex *
+region_gen_interval_index (ZRegion ** regions, int num_regions)
+{
+  IntervalIndex * index = interval_index_new ((size_t) num_regions);
+  for (int i = 0; i < num_regions; i++)
+    {
+      const ArrangerObject * r_obj = (const ArrangerObject *) regions[i];
+      interval_index_add (index, r_obj->pos.frames, r_obj->end_pos.frames, i);
+    }
+  interval_index_build (index);
+
+  return index;
+}
+
+ZRegion *
+region_gen_playback_snapshot (
+  ZRegion *    self,
+  GHashTable * prev_snapshots,
+  GHashTable * touched_ids)
+{
+  /* the snapshot must be looked up before dereferencing it
+   * because it might have been freed */
+  ZRegion * snapshot = self->playback_snapshot;
+  if (
+    snapshot && prev_snapshots
+    && !(touched_ids && g_hash_table_contains (touched_ids, &self->id))
+    && g_hash_table_contains (prev_snapshots, snapshot)
+    && region_identifier_is_equal (&snapshot->id, &self->id))
+    {
+      g_hash_table_remove (prev_snapshots, snapshot);
+      return snapshot;
+    }
+
+  snapshot = (ZRegion *) arranger_object_clone ((ArrangerObject *) self);
+  if (self->id.type == REGION_TYPE_MIDI || self->id.type == REGION_TYPE_CHORD)
+    {
+      midi_region_gen_note_timeline (snapshot);
+    }
+  self->playback_snapshot = snapshot;
+
+  return snapshot;
+}
+
 /**
  * Copies the data from src to dest.
  *
@@ -19,6 +19,25 @@ region_identifier_validate (RegionIdentifier * self)
   return true;
 }
 
+unsigned int
+region_identifier_get_hash (const void * self)
+{
+  const RegionIdentifier * id = (const RegionIdentifier *) self;
+  unsigned int             hash = id->track_name_hash;
+  hash = hash * 31 + (unsigned int) id->type;
+  hash = hash * 31 + (unsigned int) id->lane_pos;
+  hash = hash * 31 + (unsigned int) id->at_idx;
+  hash = hash * 31 + (unsigned int) id->idx;
+  return hash;
+}
+
+int
+region_identifier_is_equal_func (const void * a, const void * b)
+{
+  return region_identifier_is_equal (
+    (const RegionIdentifier *) a, (const RegionIdentifier *) b);
+}
+
 void
 region_identifier_free (RegionIdentifier * self)
 {
@@ -103,6 +103,16 @@ router_start_cycle (Router * self, EngineProcessTimeInfo time_nfo)
       return;
     }
 
+  /* switch to the graph rebuilt in the background, if
+   * any */
+  if (g_atomic_int_compare_and_exchange (
+        &self->graph_swap_state, ROUTER_GRAPH_SWAP_PENDING,
+        ROUTER_GRAPH_SWAP_APPLYING))
+    {
+      graph_apply_setup (self->graph);
+      g_atomic_int_set (&self->graph_swap_state, ROUTER_GRAPH_SWAP_NONE);
+    }
+
   self->global_offset =
     self->max_route_playback_latency - AUDIO_ENGINE->remaining_latency_preroll;
   memcpy (&self->time_nfo, &time_nfo, sizeof (EngineProcessTimeInfo));
@@ -145,6 +155,9 @@ router_start_cycle (Router * self, EngineProcessTimeInfo time_nfo)
       graph_node_process (self->graph->beat_unit_node, time_nfo);
     }
 
+  self->graph->run_static_schedule =
+    graph_can_use_static_schedule (self->graph, time_nfo.nframes);
+
   self->callback_in_progress = true;
   zix_sem_post (&self->graph->callback_start);
   zix_sem_wait (&self->graph->callback_done);
@@ -153,9 +166,54 @@ router_start_cycle (Router * self, EngineProcessTimeInfo time_nfo)
   zix_sem_post (&self->graph_access);
 }
 
+/**
+ * Rebuilds the graph while the engine keeps processing
+ * the current one and has the engine switch to the new
+ * one at the start of its next cycle.
+ *
+ * @return Whether the new graph was applied. If not,
+ *   the graph must be rebuilt with the engine paused.
+ */
+static bool
+recalc_while_running (Router * self)
+{
+  Graph * graph = self->graph;
+  graph_setup_while_running (graph);
+  if (!graph_prepare_setup (graph))
+    {
+      g_message ("graph too large for the trigger queues, pausing the engine");
+      return false;
+    }
+
+  g_atomic_int_set (&self->graph_swap_state, ROUTER_GRAPH_SWAP_PENDING);
+  const gint64 start_time = g_get_monotonic_time ();
+  const gint64 max_time_to_wait = 200 * 1000; // 200ms
+  while (g_atomic_int_get (&self->graph_swap_state) != ROUTER_GRAPH_SWAP_NONE)
+    {
+      if (
+        g_get_monotonic_time () - start_time > max_time_to_wait
+        && g_atomic_int_compare_and_exchange (
+          &self->graph_swap_state, ROUTER_GRAPH_SWAP_PENDING,
+          ROUTER_GRAPH_SWAP_NONE))
+        {
+          g_message ("engine did not pick up the new graph, pausing it");
+          return false;
+        }
+      g_usleep (100);
+    }
+
+  /* the engine is done with the previous nodes */
+  graph_finish_setup (graph);
+
+  return true;
+}
+
 /**
  * Recalculates the process acyclic directed graph.
  *
+ * If the engine is running, the new graph is built in
+ * the background and swapped in between cycles.
+ *
  * @param soft If true, only readjusts latencies.
  */
 void
@@ -171,6 +229,7 @@ router_recalc_graph (Router * self, bool soft)
       g_atomic_int_set (&self->graph_setup_in_progress, 1);
       graph_setup (self->graph, 1, 1);
       g_atomic_int_set (&self->graph_setup_in_progress, 0);
+      self->block_length = AUDIO_ENGINE->block_length;
       graph_start (self->graph);
       return;
     }
@@ -181,6 +240,13 @@ router_recalc_graph (Router * self, bool soft)
       graph_update_latencies (self->graph, false);
       zix_sem_post (&self->graph_access);
     }
+  else if (
+    g_atomic_int_get (&AUDIO_ENGINE->run)
+    && self->block_length == AUDIO_ENGINE->block_length
+    && recalc_while_running (self))
+    {
+      g_message ("recalculated without pausing the engine");
+    }
   else
     {
       int running = g_atomic_int_get (&AUDIO_ENGINE->run);
@@ -192,6 +258,7 @@ router_recalc_graph (Router * self, bool soft)
       g_atomic_int_set (&self->graph_setup_in_progress, 1);
       graph_setup (self->graph, 1, 1);
       g_atomic_int_set (&self->graph_setup_in_progress, 0);
+      self->block_length = AUDIO_ENGINE->block_length;
       g_atomic_int_set (&AUDIO_ENGINE->run, (guint) running);
     }
 
@@ -23,6 +23,7 @@
 #include "dsp/midi_bus_track.h"
 #include "dsp/midi_event.h"
 #include "dsp/midi_group_track.h"
+#include "dsp/midi_region.h"
 #include "dsp/midi_track.h"
 #include "dsp/modulator_track.h"
 #include "dsp/router.h"
@@ -44,6 +45,7 @@
 #include "utils/error.h"
 #include "utils/flags.h"
 #include "utils/gtk.h"
+#include "utils/interval_index.h"
 #include "utils/io.h"
 #include "utils/mem.h"
 #include "utils/objects.h"
@@ -2502,12 +2504,6 @@ track_fill_events (
   const unsigned_frame_t g_end_frames =
     time_nfo->g_start_frame_w_offset + time_nfo->nframes;
 
-  if (midi_events)
-    {
-      /* FIXME don't block */
-      zix_sem_wait (&midi_events->access_sem);
-    }
-
 #if 0
   g_message (
     "%s: TRACK %s STARTING from %ld, "
@@ -2520,12 +2516,22 @@ track_fill_events (
 
   bool use_caches = !track_is_auditioner (self);
 
-  TrackLane ** lanes = use_caches ? self->lane_snapshots : self->lanes;
-  int num_lanes = use_caches ? self->num_lane_snapshots : self->num_lanes;
+  /* the snapshot may be swapped while processing, so only
+   * load it once */
+  const TrackPlaybackSnapshot * snapshot = NULL;
+  if (use_caches)
+    {
+      snapshot = track_get_playback_snapshot (self);
+      if (!snapshot)
+        return;
+    }
+
+  TrackLane ** lanes = use_caches ? snapshot->lanes : self->lanes;
+  int num_lanes = use_caches ? snapshot->num_lanes : self->num_lanes;
   ZRegion ** chord_regions =
-    use_caches ? self->chord_region_snapshots : self->chord_regions;
+    use_caches ? snapshot->chord_regions : self->chord_regions;
   int num_chord_regions =
-    use_caches ? self->num_chord_region_snapshots : self->num_chord_regions;
+    use_caches ? snapshot->num_chord_regions : self->num_chord_regions;
 
   /* go through each lane */
   const int num_loops = (tt == TRACK_TYPE_CHORD ? 1 : num_lanes);
@@ -2538,11 +2544,34 @@ track_fill_events (
           g_return_if_fail (lane);
         }
 
+      /* if the regions are indexed, only go through the
+       * regions hit by the range, otherwise go through
+       * all of them */
+      IntervalIndex * region_index = NULL;
+      if (use_caches)
+        {
+          region_index =
+            tt == TRACK_TYPE_CHORD ? snapshot->chord_region_index
+                                   : lane->region_index;
+        }
+      const int * hits = NULL;
+      int         num_regions;
+      if (region_index)
+        {
+          num_regions = (int) interval_index_query (
+            region_index, (int64_t) time_nfo->g_start_frame_w_offset,
+            (int64_t) (midi_events ? g_end_frames : (g_end_frames - 1)), &hits);
+        }
+      else
+        {
+          num_regions =
+            (tt == TRACK_TYPE_CHORD ? num_chord_regions : lane->num_regions);
+        }
+
       /* go through each region */
-      const int num_regions =
-        (tt == TRACK_TYPE_CHORD ? num_chord_regions : lane->num_regions);
-      for (int i = 0; i < num_regions; i++)
+      for (int k = 0; k < num_regions; k++)
         {
+          const int i = hits ? hits[k] : k;
           ZRegion * r =
             tt == TRACK_TYPE_CHORD ? chord_regions[i] : lane->regions[i];
           ArrangerObject * r_obj = (ArrangerObject *) r;
@@ -2672,8 +2701,6 @@ track_fill_events (
           midi_events_print (midi_events, F_QUEUED);
         }
 #endif
-
-      zix_sem_post (&midi_events->access_sem);
     }
 }
 
@@ -2946,6 +2973,11 @@ track_set_name (Track * self, const char * name, bool pub_events)
         }
     }
 
+  if (self->tracklist && old_hash != new_hash)
+    {
+      tracklist_update_name_index (self->tracklist);
+    }
+
   if (pub_events)
     {
       EVENTS_PUSH (ET_TRACK_NAME_CHANGED, self);
@@ -3546,96 +3578,229 @@ track_set_caches (Track * self, CacheTypes types)
 
   if (types & CACHE_TYPE_PLAYBACK_SNAPSHOTS && !track_is_auditioner (self))
     {
-      g_return_if_fail (g_atomic_int_get (&AUDIO_ENGINE->run) == 0);
+      track_update_playback_snapshot (self, NULL);
+    }
 
-      /* normal track lanes */
-      for (int i = 0; i < self->num_lane_snapshots; i++)
-        {
-          track_lane_free (self->lane_snapshots[i]);
-        }
-      self->num_lane_snapshots = 0;
-      self->lane_snapshots = g_realloc_n (
-        self->lane_snapshots, (size_t) self->num_lanes, sizeof (TrackLane *));
-      for (int i = 0; i < self->num_lanes; i++)
+  if (types & CACHE_TYPE_PLUGIN_PORTS)
+    {
+      if (track_type_has_channel (self->type))
         {
-          self->lane_snapshots[i] = track_lane_gen_snapshot (self->lanes[i]);
-          self->num_lane_snapshots++;
+          channel_set_caches (self->channel);
         }
+    }
 
-      /* chord regions */
-      for (int i = 0; i < self->num_chord_region_snapshots; i++)
-        {
-          arranger_object_free (
-            (ArrangerObject *) self->chord_region_snapshots[i]);
-        }
-      self->num_chord_region_snapshots = 0;
-      self->chord_region_snapshots = g_realloc_n (
-        self->chord_region_snapshots, (size_t) self->num_chord_regions,
-        sizeof (ZRegion *));
-      for (int i = 0; i < self->num_chord_regions; i++)
+  if (
+    types & CACHE_TYPE_AUTOMATION_LANE_RECORD_MODES
+    || types & CACHE_TYPE_AUTOMATION_LANE_PORTS)
+    {
+      if (atl)
         {
-          self->chord_region_snapshots[i] = (ZRegion *) arranger_object_clone (
-            (ArrangerObject *) self->chord_regions[i]);
-          self->num_chord_region_snapshots++;
+          automation_tracklist_set_caches (
+            atl,
+            CACHE_TYPE_AUTOMATION_LANE_RECORD_MODES
+              | CACHE_TYPE_AUTOMATION_LANE_PORTS);
         }
+    }
+}
+
+/**
+ * Frees the snapshot, except the lanes and regions in it.
+ */
+static void
+playback_snapshot_free_shallow (TrackPlaybackSnapshot * self)
+{
+  object_zero_and_free_if_nonnull (self->lanes);
+  object_zero_and_free_if_nonnull (self->chord_regions);
+  object_free_w_func_and_null (interval_index_free, self->chord_region_index);
+
+  object_zero_and_free (self);
+}
+
+static void
+playback_snapshot_free (TrackPlaybackSnapshot * self)
+{
+  for (int i = 0; i < self->num_lanes; i++)
+    {
+      object_free_w_func_and_null (track_lane_free, self->lanes[i]);
+    }
+  for (int i = 0; i < self->num_chord_regions; i++)
+    {
+      object_free_w_func_and_null_cast (
+        arranger_object_free, ArrangerObject *, self->chord_regions[i]);
+    }
+  playback_snapshot_free_shallow (self);
+}
+
+/**
+ * Returns whether the lane snapshot can be used for the
+ * given lane with the given region snapshots.
+ */
+static bool
+lane_snapshot_is_up_to_date (
+  const TrackLane * snapshot,
+  const TrackLane * lane,
+  ZRegion **        regions,
+  int               num_regions)
+{
+  if (
+    snapshot->num_regions != num_regions || snapshot->pos != lane->pos
+    || snapshot->mute != lane->mute || snapshot->solo != lane->solo
+    || snapshot->midi_ch != lane->midi_ch)
+    return false;
+
+  for (int i = 0; i < num_regions; i++)
+    {
+      if (snapshot->regions[i] != regions[i])
+        return false;
+    }
+
+  return true;
+}
 
-      /* scales */
-      for (int i = 0; i < self->num_scale_snapshots; i++)
+/**
+ * Scale and marker snapshots are not used by the engine
+ * yet, so they are simply replaced.
+ */
+static void
+update_scale_and_marker_snapshots (Track * self)
+{
+  for (int i = 0; i < self->num_scale_snapshots; i++)
+    {
+      arranger_object_free ((ArrangerObject *) self->scale_snapshots[i]);
+    }
+  self->num_scale_snapshots = 0;
+  self->scale_snapshots = g_realloc_n (
+    self->scale_snapshots, (size_t) self->num_scales, sizeof (ScaleObject *));
+  for (int i = 0; i < self->num_scales; i++)
+    {
+      self->scale_snapshots[i] = (ScaleObject *) arranger_object_clone (
+        (ArrangerObject *) self->scales[i]);
+      self->num_scale_snapshots++;
+    }
+
+  for (int i = 0; i < self->num_marker_snapshots; i++)
+    {
+      arranger_object_free ((ArrangerObject *) self->marker_snapshots[i]);
+    }
+  self->num_marker_snapshots = 0;
+  self->marker_snapshots = g_realloc_n (
+    self->marker_snapshots, (size_t) self->num_markers, sizeof (Marker *));
+  for (int i = 0; i < self->num_markers; i++)
+    {
+      self->marker_snapshots[i] =
+        (Marker *) arranger_object_clone ((ArrangerObject *) self->markers[i]);
+      self->num_marker_snapshots++;
+    }
+}
+
+void
+track_update_playback_snapshot (Track * self, GHashTable * touched_ids)
+{
+  g_return_if_fail (!track_is_auditioner (self));
+
+  TrackPlaybackSnapshot * prev = self->playback_snapshot;
+
+  /* region snapshots of the current snapshot not reused
+   * yet */
+  GHashTable * prev_regions = g_hash_table_new (NULL, NULL);
+  for (int i = 0; prev && i < prev->num_lanes; i++)
+    {
+      TrackLane * lane = prev->lanes[i];
+      for (int j = 0; j < lane->num_regions; j++)
         {
-          arranger_object_free ((ArrangerObject *) self->scale_snapshots[i]);
+          g_hash_table_add (prev_regions, lane->regions[j]);
         }
-      self->num_scale_snapshots = 0;
-      self->scale_snapshots = g_realloc_n (
-        self->scale_snapshots, (size_t) self->num_scales,
-        sizeof (ScaleObject *));
-      for (int i = 0; i < self->num_scales; i++)
+    }
+  for (int i = 0; prev && i < prev->num_chord_regions; i++)
+    {
+      g_hash_table_add (prev_regions, prev->chord_regions[i]);
+    }
+  GHashTable * reusable_regions = touched_ids ? prev_regions : NULL;
+
+  TrackPlaybackSnapshot * snapshot = object_new (TrackPlaybackSnapshot);
+
+  /* normal track lanes */
+  snapshot->lanes = object_new_n ((size_t) self->num_lanes, TrackLane *);
+  snapshot->num_lanes = self->num_lanes;
+  ZRegion ** regions = NULL;
+  for (int i = 0; i < self->num_lanes; i++)
+    {
+      TrackLane * lane = self->lanes[i];
+      regions = g_realloc_n (
+        regions, (size_t) MAX (lane->num_regions, 1), sizeof (ZRegion *));
+      for (int j = 0; j < lane->num_regions; j++)
         {
-          self->scale_snapshots[i] = (ScaleObject *) arranger_object_clone (
-            (ArrangerObject *) self->scales[i]);
-          self->num_scale_snapshots++;
+          regions[j] = region_gen_playback_snapshot (
+            lane->regions[j], reusable_regions, touched_ids);
         }
 
-      /* markers */
-      for (int i = 0; i < self->num_marker_snapshots; i++)
+      /* share the lane snapshot if nothing in it changed */
+      TrackLane * prev_lane =
+        prev && i < prev->num_lanes ? prev->lanes[i] : NULL;
+      if (
+        prev_lane
+        && lane_snapshot_is_up_to_date (
+          prev_lane, lane, regions, lane->num_regions))
         {
-          arranger_object_free ((ArrangerObject *) self->marker_snapshots[i]);
+          snapshot->lanes[i] = prev_lane;
         }
-      self->num_marker_snapshots = 0;
-      self->marker_snapshots = g_realloc_n (
-        self->marker_snapshots, (size_t) self->num_markers, sizeof (Marker *));
-      for (int i = 0; i < self->num_markers; i++)
+      else
         {
-          self->marker_snapshots[i] = (Marker *) arranger_object_clone (
-            (ArrangerObject *) self->markers[i]);
-          self->num_marker_snapshots++;
+          snapshot->lanes[i] =
+            track_lane_gen_snapshot (lane, regions, lane->num_regions);
         }
+    }
+  g_free (regions);
 
-      /* automation regions */
-      if (atl)
-        {
-          automation_tracklist_set_caches (atl, CACHE_TYPE_PLAYBACK_SNAPSHOTS);
-        }
+  /* chord regions */
+  snapshot->chord_regions =
+    object_new_n ((size_t) self->num_chord_regions, ZRegion *);
+  snapshot->num_chord_regions = self->num_chord_regions;
+  for (int i = 0; i < self->num_chord_regions; i++)
+    {
+      snapshot->chord_regions[i] = region_gen_playback_snapshot (
+        self->chord_regions[i], reusable_regions, touched_ids);
     }
+  snapshot->chord_region_index = region_gen_interval_index (
+    snapshot->chord_regions, snapshot->num_chord_regions);
 
-  if (types & CACHE_TYPE_PLUGIN_PORTS)
+  g_atomic_pointer_set (&self->playback_snapshot, snapshot);
+
+  /* free the lanes and regions that were not reused and the
+   * previous snapshot once the engine is done with them */
+  AudioEngine * engine =
+    track_is_in_active_project (self) ? AUDIO_ENGINE : NULL;
+  for (int i = 0; prev && i < prev->num_lanes; i++)
     {
-      if (track_type_has_channel (self->type))
-        {
-          channel_set_caches (self->channel);
-        }
+      if (i < snapshot->num_lanes && snapshot->lanes[i] == prev->lanes[i])
+        continue;
+
+      engine_retire_object (
+        engine, prev->lanes[i],
+        (GDestroyNotify) track_lane_free_snapshot_shallow);
+    }
+  GHashTableIter iter;
+  void *         r_obj;
+  g_hash_table_iter_init (&iter, prev_regions);
+  while (g_hash_table_iter_next (&iter, &r_obj, NULL))
+    {
+      engine_retire_object (
+        engine, r_obj, (GDestroyNotify) arranger_object_free);
+    }
+  g_hash_table_unref (prev_regions);
+  if (prev)
+    {
+      engine_retire_object (
+        engine, prev, (GDestroyNotify) playback_snapshot_free_shallow);
     }
 
-  if (
-    types & CACHE_TYPE_AUTOMATION_LANE_RECORD_MODES
-    || types & CACHE_TYPE_AUTOMATION_LANE_PORTS)
+  update_scale_and_marker_snapshots (self);
+
+  /* automation regions */
+  AutomationTracklist * atl = track_get_automation_tracklist (self);
+  for (int i = 0; atl && i < atl->num_ats; i++)
     {
-      if (atl)
-        {
-          automation_tracklist_set_caches (
-            atl,
-            CACHE_TYPE_AUTOMATION_LANE_RECORD_MODES
-              | CACHE_TYPE_AUTOMATION_LANE_PORTS);
-        }
+      automation_track_update_playback_snapshot (atl->ats[i], touched_ids);
     }
 }
 
@@ -3658,11 +3823,7 @@ track_free (Track * self)
       object_free_w_func_and_null (track_lane_free, self->lanes[i]);
     }
   object_zero_and_free (self->lanes);
-  for (int i = 0; i < self->num_lane_snapshots; i++)
-    {
-      object_free_w_func_and_null (track_lane_free, self->lane_snapshots[i]);
-    }
-  object_zero_and_free (self->lane_snapshots);
+  object_free_w_func_and_null (playback_snapshot_free, self->playback_snapshot);
 
   /* remove automation points, curves, tracks,
    * lanes*/
@@ -3675,12 +3836,8 @@ track_free (Track * self)
         arranger_object_free, ArrangerObject *, self->chord_regions[i]);
     }
   object_zero_and_free (self->chord_regions);
-  for (int i = 0; i < self->num_chord_region_snapshots; i++)
-    {
-      object_free_w_func_and_null_cast (
-        arranger_object_free, ArrangerObject *, self->chord_region_snapshots[i]);
-    }
-  object_zero_and_free (self->chord_region_snapshots);
+  object_free_w_func_and_null (
+    interval_index_free, self->chord_region_arranger_index);
 
   /* remove scales */
   for (int i = 0; i < self->num_scales; i++)
@@ -5,6 +5,7 @@
 
 #include "dsp/audio_region.h"
 #include "dsp/midi_event.h"
+#include "dsp/midi_region.h"
 #include "dsp/track.h"
 #include "dsp/track_lane.h"
 #include "dsp/tracklist.h"
@@ -16,6 +17,7 @@
 #include "utils/arrays.h"
 #include "utils/error.h"
 #include "utils/flags.h"
+#include "utils/interval_index.h"
 #include "utils/mem.h"
 #include "utils/objects.h"
 #include "zrythm_app.h"
@@ -268,6 +270,7 @@ track_lane_insert_region (TrackLane * self, ZRegion * region, int idx)
     }
   self->num_regions++;
   self->regions[idx] = region;
+  object_free_w_func_and_null (interval_index_free, self->arranger_index);
   region->id.lane_pos = self->pos;
   region->id.idx = idx;
   region_update_identifier (region);
@@ -409,6 +412,7 @@ track_lane_remove_region (TrackLane * self, ZRegion * region)
   bool deleted = false;
   array_delete_confirm (self->regions, self->num_regions, region, deleted);
   g_return_if_fail (deleted);
+  object_free_w_func_and_null (interval_index_free, self->arranger_index);
 
   for (int i = region->id.idx; i < self->num_regions; i++)
     {
@@ -552,12 +556,39 @@ track_lane_write_to_midi_file (
  * Generate a snapshot for playback.
  */
 TrackLane *
-track_lane_gen_snapshot (const TrackLane * self)
+track_lane_gen_snapshot (
+  const TrackLane * self,
+  ZRegion **        regions,
+  int               num_regions)
 {
-  TrackLane * snapshot = track_lane_clone (self, self->track);
+  TrackLane * snapshot = object_new (TrackLane);
+  snapshot->track = self->track;
+  snapshot->name = g_strdup (self->name);
+  snapshot->height = self->height;
+  snapshot->pos = self->pos;
+  snapshot->mute = self->mute;
+  snapshot->solo = self->solo;
+  snapshot->midi_ch = self->midi_ch;
+
+  snapshot->regions_size = (size_t) num_regions;
+  snapshot->regions = object_new_n (snapshot->regions_size, ZRegion *);
+  snapshot->num_regions = num_regions;
+  for (int i = 0; i < num_regions; i++)
+    {
+      snapshot->regions[i] = regions[i];
+    }
+  snapshot->region_index =
+    region_gen_interval_index (snapshot->regions, snapshot->num_regions);
   return snapshot;
 }
 
+void
+track_lane_free_snapshot_shallow (TrackLane * self)
+{
+  self->num_regions = 0;
+  track_lane_free (self);
+}
+
 /**
  * Frees the TrackLane.
  */
@@ -573,6 +604,9 @@ track_lane_free (TrackLane * self)
 
   object_zero_and_free_if_nonnull (self->regions);
 
+  object_free_w_func_and_null (interval_index_free, self->region_index);
+  object_free_w_func_and_null (interval_index_free, self->arranger_index);
+
   for (int j = 0; j < self->num_buttons; j++)
     {
       object_free_w_func_and_null (custom_button_widget_free, self->buttons[j]);
@@ -767,7 +767,7 @@ track_processor_process (
       /* panic MIDI if necessary */
       if (g_atomic_int_get (&AUDIO_ENGINE->panic))
         {
-          midi_events_panic (pr->midi_events, F_QUEUED);
+          midi_events_panic_without_lock (pr->midi_events, F_QUEUED);
         }
       /* get events from track if playing */
       else if (
@@ -5,8 +5,10 @@
 #include "dsp/audio_region.h"
 #include "dsp/channel.h"
 #include "dsp/chord_track.h"
+#include "dsp/engine.h"
 #include "dsp/group_target_track.h"
 #include "dsp/master_track.h"
+#include "dsp/pool.h"
 #include "dsp/router.h"
 #include "dsp/track.h"
 #include "dsp/tracklist.h"
@@ -82,6 +84,8 @@ tracklist_init_loaded (
 
       track_init_loaded (track, self, NULL);
     }
+
+  tracklist_update_name_index (self);
 }
 
 /**
@@ -295,6 +299,7 @@ tracklist_insert_track (
   /* append the track at the end */
   array_append (self->tracks, self->num_tracks, track);
   track->tracklist = self;
+  tracklist_update_name_index (self);
 
   /* add flags for auditioner track ports */
   if (tracklist_is_auditioner (self))
@@ -442,6 +447,71 @@ tracklist_find_track_by_name (Tracklist * self, const char * name)
   return NULL;
 }
 
+/**
+ * Returns the first slot to probe for the given name
+ * hash.
+ */
+static inline unsigned int
+get_name_index_slot (const TracklistNameIndex * index, unsigned int hash)
+{
+  /* the name hashes are not well distributed in the low
+   * bits, so mix them first */
+  hash ^= hash >> 16;
+  hash *= 0x45d9f3bu;
+  hash ^= hash >> 16;
+  return hash & (index->size - 1);
+}
+
+static AudioEngine *
+get_engine (Tracklist * self)
+{
+  if (self->project)
+    return self->project->audio_engine;
+  else if (self->sample_processor)
+    return self->sample_processor->audio_engine;
+  return NULL;
+}
+
+/**
+ * Rebuilds the index used by
+ * tracklist_find_track_by_name_hash().
+ */
+void
+tracklist_update_name_index (Tracklist * self)
+{
+  /* keep the load factor at or below 0.5 */
+  unsigned int size = 8;
+  while (size < (unsigned int) self->num_tracks * 2)
+    size *= 2;
+
+  TracklistNameIndex * index = g_malloc0 (
+    sizeof (TracklistNameIndex) + size * sizeof (TracklistNameIndexSlot));
+  index->size = size;
+  for (int i = 0; i < self->num_tracks; i++)
+    {
+      Track * track = self->tracks[i];
+      if (!track || !track->name)
+        continue;
+
+      /* keep the first track on collisions, like the
+       * linear search */
+      unsigned int hash = track_get_name_hash (track);
+      unsigned int slot = get_name_index_slot (index, hash);
+      while (index->slots[slot].track && index->slots[slot].name_hash != hash)
+        slot = (slot + 1) & (size - 1);
+      if (!index->slots[slot].track)
+        {
+          index->slots[slot].name_hash = hash;
+          index->slots[slot].track = track;
+        }
+    }
+
+  TracklistNameIndex * prev = g_atomic_pointer_get (&self->name_index);
+  g_atomic_pointer_set (&self->name_index, index);
+  if (prev)
+    engine_retire_object (get_engine (self), prev, g_free);
+}
+
 /**
  * Returns the Track matching the given name, if
  * any.
@@ -449,6 +519,19 @@ tracklist_find_track_by_name (Tracklist * self, const char * name)
 NONNULL Track *
 tracklist_find_track_by_name_hash (Tracklist * self, unsigned int hash)
 {
+  const TracklistNameIndex * index = g_atomic_pointer_get (&self->name_index);
+  if (G_LIKELY (index))
+    {
+      unsigned int slot = get_name_index_slot (index, hash);
+      while (index->slots[slot].track)
+        {
+          if (index->slots[slot].name_hash == hash)
+            return index->slots[slot].track;
+          slot = (slot + 1) & (index->size - 1);
+        }
+      return NULL;
+    }
+
   if (
     G_LIKELY (tracklist_is_in_active_project (self)) && ROUTER
     && router_is_processing_thread (ROUTER) && !tracklist_is_auditioner (self))
@@ -824,6 +907,7 @@ tracklist_remove_track (
     }
 
   array_delete (self->tracks, self->num_tracks, track);
+  tracklist_update_name_index (self);
 
   if (tracklist_is_in_active_project (self) && !tracklist_is_auditioner (self))
     {
@@ -1766,6 +1850,13 @@ tracklist_set_caches (Tracklist * self, CacheTypes types)
       Track * track = self->tracks[i];
       track_set_caches (track, types);
     }
+
+  if (
+    types & CACHE_TYPE_PLAYBACK_SNAPSHOTS
+    && tracklist_is_in_active_project (self) && !tracklist_is_auditioner (self))
+    {
+      audio_pool_update_stream_anchors (AUDIO_POOL);
+    }
 }
 
 /**
@@ -1835,6 +1926,8 @@ tracklist_free (Tracklist * self)
       self->tempo_track = NULL;
     }
 
+  g_free_and_null (self->name_index);
+
   object_zero_and_free (self);
 
   g_message ("%s: done", __func__);
@@ -8,6 +8,7 @@
 #include "dsp/marker.h"
 #include "dsp/marker_track.h"
 #include "dsp/midi_event.h"
+#include "dsp/pool.h"
 #include "dsp/tempo_track.h"
 #include "dsp/transport.h"
 #include "gui/backend/event.h"
@@ -643,10 +644,8 @@ transport_move_playhead (
                       MidiEvents * midi_events =
                         track->processor->piano_roll->midi_events;
 
-                      zix_sem_wait (&midi_events->access_sem);
-                      midi_events_add_note_off (
-                        midi_events, 1, midi_note->val, 0, 1);
-                      zix_sem_post (&midi_events->access_sem);
+                      midi_events_add_external_note_off (
+                        midi_events, 1, midi_note->val, 0);
                     }
                 }
             }
@@ -656,6 +655,9 @@ transport_move_playhead (
   /* move to new pos */
   position_set_to_pos (&self->playhead_pos, target);
 
+  /* pre-roll streamed clips at the new position */
+  audio_pool_update_stream_anchors (AUDIO_POOL);
+
   if (set_cue_point)
     {
       /* move cue point */
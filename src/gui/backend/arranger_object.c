@@ -2,6 +2,7 @@
 // SPDX-License-Identifier: LicenseRef-ZrythmLicense
 
 #include <inttypes.h>
+#include <math.h>
 
 #include "dsp/audio_region.h"
 #include "dsp/automation_point.h"
@@ -12,6 +13,7 @@
 #include "dsp/midi_region.h"
 #include "dsp/router.h"
 #include "dsp/stretcher.h"
+#include "dsp/tracklist.h"
 #include "gui/backend/arranger_object.h"
 #include "gui/backend/automation_selections.h"
 #include "gui/backend/chord_selections.h"
@@ -48,6 +50,7 @@
 #include "utils/dsp.h"
 #include "utils/error.h"
 #include "utils/flags.h"
+#include "utils/interval_index.h"
 #include "utils/math.h"
 #include "utils/objects.h"
 #include "zrythm_app.h"
@@ -60,6 +63,13 @@
 
 #define POSITION_TYPE(x) ARRANGER_OBJECT_POSITION_TYPE_##x
 
+/**
+ * Incremented when positions change outside the GTK
+ * thread, where the indices cannot be touched, to
+ * outdate all of them.
+ */
+static volatile guint index_generation = 0;
+
 #define FOREACH_TYPE(func) \
   func (REGION, ZRegion, region) func ( \
     SCALE_OBJECT, ScaleObject, scale_object) func (MARKER, Marker, marker) \
@@ -268,6 +278,7 @@ void
 arranger_object_set_muted (ArrangerObject * self, bool muted, bool fire_events)
 {
   self->muted = muted;
+  arranger_object_bump_content_version (self);
 
   if (fire_events)
     {
@@ -290,6 +301,11 @@ arranger_object_set_to_object (ArrangerObject * dest, ArrangerObject * src)
     {
       dest->end_pos = src->end_pos;
     }
+  arranger_object_invalidate_index (dest);
+  if (arranger_object_owned_by_region (dest))
+    {
+      arranger_object_bump_content_version (dest);
+    }
   if (arranger_object_type_can_loop (src->type))
     {
       dest->clip_start_pos = src->clip_start_pos;
@@ -662,9 +678,235 @@ arranger_object_set_position (
   g_return_val_if_fail (pos_ptr, false);
   position_set_to_pos (pos_ptr, pos);
 
+  if (
+    pos_type == ARRANGER_OBJECT_POSITION_TYPE_START
+    || pos_type == ARRANGER_OBJECT_POSITION_TYPE_END)
+    {
+      arranger_object_invalidate_index (self);
+    }
+  if (arranger_object_owned_by_region (self))
+    {
+      arranger_object_bump_content_version (self);
+    }
+
   return true;
 }
 
+/**
+ * Returns the start and end ticks of the object, rounded
+ * outwards, including its transient if any (since the
+ * original is also drawn and hit while moving).
+ */
+static void
+get_index_range (const ArrangerObject * self, int64_t * start, int64_t * end)
+{
+  double start_ticks = self->pos.ticks;
+  double end_ticks =
+    arranger_object_type_has_length (self->type)
+      ? self->end_pos.ticks
+      : self->pos.ticks;
+  const ArrangerObject * transient = self->transient;
+  if (transient)
+    {
+      start_ticks = MIN (start_ticks, transient->pos.ticks);
+      end_ticks = MAX (
+        end_ticks,
+        arranger_object_type_has_length (transient->type)
+          ? transient->end_pos.ticks
+          : transient->pos.ticks);
+    }
+  *start = (int64_t) floor (start_ticks);
+  *end = (int64_t) ceil (end_ticks);
+}
+
+/**
+ * Returns the index of the positions (in ticks) of the
+ * given objects, building it if needed.
+ *
+ * The indices in the query results refer to the position
+ * in @p objs.
+ *
+ * @param index Index owned by the container of the
+ *   objects, or NULL if not built yet.
+ */
+IntervalIndex *
+arranger_object_get_index (
+  ArrangerObject ** objs,
+  int               num_objs,
+  IntervalIndex **  index)
+{
+  /* rebuild if objects were added or removed without
+   * going through the container, or if positions
+   * changed outside the GTK thread */
+  guint generation = g_atomic_int_get (&index_generation);
+  if (
+    *index
+    && ((*index)->num_items != (size_t) num_objs
+        || (*index)->tag != generation))
+    {
+      object_free_w_func_and_null (interval_index_free, *index);
+    }
+  if (*index)
+    return *index;
+
+  *index = interval_index_new ((size_t) num_objs);
+  (*index)->tag = generation;
+  for (int i = 0; i < num_objs; i++)
+    {
+      int64_t start, end;
+      get_index_range (objs[i], &start, &end);
+      interval_index_add (*index, start, end, i);
+    }
+  interval_index_build (*index);
+
+  return *index;
+}
+
+/**
+ * Returns the region with the given identifier, or NULL
+ * if not found.
+ *
+ * Unlike region_find(), this does not complain if the
+ * region is not found, since the object looking for it
+ * may not be part of the project.
+ */
+static ZRegion *
+find_region_quietly (const RegionIdentifier * id)
+{
+  if (!PROJECT || !TRACKLIST)
+    return NULL;
+
+  Track * track =
+    tracklist_find_track_by_name_hash (TRACKLIST, id->track_name_hash);
+  if (!track)
+    return NULL;
+
+  switch (id->type)
+    {
+    case REGION_TYPE_MIDI:
+    case REGION_TYPE_AUDIO:
+      {
+        if (id->lane_pos < 0 || id->lane_pos >= track->num_lanes)
+          return NULL;
+        TrackLane * lane = track->lanes[id->lane_pos];
+        if (id->idx < 0 || id->idx >= lane->num_regions)
+          return NULL;
+        return lane->regions[id->idx];
+      }
+    case REGION_TYPE_AUTOMATION:
+      {
+        AutomationTracklist * atl = &track->automation_tracklist;
+        if (id->at_idx < 0 || id->at_idx >= atl->num_ats)
+          return NULL;
+        AutomationTrack * at = atl->ats[id->at_idx];
+        if (id->idx < 0 || id->idx >= at->num_regions)
+          return NULL;
+        return at->regions[id->idx];
+      }
+    case REGION_TYPE_CHORD:
+      if (id->idx < 0 || id->idx >= track->num_chord_regions)
+        return NULL;
+      return track->chord_regions[id->idx];
+    }
+
+  return NULL;
+}
+
+/**
+ * Returns a pointer to the index the object would be in,
+ * based on its identifier, or NULL if the object is not
+ * indexed.
+ *
+ * This does not complain if the container is not found,
+ * since the object may not be part of the project.
+ */
+static IntervalIndex **
+get_index_ptr (const ArrangerObject * self)
+{
+  if (!PROJECT || !TRACKLIST)
+    return NULL;
+
+  if (self->type == ARRANGER_OBJECT_TYPE_REGION)
+    {
+      const ZRegion * r = (const ZRegion *) self;
+      Track * track = tracklist_find_track_by_name_hash (
+        TRACKLIST, r->id.track_name_hash);
+      if (!track)
+        return NULL;
+
+      switch (r->id.type)
+        {
+        case REGION_TYPE_MIDI:
+        case REGION_TYPE_AUDIO:
+          if (r->id.lane_pos < 0 || r->id.lane_pos >= track->num_lanes)
+            return NULL;
+          return &track->lanes[r->id.lane_pos]->arranger_index;
+        case REGION_TYPE_AUTOMATION:
+          {
+            AutomationTracklist * atl = &track->automation_tracklist;
+            if (r->id.at_idx < 0 || r->id.at_idx >= atl->num_ats)
+              return NULL;
+            return &atl->ats[r->id.at_idx]->arranger_index;
+          }
+        case REGION_TYPE_CHORD:
+          return &track->chord_region_arranger_index;
+        }
+    }
+  else if (self->type == ARRANGER_OBJECT_TYPE_MIDI_NOTE)
+    {
+      ZRegion * r = find_region_quietly (&self->region_id);
+      return r ? &r->arranger_index : NULL;
+    }
+
+  return NULL;
+}
+
+/**
+ * Clears the index of the container the object belongs
+ * to, so that it is rebuilt on the next hit test.
+ *
+ * To be called when the position of the object changes.
+ */
+void
+arranger_object_invalidate_index (const ArrangerObject * self)
+{
+  /* indices are only used and freed in the GTK thread */
+  if (!ZRYTHM_APP_IS_GTK_THREAD)
+    {
+      g_atomic_int_inc (&index_generation);
+      return;
+    }
+
+  IntervalIndex ** index = get_index_ptr (self);
+  if (index)
+    {
+      object_free_w_func_and_null (interval_index_free, *index);
+    }
+}
+
+/**
+ * Marks the drawing of the region the object is drawn in
+ * (the object itself if it is a region) as outdated.
+ */
+void
+arranger_object_bump_content_version (const ArrangerObject * self)
+{
+  ZRegion * r = NULL;
+  if (self->type == ARRANGER_OBJECT_TYPE_REGION)
+    {
+      r = (ZRegion *) self;
+    }
+  else if (arranger_object_owned_by_region (self))
+    {
+      r = find_region_quietly (&self->region_id);
+    }
+
+  if (r)
+    {
+      r->content_version++;
+    }
+}
+
 /**
  * Returns the type as a string.
  */
@@ -1126,6 +1368,16 @@ arranger_object_update_positions (
       position_update (&self->fade_out_pos, from_ticks, ratio);
     }
 
+  /* the ticks change when updating from frames */
+  if (!from_ticks)
+    {
+      arranger_object_invalidate_index (self);
+      if (arranger_object_owned_by_region (self))
+        {
+          arranger_object_bump_content_version (self);
+        }
+    }
+
 #if 0
   g_debug ("\n\n\nobject after just position updates");
   arranger_object_print (self);
@@ -2665,8 +2917,9 @@ arranger_object_split (
         && ((ZRegion *) (*r1))->id.type == REGION_TYPE_AUDIO)
         {
           ZRegion *   prev_r1 = (ZRegion *) *r1;
-          AudioClip * prev_r1_clip = audio_region_get_clip (prev_r1);
-          g_return_val_if_fail (prev_r1_clip, false);
+          AudioClip * prev_r1_clip = audio_region_load_clip (prev_r1, error);
+          if (!prev_r1_clip)
+            return false;
           float * frames = object_new_n (
             (size_t) localp.frames * prev_r1_clip->channels, float);
           dsp_copy (
@@ -2729,8 +2982,9 @@ arranger_object_split (
         && ((ZRegion *) (*r2))->id.type == REGION_TYPE_AUDIO)
         {
           ZRegion *   prev_r2 = (ZRegion *) *r2;
-          AudioClip * prev_r2_clip = audio_region_get_clip (prev_r2);
-          g_return_val_if_fail (prev_r2_clip, false);
+          AudioClip * prev_r2_clip = audio_region_load_clip (prev_r2, error);
+          if (!prev_r2_clip)
+            return false;
           size_t num_frames =
             (size_t) r2_local_end.frames * prev_r2_clip->channels;
           z_return_val_if_fail_cmp (num_frames, >, 0, false);
@@ -3500,6 +3754,10 @@ free_region (ZRegion * self)
       FREE_R (AUTOMATION, automation);
     }
 
+  object_free_w_func_and_null (midi_note_timeline_free, self->note_timeline);
+  object_free_w_func_and_null (interval_index_free, self->arranger_index);
+  region_free_content_caches (self);
+
   g_free_and_null (self->name);
   g_free_and_null (self->escaped_name);
   if (G_IS_OBJECT (self->layout))
@@ -2104,7 +2104,13 @@ arranger_selections_merge (ArrangerSelections * self)
             long r_frames_length = arranger_object_get_length_in_frames (r_obj);
 
             /* add all audio data */
-            AudioClip * clip = audio_region_get_clip (r);
+            GError *    err = NULL;
+            AudioClip * clip = audio_region_load_clip (r, &err);
+            if (!clip)
+              {
+                HANDLE_ERROR_LITERAL (err, _ ("Failed to merge audio regions"));
+                continue;
+              }
             dsp_add2 (
               &lframes[frames_diff], clip->ch_frames[0],
               (size_t) r_frames_length);
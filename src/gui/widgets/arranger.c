@@ -28,6 +28,8 @@
  * GTK+ at ftp://ftp.gtk.org/pub/gtk/.
  */
 
+#include <math.h>
+
 #include "actions/actions.h"
 #include "actions/arranger_selections.h"
 #include "dsp/automation_region.h"
@@ -86,6 +88,7 @@
 #include "utils/error.h"
 #include "utils/flags.h"
 #include "utils/gtk.h"
+#include "utils/interval_index.h"
 #include "utils/math.h"
 #include "utils/objects.h"
 #include "utils/resources.h"
@@ -547,6 +550,50 @@ add_object_if_overlap (ArrangerWidget * self, ObjectOverlapInfo * nfo)
   return add;
 }
 
+/**
+ * Returns the indices of the objects that may overlap
+ * with the range in @p nfo, looked up in the index of
+ * their positions, or NULL if all of them should be
+ * checked.
+ *
+ * The range is the same as the one checked at the start
+ * of add_object_if_overlap().
+ *
+ * @param index Index owned by the container of the
+ *   objects (see arranger_object_get_index()).
+ * @param offset_ticks Position of the parent region, for
+ *   objects positioned relative to it.
+ * @param[in,out] num_objs Number of objects, set to the
+ *   number of objects to check.
+ */
+static const int *
+get_objects_in_range (
+  ArrangerWidget *    self,
+  ObjectOverlapInfo * nfo,
+  ArrangerObject **   objs,
+  int *               num_objs,
+  IntervalIndex **    index,
+  double              offset_ticks)
+{
+  /* no range if x is not checked */
+  if (!nfo->rect && nfo->x < 0.0)
+    return NULL;
+
+  RulerWidget * ruler = arranger_widget_get_ruler (self);
+  double        start_ticks = nfo->start_pos.ticks - offset_ticks;
+  double        end_ticks =
+    (nfo->end_pos.ticks + 12.0 / ruler->px_per_tick) - offset_ticks;
+
+  IntervalIndex * obj_index =
+    arranger_object_get_index (objs, *num_objs, index);
+  const int * hits;
+  *num_objs = (int) interval_index_query (
+    obj_index, (int64_t) floor (start_ticks), (int64_t) ceil (end_ticks),
+    &hits);
+
+  return hits;
+}
+
 /**
  * Fills in the given array with the
  * ArrangerObject's of the given type that appear
@@ -666,8 +713,13 @@ get_hit_objects (
               for (int j = 0; j < track->num_lanes; j++)
                 {
                   TrackLane * lane = track->lanes[j];
-                  for (int k = 0; k < lane->num_regions; k++)
+                  int         num_regions = lane->num_regions;
+                  const int * hits = get_objects_in_range (
+                    self, &nfo, (ArrangerObject **) lane->regions,
+                    &num_regions, &lane->arranger_index, 0.0);
+                  for (int l = 0; l < num_regions; l++)
                     {
+                      const int k = hits ? hits[l] : l;
                       ZRegion * r = lane->regions[k];
                       g_warn_if_fail (IS_REGION (r));
                       obj = (ArrangerObject *) r;
@@ -694,8 +746,13 @@ get_hit_objects (
                 }
 
               /* chord regions */
-              for (int j = 0; j < track->num_chord_regions; j++)
+              int         num_chord_regions = track->num_chord_regions;
+              const int * chord_hits = get_objects_in_range (
+                self, &nfo, (ArrangerObject **) track->chord_regions,
+                &num_chord_regions, &track->chord_region_arranger_index, 0.0);
+              for (int l = 0; l < num_chord_regions; l++)
                 {
+                  const int j = chord_hits ? chord_hits[l] : l;
                   ZRegion * cr = track->chord_regions[j];
                   obj = (ArrangerObject *) cr;
                   nfo.obj = obj;
@@ -711,8 +768,13 @@ get_hit_objects (
                       AutomationTrack * at =
                         g_ptr_array_index (atl->visible_ats, j);
 
-                      for (int k = 0; k < at->num_regions; k++)
+                      int         num_regions = at->num_regions;
+                      const int * hits = get_objects_in_range (
+                        self, &nfo, (ArrangerObject **) at->regions,
+                        &num_regions, &at->arranger_index, 0.0);
+                      for (int l = 0; l < num_regions; l++)
                         {
+                          const int k = hits ? hits[l] : l;
                           obj = (ArrangerObject *) at->regions[k];
                           nfo.obj = obj;
                           add_object_if_overlap (self, &nfo);
@@ -762,8 +824,13 @@ get_hit_objects (
             break;
 
           /* add main region notes */
-          for (int i = 0; i < r->num_midi_notes; i++)
+          int         num_notes = r->num_midi_notes;
+          const int * hits = get_objects_in_range (
+            self, &nfo, (ArrangerObject **) r->midi_notes, &num_notes,
+            &r->arranger_index, r->base.pos.ticks);
+          for (int l = 0; l < num_notes; l++)
             {
+              const int  i = hits ? hits[l] : l;
               MidiNote * mn = r->midi_notes[i];
               obj = (ArrangerObject *) mn;
               nfo.obj = obj;
@@ -785,8 +852,14 @@ get_hit_objects (
                       ZRegion * cur_r = lane->regions[j];
                       if (cur_r == r)
                         continue;
-                      for (int k = 0; k < cur_r->num_midi_notes; k++)
+                      int num_cur_notes = cur_r->num_midi_notes;
+                      hits = get_objects_in_range (
+                        self, &nfo, (ArrangerObject **) cur_r->midi_notes,
+                        &num_cur_notes, &cur_r->arranger_index,
+                        cur_r->base.pos.ticks);
+                      for (int l = 0; l < num_cur_notes; l++)
                         {
+                          const int  k = hits ? hits[l] : l;
                           MidiNote * mn = cur_r->midi_notes[k];
                           obj = (ArrangerObject *) mn;
                           nfo.obj = obj;
@@ -1,6 +1,7 @@
 // SPDX-FileCopyrightText: © 2018-2023 Alexandros Theodotou <alex@zrythm.org>
 // SPDX-License-Identifier: LicenseRef-ZrythmLicense
 
+#include "dsp/clip_peaks.h"
 #include "dsp/control_port.h"
 #include "dsp/fade.h"
 #include "dsp/track_lane.h"
@@ -22,6 +23,7 @@
 #include "gui/widgets/midi_editor_space.h"
 #include "gui/widgets/midi_modifier_arranger.h"
 #include "gui/widgets/piano_roll_keys.h"
+#include "gui/widgets/region.h"
 #include "gui/widgets/ruler.h"
 #include "gui/widgets/timeline_arranger.h"
 #include "gui/widgets/timeline_panel.h"
@@ -171,6 +173,60 @@ draw_arranger_object (
     }
 }
 
+/**
+ * Frees the cached content drawings of the given region if
+ * it was not drawn in this snapshot.
+ */
+static void
+free_content_caches_if_not_drawn (ArrangerWidget * self, ZRegion * r)
+{
+  if (!r->content_caches[0] && !r->content_caches[1])
+    return;
+
+  if (!g_ptr_array_find (self->hit_objs_to_draw, r, NULL))
+    {
+      region_free_content_caches (r);
+    }
+}
+
+/**
+ * Frees the cached content drawings of the regions handled by
+ * this timeline arranger that have left the viewport, so that
+ * they are not kept around until the regions are freed.
+ */
+static void
+free_offscreen_region_caches (ArrangerWidget * self)
+{
+  for (int i = 0; i < TRACKLIST->num_tracks; i++)
+    {
+      Track * track = TRACKLIST->tracks[i];
+      if (track_is_pinned (track) != self->is_pinned)
+        continue;
+
+      for (int j = 0; j < track->num_lanes; j++)
+        {
+          TrackLane * lane = track->lanes[j];
+          for (int k = 0; k < lane->num_regions; k++)
+            {
+              free_content_caches_if_not_drawn (self, lane->regions[k]);
+            }
+        }
+
+      AutomationTracklist * atl = track_get_automation_tracklist (track);
+      if (!atl)
+        continue;
+
+      for (int j = 0; j < atl->num_ats; j++)
+        {
+          AutomationTrack * at = atl->ats[j];
+          for (int k = 0; k < at->num_regions; k++)
+            {
+              free_content_caches_if_not_drawn (self, at->regions[k]);
+            }
+        }
+    }
+}
+
 /**
  * @param rect Arranger draw rectangle.
  */
@@ -592,6 +648,28 @@ draw_audio_bg (ArrangerWidget * self, GtkSnapshot * snapshot, GdkRectangle * rec
         break;
     }
 
+  /* use the coarsest peaks that still have a peak per
+   * column, or the frames if zoomed in further (streamed
+   * clips are always drawn from their peaks) */
+  const AudioClipPeaks * peaks = g_atomic_pointer_get (&clip->peaks);
+  if (peaks && peaks->num_frames != clip->num_frames)
+    peaks = NULL;
+  double frames_per_px =
+    (double) AUDIO_ENGINE->frames_per_tick
+    / Z_RULER_WIDGET (EDITOR_RULER)->px_per_tick;
+  const AudioClipPeaksLevel * peaks_level =
+    peaks
+      ? audio_clip_peaks_get_level (peaks, frames_per_px * increment)
+      : NULL;
+  if (!clip->frames)
+    {
+      /* streamed clip without peaks yet */
+      if (!peaks)
+        return;
+
+      peaks_level = peaks_level ? peaks_level : &peaks->levels[0];
+    }
+
   /* draw audio part */
   GdkRGBA * color = &track->color;
   GdkRGBA   audio_lines_color = {
@@ -631,10 +709,20 @@ draw_audio_bg (ArrangerWidget * self, GtkSnapshot * snapshot, GdkRectangle * rec
         {
           for (unsigned int k = 0; k < clip->channels; k++)
             {
-              ch_min[k] =
-                dsp_min (&clip->ch_frames[k][from], (size_t) frames_to_check);
-              ch_max[k] =
-                dsp_max (&clip->ch_frames[k][from], (size_t) frames_to_check);
+              if (peaks_level)
+                {
+                  audio_clip_peaks_get_min_max (
+                    peaks_level, (channels_t) k, (unsigned_frame_t) from,
+                    (unsigned_frame_t) frames_to_check, &ch_min[k],
+                    &ch_max[k]);
+                }
+              else
+                {
+                  ch_min[k] = dsp_min (
+                    &clip->ch_frames[k][from], (size_t) frames_to_check);
+                  ch_max[k] = dsp_max (
+                    &clip->ch_frames[k][from], (size_t) frames_to_check);
+                }
 
               /* normalize */
               ch_min[k] = (ch_min[k] + 1.f) / 2.f;
@@ -1114,6 +1202,11 @@ arranger_snapshot (GtkWidget * widget, GtkSnapshot * snapshot)
       draw_arranger_object (self, obj, snapshot, &visible_rect_gdk);
     }
 
+  if (self->type == TYPE (TIMELINE))
+    {
+      free_offscreen_region_caches (self);
+    }
+
   /* draw dnd highlight */
   draw_highlight (self, snapshot, &visible_rect_gdk);
 
@@ -41,8 +41,8 @@ send_note_offs (ChordPadWidget * self)
 
       /* send note offs at time 1 */
       Port * port = track->processor->midi_in;
-      midi_events_add_note_offs_from_chord_descr (
-        port->midi_events, descr, 1, 1, F_QUEUED);
+      midi_events_add_external_note_offs_from_chord_descr (
+        port->midi_events, descr, 1, 1);
     }
 }
 
@@ -66,8 +66,8 @@ on_chord_click_pressed (
 
       /* send note ons at time 0 */
       Port * port = track->processor->midi_in;
-      midi_events_add_note_ons_from_chord_descr (
-        port->midi_events, descr, 1, VELOCITY_DEFAULT, 0, F_QUEUED);
+      midi_events_add_external_note_ons_from_chord_descr (
+        port->midi_events, descr, 1, VELOCITY_DEFAULT, 0);
     }
 }
 
@@ -491,6 +491,8 @@ init_export_info (ExportDialogWidget * self, Track * track)
 
       info->dither = gtk_switch_get_active (self->audio_dither_switch);
       g_settings_set_boolean (s, "dither", info->dither);
+
+      info->offline_block_length = exporter_get_offline_block_length ();
     }
 
   if (!is_audio)
@@ -566,7 +568,14 @@ progress_close_cb (ExportData * data)
 
   g_thread_join (data->thread);
 
-  if (data->export_stems)
+  if (data->export_stems && data->info->stems)
+    {
+      /* re-connect disconnected connections */
+      exporter_post_export (data->info, data->conns, data->state);
+
+      g_debug ("~ finished bouncing %u stems ~", data->info->stems->len);
+    }
+  else if (data->export_stems)
     {
       /* re-connect disconnected connections */
       exporter_post_export (data->info, data->conns, data->state);
@@ -636,7 +645,17 @@ progress_close_cb (ExportData * data)
       g_debug ("~ finished bouncing mixdown ~");
     }
 
-  ui_show_notification (_ ("Exported"));
+  if (data->info->realtime_factor > 0)
+    {
+      char * msg = g_strdup_printf (
+        _ ("Exported (%.1fx realtime)"), data->info->realtime_factor);
+      ui_show_notification (msg);
+      g_free (msg);
+    }
+  else
+    {
+      ui_show_notification (_ ("Exported"));
+    }
 
   update_text (self);
 }
@@ -677,7 +696,49 @@ on_export (ExportDialogWidget * self, bool audio)
 
   /* begin export */
 
-  if (export_stems)
+  if (export_stems && audio)
+    {
+      g_debug ("~ bouncing %u stems in a single pass ~", tracks->len);
+
+      /* render the timeline once and write the output of
+       * each track to its own file */
+      Track *          first_track = g_ptr_array_index (tracks, 0);
+      ExportSettings * info = init_export_info (self, first_track);
+      info->mode = EXPORT_MODE_FULL;
+      info->bounce_with_parents = false;
+      info->bounce_step = BOUNCE_STEP_POST_FADER;
+      info->stems =
+        g_ptr_array_new_with_free_func ((GDestroyNotify) export_stem_free);
+      for (guint i = 0; i < tracks->len; i++)
+        {
+          Track * track = g_ptr_array_index (tracks, i);
+          char *  file_uri = get_export_filename (self, true, track);
+          g_ptr_array_add (info->stems, export_stem_new (track, file_uri));
+          g_free (file_uri);
+        }
+      info->num_files = (int) tracks->len;
+
+      ExportData * data = export_data_new (GTK_WIDGET (self), info);
+      data->export_stems = true;
+      data->tracks = tracks;
+
+      /* unmark all tracks for bounce */
+      tracklist_mark_all_tracks_for_bounce (TRACKLIST, false);
+
+      data->conns = exporter_prepare_tracks_for_export (data->info, data->state);
+
+      /* start exporting in a new thread */
+      data->thread = g_thread_new (
+        "stem_export_thread", (GThreadFunc) exporter_generic_export_thread,
+        data->info);
+
+      /* create a progress dialog and show */
+      ExportProgressDialogWidget * progress_dialog =
+        export_progress_dialog_widget_new (
+          data, false, progress_close_cb, true, F_CANCELABLE);
+      adw_dialog_present (ADW_DIALOG (progress_dialog), GTK_WIDGET (self));
+    }
+  else if (export_stems)
     {
       /* export the first track for now */
       Track *          track = g_ptr_array_index (tracks, 0);
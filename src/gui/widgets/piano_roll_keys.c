@@ -303,18 +303,18 @@ send_note_event (PianoRollKeysWidget * self, int note, bool on)
   if (on)
     {
       /* add note on event */
-      midi_events_add_note_on (
+      midi_events_add_external_note_on (
         MANUAL_PRESS_EVENTS, midi_region_get_midi_ch (region),
-        (midi_byte_t) note, 90, 1, 1);
+        (midi_byte_t) note, 90, 1);
 
       piano_roll_add_current_note (PIANO_ROLL, note);
     }
   else
     {
       /* add note off event */
-      midi_events_add_note_off (
+      midi_events_add_external_note_off (
         MANUAL_PRESS_EVENTS, midi_region_get_midi_ch (region),
-        (midi_byte_t) note, 1, 1);
+        (midi_byte_t) note, 1);
 
       piano_roll_remove_current_note (PIANO_ROLL, note);
     }
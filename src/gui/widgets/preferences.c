@@ -4,6 +4,7 @@
 #include "zrythm-config.h"
 
 #include "dsp/engine.h"
+#include "dsp/graph.h"
 #include "gui/widgets/active_hardware_mb.h"
 #include "gui/widgets/file_chooser_entry.h"
 #include "gui/widgets/main_window.h"
@@ -545,6 +546,11 @@ make_control (
             "General", "Engine", "sample-rate", sample_rate_str);
           SET_STRV_IF_MATCH (
             "General", "Engine", "buffer-size", buffer_size_str);
+          SET_STRV_IF_MATCH (
+            "General", "Engine", "graph-scheduler", graph_scheduler_str);
+          SET_STRV_IF_MATCH (
+            "General", "Engine", "automation-resolution",
+            automation_resolution_str);
           SET_STRV_FROM_CYAML_IF_MATCH (
             "Editing", "Audio", "fade-algorithm", curve_algorithm_strings);
           SET_STRV_FROM_CYAML_IF_MATCH (
@@ -4,11 +4,13 @@
 #include "zrythm-config.h"
 
 #include <math.h>
+#include <string.h>
 
 #include "dsp/audio_bus_track.h"
 #include "dsp/audio_region.h"
 #include "dsp/automation_region.h"
 #include "dsp/channel.h"
+#include "dsp/clip_peaks.h"
 #include "dsp/fade.h"
 #include "dsp/instrument_track.h"
 #include "dsp/tempo_track.h"
@@ -78,34 +80,6 @@ recreate_pango_layouts (ZRegion * self, int width)
     pango_units_from_double (MAX (width - REGION_NAME_PADDING_R, 0)));
 }
 
-/**
- * Returns the last_*_full_rect and
- * last_*_draw_rect.
- *
- * @param[out] full_rect
- * @param[out] draw_rect
- */
-static void
-get_last_rects (
-  ZRegion *         self,
-  RegionCounterpart counterpart,
-  GdkRectangle *    full_rect,
-  GdkRectangle *    draw_rect)
-{
-  if (counterpart == REGION_COUNTERPART_MAIN)
-    {
-      *draw_rect = self->last_main_draw_rect;
-      *full_rect = self->last_main_full_rect;
-    }
-  else
-    {
-      *draw_rect = self->last_lane_draw_rect;
-      *full_rect = self->last_lane_full_rect;
-    }
-
-  g_return_if_fail ((*draw_rect).width < 40000);
-}
-
 /**
  * @param rect Arranger rectangle.
  * @param full_rect Object full rectangle.
@@ -664,15 +638,10 @@ handle_loop (
       const int line_width = 2;
       double    curve_width = fabs (x_end_in_region - x_start_in_region);
 
-      ArrangerWidget *     arranger = arranger_object_get_arranger (obj);
-      const EditorSettings settings =
-        arranger_widget_get_editor_setting_values (arranger);
-
-      /* rectangle where origin is the top left of the
-       * screen */
+      /* rectangle for the part to draw, where the region
+       * start is (0,0) */
       GdkRectangle vis_rect = Z_GDK_RECTANGLE_INIT (
-        settings.scroll_start_x - full_rect->x, -full_rect->y,
-        gtk_widget_get_width (GTK_WIDGET (arranger)), full_rect->height);
+        draw_rect->x - full_rect->x, 0, draw_rect->width, full_rect->height);
 
       /* rectangle for the loop part, where the region start
        * is (0,0) */
@@ -1029,7 +998,9 @@ draw_audio_part (
 {
   g_return_if_fail (vis_width < 40000);
 
+  /* streamed clips are drawn from their peaks */
   AudioClip * clip = audio_region_get_clip (self);
+  g_return_if_fail (clip);
 
   ArrangerObject * obj = (ArrangerObject *) self;
 
@@ -1073,6 +1044,22 @@ draw_audio_part (
     ui_detail_str[detail]);
 #endif
 
+  /* use the coarsest peaks that still have a peak per
+   * column, or the frames if zoomed in further */
+  const AudioClipPeaks * peaks = g_atomic_pointer_get (&clip->peaks);
+  if (peaks && peaks->num_frames != clip->num_frames)
+    peaks = NULL;
+  const AudioClipPeaksLevel * peaks_level =
+    peaks ? audio_clip_peaks_get_level (peaks, multiplier * increment) : NULL;
+  if (!clip->frames)
+    {
+      /* streamed clip without peaks yet */
+      if (!peaks)
+        return;
+
+      peaks_level = peaks_level ? peaks_level : &peaks->levels[0];
+    }
+
   signed_frame_t loop_end_frames = math_round_double_to_signed_frame_t (
     obj->loop_end_pos.ticks * frames_per_tick);
   signed_frame_t loop_frames = math_round_double_to_signed_frame_t (
@@ -1129,10 +1116,22 @@ draw_audio_part (
           size_t frames_to_check_unsigned = (size_t) frames_to_check;
           for (unsigned int k = 0; k < clip->channels; k++)
             {
-              ch_min[k] = dsp_min (
-                &clip->ch_frames[k][from], (size_t) frames_to_check_unsigned);
-              ch_max[k] = dsp_max (
-                &clip->ch_frames[k][from], (size_t) frames_to_check_unsigned);
+              if (peaks_level)
+                {
+                  audio_clip_peaks_get_min_max (
+                    peaks_level, (channels_t) k, (unsigned_frame_t) from,
+                    (unsigned_frame_t) frames_to_check, &ch_min[k],
+                    &ch_max[k]);
+                }
+              else
+                {
+                  ch_min[k] = dsp_min (
+                    &clip->ch_frames[k][from],
+                    (size_t) frames_to_check_unsigned);
+                  ch_max[k] = dsp_max (
+                    &clip->ch_frames[k][from],
+                    (size_t) frames_to_check_unsigned);
+                }
 
               /* normalize */
               ch_min[k] = (ch_min[k] + 1.f) / 2.f;
@@ -1353,6 +1352,152 @@ draw_bottom_right_part (
     }
 }
 
+/**
+ * Fills in what the drawing of the region's contents
+ * depends on.
+ */
+static void
+get_content_cache_key (
+  ZRegion *               self,
+  GdkRectangle *          full_rect,
+  RegionContentCacheKey * key)
+{
+  ArrangerObject * obj = (ArrangerObject *) self;
+
+  memset (key, 0, sizeof (RegionContentCacheKey));
+  key->version = self->content_version;
+  key->width = full_rect->width;
+  key->height = full_rect->height;
+  key->px_per_tick = MW_RULER->px_per_tick;
+  key->frames_per_tick = (double) AUDIO_ENGINE->frames_per_tick;
+  key->length = arranger_object_get_length_in_ticks (obj);
+  key->clip_start_pos = obj->clip_start_pos.ticks;
+  key->loop_start_pos = obj->loop_start_pos.ticks;
+  key->loop_end_pos = obj->loop_end_pos.ticks;
+
+  Track * track = arranger_object_get_track (obj);
+  key->grey_notes =
+    self->id.type == REGION_TYPE_MIDI && track
+    && color_is_very_very_bright (&track->color);
+
+  if (self->id.type == REGION_TYPE_AUDIO)
+    {
+      key->fade_in_pos = obj->fade_in_pos.ticks;
+      key->fade_out_pos = obj->fade_out_pos.ticks;
+      key->fade_in_opts = obj->fade_in_opts;
+      key->fade_out_opts = obj->fade_out_opts;
+      key->detail = ui_get_detail_level ();
+      AudioClip * clip = audio_region_get_clip (self);
+      key->clip = clip;
+      if (clip)
+        {
+          key->peaks = g_atomic_pointer_get (&clip->peaks);
+          key->num_frames = clip->num_frames;
+        }
+      key->last_clip_change = self->last_clip_change;
+      key->musical_mode = region_get_musical_mode (self);
+      if (key->musical_mode)
+        {
+          key->bpm = tempo_track_get_current_bpm (P_TEMPO_TRACK);
+        }
+      key->stretching = self->stretching;
+      key->hovered = arranger_object_is_hovered_or_start_object (obj, NULL);
+    }
+}
+
+/**
+ * Draws the notes, automation curves or waveform of the
+ * region in coordinates relative to the region.
+ *
+ * The drawing is cached in a render node covering the
+ * visible part plus a margin on each side, and is only
+ * redone when something it depends on changes or when
+ * the visible part scrolls out of it.
+ *
+ * @param full_rect Region rectangle with absolute
+ *   coordinates.
+ * @param draw_rect Visible part of the region with
+ *   absolute coordinates.
+ */
+static void
+draw_contents (
+  ZRegion *         self,
+  GtkSnapshot *     snapshot,
+  RegionCounterpart counterpart,
+  GdkRectangle *    full_rect,
+  GdkRectangle *    draw_rect)
+{
+  /* chord regions depend on the chord descriptors and are
+   * cheap to draw, so they are not cached */
+  if (self->id.type == REGION_TYPE_CHORD)
+    {
+      draw_chord_region (self, snapshot, full_rect, draw_rect);
+      return;
+    }
+
+  RegionContentCacheKey key;
+  get_content_cache_key (self, full_rect, &key);
+
+  int vis_x = draw_rect->x - full_rect->x;
+  int vis_width = draw_rect->width;
+
+  RegionContentCache * cache = self->content_caches[counterpart];
+  if (!cache)
+    {
+      cache = object_new (RegionContentCache);
+      self->content_caches[counterpart] = cache;
+    }
+
+  if (
+    cache->width == 0 || memcmp (&cache->key, &key, sizeof (key)) != 0
+    || vis_x < cache->x || vis_x + vis_width > cache->x + cache->width)
+    {
+      /* keep the drawn width under 40000 like the
+       * visible part */
+      int margin = MIN (vis_width / 2, (39999 - vis_width) / 2);
+      int start_x = MAX (vis_x - margin, 0);
+      int end_x = MIN (vis_x + vis_width + margin, full_rect->width);
+      GdkRectangle cache_rect = Z_GDK_RECTANGLE_INIT (
+        full_rect->x + start_x, full_rect->y, end_x - start_x,
+        full_rect->height);
+
+      GtkSnapshot * cache_snapshot = gtk_snapshot_new ();
+      switch (self->id.type)
+        {
+        case REGION_TYPE_MIDI:
+          draw_midi_region (self, cache_snapshot, full_rect, &cache_rect);
+          break;
+        case REGION_TYPE_AUTOMATION:
+          draw_automation_region (
+            self, cache_snapshot, full_rect, &cache_rect);
+          break;
+        case REGION_TYPE_AUDIO:
+          draw_audio_region (
+            self, cache_snapshot, full_rect, &cache_rect, false, 0,
+            cache_rect.width);
+          break;
+        default:
+          break;
+        }
+
+      object_free_w_func_and_null (gsk_render_node_unref, cache->node);
+      cache->node = gtk_snapshot_free_to_node (cache_snapshot);
+      cache->key = key;
+      cache->x = start_x;
+      cache->width = cache_rect.width;
+    }
+
+  if (!cache->node)
+    return;
+
+  graphene_rect_t vis_rect = GRAPHENE_RECT_INIT (
+    (float) vis_x, (float) (draw_rect->y - full_rect->y), (float) vis_width,
+    (float) draw_rect->height);
+  gtk_snapshot_push_clip (snapshot, &vis_rect);
+  gtk_snapshot_append_node (snapshot, cache->node);
+  gtk_snapshot_pop (snapshot);
+}
+
 /**
  * Draws the ZRegion in the given cairo context in
  * relative coordinates.
@@ -1390,7 +1535,6 @@ region_draw (ZRegion * self, GtkSnapshot * snapshot, GdkRectangle * rect)
     false, arranger_object_get_muted (obj, true) || track->frozen);
 
   GdkRectangle draw_rect;
-  GdkRectangle last_draw_rect, last_full_rect;
   GdkRectangle full_rect = obj->full_rect;
   for (int i = REGION_COUNTERPART_MAIN; i <= REGION_COUNTERPART_LANE; i++)
     {
@@ -1424,9 +1568,6 @@ region_draw (ZRegion * self, GtkSnapshot * snapshot, GdkRectangle * rect)
       /* get draw (visible only) rectangle */
       arranger_object_get_draw_rectangle (obj, rect, &full_rect, &draw_rect);
 
-      /* get last rects */
-      get_last_rects (self, i, &last_full_rect, &last_draw_rect);
-
       /* skip if draw rect has 0 width */
       if (draw_rect.width == 0)
         {
@@ -1461,26 +1602,9 @@ region_draw (ZRegion * self, GtkSnapshot * snapshot, GdkRectangle * rect)
         snapshot,
         &GRAPHENE_POINT_INIT ((float) full_rect.x, (float) full_rect.y));
 
-      /* draw any remaining parts */
-      switch (self->id.type)
-        {
-        case REGION_TYPE_MIDI:
-          draw_midi_region (self, snapshot, &full_rect, &draw_rect);
-          break;
-        case REGION_TYPE_AUTOMATION:
-          draw_automation_region (self, snapshot, &full_rect, &draw_rect);
-          break;
-        case REGION_TYPE_CHORD:
-          draw_chord_region (self, snapshot, &full_rect, &draw_rect);
-          break;
-        case REGION_TYPE_AUDIO:
-          draw_audio_region (
-            self, snapshot, &full_rect, &draw_rect, false,
-            (int) draw_rect.x - last_full_rect.x, (int) draw_rect.width);
-          break;
-        default:
-          break;
-        }
+      /* draw the notes/automation/waveform */
+      draw_contents (
+        self, snapshot, (RegionCounterpart) i, &full_rect, &draw_rect);
 
         /* ---- draw applicable icons ---- */
 
@@ -1574,6 +1698,24 @@ region_draw (ZRegion * self, GtkSnapshot * snapshot, GdkRectangle * rect)
   obj->use_cache = true;
 }
 
+/**
+ * Frees the cached drawings of the region's contents.
+ */
+void
+region_free_content_caches (ZRegion * self)
+{
+  for (int i = REGION_COUNTERPART_MAIN; i <= REGION_COUNTERPART_LANE; i++)
+    {
+      RegionContentCache * cache = self->content_caches[i];
+      if (!cache)
+        continue;
+
+      object_free_w_func_and_null (gsk_render_node_unref, cache->node);
+      object_zero_and_free (cache);
+      self->content_caches[i] = NULL;
+    }
+}
+
 /**
  * Returns the lane rectangle for the region.
  */
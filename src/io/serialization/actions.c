@@ -802,6 +802,16 @@ arranger_selections_action_deserialize_from_json (
   yyjson_val * midi_note_r2_arr = yyjson_obj_iter_get (&it, "midiNoteR2");
   action->num_split_objs =
     MAX (yyjson_arr_size (region_r1_arr), yyjson_arr_size (midi_note_r1_arr));
+  if (action->num_split_objs > 0)
+    {
+      size_t num_split_objs = (size_t) action->num_split_objs;
+      action->r1 = object_new_n (num_split_objs, ArrangerObject *);
+      action->r2 = object_new_n (num_split_objs, ArrangerObject *);
+      action->region_r1 = object_new_n (num_split_objs, ZRegion *);
+      action->region_r2 = object_new_n (num_split_objs, ZRegion *);
+      action->mn_r1 = object_new_n (num_split_objs, MidiNote *);
+      action->mn_r2 = object_new_n (num_split_objs, MidiNote *);
+    }
   size_t          count = 0;
   yyjson_arr_iter region_r1_iter = yyjson_arr_iter_with (region_r1_arr);
   yyjson_val *    region_r1_obj = NULL;
@@ -1351,3 +1361,95 @@ chord_action_deserialize_from_json (
     }
   return true;
 }
+
+bool
+undoable_action_serialize_typed_to_json (
+  yyjson_mut_doc *       doc,
+  yyjson_mut_val *       action_obj,
+  const UndoableAction * action,
+  GError **              error)
+{
+  /* uppercase, snake case, camel case */
+#define SERIALIZE(uc, sc, cc) \
+  case UA_##uc: \
+    return sc##_action_serialize_to_json ( \
+      doc, action_obj, (const cc##Action *) action, error);
+
+  switch (action->type)
+    {
+      SERIALIZE (
+        TRACKLIST_SELECTIONS, tracklist_selections, TracklistSelections);
+      SERIALIZE (CHANNEL_SEND, channel_send, ChannelSend);
+      SERIALIZE (MIXER_SELECTIONS, mixer_selections, MixerSelections);
+      SERIALIZE (ARRANGER_SELECTIONS, arranger_selections, ArrangerSelections);
+      SERIALIZE (MIDI_MAPPING, midi_mapping, MidiMapping);
+      SERIALIZE (PORT_CONNECTION, port_connection, PortConnection);
+      SERIALIZE (PORT, port, Port);
+      SERIALIZE (RANGE, range, Range);
+      SERIALIZE (TRANSPORT, transport, Transport);
+      SERIALIZE (CHORD, chord, Chord);
+    default:
+      break;
+    }
+
+#undef SERIALIZE
+
+  g_set_error (
+    error, Z_IO_SERIALIZATION_ACTIONS_ERROR,
+    Z_IO_SERIALIZATION_ACTIONS_ERROR_FAILED, "Unknown action type %d",
+    action->type);
+  return false;
+}
+
+UndoableAction *
+undoable_action_deserialize_typed_from_json (
+  yyjson_doc * doc,
+  yyjson_val * action_obj,
+  GError **    error)
+{
+  yyjson_obj_iter it = yyjson_obj_iter_with (action_obj);
+  yyjson_val *    base_obj = yyjson_obj_iter_get (&it, "base");
+  if (!base_obj)
+    {
+      g_set_error_literal (
+        error, Z_IO_SERIALIZATION_ACTIONS_ERROR,
+        Z_IO_SERIALIZATION_ACTIONS_ERROR_FAILED, "Action has no base");
+      return NULL;
+    }
+  UndoableActionType type =
+    (UndoableActionType) yyjson_get_int (yyjson_obj_get (base_obj, "type"));
+
+  /* uppercase, snake case, camel case */
+#define DESERIALIZE(uc, sc, cc) \
+  case UA_##uc: \
+    { \
+      cc##Action * action = object_new (cc##Action); \
+      sc##_action_deserialize_from_json (doc, action_obj, action, error); \
+      return (UndoableAction *) action; \
+    }
+
+  switch (type)
+    {
+      DESERIALIZE (
+        TRACKLIST_SELECTIONS, tracklist_selections, TracklistSelections);
+      DESERIALIZE (CHANNEL_SEND, channel_send, ChannelSend);
+      DESERIALIZE (MIXER_SELECTIONS, mixer_selections, MixerSelections);
+      DESERIALIZE (
+        ARRANGER_SELECTIONS, arranger_selections, ArrangerSelections);
+      DESERIALIZE (MIDI_MAPPING, midi_mapping, MidiMapping);
+      DESERIALIZE (PORT_CONNECTION, port_connection, PortConnection);
+      DESERIALIZE (PORT, port, Port);
+      DESERIALIZE (RANGE, range, Range);
+      DESERIALIZE (TRANSPORT, transport, Transport);
+      DESERIALIZE (CHORD, chord, Chord);
+    default:
+      break;
+    }
+
+#undef DESERIALIZE
+
+  g_set_error (
+    error, Z_IO_SERIALIZATION_ACTIONS_ERROR,
+    Z_IO_SERIALIZATION_ACTIONS_ERROR_FAILED, "Unknown action type %d", type);
+  return NULL;
+}
@@ -11,6 +11,8 @@
 #include "io/serialization/selections.h"
 #include "io/serialization/track.h"
 #include "project.h"
+#include "utils/error.h"
+#include "utils/flags.h"
 #include "utils/objects.h"
 
 #include <yyjson.h>
@@ -349,13 +351,145 @@ midi_mappings_deserialize_from_json (
   return true;
 }
 
+typedef bool (*DeserializeFunc) (
+  yyjson_doc * doc,
+  yyjson_val * obj,
+  void *       dest,
+  GError **    error);
+
+/**
+ * An independent part of the project (eg, a track) to be
+ * deserialized on a worker thread.
+ */
+typedef struct DeserializationJob
+{
+  yyjson_doc *    doc;
+  yyjson_val *    obj;
+  void *          dest;
+  DeserializeFunc func;
+
+  /** To be set after deserializing. */
+  bool     successful;
+  GError * error;
+} DeserializationJob;
+
+static void
+add_deserialization_job (
+  GPtrArray *     jobs,
+  yyjson_doc *    doc,
+  yyjson_val *    obj,
+  void *          dest,
+  DeserializeFunc func)
+{
+  DeserializationJob * job = object_new (DeserializationJob);
+  job->doc = doc;
+  job->obj = obj;
+  job->dest = dest;
+  job->func = func;
+  g_ptr_array_add (jobs, job);
+}
+
+static void
+deserialization_job_free (void * data)
+{
+  DeserializationJob * self = (DeserializationJob *) data;
+  if (self->error)
+    g_error_free (self->error);
+  object_zero_and_free (self);
+}
+
+/**
+ * To be used as a GFunc for the thread pool.
+ */
+static void
+deserialization_job_thread (void * data, void * user_data)
+{
+  DeserializationJob * job = (DeserializationJob *) data;
+  job->successful = job->func (job->doc, job->obj, job->dest, &job->error);
+}
+
+/**
+ * Runs the jobs in a thread pool and waits for them to
+ * finish.
+ *
+ * The objects only read from the (immutable) document and
+ * write to their own destination, so they can be parsed
+ * in any order.
+ *
+ * If more than one job fails, the error of the first one
+ * is returned.
+ */
+static bool
+run_deserialization_jobs (GPtrArray * jobs, GError ** error)
+{
+  if (jobs->len == 0)
+    return true;
+
+  GError *      err = NULL;
+  GThreadPool * thread_pool = g_thread_pool_new (
+    deserialization_job_thread, NULL,
+    (int) MIN ((guint) g_get_num_processors (), jobs->len), F_NOT_EXCLUSIVE,
+    &err);
+  if (thread_pool)
+    {
+      for (guint i = 0; i < jobs->len; i++)
+        {
+          g_thread_pool_push (thread_pool, g_ptr_array_index (jobs, i), NULL);
+        }
+
+      /* wait for all jobs to finish */
+      g_thread_pool_free (thread_pool, false, true);
+    }
+  else
+    {
+      g_warning (
+        "Failed to create thread pool, deserializing on this thread: %s",
+        err->message);
+      g_error_free (err);
+      for (guint i = 0; i < jobs->len; i++)
+        {
+          deserialization_job_thread (g_ptr_array_index (jobs, i), NULL);
+        }
+    }
+
+  for (guint i = 0; i < jobs->len; i++)
+    {
+      DeserializationJob * job = g_ptr_array_index (jobs, i);
+      if (!job->successful)
+        {
+          if (job->error)
+            {
+              g_propagate_error (error, job->error);
+              job->error = NULL;
+            }
+          else
+            {
+              g_set_error_literal (
+                error, Z_IO_SERIALIZATION_PROJECT_ERROR,
+                Z_IO_SERIALIZATION_PROJECT_ERROR_FAILED,
+                "Failed to deserialize project");
+            }
+          return false;
+        }
+    }
+
+  return true;
+}
+
 static bool
 undo_stack_deserialize_from_json (
   yyjson_doc * doc,
   yyjson_val * stack_obj,
   UndoStack *  stack,
+  GPtrArray *  jobs,
   GError **    error)
 {
+  /* the actions are parsed later in parallel */
+#define ADD_ACTION_JOB(sc) \
+  add_deserialization_job ( \
+    jobs, doc, action_obj, action, \
+    (DeserializeFunc) sc##_deserialize_from_json)
+
   yyjson_obj_iter it = yyjson_obj_iter_with (stack_obj);
   yyjson_val *    as_actions_arr =
     yyjson_obj_iter_get (&it, "arrangerSelectionsActions");
@@ -373,8 +507,7 @@ undo_stack_deserialize_from_json (
               ArrangerSelectionsAction * action =
                 object_new (ArrangerSelectionsAction);
               stack->as_actions[stack->num_as_actions++] = action;
-              arranger_selections_action_deserialize_from_json (
-                doc, action_obj, action, error);
+              ADD_ACTION_JOB (arranger_selections_action);
             }
         }
     }
@@ -399,8 +532,7 @@ undo_stack_deserialize_from_json (
                 object_new (MixerSelectionsAction);
               stack->mixer_selections_actions
                 [stack->num_mixer_selections_actions++] = action;
-              mixer_selections_action_deserialize_from_json (
-                doc, action_obj, action, error);
+              ADD_ACTION_JOB (mixer_selections_action);
             }
         }
     }
@@ -425,8 +557,7 @@ undo_stack_deserialize_from_json (
                 object_new (TracklistSelectionsAction);
               stack->tracklist_selections_actions
                 [stack->num_tracklist_selections_actions++] = action;
-              tracklist_selections_action_deserialize_from_json (
-                doc, action_obj, action, error);
+              ADD_ACTION_JOB (tracklist_selections_action);
             }
         }
     }
@@ -448,8 +579,7 @@ undo_stack_deserialize_from_json (
               ChannelSendAction * action = object_new (ChannelSendAction);
               stack->channel_send_actions[stack->num_channel_send_actions++] =
                 action;
-              channel_send_action_deserialize_from_json (
-                doc, action_obj, action, error);
+              ADD_ACTION_JOB (channel_send_action);
             }
         }
     }
@@ -473,8 +603,7 @@ undo_stack_deserialize_from_json (
               PortConnectionAction * action = object_new (PortConnectionAction);
               stack->port_connection_actions
                 [stack->num_port_connection_actions++] = action;
-              port_connection_action_deserialize_from_json (
-                doc, action_obj, action, error);
+              ADD_ACTION_JOB (port_connection_action);
             }
         }
     }
@@ -493,7 +622,7 @@ undo_stack_deserialize_from_json (
             {
               PortAction * action = object_new (PortAction);
               stack->port_actions[stack->num_port_actions++] = action;
-              port_action_deserialize_from_json (doc, action_obj, action, error);
+              ADD_ACTION_JOB (port_action);
             }
         }
     }
@@ -515,8 +644,7 @@ undo_stack_deserialize_from_json (
               MidiMappingAction * action = object_new (MidiMappingAction);
               stack->midi_mapping_actions[stack->num_midi_mapping_actions++] =
                 action;
-              midi_mapping_action_deserialize_from_json (
-                doc, action_obj, action, error);
+              ADD_ACTION_JOB (midi_mapping_action);
             }
         }
     }
@@ -535,8 +663,7 @@ undo_stack_deserialize_from_json (
             {
               RangeAction * action = object_new (RangeAction);
               stack->range_actions[stack->num_range_actions++] = action;
-              range_action_deserialize_from_json (
-                doc, action_obj, action, error);
+              ADD_ACTION_JOB (range_action);
             }
         }
     }
@@ -556,8 +683,7 @@ undo_stack_deserialize_from_json (
             {
               TransportAction * action = object_new (TransportAction);
               stack->transport_actions[stack->num_transport_actions++] = action;
-              transport_action_deserialize_from_json (
-                doc, action_obj, action, error);
+              ADD_ACTION_JOB (transport_action);
             }
         }
     }
@@ -576,14 +702,16 @@ undo_stack_deserialize_from_json (
             {
               ChordAction * action = object_new (ChordAction);
               stack->chord_actions[stack->num_chord_actions++] = action;
-              chord_action_deserialize_from_json (
-                doc, action_obj, action, error);
+              ADD_ACTION_JOB (chord_action);
             }
         }
     }
   yyjson_val * s_obj = yyjson_obj_iter_get (&it, "stack");
   stack->stack = object_new (Stack);
   stack_deserialize_from_json (doc, s_obj, stack->stack, error);
+
+#undef ADD_ACTION_JOB
+
   return true;
 }
 
@@ -592,141 +720,234 @@ undo_manager_deserialize_from_json (
   yyjson_doc *  doc,
   yyjson_val *  um_obj,
   UndoManager * um,
+  GPtrArray *   jobs,
   GError **     error)
 {
   yyjson_obj_iter it = yyjson_obj_iter_with (um_obj);
   yyjson_val *    undo_stack_obj = yyjson_obj_iter_get (&it, "undoStack");
   um->undo_stack = object_new (UndoStack);
-  undo_stack_deserialize_from_json (doc, undo_stack_obj, um->undo_stack, error);
+  undo_stack_deserialize_from_json (
+    doc, undo_stack_obj, um->undo_stack, jobs, error);
   yyjson_val * redo_stack_obj = yyjson_obj_iter_get (&it, "redoStack");
   um->redo_stack = object_new (UndoStack);
-  undo_stack_deserialize_from_json (doc, redo_stack_obj, um->redo_stack, error);
+  undo_stack_deserialize_from_json (
+    doc, redo_stack_obj, um->redo_stack, jobs, error);
   return true;
 }
 
-char *
-project_serialize_to_json_str (const Project * prj, GError ** error)
+/**
+ * Writes "key":value, preceded by a comma unless @p first.
+ *
+ * Nothing is written if @p val is NULL.
+ */
+static bool
+write_member (
+  const char *                      key,
+  yyjson_mut_val *                  val,
+  bool                              first,
+  ProjectSerializationChunkCallback cb,
+  void *                            user_data,
+  GError **                         error)
 {
-  /* create a mutable doc */
-  yyjson_mut_doc * doc = yyjson_mut_doc_new (NULL);
-  yyjson_mut_val * root = yyjson_mut_obj (doc);
-  if (!root)
+  if (!val)
+    return true;
+
+  size_t len;
+  char * json = yyjson_mut_val_write (val, YYJSON_WRITE_NOFLAG, &len);
+  if (!json)
     {
-      g_set_error_literal (
+      g_set_error (
         error, Z_IO_SERIALIZATION_PROJECT_ERROR,
-        Z_IO_SERIALIZATION_PROJECT_ERROR_FAILED, "Failed to create root obj");
-      return NULL;
+        Z_IO_SERIALIZATION_PROJECT_ERROR_FAILED, "Failed to write %s", key);
+      return false;
     }
-  yyjson_mut_doc_set_root (doc, root);
+  char * prefix = g_strdup_printf ("%s\"%s\":", first ? "" : ",", key);
+  bool   ret = cb (prefix, strlen (prefix), user_data, error)
+             && cb (json, len, user_data, error);
+  g_free (prefix);
+  free (json);
+
+  return ret;
+}
 
-  yyjson_mut_obj_add_str (doc, root, "type", "ZrythmProject");
-  yyjson_mut_obj_add_int (doc, root, "formatMajor", PROJECT_FORMAT_MAJOR);
-  yyjson_mut_obj_add_int (doc, root, "formatMinor", PROJECT_FORMAT_MINOR);
+/**
+ * Serializes a member of the project into its own document
+ * and writes it.
+ */
+#define WRITE_SECTION(key, serialize_func, ptr) \
+  G_STMT_START \
+  { \
+    yyjson_mut_doc * section_doc = yyjson_mut_doc_new (NULL); \
+    yyjson_mut_val * section_obj = yyjson_mut_obj (section_doc); \
+    serialize_func (section_doc, section_obj, ptr, error); \
+    bool written = \
+      write_member (key, section_obj, false, cb, user_data, error); \
+    yyjson_mut_doc_free (section_doc); \
+    if (!written) \
+      return false; \
+  } \
+  G_STMT_END
 
-  yyjson_mut_obj_add_str (doc, root, "title", prj->title);
-  yyjson_mut_obj_add_str (doc, root, "datetime", prj->datetime_str);
-  yyjson_mut_obj_add_str (doc, root, "version", prj->version);
+#define WRITE_STR(str) \
+  G_STMT_START \
+  { \
+    if (!cb (str, strlen (str), user_data, error)) \
+      return false; \
+  } \
+  G_STMT_END
 
-  /* tracklist */
-  Tracklist *      tracklist = prj->tracklist;
-  yyjson_mut_val * tracklist_obj =
-    yyjson_mut_obj_add_obj (doc, root, "tracklist");
-  yyjson_mut_obj_add_int (
-    doc, tracklist_obj, "pinnedTracksCutoff", tracklist->pinned_tracks_cutoff);
-  yyjson_mut_val * tracks_arr =
-    yyjson_mut_obj_add_arr (doc, tracklist_obj, "tracks");
+bool
+project_serialize_to_json_chunks (
+  const Project *                   prj,
+  bool                              with_undo_history,
+  ProjectSerializationChunkCallback cb,
+  void *                            user_data,
+  GError **                         error)
+{
+  /* header */
+  yyjson_mut_doc * doc = yyjson_mut_doc_new (NULL);
+  WRITE_STR ("{");
+  bool written =
+    write_member (
+      "type", yyjson_mut_str (doc, "ZrythmProject"), true, cb, user_data,
+      error)
+    && write_member (
+      "formatMajor", yyjson_mut_int (doc, PROJECT_FORMAT_MAJOR), false, cb,
+      user_data, error)
+    && write_member (
+      "formatMinor", yyjson_mut_int (doc, PROJECT_FORMAT_MINOR), false, cb,
+      user_data, error)
+    && write_member (
+      "title", yyjson_mut_str (doc, prj->title), false, cb, user_data, error)
+    && write_member (
+      "datetime", yyjson_mut_str (doc, prj->datetime_str), false, cb,
+      user_data, error)
+    && write_member (
+      "version", yyjson_mut_str (doc, prj->version), false, cb, user_data,
+      error);
+  yyjson_mut_doc_free (doc);
+  if (!written)
+    return false;
+
+  /* tracklist, one track at a time */
+  Tracklist * tracklist = prj->tracklist;
+  char *      tracklist_header = g_strdup_printf (
+    ",\"tracklist\":{\"pinnedTracksCutoff\":%d,\"tracks\":[",
+    tracklist->pinned_tracks_cutoff);
+  written = cb (tracklist_header, strlen (tracklist_header), user_data, error);
+  g_free (tracklist_header);
+  if (!written)
+    return false;
   for (int i = 0; i < tracklist->num_tracks; i++)
     {
-      Track *          track = tracklist->tracks[i];
-      yyjson_mut_val * track_obj = yyjson_mut_arr_add_obj (doc, tracks_arr);
+      Track * track = tracklist->tracks[i];
+      doc = yyjson_mut_doc_new (NULL);
+      yyjson_mut_val * track_obj = yyjson_mut_obj (doc);
       track_serialize_to_json (doc, track_obj, track, error);
+      size_t len;
+      char * json = yyjson_mut_val_write (track_obj, YYJSON_WRITE_NOFLAG, &len);
+      yyjson_mut_doc_free (doc);
+      if (!json)
+        {
+          g_set_error (
+            error, Z_IO_SERIALIZATION_PROJECT_ERROR,
+            Z_IO_SERIALIZATION_PROJECT_ERROR_FAILED,
+            "Failed to write track %s", track->name);
+          return false;
+        }
+      written = (i == 0 || cb (",", 1, user_data, error))
+                && cb (json, len, user_data, error);
+      free (json);
+      if (!written)
+        return false;
     }
-  yyjson_mut_val * clip_editor_obj =
-    yyjson_mut_obj_add_obj (doc, root, "clipEditor");
-  clip_editor_serialize_to_json (doc, clip_editor_obj, prj->clip_editor, error);
-  yyjson_mut_val * timeline_obj = yyjson_mut_obj_add_obj (doc, root, "timeline");
-  timeline_serialize_to_json (doc, timeline_obj, prj->timeline, error);
-  yyjson_mut_val * snap_grid_tl_obj =
-    yyjson_mut_obj_add_obj (doc, root, "snapGridTimeline");
-  snap_grid_serialize_to_json (
-    doc, snap_grid_tl_obj, prj->snap_grid_timeline, error);
-  yyjson_mut_val * snap_grid_editor_obj =
-    yyjson_mut_obj_add_obj (doc, root, "snapGridEditor");
-  snap_grid_serialize_to_json (
-    doc, snap_grid_editor_obj, prj->snap_grid_editor, error);
-  yyjson_mut_val * quantize_options_tl_obj =
-    yyjson_mut_obj_add_obj (doc, root, "quantizeOptsTimeline");
-  quantize_options_serialize_to_json (
-    doc, quantize_options_tl_obj, prj->quantize_opts_timeline, error);
-  yyjson_mut_val * quantize_options_editor_obj =
-    yyjson_mut_obj_add_obj (doc, root, "quantizeOptsEditor");
-  quantize_options_serialize_to_json (
-    doc, quantize_options_editor_obj, prj->quantize_opts_editor, error);
-  yyjson_mut_val * audio_engine_obj =
-    yyjson_mut_obj_add_obj (doc, root, "audioEngine");
-  audio_engine_serialize_to_json (
-    doc, audio_engine_obj, prj->audio_engine, error);
-  yyjson_mut_val * mixer_selections_obj =
-    yyjson_mut_obj_add_obj (doc, root, "mixerSelections");
-  mixer_selections_serialize_to_json (
-    doc, mixer_selections_obj, prj->mixer_selections, error);
-  yyjson_mut_val * timeline_selections_obj =
-    yyjson_mut_obj_add_obj (doc, root, "timelineSelections");
-  timeline_selections_serialize_to_json (
-    doc, timeline_selections_obj, prj->timeline_selections, error);
-  yyjson_mut_val * midi_arranger_selections_obj =
-    yyjson_mut_obj_add_obj (doc, root, "midiArrangerSelections");
-  midi_arranger_selections_serialize_to_json (
-    doc, midi_arranger_selections_obj, prj->midi_arranger_selections, error);
-  yyjson_mut_val * chord_selections_obj =
-    yyjson_mut_obj_add_obj (doc, root, "chordSelections");
-  chord_selections_serialize_to_json (
-    doc, chord_selections_obj, prj->chord_selections, error);
-  yyjson_mut_val * automation_selections_obj =
-    yyjson_mut_obj_add_obj (doc, root, "automationSelections");
-  automation_selections_serialize_to_json (
-    doc, automation_selections_obj, prj->automation_selections, error);
-  yyjson_mut_val * audio_selections_obj =
-    yyjson_mut_obj_add_obj (doc, root, "audioSelections");
-  audio_selections_serialize_to_json (
-    doc, audio_selections_obj, prj->audio_selections, error);
-  yyjson_mut_val * tracklist_selections_obj =
-    yyjson_mut_obj_add_obj (doc, root, "tracklistSelections");
-  tracklist_selections_serialize_to_json (
-    doc, tracklist_selections_obj, prj->tracklist_selections, error);
-  yyjson_mut_val * region_link_group_mgr_obj =
-    yyjson_mut_obj_add_obj (doc, root, "regionLinkGroupManager");
-  region_link_group_manager_serialize_to_json (
-    doc, region_link_group_mgr_obj, prj->region_link_group_manager, error);
-  yyjson_mut_val * port_connections_mgr_obj =
-    yyjson_mut_obj_add_obj (doc, root, "portConnectionsManager");
-  port_connections_manager_serialize_to_json (
-    doc, port_connections_mgr_obj, prj->port_connections_manager, error);
-  yyjson_mut_val * midi_mappings_obj =
-    yyjson_mut_obj_add_obj (doc, root, "midiMappings");
-  midi_mappings_serialize_to_json (
-    doc, midi_mappings_obj, prj->midi_mappings, error);
-  if (prj->undo_manager)
-    {
-      yyjson_mut_val * undo_manager_obj =
-        yyjson_mut_obj_add_obj (doc, root, "undoManager");
-      undo_manager_serialize_to_json (
-        doc, undo_manager_obj, prj->undo_manager, error);
-    }
-  yyjson_mut_obj_add_int (doc, root, "lastSelection", prj->last_selection);
-
-  /* to string - minified */
-  char * json = yyjson_mut_write (
-    doc, YYJSON_WRITE_NOFLAG /* YYJSON_WRITE_PRETTY_TWO_SPACES */, NULL);
-  g_message ("done writing json to string");
-  if (json)
+  WRITE_STR ("]}");
+
+  WRITE_SECTION ("clipEditor", clip_editor_serialize_to_json, prj->clip_editor);
+  WRITE_SECTION ("timeline", timeline_serialize_to_json, prj->timeline);
+  WRITE_SECTION (
+    "snapGridTimeline", snap_grid_serialize_to_json, prj->snap_grid_timeline);
+  WRITE_SECTION (
+    "snapGridEditor", snap_grid_serialize_to_json, prj->snap_grid_editor);
+  WRITE_SECTION (
+    "quantizeOptsTimeline", quantize_options_serialize_to_json,
+    prj->quantize_opts_timeline);
+  WRITE_SECTION (
+    "quantizeOptsEditor", quantize_options_serialize_to_json,
+    prj->quantize_opts_editor);
+  WRITE_SECTION (
+    "audioEngine", audio_engine_serialize_to_json, prj->audio_engine);
+  WRITE_SECTION (
+    "mixerSelections", mixer_selections_serialize_to_json,
+    prj->mixer_selections);
+  WRITE_SECTION (
+    "timelineSelections", timeline_selections_serialize_to_json,
+    prj->timeline_selections);
+  WRITE_SECTION (
+    "midiArrangerSelections", midi_arranger_selections_serialize_to_json,
+    prj->midi_arranger_selections);
+  WRITE_SECTION (
+    "chordSelections", chord_selections_serialize_to_json,
+    prj->chord_selections);
+  WRITE_SECTION (
+    "automationSelections", automation_selections_serialize_to_json,
+    prj->automation_selections);
+  WRITE_SECTION (
+    "audioSelections", audio_selections_serialize_to_json,
+    prj->audio_selections);
+  WRITE_SECTION (
+    "tracklistSelections", tracklist_selections_serialize_to_json,
+    prj->tracklist_selections);
+  WRITE_SECTION (
+    "regionLinkGroupManager", region_link_group_manager_serialize_to_json,
+    prj->region_link_group_manager);
+  WRITE_SECTION (
+    "portConnectionsManager", port_connections_manager_serialize_to_json,
+    prj->port_connections_manager);
+  WRITE_SECTION (
+    "midiMappings", midi_mappings_serialize_to_json, prj->midi_mappings);
+  if (with_undo_history && prj->undo_manager)
     {
-      /*g_message ("json: %s\n", json);*/
+      WRITE_SECTION (
+        "undoManager", undo_manager_serialize_to_json, prj->undo_manager);
     }
 
-  yyjson_mut_doc_free (doc);
+  char * footer =
+    g_strdup_printf (",\"lastSelection\":%d}", (int) prj->last_selection);
+  written = cb (footer, strlen (footer), user_data, error);
+  g_free (footer);
 
-  return json;
+  return written;
+}
+
+#undef WRITE_SECTION
+#undef WRITE_STR
+
+static bool
+append_chunk (
+  const char * chunk,
+  size_t       size,
+  void *       user_data,
+  GError **    error)
+{
+  g_string_append_len ((GString *) user_data, chunk, (gssize) size);
+  return true;
+}
+
+char *
+project_serialize_to_json_str (const Project * prj, GError ** error)
+{
+  GString * str = g_string_new (NULL);
+  bool      success = project_serialize_to_json_chunks (
+    prj, true, append_chunk, str, error);
+  if (!success)
+    {
+      g_string_free (str, true);
+      return NULL;
+    }
+  g_message ("done writing json to string");
+
+  return g_string_free (str, false);
 }
 
 static bool
@@ -734,6 +955,7 @@ tracklist_deserialize_from_json (
   yyjson_doc * doc,
   yyjson_val * tracklist_obj,
   Tracklist *  tracklist,
+  GPtrArray *  jobs,
   GError **    error)
 {
   yyjson_obj_iter it = yyjson_obj_iter_with (tracklist_obj);
@@ -746,7 +968,9 @@ tracklist_deserialize_from_json (
     {
       Track * track = object_new (Track);
       tracklist->tracks[tracklist->num_tracks++] = track;
-      track_deserialize_from_json (doc, track_obj, track, error);
+      add_deserialization_job (
+        jobs, doc, track_obj, track,
+        (DeserializeFunc) track_deserialize_from_json);
     }
   return true;
 }
@@ -783,9 +1007,14 @@ project_deserialize_from_json_str (const char * json, GError ** error)
     g_strdup (yyjson_get_str (yyjson_obj_iter_get (&it, "datetime")));
   self->version =
     g_strdup (yyjson_get_str (yyjson_obj_iter_get (&it, "version")));
+  /* tracks and undoable actions are independent of each
+   * other and make up most of the project, so they are
+   * parsed in parallel after the rest */
+  GPtrArray * jobs = g_ptr_array_new_with_free_func (deserialization_job_free);
+
   self->tracklist = object_new (Tracklist);
   tracklist_deserialize_from_json (
-    doc, yyjson_obj_iter_get (&it, "tracklist"), self->tracklist, error);
+    doc, yyjson_obj_iter_get (&it, "tracklist"), self->tracklist, jobs, error);
   yyjson_val * clip_editor_obj = yyjson_obj_iter_get (&it, "clipEditor");
   self->clip_editor = object_new (ClipEditor);
   clip_editor_deserialize_from_json (
@@ -896,13 +1125,23 @@ project_deserialize_from_json_str (const char * json, GError ** error)
         {
           self->undo_manager = object_new (UndoManager);
           undo_manager_deserialize_from_json (
-            doc, undo_manager_obj, self->undo_manager, error);
+            doc, undo_manager_obj, self->undo_manager, jobs, error);
         }
     }
   self->last_selection =
     (SelectionType) yyjson_get_int (yyjson_obj_iter_get (&it, "lastSelection"));
 
+  GError * err = NULL;
+  bool     success = run_deserialization_jobs (jobs, &err);
+  g_ptr_array_unref (jobs);
   yyjson_doc_free (doc);
+  if (!success)
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, "Failed to deserialize project");
+      project_free (self);
+      return NULL;
+    }
 
   return self;
 }
@@ -1,6 +1,8 @@
-// SPDX-FileCopyrightText: © 2020-2023 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-FileCopyrightText: © 2020-2024 Alexandros Theodotou <alex@zrythm.org>
 // SPDX-License-Identifier: LicenseRef-ZrythmLicense
 
+#include <string.h>
+
 #include "plugins/cached_plugin_descriptors.h"
 #include "utils/error.h"
 #include "utils/file.h"
@@ -9,7 +11,23 @@
 #include "utils/string.h"
 #include "zrythm.h"
 
-#include <glib/gi18n.h>
+#include <glib/gstdio.h>
+
+G_STATIC_ASSERT (sizeof (CachedPluginDescriptorsHeader) % 8 == 0);
+G_STATIC_ASSERT (sizeof (CachedPluginDescriptorRecord) % 8 == 0);
+
+typedef enum
+{
+  Z_PLUGINS_CACHED_PLUGIN_DESCRIPTORS_ERROR_FAILED,
+} ZPluginsCachedPluginDescriptorsError;
+
+#define Z_PLUGINS_CACHED_PLUGIN_DESCRIPTORS_ERROR \
+  z_plugins_cached_plugin_descriptors_error_quark ()
+GQuark
+z_plugins_cached_plugin_descriptors_error_quark (void);
+G_DEFINE_QUARK (
+  z - plugins - cached - plugin - descriptors - error - quark,
+  z_plugins_cached_plugin_descriptors_error)
 
 static char *
 get_cached_plugin_descriptors_file_path (void)
@@ -17,132 +35,574 @@ get_cached_plugin_descriptors_file_path (void)
   char * zrythm_dir = zrythm_get_dir (ZRYTHM_DIR_USER_TOP);
   g_return_val_if_fail (zrythm_dir, NULL);
 
-  return g_build_filename (zrythm_dir, "cached_plugin_descriptors.yaml", NULL);
+  char * path =
+    g_build_filename (zrythm_dir, "cached_plugin_descriptors.bin", NULL);
+  g_free (zrythm_dir);
+  return path;
 }
 
-void
-cached_plugin_descriptors_serialize_to_file (CachedPluginDescriptors * self)
+/**
+ * Removes the YAML cache used by older versions.
+ */
+static void
+remove_legacy_file (void)
 {
-  g_message ("Serializing cached plugin descriptors...");
-  GError * err = NULL;
-  char * yaml = yaml_serialize (self, &cached_plugin_descriptors_schema, &err);
-  if (!yaml)
+  char * zrythm_dir = zrythm_get_dir (ZRYTHM_DIR_USER_TOP);
+  g_return_if_fail (zrythm_dir);
+
+  char * path =
+    g_build_filename (zrythm_dir, "cached_plugin_descriptors.yaml", NULL);
+  if (file_exists (path))
     {
-      HANDLE_ERROR_LITERAL (
-        err, _ ("Failed to serialize cached plugin descriptors"));
-      return;
+      g_message ("Removing old plugin descriptor cache %s", path);
+      io_remove (path);
     }
-  err = NULL;
-  char * path = get_cached_plugin_descriptors_file_path ();
-  g_return_if_fail (path && strlen (path) > 2);
-  g_message ("Writing cached plugin descriptors to %s...", path);
-  g_file_set_contents (path, yaml, -1, &err);
-  if (err != NULL)
+  g_free (path);
+  g_free (zrythm_dir);
+}
+
+static const char *
+get_string (const CachedPluginDescriptors * self, uint32_t offset)
+{
+  if (offset == CACHED_PLUGIN_DESCRIPTORS_NO_STRING)
+    return NULL;
+
+  return &self->strings[offset];
+}
+
+static void
+entry_free (CachedPluginDescriptor * entry)
+{
+  object_free_w_func_and_null (plugin_descriptor_free, entry->descr);
+
+  object_zero_and_free (entry);
+}
+
+static CachedPluginDescriptor *
+entry_new_for_descr (PluginDescriptor * descr)
+{
+  CachedPluginDescriptor * entry = object_new (CachedPluginDescriptor);
+  entry->descr = descr;
+  return entry;
+}
+
+/**
+ * Creates a new descriptor from the given record.
+ */
+static PluginDescriptor *
+create_descr_from_record (
+  const CachedPluginDescriptors *      self,
+  const CachedPluginDescriptorRecord * rec)
+{
+  PluginDescriptor * descr = plugin_descriptor_new ();
+  descr->author = g_strdup (get_string (self, rec->author));
+  descr->name = g_strdup (get_string (self, rec->name));
+  descr->website = g_strdup (get_string (self, rec->website));
+  descr->category_str = g_strdup (get_string (self, rec->category_str));
+  descr->path = g_strdup (get_string (self, rec->path));
+  descr->uri = g_strdup (get_string (self, rec->uri));
+  descr->category = (ZPluginCategory) rec->category;
+  descr->num_audio_ins = rec->num_audio_ins;
+  descr->num_midi_ins = rec->num_midi_ins;
+  descr->num_audio_outs = rec->num_audio_outs;
+  descr->num_midi_outs = rec->num_midi_outs;
+  descr->num_ctrl_ins = rec->num_ctrl_ins;
+  descr->num_ctrl_outs = rec->num_ctrl_outs;
+  descr->num_cv_ins = rec->num_cv_ins;
+  descr->num_cv_outs = rec->num_cv_outs;
+  descr->arch = (PluginArchitecture) rec->arch;
+  descr->protocol = (ZPluginProtocol) rec->protocol;
+  descr->min_bridge_mode = (CarlaBridgeMode) rec->min_bridge_mode;
+  descr->has_custom_ui = rec->has_custom_ui;
+  descr->ghash = rec->ghash;
+  descr->unique_id = rec->unique_id;
+  descr->file_mtime = rec->file_mtime;
+  descr->file_size = rec->file_size;
+
+  return descr;
+}
+
+/**
+ * Creates the descriptor from its record, if not created
+ * yet.
+ */
+static PluginDescriptor *
+entry_get_descr (
+  const CachedPluginDescriptors * self,
+  CachedPluginDescriptor *        entry)
+{
+  if (!entry->descr)
     {
-      g_warning (
-        "Unable to write cached plugin descriptors "
-        "file: %s",
-        err->message);
-      g_error_free (err);
-      g_free (path);
-      g_free (yaml);
-      g_return_if_reached ();
+      entry->descr = create_descr_from_record (self, entry->record);
     }
-  g_free (path);
-  g_free (yaml);
+
+  return entry->descr;
+}
+
+/**
+ * Returns a new descriptor for the entry, without creating
+ * the cached one.
+ */
+static PluginDescriptor *
+entry_create_descr (
+  const CachedPluginDescriptors * self,
+  const CachedPluginDescriptor *  entry)
+{
+  if (entry->descr)
+    return plugin_descriptor_clone (entry->descr);
+
+  return create_descr_from_record (self, entry->record);
+}
+
+static const char *
+entry_get_path (
+  const CachedPluginDescriptors * self,
+  const CachedPluginDescriptor *  entry)
+{
+  return entry->descr ? entry->descr->path
+                      : get_string (self, entry->record->path);
+}
+
+static ZPluginProtocol
+entry_get_protocol (const CachedPluginDescriptor * entry)
+{
+  return entry->descr
+           ? entry->descr->protocol
+           : (ZPluginProtocol) entry->record->protocol;
+}
+
+/**
+ * Gets the modification time and size of the file at the
+ * given path.
+ */
+static bool
+get_file_info (const char * path, int64_t * mtime, int64_t * size)
+{
+  GStatBuf st;
+  if (g_stat (path, &st) != 0)
+    {
+      *mtime = 0;
+      *size = -1;
+      return false;
+    }
+
+  *mtime = (int64_t) st.st_mtime;
+  *size = (int64_t) st.st_size;
+  return true;
+}
+
+static bool
+is_up_to_date (
+  const CachedPluginDescriptor * entry,
+  int64_t                        mtime,
+  int64_t                        size)
+{
+  if (entry->descr)
+    {
+      return entry->descr->file_mtime == mtime
+             && entry->descr->file_size == size;
+    }
+
+  return entry->record->file_mtime == mtime
+         && entry->record->file_size == size;
+}
+
+/**
+ * Same as plugin_descriptor_is_same_plugin(), without
+ * creating the cached descriptor.
+ */
+static bool
+is_same_plugin (
+  const CachedPluginDescriptors * self,
+  const CachedPluginDescriptor *  entry,
+  const PluginDescriptor *        descr)
+{
+  if (entry->descr)
+    return plugin_descriptor_is_same_plugin (entry->descr, descr);
+
+  const CachedPluginDescriptorRecord * rec = entry->record;
+  return rec->arch == (int32_t) descr->arch
+         && rec->protocol == (int32_t) descr->protocol
+         && rec->unique_id == descr->unique_id && rec->ghash == descr->ghash
+         && string_is_equal (get_string (self, rec->path), descr->path)
+         && string_is_equal (get_string (self, rec->uri), descr->uri);
+}
+
+static void
+index_entry (CachedPluginDescriptors * self, CachedPluginDescriptor * entry)
+{
+  /* LV2 plugins are found by URI */
+  const char * path = entry_get_path (self, entry);
+  if (entry_get_protocol (entry) == Z_PLUGIN_PROTOCOL_LV2 || !path)
+    return;
+
+  GPtrArray * entries = g_hash_table_lookup (self->descriptors_by_path, path);
+  if (!entries)
+    {
+      entries = g_ptr_array_new ();
+      g_hash_table_insert (self->descriptors_by_path, g_strdup (path), entries);
+    }
+  g_ptr_array_add (entries, entry);
+}
+
+static void
+unindex_entry (CachedPluginDescriptors * self, CachedPluginDescriptor * entry)
+{
+  const char * path = entry_get_path (self, entry);
+  if (!path)
+    return;
+
+  GPtrArray * entries = g_hash_table_lookup (self->descriptors_by_path, path);
+  if (!entries)
+    return;
+
+  g_ptr_array_remove (entries, entry);
+  if (entries->len == 0)
+    {
+      g_hash_table_remove (self->descriptors_by_path, path);
+    }
+}
+
+static void
+index_blacklisted_entry (
+  CachedPluginDescriptors * self,
+  CachedPluginDescriptor *  entry)
+{
+  const char * path = entry_get_path (self, entry);
+  if (path)
+    {
+      g_hash_table_insert (self->blacklisted_by_path, g_strdup (path), entry);
+    }
+}
+
+static void
+rebuild_index (CachedPluginDescriptors * self)
+{
+  g_hash_table_remove_all (self->descriptors_by_path);
+  g_hash_table_remove_all (self->blacklisted_by_path);
+  for (guint i = 0; i < self->descriptors->len; i++)
+    {
+      index_entry (self, g_ptr_array_index (self->descriptors, i));
+    }
+  for (guint i = 0; i < self->blacklisted->len; i++)
+    {
+      index_blacklisted_entry (self, g_ptr_array_index (self->blacklisted, i));
+    }
+}
+
+/**
+ * Creates all the descriptors from their records and
+ * unmaps the file.
+ */
+static void
+detach_from_file (CachedPluginDescriptors * self)
+{
+  if (!self->mapped_file)
+    return;
+
+  for (guint i = 0; i < self->descriptors->len; i++)
+    {
+      CachedPluginDescriptor * entry = g_ptr_array_index (self->descriptors, i);
+      entry_get_descr (self, entry);
+      entry->record = NULL;
+    }
+  for (guint i = 0; i < self->blacklisted->len; i++)
+    {
+      CachedPluginDescriptor * entry = g_ptr_array_index (self->blacklisted, i);
+      entry_get_descr (self, entry);
+      entry->record = NULL;
+    }
+
+  g_mapped_file_unref (self->mapped_file);
+  self->mapped_file = NULL;
+  self->strings = NULL;
+  self->strings_size = 0;
 }
 
 static bool
-is_yaml_our_version (const char * yaml)
+is_record_valid (
+  const CachedPluginDescriptors *      self,
+  const CachedPluginDescriptorRecord * rec)
 {
-  bool same_version = false;
-  char version_str[120];
-  sprintf (
-    version_str, "schema_version: %d\n",
-    CACHED_PLUGIN_DESCRIPTORS_SCHEMA_VERSION);
-  same_version = g_str_has_prefix (yaml, version_str);
-  if (!same_version)
+  const uint32_t offsets[] = {
+    rec->author,       rec->name, rec->website,
+    rec->category_str, rec->path, rec->uri,
+  };
+  for (size_t i = 0; i < G_N_ELEMENTS (offsets); i++)
     {
-      sprintf (
-        version_str, "---\nschema_version: %d\n",
-        CACHED_PLUGIN_DESCRIPTORS_SCHEMA_VERSION);
-      same_version = g_str_has_prefix (yaml, version_str);
+      if (
+        offsets[i] != CACHED_PLUGIN_DESCRIPTORS_NO_STRING
+        && offsets[i] >= self->strings_size)
+        return false;
     }
 
-  return same_version;
+  return true;
 }
 
 /**
- * Reads the file and fills up the object.
+ * Maps the cache file and adds entries for its records.
+ */
+static bool
+load_file (CachedPluginDescriptors * self, const char * path, GError ** error)
+{
+  GError *      err = NULL;
+  GMappedFile * mapped_file = g_mapped_file_new (path, false, &err);
+  if (!mapped_file)
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (error, err, "Failed to map file");
+      return false;
+    }
+
+  size_t       size = g_mapped_file_get_length (mapped_file);
+  const char * contents = g_mapped_file_get_contents (mapped_file);
+  const CachedPluginDescriptorsHeader * header =
+    (const CachedPluginDescriptorsHeader *) contents;
+  if (
+    size < sizeof (CachedPluginDescriptorsHeader)
+    || memcmp (
+         header->magic, CACHED_PLUGIN_DESCRIPTORS_MAGIC, sizeof (header->magic))
+         != 0
+    || header->version != CACHED_PLUGIN_DESCRIPTORS_SCHEMA_VERSION)
+    {
+      g_mapped_file_unref (mapped_file);
+      g_set_error_literal (
+        error, Z_PLUGINS_CACHED_PLUGIN_DESCRIPTORS_ERROR,
+        Z_PLUGINS_CACHED_PLUGIN_DESCRIPTORS_ERROR_FAILED,
+        "Unknown file version");
+      return false;
+    }
+
+  uint64_t num_records =
+    (uint64_t) header->num_descriptors + header->num_blacklisted;
+  uint64_t expected_size =
+    sizeof (CachedPluginDescriptorsHeader)
+    + num_records * sizeof (CachedPluginDescriptorRecord)
+    + header->strings_size;
+  if (
+    expected_size != size
+    || (header->strings_size > 0 && contents[size - 1] != '\0'))
+    {
+      g_mapped_file_unref (mapped_file);
+      g_set_error_literal (
+        error, Z_PLUGINS_CACHED_PLUGIN_DESCRIPTORS_ERROR,
+        Z_PLUGINS_CACHED_PLUGIN_DESCRIPTORS_ERROR_FAILED, "Truncated file");
+      return false;
+    }
+
+  self->mapped_file = mapped_file;
+  self->strings = &contents[size - header->strings_size];
+  self->strings_size = header->strings_size;
+
+  const CachedPluginDescriptorRecord * records =
+    (const CachedPluginDescriptorRecord *) &contents[sizeof (
+      CachedPluginDescriptorsHeader)];
+  for (uint64_t i = 0; i < num_records; i++)
+    {
+      if (!is_record_valid (self, &records[i]))
+        {
+          g_set_error (
+            error, Z_PLUGINS_CACHED_PLUGIN_DESCRIPTORS_ERROR,
+            Z_PLUGINS_CACHED_PLUGIN_DESCRIPTORS_ERROR_FAILED,
+            "Invalid record %" G_GUINT64_FORMAT, i);
+          return false;
+        }
+
+      CachedPluginDescriptor * entry = object_new (CachedPluginDescriptor);
+      entry->record = &records[i];
+      if (i < header->num_descriptors)
+        {
+          g_ptr_array_add (self->descriptors, entry);
+          index_entry (self, entry);
+        }
+      else
+        {
+          g_ptr_array_add (self->blacklisted, entry);
+          index_blacklisted_entry (self, entry);
+        }
+    }
+
+  return true;
+}
+
+/**
+ * Maps the cache file, if valid, and indexes its
+ * records.
  */
 CachedPluginDescriptors *
 cached_plugin_descriptors_new (void)
 {
-  GError * err = NULL;
-  char *   path = get_cached_plugin_descriptors_file_path ();
+  CachedPluginDescriptors * self = object_new (CachedPluginDescriptors);
+  self->descriptors =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) entry_free);
+  self->blacklisted =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) entry_free);
+  self->descriptors_by_path = g_hash_table_new_full (
+    g_str_hash, g_str_equal, g_free, (GDestroyNotify) g_ptr_array_unref);
+  self->blacklisted_by_path =
+    g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  remove_legacy_file ();
+
+  char * path = get_cached_plugin_descriptors_file_path ();
+  g_return_val_if_fail (path, self);
   if (!file_exists (path))
     {
-      g_message (
-        "Cached plugin descriptors file at %s does "
-        "not exist",
-        path);
-return_new_instance:
+      g_message ("Cached plugin descriptors file at %s does not exist", path);
       g_free (path);
-      CachedPluginDescriptors * self = object_new (CachedPluginDescriptors);
-      self->schema_version = CACHED_PLUGIN_DESCRIPTORS_SCHEMA_VERSION;
       return self;
     }
-  char * yaml = NULL;
-  g_file_get_contents (path, &yaml, NULL, &err);
-  if (err != NULL)
+
+  GError * err = NULL;
+  if (!load_file (self, path, &err))
     {
-      g_critical (
-        "Failed to create CachedPluginDescriptors "
-        "from %s",
-        path);
-      g_free (err);
-      g_free (yaml);
-      g_free (path);
-      return NULL;
+      g_message (
+        "Purging invalid cached plugin descriptors file %s: %s", path,
+        err->message);
+      g_error_free (err);
+      g_ptr_array_set_size (self->descriptors, 0);
+      g_ptr_array_set_size (self->blacklisted, 0);
+      g_hash_table_remove_all (self->descriptors_by_path);
+      g_hash_table_remove_all (self->blacklisted_by_path);
+      if (self->mapped_file)
+        {
+          g_mapped_file_unref (self->mapped_file);
+          self->mapped_file = NULL;
+          self->strings = NULL;
+          self->strings_size = 0;
+        }
+      io_remove (path);
     }
-
-  /* if not same version, purge file and return
-   * a new instance */
-  if (!is_yaml_our_version (yaml))
+  else
     {
       g_message (
-        "Found old plugin descriptor file version. "
-        "Purging file and creating a new one.");
-      GFile * file = g_file_new_for_path (path);
-      g_file_delete (file, NULL, NULL);
-      g_object_unref (file);
-      g_free (yaml);
-      goto return_new_instance;
+        "Mapped %u cached plugin descriptors (%u blacklisted) from %s",
+        self->descriptors->len, self->blacklisted->len, path);
     }
+  g_free (path);
+
+  return self;
+}
+
+/**
+ * Adds the string to the string table, if not already
+ * there.
+ */
+static uint32_t
+add_string (GByteArray * strings, GHashTable * offsets, const char * str)
+{
+  if (!str)
+    return CACHED_PLUGIN_DESCRIPTORS_NO_STRING;
+
+  gpointer offset;
+  if (g_hash_table_lookup_extended (offsets, str, NULL, &offset))
+    return GPOINTER_TO_UINT (offset);
+
+  uint32_t new_offset = strings->len;
+  g_byte_array_append (strings, (const guint8 *) str, (guint) strlen (str) + 1);
+  g_hash_table_insert (offsets, (gpointer) str, GUINT_TO_POINTER (new_offset));
+  return new_offset;
+}
 
-  CachedPluginDescriptors * self = (CachedPluginDescriptors *)
-    yaml_deserialize (yaml, &cached_plugin_descriptors_schema, &err);
-  if (!self)
+static void
+add_record (
+  GByteArray *             records,
+  GByteArray *             strings,
+  GHashTable *             offsets,
+  const PluginDescriptor * descr)
+{
+  CachedPluginDescriptorRecord rec = {
+    .author = add_string (strings, offsets, descr->author),
+    .name = add_string (strings, offsets, descr->name),
+    .website = add_string (strings, offsets, descr->website),
+    .category_str = add_string (strings, offsets, descr->category_str),
+    .path = add_string (strings, offsets, descr->path),
+    .uri = add_string (strings, offsets, descr->uri),
+    .category = (int32_t) descr->category,
+    .num_audio_ins = descr->num_audio_ins,
+    .num_midi_ins = descr->num_midi_ins,
+    .num_audio_outs = descr->num_audio_outs,
+    .num_midi_outs = descr->num_midi_outs,
+    .num_ctrl_ins = descr->num_ctrl_ins,
+    .num_ctrl_outs = descr->num_ctrl_outs,
+    .num_cv_ins = descr->num_cv_ins,
+    .num_cv_outs = descr->num_cv_outs,
+    .arch = (int32_t) descr->arch,
+    .protocol = (int32_t) descr->protocol,
+    .min_bridge_mode = (int32_t) descr->min_bridge_mode,
+    .has_custom_ui = descr->has_custom_ui,
+    .ghash = descr->ghash,
+    .unique_id = descr->unique_id,
+    .file_mtime = descr->file_mtime,
+    .file_size = descr->file_size,
+  };
+  g_byte_array_append (records, (const guint8 *) &rec, sizeof (rec));
+}
+
+/**
+ * Writes the cache file, if the cache changed.
+ */
+void
+cached_plugin_descriptors_serialize_to_file (CachedPluginDescriptors * self)
+{
+  if (!self->dirty)
     {
-      g_critical (
-        "Failed to deserialize "
-        "CachedPluginDescriptors from %s:\n%s",
-        path, err->message);
-      g_error_free (err);
-      g_free (yaml);
-      g_free (path);
-      return NULL;
+      g_debug ("Cached plugin descriptors unchanged, not writing");
+      return;
     }
-  g_free (yaml);
-  g_free (path);
 
-  for (int i = 0; i < self->num_descriptors; i++)
+  g_message ("Serializing cached plugin descriptors...");
+
+  /* the file is about to be replaced */
+  detach_from_file (self);
+
+  CachedPluginDescriptorsHeader header = {
+    .version = CACHED_PLUGIN_DESCRIPTORS_SCHEMA_VERSION,
+    .num_descriptors = self->descriptors->len,
+    .num_blacklisted = self->blacklisted->len,
+  };
+  memcpy (
+    header.magic, CACHED_PLUGIN_DESCRIPTORS_MAGIC, sizeof (header.magic));
+
+  GByteArray * records = g_byte_array_new ();
+  GByteArray * strings = g_byte_array_new ();
+  GHashTable * offsets = g_hash_table_new (g_str_hash, g_str_equal);
+  for (guint i = 0; i < self->descriptors->len; i++)
+    {
+      CachedPluginDescriptor * entry = g_ptr_array_index (self->descriptors, i);
+      add_record (records, strings, offsets, entry->descr);
+    }
+  for (guint i = 0; i < self->blacklisted->len; i++)
     {
-      self->descriptors[i]->category = plugin_descriptor_string_to_category (
-        self->descriptors[i]->category_str);
+      CachedPluginDescriptor * entry = g_ptr_array_index (self->blacklisted, i);
+      add_record (records, strings, offsets, entry->descr);
     }
+  g_hash_table_unref (offsets);
+  header.strings_size = strings->len;
 
-  return self;
+  GByteArray * contents = g_byte_array_new ();
+  g_byte_array_append (contents, (const guint8 *) &header, sizeof (header));
+  g_byte_array_append (contents, records->data, records->len);
+  g_byte_array_append (contents, strings->data, strings->len);
+  g_byte_array_unref (records);
+  g_byte_array_unref (strings);
+
+  char * path = get_cached_plugin_descriptors_file_path ();
+  g_return_if_fail (path && strlen (path) > 2);
+  g_message ("Writing cached plugin descriptors to %s...", path);
+  GError * err = NULL;
+  if (g_file_set_contents (
+        path, (const char *) contents->data, contents->len, &err))
+    {
+      self->dirty = false;
+    }
+  else
+    {
+      g_warning (
+        "Unable to write cached plugin descriptors file: %s", err->message);
+      g_error_free (err);
+    }
+  g_byte_array_unref (contents);
+  g_free (path);
 }
 
 static void
@@ -171,20 +631,27 @@ cached_plugin_descriptors_is_blacklisted (
 {
   char * traversed_path = io_traverse_path (abs_path);
 
-  for (int i = 0; i < self->num_blacklisted; i++)
+  CachedPluginDescriptor * entry =
+    g_hash_table_lookup (self->blacklisted_by_path, traversed_path);
+  if (!entry)
     {
-      PluginDescriptor * descr = self->blacklisted[i];
-      GFile *            file = g_file_new_for_path (descr->path);
-      if (
-        string_is_equal (descr->path, traversed_path)
-        && descr->ghash == g_file_hash (file))
-        {
-          g_object_unref (file);
-          g_free (traversed_path);
-          return 1;
-        }
-      g_object_unref (file);
+      g_free (traversed_path);
+      return 0;
     }
+
+  int64_t mtime, size;
+  get_file_info (traversed_path, &mtime, &size);
+  if (is_up_to_date (entry, mtime, size))
+    {
+      g_free (traversed_path);
+      return 1;
+    }
+
+  /* the plugin changed, give it another chance */
+  g_message ("%s changed since it was blacklisted", traversed_path);
+  g_hash_table_remove (self->blacklisted_by_path, traversed_path);
+  g_ptr_array_remove (self->blacklisted, entry);
+  self->dirty = true;
   g_free (traversed_path);
   return 0;
 }
@@ -209,23 +676,25 @@ cached_plugin_descriptors_find (
 {
   if (check_valid)
     {
-      for (int i = 0; i < self->num_descriptors; i++)
+      for (guint i = 0; i < self->descriptors->len; i++)
         {
-          PluginDescriptor * cur_descr = self->descriptors[i];
-          if (plugin_descriptor_is_same_plugin (cur_descr, descr))
+          CachedPluginDescriptor * entry =
+            g_ptr_array_index (self->descriptors, i);
+          if (is_same_plugin (self, entry, descr))
             {
-              return cur_descr;
+              return entry_get_descr (self, entry);
             }
         }
     }
   if (check_blacklisted)
     {
-      for (int i = 0; i < self->num_blacklisted; i++)
+      for (guint i = 0; i < self->blacklisted->len; i++)
         {
-          PluginDescriptor * cur_descr = self->blacklisted[i];
-          if (plugin_descriptor_is_same_plugin (cur_descr, descr))
+          CachedPluginDescriptor * entry =
+            g_ptr_array_index (self->blacklisted, i);
+          if (is_same_plugin (self, entry, descr))
             {
-              return cur_descr;
+              return entry_get_descr (self, entry);
             }
         }
     }
@@ -236,10 +705,15 @@ cached_plugin_descriptors_find (
 /**
  * Returns the PluginDescriptor's corresponding to
  * the .so/.dll file at the given path, if it
- * exists and the MD5 hash matches.
+ * exists and the file did not change since it was
+ * cached.
+ *
+ * The descriptors are created directly from the
+ * records in the mapped file, so the cached ones are
+ * not created.
  *
- * @note The returned array must be free'd but not
- *   the descriptors.
+ * @note The returned array and descriptors are owned
+ *   by the caller.
  *
  * @return NULL-terminated array.
  */
@@ -248,52 +722,46 @@ cached_plugin_descriptors_get (
   CachedPluginDescriptors * self,
   const char *              abs_path)
 {
-  PluginDescriptor ** descriptors = object_new_n (1, PluginDescriptor *);
-  int                 num_descriptors = 0;
-
   char * traversed_path = io_traverse_path (abs_path);
 
   g_debug ("Getting cached descriptors for %s", traversed_path);
 
-  for (int i = 0; i < self->num_descriptors; i++)
+  GPtrArray * entries =
+    g_hash_table_lookup (self->descriptors_by_path, traversed_path);
+  if (!entries)
     {
-      PluginDescriptor * descr = self->descriptors[i];
-
-      /* skip LV2 since they don't have paths */
-      if (descr->protocol == Z_PLUGIN_PROTOCOL_LV2)
-        continue;
-
-      GFile * file = g_file_new_for_path (descr->path);
-      if (string_is_equal (descr->path, traversed_path))
-        {
-          if (descr->ghash == g_file_hash (file))
-            {
-              num_descriptors++;
-              descriptors = g_realloc (
-                descriptors,
-                (size_t) (num_descriptors + 1) * sizeof (PluginDescriptor *));
-              descriptors[num_descriptors - 1] = descr;
-            }
-          else
-            {
-              g_debug (
-                "hash differs %u != %u", descr->ghash, g_file_hash (file));
-            }
-        }
-      g_object_unref (file);
+      g_free (traversed_path);
+      return NULL;
     }
 
-  if (num_descriptors == 0)
+  int64_t mtime, size;
+  get_file_info (traversed_path, &mtime, &size);
+  if (!is_up_to_date (g_ptr_array_index (entries, 0), mtime, size))
     {
-      free (descriptors);
+      /* the plugin changed, drop the stale descriptors
+       * so that it gets scanned again */
+      g_message ("%s changed since it was cached", traversed_path);
+      for (guint i = 0; i < entries->len; i++)
+        {
+          g_ptr_array_remove (
+            self->descriptors, g_ptr_array_index (entries, i));
+        }
+      g_hash_table_remove (self->descriptors_by_path, traversed_path);
+      self->dirty = true;
       g_free (traversed_path);
       return NULL;
     }
+  g_free (traversed_path);
 
-  /* NULL-terminate */
-  descriptors[num_descriptors] = NULL;
+  /* NULL-terminated */
+  PluginDescriptor ** descriptors =
+    object_new_n (entries->len + 1, PluginDescriptor *);
+  for (guint i = 0; i < entries->len; i++)
+    {
+      descriptors[i] =
+        entry_create_descr (self, g_ptr_array_index (entries, i));
+    }
 
-  g_free (traversed_path);
   return descriptors;
 }
 
@@ -318,7 +786,12 @@ cached_plugin_descriptors_blacklist (
   GFile * file = g_file_new_for_path (traversed_path);
   new_descr->ghash = g_file_hash (file);
   g_object_unref (file);
-  self->blacklisted[self->num_blacklisted++] = new_descr;
+  get_file_info (
+    traversed_path, &new_descr->file_mtime, &new_descr->file_size);
+  CachedPluginDescriptor * entry = entry_new_for_descr (new_descr);
+  g_ptr_array_add (self->blacklisted, entry);
+  index_blacklisted_entry (self, entry);
+  self->dirty = true;
   if (_serialize)
     {
       cached_plugin_descriptors_serialize_to_file (self);
@@ -341,34 +814,37 @@ cached_plugin_descriptors_replace (
   const PluginDescriptor *  _new_descr,
   bool                      _serialize)
 {
-  PluginDescriptor * new_descr = plugin_descriptor_clone (_new_descr);
-
-  for (int i = 0; i < self->num_descriptors; i++)
+  for (guint i = 0; i < self->descriptors->len; i++)
     {
-      PluginDescriptor * cur_descr = self->descriptors[i];
-      if (plugin_descriptor_is_same_plugin (cur_descr, new_descr))
+      CachedPluginDescriptor * entry = g_ptr_array_index (self->descriptors, i);
+      if (is_same_plugin (self, entry, _new_descr))
         {
-          self->descriptors[i] = new_descr;
-          plugin_descriptor_free (cur_descr);
+          unindex_entry (self, entry);
+          object_free_w_func_and_null (plugin_descriptor_free, entry->descr);
+          entry->record = NULL;
+          entry->descr = plugin_descriptor_clone (_new_descr);
+          index_entry (self, entry);
           goto check_serialize;
         }
     }
-  for (int i = 0; i < self->num_blacklisted; i++)
+  for (guint i = 0; i < self->blacklisted->len; i++)
     {
-      PluginDescriptor * cur_descr = self->blacklisted[i];
-      if (plugin_descriptor_is_same_plugin (cur_descr, new_descr))
+      CachedPluginDescriptor * entry = g_ptr_array_index (self->blacklisted, i);
+      if (is_same_plugin (self, entry, _new_descr))
         {
-          self->descriptors[i] = new_descr;
-          plugin_descriptor_free (cur_descr);
+          /* the path stays the same */
+          object_free_w_func_and_null (plugin_descriptor_free, entry->descr);
+          entry->record = NULL;
+          entry->descr = plugin_descriptor_clone (_new_descr);
           goto check_serialize;
         }
     }
   /* plugin not found, add instead */
   cached_plugin_descriptors_add (self, _new_descr, _serialize);
-  plugin_descriptor_free (new_descr);
   return;
 
 check_serialize:
+  self->dirty = true;
   if (_serialize)
     {
       cached_plugin_descriptors_serialize_to_file (self);
@@ -393,8 +869,13 @@ cached_plugin_descriptors_add (
       GFile * file = g_file_new_for_path (descr->path);
       new_descr->ghash = g_file_hash (file);
       g_object_unref (file);
+      get_file_info (
+        descr->path, &new_descr->file_mtime, &new_descr->file_size);
     }
-  self->descriptors[self->num_descriptors++] = new_descr;
+  CachedPluginDescriptor * entry = entry_new_for_descr (new_descr);
+  g_ptr_array_add (self->descriptors, entry);
+  index_entry (self, entry);
+  self->dirty = true;
 
   if (_serialize)
     {
@@ -408,11 +889,12 @@ cached_plugin_descriptors_add (
 void
 cached_plugin_descriptors_clear (CachedPluginDescriptors * self)
 {
-  for (int i = 0; i < self->num_descriptors; i++)
-    {
-      plugin_descriptor_free (self->descriptors[i]);
-    }
-  self->num_descriptors = 0;
+  /* keep the blacklisted descriptors until they are
+   * written again */
+  detach_from_file (self);
+  g_ptr_array_set_size (self->descriptors, 0);
+  rebuild_index (self);
+  self->dirty = true;
 
   delete_file ();
 }
@@ -420,14 +902,11 @@ cached_plugin_descriptors_clear (CachedPluginDescriptors * self)
 void
 cached_plugin_descriptors_free (CachedPluginDescriptors * self)
 {
-  for (int i = 0; i < self->num_descriptors; i++)
-    {
-      object_free_w_func_and_null (plugin_descriptor_free, self->descriptors[i]);
-    }
-  for (int i = 0; i < self->num_blacklisted; i++)
-    {
-      object_free_w_func_and_null (plugin_descriptor_free, self->blacklisted[i]);
-    }
+  object_free_w_func_and_null (g_hash_table_destroy, self->descriptors_by_path);
+  object_free_w_func_and_null (g_hash_table_destroy, self->blacklisted_by_path);
+  object_free_w_func_and_null (g_ptr_array_unref, self->descriptors);
+  object_free_w_func_and_null (g_ptr_array_unref, self->blacklisted);
+  object_free_w_func_and_null (g_mapped_file_unref, self->mapped_file);
 
   object_zero_and_free (self);
 }
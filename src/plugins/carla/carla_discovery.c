@@ -341,7 +341,8 @@ z_carla_discovery_run (
     system_get_cmd_output (argv, 1200, true);
 #  endif
   char * res;
-  int    ret = system_run_cmd_w_args (argv, 8000, &res, NULL, true);
+  int    ret = system_run_cmd_w_args (
+    argv, Z_CARLA_DISCOVERY_TIMEOUT_MS, &res, NULL, true);
   if (ret == 0)
     {
       return res;
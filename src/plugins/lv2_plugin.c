@@ -351,6 +351,7 @@ create_port (
           g_return_val_if_fail (IS_PORT_AND_NONNULL (port), NULL);
           port->buf = g_realloc (
             port->buf, (size_t) AUDIO_ENGINE->block_length * sizeof (float));
+          port->last_buf_sz = AUDIO_ENGINE->block_length;
         }
       else
         {
@@ -2408,7 +2409,7 @@ lv2_plugin_instantiate (
   static float        samplerate = 0.f;
   static int          nominal_blocklength = 0;
   static int          min_blocklength = 0;
-  static int          max_blocklength = 4096;
+  static int          max_blocklength = LV2_PLUGIN_MAX_BLOCK_LENGTH;
   static int          midi_buf_size = 0;
   static const char * prog_name = PROGRAM_NAME;
 
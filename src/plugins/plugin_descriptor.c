@@ -84,6 +84,8 @@ plugin_descriptor_copy (PluginDescriptor * dest, const PluginDescriptor * src)
   dest->min_bridge_mode = src->min_bridge_mode;
   dest->has_custom_ui = src->has_custom_ui;
   dest->ghash = src->ghash;
+  dest->file_mtime = src->file_mtime;
+  dest->file_size = src->file_size;
 }
 
 /**
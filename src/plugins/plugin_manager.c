@@ -998,8 +998,204 @@ plugin_manager_supports_protocol (PluginManager * self, ZPluginProtocol protocol
 }
 
 #ifdef HAVE_CARLA
+
+/**
+ * Maximum number of discovery processes to run at the
+ * same time.
+ */
+#  define MAX_DISCOVERY_JOBS 8
+
+/**
+ * Discovery of the plugins in a file, run in a worker
+ * thread.
+ */
+typedef struct DiscoveryJob
+{
+  char *          plugin_path;
+  ZPluginProtocol protocol;
+
+  /** Result. */
+  PluginDescriptor ** descriptors;
+
+  /** Queue to push the job to when done. */
+  GAsyncQueue * done_queue;
+} DiscoveryJob;
+
+static void
+run_discovery_job (DiscoveryJob * job, gpointer user_data)
+{
+  job->descriptors = z_carla_discovery_create_descriptors_from_file (
+    job->plugin_path, ARCH_64, job->protocol);
+
+  /* try 32-bit if above failed */
+  if (!job->descriptors)
+    {
+      g_debug ("no descriptors for %s, trying 32bit...", job->plugin_path);
+      job->descriptors = z_carla_discovery_create_descriptors_from_file (
+        job->plugin_path, ARCH_32, job->protocol);
+    }
+
+  g_async_queue_push (job->done_queue, job);
+}
+
+/**
+ * Creates the descriptor of a SFZ/SF2 file.
+ *
+ * @return A newly allocated NULL-terminated array, or NULL
+ *   on failure.
+ */
+static PluginDescriptor **
+create_sf_descriptors (const char * plugin_path, ZPluginProtocol protocol)
+{
+  char * parent_path = io_path_get_parent_dir (plugin_path);
+  if (!parent_path)
+    {
+      g_warning ("Failed to get parent dir of %s", plugin_path);
+      return NULL;
+    }
+
+  PluginDescriptor ** descriptors = object_new_n (2, PluginDescriptor *);
+  descriptors[0] = plugin_descriptor_new ();
+  PluginDescriptor * descr = descriptors[0];
+  descr->path = g_strdup (plugin_path);
+  GFile * file = g_file_new_for_path (descr->path);
+  descr->ghash = g_file_hash (file);
+  g_object_unref (file);
+  descr->category = PC_INSTRUMENT;
+  descr->category_str = plugin_descriptor_category_to_string (descr->category);
+  descr->name = io_path_get_basename_without_ext (plugin_path);
+  descr->author = g_path_get_basename (parent_path);
+  g_free (parent_path);
+  descr->num_audio_outs = 2;
+  descr->num_midi_ins = 1;
+  descr->arch = ARCH_64;
+  descr->protocol = protocol;
+
+  return descriptors;
+}
+
+/**
+ * Adds newly scanned descriptors to the list and the
+ * cache, or blacklists the plugin if there are none.
+ */
+static void
+add_scanned_descriptors (
+  PluginManager *     self,
+  ZPluginProtocol     protocol,
+  const char *        plugin_path,
+  PluginDescriptor ** descriptors)
+{
+  const char * protocol_str = plugin_protocol_to_str (protocol);
+
+  g_debug ("descriptors for %s: %p", plugin_path, descriptors);
+
+  if (descriptors)
+    {
+      PluginDescriptor * descriptor = NULL;
+      int                i = 0;
+      while ((descriptor = descriptors[i++]))
+        {
+          g_ptr_array_add (self->plugin_descriptors, descriptor);
+          add_category_and_author (
+            self, descriptor->category_str, descriptor->author);
+          g_message ("Caching %s %s", protocol_str, descriptor->name);
+
+          cached_plugin_descriptors_add (
+            self->cached_plugin_descriptors, descriptor, F_NO_SERIALIZE);
+          self->num_new_plugins++;
+        }
+      g_debug ("%d descriptors cached for %s", i - 1, plugin_path);
+    }
+  else
+    {
+      g_message ("Blacklisting %s %s", protocol_str, plugin_path);
+      cached_plugin_descriptors_blacklist (
+        self->cached_plugin_descriptors, plugin_path, 0);
+    }
+}
+
+/**
+ * Updates the progress after a plugin file was handled
+ * and frees the given array (but not the descriptors).
+ */
+static void
+finish_plugin_file (
+  ZPluginProtocol     protocol,
+  const char *        plugin_path,
+  PluginDescriptor ** descriptors,
+  unsigned int *      count,
+  const double        size,
+  double *            progress,
+  const double        start_progress,
+  const double        max_progress)
+{
+  (*count)++;
+
+  if (progress)
+    {
+      const char * protocol_str = plugin_protocol_to_str (protocol);
+      *progress =
+        start_progress
+        + ((double) *count / size) * (max_progress - start_progress);
+      char prog_str[800];
+      if (descriptors)
+        {
+          sprintf (
+            prog_str, _ ("Scanned %s plugin: %s"), protocol_str,
+            descriptors[0]->name);
+        }
+      else
+        {
+          sprintf (
+            prog_str,
+            /* TRANSLATORS: first argument is plugin protocol, 2nd
+               argument is path */
+            _ ("Skipped %1$s plugin at %2$s"), protocol_str, plugin_path);
+        }
+      if (zrythm_app->greeter)
+        {
+          greeter_widget_set_progress_and_status (
+            zrythm_app->greeter, NULL, prog_str, *progress);
+        }
+      else
+        {
+          g_critical ("no greeter to report the scan progress to");
+        }
+    }
+
+  free (descriptors);
+}
+
+/**
+ * Adds the results of a finished discovery job and frees
+ * it.
+ */
+static void
+finish_discovery_job (
+  PluginManager * self,
+  DiscoveryJob *  job,
+  unsigned int *  count,
+  const double    size,
+  double *        progress,
+  const double    start_progress,
+  const double    max_progress)
+{
+  add_scanned_descriptors (
+    self, job->protocol, job->plugin_path, job->descriptors);
+  finish_plugin_file (
+    job->protocol, job->plugin_path, job->descriptors, count, size, progress,
+    start_progress, max_progress);
+  g_free (job->plugin_path);
+  object_zero_and_free (job);
+}
+
 /**
  * Used for plugin protocols that are scanned from paths.
+ *
+ * Cached plugins are looked up directly, while the
+ * others are discovered by up to MAX_DISCOVERY_JOBS
+ * carla-discovery processes at a time (each one with a
+ * timeout, see z_carla_discovery_run()).
  */
 static void
 scan_carla_descriptors_from_paths (
@@ -1066,6 +1262,13 @@ scan_carla_descriptors_from_paths (
     }
   g_return_if_fail (paths && suffix);
 
+  GAsyncQueue * done_queue = g_async_queue_new ();
+  GThreadPool * pool = g_thread_pool_new (
+    (GFunc) run_discovery_job, NULL,
+    CLAMP ((int) g_get_num_processors (), 1, MAX_DISCOVERY_JOBS), false, NULL);
+  int  num_pending = 0;
+  bool scanned_any = false;
+
   int    path_idx = 0;
   char * path;
   while ((path = paths[path_idx++]) != NULL)
@@ -1083,14 +1286,18 @@ scan_carla_descriptors_from_paths (
       int    plugin_idx = 0;
       while ((plugin_path = plugins[plugin_idx++]) != NULL)
         {
+          scanned_any = true;
           PluginDescriptor ** descriptors = cached_plugin_descriptors_get (
             self->cached_plugin_descriptors, plugin_path);
 
           /* if any cached descriptors are found */
           if (descriptors)
             {
-              /* clone and add them to the list
-               * of descriptors */
+              /* add them to the list of descriptors (they
+               * are created from the cache records and
+               * owned by us) */
+              GPtrArray * skipped = g_ptr_array_new_with_free_func (
+                (GDestroyNotify) plugin_descriptor_free);
               PluginDescriptor * descriptor = NULL;
               int                i = 0;
               while ((descriptor = descriptors[i++]))
@@ -1101,163 +1308,92 @@ scan_carla_descriptors_from_paths (
                       self->plugin_descriptors, descriptor,
                       (GEqualFunc) plugin_descriptor_is_same_plugin, NULL))
                     {
-                      PluginDescriptor * clone =
-                        plugin_descriptor_clone (descriptor);
-                      g_ptr_array_add (self->plugin_descriptors, clone);
+                      g_ptr_array_add (self->plugin_descriptors, descriptor);
                       add_category_and_author (
-                        self, clone->category_str, clone->author);
+                        self, descriptor->category_str, descriptor->author);
                       added = true;
                     }
+                  else
+                    {
+                      g_ptr_array_add (skipped, descriptor);
+                    }
                   g_debug (
                     "Found cached %s %s%s", protocol_str, descriptor->name,
                     added ? "" : " (skipped)");
                 }
+              finish_plugin_file (
+                protocol, plugin_path, descriptors, count, size, progress,
+                start_progress, max_progress);
+              g_ptr_array_unref (skipped);
             }
           /* if no cached descriptors found */
-          else
+          else if (cached_plugin_descriptors_is_blacklisted (
+                     self->cached_plugin_descriptors, plugin_path))
             {
-              g_debug (
-                "No cached descriptors found for "
-                "%s",
+              g_message (
+                "Ignoring blacklisted %s plugin: %s", protocol_str,
                 plugin_path);
-              if (cached_plugin_descriptors_is_blacklisted (
-                    self->cached_plugin_descriptors, plugin_path))
-                {
-                  g_message (
-                    "Ignoring blacklisted %s "
-                    "plugin: %s",
-                    protocol_str, plugin_path);
-                }
-              else
-                {
-                  if (
-                    protocol == Z_PLUGIN_PROTOCOL_SFZ
-                    || protocol == Z_PLUGIN_PROTOCOL_SF2)
-                    {
-                      descriptors = object_new_n (2, PluginDescriptor *);
-                      descriptors[0] = plugin_descriptor_new ();
-                      PluginDescriptor * descr = descriptors[0];
-                      descr->path = g_strdup (plugin_path);
-                      GFile * file = g_file_new_for_path (descr->path);
-                      descr->ghash = g_file_hash (file);
-                      g_object_unref (file);
-                      descr->category = PC_INSTRUMENT;
-                      descr->category_str =
-                        plugin_descriptor_category_to_string (descr->category);
-                      descr->name =
-                        io_path_get_basename_without_ext (plugin_path);
-                      char * parent_path = io_path_get_parent_dir (plugin_path);
-                      if (!parent_path)
-                        {
-                          g_warning (
-                            "Failed to get parent dir of "
-                            "%s",
-                            plugin_path);
-                          plugin_descriptor_free (descr);
-                          descriptors[0] = NULL;
-                          continue;
-                        }
-                      descr->author = g_path_get_basename (parent_path);
-                      g_free (parent_path);
-                      descr->num_audio_outs = 2;
-                      descr->num_midi_ins = 1;
-                      descr->arch = ARCH_64;
-                      descr->protocol = protocol;
-                    }
-                  /* else if not SFZ or SF2 */
-                  else
-                    {
-                      descriptors =
-                        z_carla_discovery_create_descriptors_from_file (
-                          plugin_path, ARCH_64, protocol);
-
-                      /* try 32-bit if above failed */
-                      if (!descriptors)
-                        {
-                          g_debug (
-                            "no descriptors for %s, "
-                            "trying 32bit...",
-                            plugin_path);
-                          descriptors =
-                            z_carla_discovery_create_descriptors_from_file (
-                              plugin_path, ARCH_32, protocol);
-                        }
-                    }
-
-                  g_debug ("descriptors for %s: %p", plugin_path, descriptors);
-
-                  if (descriptors)
-                    {
-                      PluginDescriptor * descriptor = NULL;
-                      int                i = 0;
-                      while ((descriptor = descriptors[i++]))
-                        {
-                          g_ptr_array_add (self->plugin_descriptors, descriptor);
-                          add_category_and_author (
-                            self, descriptor->category_str, descriptor->author);
-                          g_message (
-                            "Caching %s %s", protocol_str, descriptor->name);
-
-                          PluginDescriptor * clone =
-                            plugin_descriptor_clone (descriptor);
-                          cached_plugin_descriptors_add (
-                            self->cached_plugin_descriptors, clone,
-                            F_NO_SERIALIZE);
-                          self->num_new_plugins++;
-                        }
-                      g_debug (
-                        "%d descriptors cached for "
-                        "%s",
-                        i - 1, plugin_path);
-                    }
-                  else
-                    {
-                      g_message (
-                        "Blacklisting %s %s", protocol_str, plugin_path);
-                      cached_plugin_descriptors_blacklist (
-                        self->cached_plugin_descriptors, plugin_path, 0);
-                    }
-                }
+              finish_plugin_file (
+                protocol, plugin_path, NULL, count, size, progress,
+                start_progress, max_progress);
             }
-          (*count)++;
-
-          if (progress)
+          else if (
+            protocol == Z_PLUGIN_PROTOCOL_SFZ
+            || protocol == Z_PLUGIN_PROTOCOL_SF2)
             {
-              *progress =
-                start_progress
-                + ((double) *count / size) * (max_progress - start_progress);
-              char prog_str[800];
+              descriptors = create_sf_descriptors (plugin_path, protocol);
               if (descriptors)
                 {
-                  sprintf (
-                    prog_str, _ ("Scanned %s plugin: %s"), protocol_str,
-                    descriptors[0]->name);
-
-                  free (descriptors);
-                  descriptors = NULL;
-                }
-              else
-                {
-                  sprintf (
-                    prog_str,
-                    /* TRANSLATORS: first argument is plugin protocol, 2nd
-                       argument is path */
-                    _ ("Skipped %1$s plugin at %2$s"), protocol_str,
-                    plugin_path);
+                  add_scanned_descriptors (
+                    self, protocol, plugin_path, descriptors);
                 }
-              g_return_if_fail (zrythm_app->greeter);
-              greeter_widget_set_progress_and_status (
-                zrythm_app->greeter, NULL, prog_str, *progress);
+              finish_plugin_file (
+                protocol, plugin_path, descriptors, count, size, progress,
+                start_progress, max_progress);
+            }
+          /* else if not SFZ or SF2, discover in the
+           * background */
+          else
+            {
+              g_debug ("No cached descriptors found for %s", plugin_path);
+              DiscoveryJob * job = object_new (DiscoveryJob);
+              job->plugin_path = g_strdup (plugin_path);
+              job->protocol = protocol;
+              job->done_queue = done_queue;
+              g_thread_pool_push (pool, job, NULL);
+              num_pending++;
+            }
+
+          /* add the plugins discovered so far */
+          DiscoveryJob * job;
+          while ((job = g_async_queue_try_pop (done_queue)))
+            {
+              finish_discovery_job (
+                self, job, count, size, progress, start_progress,
+                max_progress);
+              num_pending--;
             }
-        }
-      if (plugin_idx > 0 && !ZRYTHM_TESTING)
-        {
-          cached_plugin_descriptors_serialize_to_file (
-            self->cached_plugin_descriptors);
         }
       g_strfreev (plugins);
     }
   g_strfreev (paths);
+
+  /* wait for the remaining discovery jobs */
+  while (num_pending > 0)
+    {
+      DiscoveryJob * job = g_async_queue_pop (done_queue);
+      finish_discovery_job (
+        self, job, count, size, progress, start_progress, max_progress);
+      num_pending--;
+    }
+  g_thread_pool_free (pool, false, true);
+  g_async_queue_unref (done_queue);
+
+  if (scanned_any && !ZRYTHM_TESTING)
+    {
+      cached_plugin_descriptors_serialize_to_file (
+        self->cached_plugin_descriptors);
+    }
 }
 #endif
 
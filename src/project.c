@@ -16,6 +16,7 @@
 #include "dsp/midi_note.h"
 #include "dsp/modulator_track.h"
 #include "dsp/port_connections_manager.h"
+#include "dsp/recording_manager.h"
 #include "dsp/router.h"
 #include "dsp/tempo_track.h"
 #include "dsp/track.h"
@@ -51,6 +52,7 @@
 #include "schemas/project.h"
 #include "settings/settings.h"
 #include "utils/arrays.h"
+#include "utils/compression.h"
 #include "utils/datetime.h"
 #include "utils/debug.h"
 #include "utils/error.h"
@@ -202,28 +204,15 @@ _project_compress (
             "Project not compressed by zstd");
           return false;
         }
-      dest = malloc ((size_t) frame_content_size);
-      dest_size = ZSTD_decompress (dest, frame_content_size, src, src_size);
-      if (ZSTD_isError (dest_size))
-        {
-          free (dest);
 
-          g_set_error (
-            error, Z_PROJECT_ERROR, Z_PROJECT_ERROR_FAILED,
-            "Failed to decompress project file: %s",
-            ZSTD_getErrorName (dest_size));
-          return false;
-        }
-      if (dest_size != frame_content_size)
+      /* projects are written in chunks so the frame may
+       * not contain the decompressed size */
+      GError * err = NULL;
+      dest = compression_decompress_stream (src, src_size, &dest_size, &err);
+      if (!dest)
         {
-          free (dest);
-
-          /* impossible because zstd will check
-           * this condition */
-          g_set_error_literal (
-            error, Z_PROJECT_ERROR, Z_PROJECT_ERROR_FAILED,
-            "uncompressed_size != "
-            "frame_content_size");
+          PROPAGATE_PREFIXED_ERROR_LITERAL (
+            error, err, "Failed to decompress project file");
           return false;
         }
     }
@@ -526,9 +515,26 @@ project_get_existing_uncompressed_text (
 int
 project_autosave_cb (void * data)
 {
+  if (!PROJECT || !PROJECT->loaded)
+    return G_SOURCE_CONTINUE;
+
+  /* the journal is cheap to write, so it records the
+   * actions done while backups are skipped (eg, while
+   * playing or when autosave is disabled) */
+  AutosaveJournal * journal = PROJECT->autosave_journal;
+  if (journal)
+    {
+      GError * journal_err = NULL;
+      if (!autosave_journal_flush (journal, &journal_err))
+        {
+          g_warning ("%s", journal_err->message);
+          g_error_free (journal_err);
+        }
+    }
+
   if (
-    !PROJECT || !PROJECT->loaded || !PROJECT->dir || !PROJECT->datetime_str
-    || !MAIN_WINDOW || !MAIN_WINDOW->setup)
+    !PROJECT->dir || !PROJECT->datetime_str || !MAIN_WINDOW
+    || !MAIN_WINDOW->setup)
     return G_SOURCE_CONTINUE;
 
   unsigned int autosave_interval_mins =
@@ -560,10 +566,12 @@ project_autosave_cb (void * data)
   UndoableAction * last_action =
     undo_manager_get_last_action (PROJECT->undo_manager);
 
-  /* skip if bad time to save or rolling */
+  /* skip if bad time to save or rolling (a long journal
+   * is replaced with a backup as soon as possible) */
   if (
-    cur_time - PROJECT->last_successful_autosave_time
-      < microsec_to_autosave
+    (cur_time - PROJECT->last_successful_autosave_time
+       < microsec_to_autosave
+     && !(journal && autosave_journal_needs_compaction (journal)))
     || TRANSPORT_IS_ROLLING
     ||
     (TRANSPORT->play_state == PLAYSTATE_ROLL_REQUESTED
@@ -691,10 +699,15 @@ project_get_path (Project * self, ProjectPath path, bool backup)
       break;
     case PROJECT_PATH_POOL:
       return g_build_filename (dir, PROJECT_POOL_DIR, NULL);
+    case PROJECT_PATH_POOL_CACHE:
+      return g_build_filename (dir, PROJECT_CACHE_DIR, PROJECT_POOL_DIR, NULL);
     case PROJECT_PATH_PROJECT_FILE:
       return g_build_filename (dir, PROJECT_FILE, NULL);
     case PROJECT_PATH_FINISHED_FILE:
       return g_build_filename (dir, PROJECT_FINISHED_FILE, NULL);
+    case PROJECT_PATH_AUTOSAVE_JOURNAL:
+      return g_build_filename (
+        self->dir, PROJECT_AUTOSAVE_JOURNAL_FILE, NULL);
     default:
       g_return_val_if_reached (NULL);
     }
@@ -755,84 +768,160 @@ void
 project_save_data_free (ProjectSaveData * self)
 {
   g_free_and_null (self->project_file_path);
-  object_free_w_func_and_null (project_free, self->project);
   object_free_w_func_and_null (progress_info_free, self->progress_info);
 
   object_zero_and_free_unresizable (ProjectSaveData, self);
 }
 
+/** Maximum number of serialized chunks waiting to be
+ * written. */
+#define MAX_PENDING_CHUNKS 16
+
 /**
- * Thread that does the serialization and saving.
+ * Thread that compresses and writes the serialized
+ * chunks.
  */
 static void *
-serialize_project_thread (ProjectSaveData * data)
+write_project_file_thread (ProjectSaveData * data)
 {
-  char * compressed_json;
-  size_t compressed_size;
-  bool   ret;
+  while (true)
+    {
+      GBytes *     chunk = (GBytes *) g_async_queue_pop (data->chunks);
+      gsize        size;
+      const char * contents = (const char *) g_bytes_get_data (chunk, &size);
+
+      /* after an error, keep consuming the chunks until the
+       * end so that the serializer doesn't block */
+      if (size > 0 && !data->write_error)
+        {
+          compression_file_writer_write (
+            data->writer, contents, size, &data->write_error);
+        }
+      g_bytes_unref (chunk);
+      zix_sem_post (&data->chunk_slots);
 
-  /* generate json */
-  g_message ("serializing project to json...");
+      if (size == 0)
+        break;
+    }
+
+  return NULL;
+}
+
+static bool
+write_chunk (
+  const char *      chunk,
+  size_t            size,
+  ProjectSaveData * data,
+  GError **         error)
+{
+  if (!data->chunks)
+    {
+      return compression_file_writer_write (data->writer, chunk, size, error);
+    }
+
+  zix_sem_wait (&data->chunk_slots);
+  g_async_queue_push (data->chunks, g_bytes_new (chunk, size));
+  return true;
+}
+
+/**
+ * Serializes the project and writes the compressed
+ * project file.
+ *
+ * The project is serialized in chunks that are compressed
+ * into the file as they are produced, so the whole JSON is
+ * never held in memory. If @p async, the chunks are
+ * compressed and written in a separate thread while the
+ * next ones are serialized.
+ */
+static bool
+write_project_file (ProjectSaveData * data, bool async, GError ** error)
+{
   GError * err = NULL;
-  gint64   time_before = g_get_monotonic_time ();
-  char *   json = project_serialize_to_json_str (data->project, &err);
-  gint64   time_after = g_get_monotonic_time ();
-  g_message (
-    "time to serialize: %ldms", (long) (time_after - time_before) / 1000);
-  if (!json)
+  data->writer = compression_file_writer_new (data->project_file_path, &err);
+  if (!data->writer)
     {
-      HANDLE_ERROR_LITERAL (err, _ ("Failed to serialize project"));
-      data->has_error = true;
-      goto serialize_end;
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, _ ("Failed to write project file"));
+      return false;
     }
 
-  /* compress */
-  err = NULL;
-  ret = project_compress (
-    &compressed_json, &compressed_size, PROJECT_COMPRESS_DATA, json,
-    strlen (json) * sizeof (char), PROJECT_COMPRESS_DATA, &err);
-  g_free (json);
-  if (!ret)
+  GThread * thread = NULL;
+  if (async)
     {
-      HANDLE_ERROR (err, "%s", _ ("Failed to compress project file"));
-      data->has_error = true;
-      goto serialize_end;
+      data->chunks = g_async_queue_new ();
+      zix_sem_init (&data->chunk_slots, MAX_PENDING_CHUNKS);
+      thread = g_thread_new (
+        "write_project_file_thread", (GThreadFunc) write_project_file_thread,
+        data);
     }
 
-  /* set file contents */
   g_message (
-    "%s: saving project file at %s...", __func__, data->project_file_path);
-  g_file_set_contents (
-    data->project_file_path, compressed_json, (gssize) compressed_size, &err);
-  free (compressed_json);
-  if (err != NULL)
+    "%s: serializing project to %s...", __func__, data->project_file_path);
+  gint64 time_before = g_get_monotonic_time ();
+  bool   success = project_serialize_to_json_chunks (
+    data->project, !data->is_backup,
+    (ProjectSerializationChunkCallback) write_chunk, data, &err);
+
+  if (thread)
     {
-      g_critical (
-        "%s: Unable to write project file: %s", __func__, err->message);
-      g_error_free (err);
-      data->has_error = true;
+      /* mark the end and wait for the rest to be
+       * written */
+      g_async_queue_push (data->chunks, g_bytes_new (NULL, 0));
+      g_thread_join (thread);
+      g_async_queue_unref (data->chunks);
+      data->chunks = NULL;
+      zix_sem_destroy (&data->chunk_slots);
+
+      if (data->write_error)
+        {
+          if (success)
+            {
+              err = data->write_error;
+              success = false;
+            }
+          else
+            {
+              g_error_free (data->write_error);
+            }
+          data->write_error = NULL;
+        }
+    }
+
+  GError * close_err = NULL;
+  bool     closed =
+    compression_file_writer_close (data->writer, !success, &close_err);
+  data->writer = NULL;
+  gint64 time_after = g_get_monotonic_time ();
+  g_message (
+    "time to serialize and write: %ldms",
+    (long) (time_after - time_before) / 1000);
+  if (!success)
+    {
+      if (close_err)
+        g_error_free (close_err);
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, _ ("Failed to serialize project"));
+      return false;
+    }
+  if (!closed)
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, close_err, _ ("Failed to write project file"));
+      return false;
     }
 
   g_message ("%s: successfully saved project", __func__);
 
-serialize_end:
-  zix_sem_post (&UNDO_MANAGER->action_sem);
-  data->finished = true;
-  return NULL;
+  return true;
 }
 
 /**
- * Idle func to check if the project has finished
- * saving and show a notification.
+ * Shows a notification after the project is saved.
  */
-static int
-project_idle_saved_cb (ProjectSaveData * data)
+static void
+notify_project_saved (ProjectSaveData * data)
 {
-  if (!data->finished)
-    {
-      return G_SOURCE_CONTINUE;
-    }
-
   if (data->is_backup)
     {
       g_message (_ ("Backup saved."));
@@ -858,8 +947,6 @@ project_idle_saved_cb (ProjectSaveData * data)
 
   progress_info_mark_completed (
     data->progress_info, PROGRESS_COMPLETED_SUCCESS, NULL);
-
-  return G_SOURCE_REMOVE;
 }
 
 /**
@@ -872,23 +959,9 @@ cleanup_plugin_state_dirs (ProjectSaveData * data)
   g_debug (
     "cleaning plugin state dirs%s...", data->is_backup ? " for backup" : "");
 
-  /* if saving backup, the temporary state dirs
-   * created during clone() are not needed by
-   * the main project so we just check what is
-   * needed from the main project and delete the
-   * rest.
-   * if saving the main project, the newly copied
-   * state dirs are used instead of the old ones,
-   * so we check the cloned project and delete
-   * the rest
-   *
-   * that said, there is still an issue
-   * (see https://todo.sr.ht/~alextee/zrythm-bug/1047)
-   * so just don't delete any plugins in either the clone
-   * or the current/main project
-   * */
+  /* keep the state dirs of the plugins in the project
+   * (including the undo history) and delete the rest */
   GPtrArray * arr = g_ptr_array_new ();
-  plugin_get_all (PROJECT, arr, true);
   plugin_get_all (data->project, arr, true);
   for (size_t i = 0; i < arr->len; i++)
     {
@@ -949,6 +1022,82 @@ cleanup_plugin_state_dirs (ProjectSaveData * data)
   g_debug ("cleaned plugin state dirs");
 }
 
+/**
+ * Saves the state of each instantiated plugin into its
+ * state directory.
+ */
+static bool
+save_plugin_states (Project * self, bool is_backup, GError ** error)
+{
+  GPtrArray * plugins = g_ptr_array_new ();
+  plugin_get_all (self, plugins, false);
+  for (size_t i = 0; i < plugins->len; i++)
+    {
+      Plugin * pl = (Plugin *) g_ptr_array_index (plugins, i);
+      if (!pl->instantiated)
+        continue;
+
+      if (pl->setting->open_with_carla)
+        {
+#ifdef HAVE_CARLA
+          GError * err = NULL;
+          bool     success =
+            carla_native_plugin_save_state (pl->carla, is_backup, NULL, &err);
+          if (!success)
+            {
+              PROPAGATE_PREFIXED_ERROR_LITERAL (
+                error, err, _ ("Failed saving Carla plugin state"));
+              g_ptr_array_unref (plugins);
+              return false;
+            }
+#else
+          g_warn_if_reached ();
+#endif
+        }
+      else
+        {
+          LilvState * state = lv2_state_save_to_file (pl->lv2, is_backup);
+          lilv_state_free (state);
+        }
+    }
+  g_ptr_array_unref (plugins);
+
+  return true;
+}
+
+/**
+ * Starts a new autosave journal on top of the project
+ * (or backup) that was just saved.
+ */
+static void
+reset_autosave_journal (Project * self, bool is_backup)
+{
+  char * path =
+    project_get_path (self, PROJECT_PATH_AUTOSAVE_JOURNAL, F_NOT_BACKUP);
+  if (self->autosave_journal)
+    {
+      /* the project was saved somewhere else */
+      if (!string_is_equal (self->autosave_journal->path, path))
+        {
+          autosave_journal_remove_file (self->autosave_journal);
+        }
+      object_free_w_func_and_null (
+        autosave_journal_free, self->autosave_journal);
+    }
+
+  char * checkpoint =
+    is_backup ? g_path_get_basename (self->backup_dir) : g_strdup ("");
+  GError * err = NULL;
+  self->autosave_journal = autosave_journal_new (path, checkpoint, &err);
+  if (!self->autosave_journal)
+    {
+      g_warning ("%s", err->message);
+      g_error_free (err);
+    }
+  g_free (checkpoint);
+  g_free (path);
+}
+
 /**
  * Saves the project to a project file in the
  * given dir.
@@ -957,8 +1106,9 @@ cleanup_plugin_state_dirs (ProjectSaveData * data)
  *   will be saved as <original filename>.bak<num>.
  * @param show_notification Show a notification
  *   in the UI that the project was saved.
- * @param async Save asynchronously in another
- *   thread.
+ * @param async Compress and write the file in
+ *   another thread while the project is being
+ *   serialized.
  *
  * @return Whether successful.
  */
@@ -1036,7 +1186,13 @@ project_save (
       return false;
     }
 
-  /* write the pool */
+  /* write the pool (the files of clips being recorded
+   * are written by the disk writer, so let it catch up
+   * first) */
+  if (RECORDING_MANAGER)
+    {
+      recording_manager_flush_takes (RECORDING_MANAGER);
+    }
   audio_pool_remove_unused (AUDIO_POOL, is_backup);
   success = audio_pool_write_to_disk (AUDIO_POOL, is_backup, &err);
   if (!success)
@@ -1046,67 +1202,6 @@ project_save (
       return false;
     }
 
-  ProjectSaveData * data = project_save_data_new ();
-  data->project_file_path =
-    project_get_path (self, PROJECT_PATH_PROJECT_FILE, is_backup);
-  data->show_notification = show_notification;
-  data->is_backup = is_backup;
-  data->project = project_clone (PROJECT, is_backup, &err);
-  if (!data->project)
-    {
-      PROPAGATE_PREFIXED_ERROR (error, err, "%s", _ ("Failed to clone project"));
-      return false;
-    }
-  g_return_val_if_fail (data->project->tracklist_selections, false);
-  data->project->tracklist_selections->free_tracks = true;
-
-#if 0
-  /* write plugin states */
-  GPtrArray * plugins =
-    g_ptr_array_new_full (100, NULL);
-  tracklist_get_plugins (self->tracklist, plugins);
-  for (size_t i = 0; i < plugins->len; i++)
-    {
-      Plugin * pl = g_ptr_array_index (plugins, i);
-
-      if (!pl->instantiated)
-        {
-          g_debug (
-            "skipping uninstantiated plugin %s...",
-            pl->setting->descr->name);
-          continue;
-        }
-
-      /* save state */
-#  ifdef HAVE_CARLA
-      if (pl->setting->open_with_carla)
-        {
-          carla_native_plugin_save_state (
-            pl->carla, is_backup, NULL);
-        }
-      else
-        {
-#  endif
-          switch (pl->setting->descr->protocol)
-            {
-            case PROT_LV2:
-              {
-                LilvState * tmp_state =
-                  lv2_state_save_to_file (
-                    pl->lv2, is_backup);
-                lilv_state_free (tmp_state);
-              }
-              break;
-            default:
-              g_warn_if_reached ();
-              break;
-            }
-#  ifdef HAVE_CARLA
-        }
-#  endif
-    }
-#endif
-
   if (is_backup)
     {
       /* copy plugin states */
@@ -1125,6 +1220,22 @@ project_save (
         }
     }
 
+  /* write plugin states */
+  success = save_plugin_states (self, is_backup, &err);
+  if (!success)
+    {
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, "Failed to save plugin states");
+      return false;
+    }
+
+  ProjectSaveData * data = project_save_data_new ();
+  data->project_file_path =
+    project_get_path (self, PROJECT_PATH_PROJECT_FILE, is_backup);
+  data->show_notification = show_notification;
+  data->is_backup = is_backup;
+  data->project = self;
+
   if (!is_backup)
     {
       /* cleanup unused plugin states (or do it when executing
@@ -1134,34 +1245,25 @@ project_save (
 
   /* TODO verify all plugin states exist */
 
+  success = write_project_file (data, async, &err);
+  data->has_error = !success;
+  data->finished = true;
   if (async)
     {
-      g_thread_new (
-        "serialize_project_thread", (GThreadFunc) serialize_project_thread,
-        data);
-
-      /* TODO: show progress dialog */
-      if (ZRYTHM_HAVE_UI && false)
-        {
-          g_idle_add ((GSourceFunc) project_idle_saved_cb, data);
-
-          /* show progress while saving (TODO) */
-        }
-      else
-        {
-          while (!data->finished)
-            {
-              g_usleep (1000);
-            }
-          project_idle_saved_cb (data);
-        }
+      zix_sem_post (&UNDO_MANAGER->action_sem);
     }
-  else /* else if no async */
+  if (!success)
     {
-      /* call synchronously */
-      serialize_project_thread (data);
-      project_idle_saved_cb (data);
+      object_free_w_func_and_null (project_save_data_free, data);
+      if (engine_paused)
+        {
+          engine_resume (AUDIO_ENGINE, &state);
+        }
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        error, err, _ ("Failed to save project"));
+      return false;
     }
+  notify_project_saved (data);
 
   object_free_w_func_and_null (project_save_data_free, data);
 
@@ -1187,6 +1289,8 @@ project_save (
       self->last_saved_action = last_action;
     }
 
+  reset_autosave_journal (self, is_backup);
+
   if (engine_paused)
     {
       engine_resume (AUDIO_ENGINE, &state);
@@ -1205,76 +1309,6 @@ project_has_unsaved_changes (const Project * self)
   return last_performed_action != self->last_saved_action;
 }
 
-/**
- * Deep-clones the given project.
- *
- * To be used during save on the main thread.
- *
- * @param for_backup Whether the resulting project
- *   is for a backup.
- */
-Project *
-project_clone (const Project * src, bool for_backup, GError ** error)
-{
-  g_return_val_if_fail (ZRYTHM_APP_IS_GTK_THREAD, NULL);
-  g_message ("cloning project...");
-
-  Project * self = object_new (Project);
-  /*self->schema_version = PROJECT_SCHEMA_VERSION;*/
-
-  self->title = g_strdup (src->title);
-  self->datetime_str = g_strdup (src->datetime_str);
-  self->version = g_strdup (src->version);
-  self->tracklist = tracklist_clone (src->tracklist);
-  self->clip_editor = clip_editor_clone (src->clip_editor);
-  self->timeline = timeline_clone (src->timeline);
-  self->snap_grid_timeline = snap_grid_clone (src->snap_grid_timeline);
-  self->snap_grid_editor = snap_grid_clone (src->snap_grid_editor);
-  self->quantize_opts_timeline =
-    quantize_options_clone (src->quantize_opts_timeline);
-  self->quantize_opts_editor =
-    quantize_options_clone (src->quantize_opts_editor);
-  self->audio_engine = engine_clone (src->audio_engine);
-  self->mixer_selections =
-    mixer_selections_clone (src->mixer_selections, F_PROJECT);
-  self->timeline_selections = (TimelineSelections *) arranger_selections_clone (
-    (ArrangerSelections *) src->timeline_selections);
-  self->midi_arranger_selections =
-    (MidiArrangerSelections *) arranger_selections_clone (
-      (ArrangerSelections *) src->midi_arranger_selections);
-  self->chord_selections = (ChordSelections *) arranger_selections_clone (
-    (ArrangerSelections *) src->chord_selections);
-  self->automation_selections = (AutomationSelections *)
-    arranger_selections_clone ((ArrangerSelections *) src->automation_selections);
-  self->audio_selections = (AudioSelections *) arranger_selections_clone (
-    (ArrangerSelections *) src->audio_selections);
-  GError * err = NULL;
-  self->tracklist_selections =
-    tracklist_selections_clone (src->tracklist_selections, &err);
-  if (!self->tracklist_selections)
-    {
-      PROPAGATE_PREFIXED_ERROR (
-        error, err, "%s", "Failed to clone track selections");
-      return NULL;
-    }
-  self->tracklist_selections->is_project = true;
-  self->region_link_group_manager =
-    region_link_group_manager_clone (src->region_link_group_manager);
-  self->port_connections_manager =
-    port_connections_manager_clone (src->port_connections_manager);
-  self->midi_mappings = midi_mappings_clone (src->midi_mappings);
-
-  /* no undo history in backups */
-  if (!for_backup)
-    {
-      self->undo_manager = undo_manager_clone (src->undo_manager);
-    }
-
-  g_message ("finished cloning project");
-
-  return self;
-}
-
 /**
  * Frees the selections in the project.
  */
@@ -1315,6 +1349,14 @@ project_free (Project * self)
    * track */
   self->clip_editor->has_region = false;
 
+  /* the journal is only needed after a crash */
+  if (self->autosave_journal)
+    {
+      autosave_journal_remove_file (self->autosave_journal);
+      object_free_w_func_and_null (
+        autosave_journal_free, self->autosave_journal);
+    }
+
   object_free_w_func_and_null (undo_manager_free, self->undo_manager);
 
   /* must be free'd before tracklist selections,
@@ -0,0 +1,301 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include <stdio.h>
+#include <string.h>
+
+#include "actions/undo_manager.h"
+#include "actions/undoable_action.h"
+#include "io/serialization/actions.h"
+#include "project/autosave_journal.h"
+#include "utils/error.h"
+#include "utils/io.h"
+#include "utils/objects.h"
+
+#include <glib/gstdio.h>
+
+#include <yyjson.h>
+
+typedef enum
+{
+  Z_PROJECT_AUTOSAVE_JOURNAL_ERROR_FAILED,
+} ZProjectAutosaveJournalError;
+
+#define Z_PROJECT_AUTOSAVE_JOURNAL_ERROR \
+  z_project_autosave_journal_error_quark ()
+GQuark
+z_project_autosave_journal_error_quark (void);
+G_DEFINE_QUARK (
+  z - project - autosave - journal - error - quark,
+  z_project_autosave_journal_error)
+
+/**
+ * Creates a journal for the given checkpoint, replacing
+ * any existing journal file at @p path.
+ */
+AutosaveJournal *
+autosave_journal_new (
+  const char * path,
+  const char * checkpoint,
+  GError **    error)
+{
+  yyjson_mut_doc * doc = yyjson_mut_doc_new (NULL);
+  yyjson_mut_val * root = yyjson_mut_obj (doc);
+  yyjson_mut_doc_set_root (doc, root);
+  yyjson_mut_obj_add_int (doc, root, "version", AUTOSAVE_JOURNAL_VERSION);
+  yyjson_mut_obj_add_str (doc, root, "checkpoint", checkpoint);
+  char * json = yyjson_mut_write (doc, YYJSON_WRITE_NOFLAG, NULL);
+  yyjson_mut_doc_free (doc);
+  char * header = g_strdup_printf ("%s\n", json);
+  free (json);
+
+  GError * err = NULL;
+  bool     success = g_file_set_contents (path, header, -1, &err);
+  g_free (header);
+  if (!success)
+    {
+      PROPAGATE_PREFIXED_ERROR (
+        error, err, "Failed to create autosave journal %s", path);
+      return NULL;
+    }
+
+  AutosaveJournal * self = object_new (AutosaveJournal);
+  self->path = g_strdup (path);
+  self->checkpoint = g_strdup (checkpoint);
+  self->pending = g_string_new (NULL);
+
+  return self;
+}
+
+/**
+ * Serializes the action into a record.
+ */
+char *
+autosave_journal_serialize_action (
+  const UndoableAction * action,
+  AutosaveJournalOp      op)
+{
+  yyjson_mut_doc * doc = yyjson_mut_doc_new (NULL);
+  yyjson_mut_val * root = yyjson_mut_obj (doc);
+  yyjson_mut_doc_set_root (doc, root);
+  yyjson_mut_obj_add_int (doc, root, "op", op);
+  yyjson_mut_val * action_obj = yyjson_mut_obj_add_obj (doc, root, "action");
+
+  GError * err = NULL;
+  char *   record = NULL;
+  if (undoable_action_serialize_typed_to_json (doc, action_obj, action, &err))
+    {
+      char * json = yyjson_mut_write (doc, YYJSON_WRITE_NOFLAG, NULL);
+      record = g_strdup (json);
+      free (json);
+    }
+  else
+    {
+      g_warning ("Failed to serialize action for the journal: %s", err->message);
+      g_error_free (err);
+    }
+  yyjson_mut_doc_free (doc);
+
+  return record;
+}
+
+/**
+ * Appends a record to the journal.
+ */
+void
+autosave_journal_append (AutosaveJournal * self, char * record)
+{
+  if (self->broken)
+    {
+      g_free (record);
+      return;
+    }
+  if (!record)
+    {
+      g_message (
+        "autosave journal is missing an action, waiting for the next "
+        "backup");
+      self->broken = true;
+      return;
+    }
+
+  g_string_append (self->pending, record);
+  g_string_append_c (self->pending, '\n');
+  self->num_records++;
+  g_free (record);
+}
+
+/**
+ * Writes the pending records to the file.
+ */
+bool
+autosave_journal_flush (AutosaveJournal * self, GError ** error)
+{
+  if (self->pending->len == 0)
+    return true;
+
+  FILE * f = g_fopen (self->path, "ab");
+  bool   success = f != NULL;
+  if (success)
+    {
+      size_t written =
+        fwrite (self->pending->str, 1, self->pending->len, f);
+      success = written == self->pending->len;
+
+      /* drop what made it to the file so that a partial
+       * write doesn't duplicate records on the next
+       * attempt */
+      g_string_erase (self->pending, 0, (gssize) written);
+      success = fclose (f) == 0 && success;
+    }
+  if (!success)
+    {
+      /* keep the remaining records for the next attempt */
+      g_set_error (
+        error, Z_PROJECT_AUTOSAVE_JOURNAL_ERROR,
+        Z_PROJECT_AUTOSAVE_JOURNAL_ERROR_FAILED,
+        "Failed to write autosave journal %s", self->path);
+      return false;
+    }
+
+  g_string_truncate (self->pending, 0);
+
+  return true;
+}
+
+/**
+ * Returns whether a full backup should be saved to
+ * start a new journal.
+ */
+bool
+autosave_journal_needs_compaction (const AutosaveJournal * self)
+{
+  return self->broken || self->num_records >= AUTOSAVE_JOURNAL_MAX_RECORDS;
+}
+
+static bool
+header_matches (const char * line, const char * checkpoint)
+{
+  yyjson_doc * doc = yyjson_read (line, strlen (line), 0);
+  yyjson_val * root = yyjson_doc_get_root (doc);
+  bool         matches =
+    root
+    && yyjson_get_int (yyjson_obj_get (root, "version"))
+         == AUTOSAVE_JOURNAL_VERSION
+    && yyjson_equals_str (yyjson_obj_get (root, "checkpoint"), checkpoint);
+  yyjson_doc_free (doc);
+
+  return matches;
+}
+
+/**
+ * Reads the records of the journal file at @p path.
+ */
+GPtrArray *
+autosave_journal_read_records (const char * path, const char * checkpoint)
+{
+  char * contents = NULL;
+  if (!g_file_get_contents (path, &contents, NULL, NULL))
+    return NULL;
+
+  char **     lines = g_strsplit (contents, "\n", -1);
+  GPtrArray * records = NULL;
+  if (lines[0] && header_matches (lines[0], checkpoint))
+    {
+      records = g_ptr_array_new_with_free_func (g_free);
+
+      /* the last line is either empty or a record that
+       * was cut off while writing */
+      for (int i = 1; lines[i] && lines[i + 1]; i++)
+        {
+          if (strlen (lines[i]) > 0)
+            g_ptr_array_add (records, g_strdup (lines[i]));
+        }
+    }
+  else
+    {
+      g_message ("ignoring autosave journal not based on '%s'", checkpoint);
+    }
+
+  g_strfreev (lines);
+  g_free (contents);
+
+  return records;
+}
+
+/**
+ * Re-applies the records to the project, stopping at the
+ * first one that fails.
+ */
+bool
+autosave_journal_replay_records (
+  GPtrArray *   records,
+  UndoManager * undo_manager,
+  int *         num_replayed,
+  GError **     error)
+{
+  *num_replayed = 0;
+  for (guint i = 0; i < records->len; i++)
+    {
+      const char * record = g_ptr_array_index (records, i);
+      yyjson_doc * doc = yyjson_read (record, strlen (record), 0);
+      yyjson_val * root = yyjson_doc_get_root (doc);
+      yyjson_val * action_obj = root ? yyjson_obj_get (root, "action") : NULL;
+      if (!action_obj)
+        {
+          yyjson_doc_free (doc);
+          g_set_error (
+            error, Z_PROJECT_AUTOSAVE_JOURNAL_ERROR,
+            Z_PROJECT_AUTOSAVE_JOURNAL_ERROR_FAILED, "Invalid record %u", i);
+          return false;
+        }
+
+      AutosaveJournalOp op =
+        (AutosaveJournalOp) yyjson_get_int (yyjson_obj_get (root, "op"));
+      GError *         err = NULL;
+      UndoableAction * action =
+        undoable_action_deserialize_typed_from_json (doc, action_obj, &err);
+      yyjson_doc_free (doc);
+      if (!action)
+        {
+          PROPAGATE_PREFIXED_ERROR (
+            error, err, "Failed to deserialize record %u", i);
+          return false;
+        }
+      undoable_action_init_loaded (action);
+
+      int ret = undo_manager_replay (undo_manager, action, op, &err);
+      if (ret != 0)
+        {
+          undoable_action_free (action);
+          PROPAGATE_PREFIXED_ERROR (error, err, "Failed to replay record %u", i);
+          return false;
+        }
+      (*num_replayed)++;
+    }
+
+  return true;
+}
+
+/**
+ * Removes the journal file.
+ */
+void
+autosave_journal_remove_file (AutosaveJournal * self)
+{
+  if (g_file_test (self->path, G_FILE_TEST_EXISTS))
+    {
+      io_remove (self->path);
+    }
+}
+
+void
+autosave_journal_free (AutosaveJournal * self)
+{
+  g_free_and_null (self->path);
+  g_free_and_null (self->checkpoint);
+  if (self->pending)
+    g_string_free (self->pending, true);
+
+  object_zero_and_free (self);
+}
@@ -14,6 +14,7 @@
 #include "gui/backend/event.h"
 #include "gui/backend/event_manager.h"
 #include "gui/widgets/center_dock.h"
+#include "gui/widgets/dialogs/generic_progress_dialog.h"
 #include "gui/widgets/greeter.h"
 #include "gui/widgets/main_notebook.h"
 #include "gui/widgets/main_window.h"
@@ -28,6 +29,7 @@
 #include "utils/flags.h"
 #include "utils/io.h"
 #include "utils/objects.h"
+#include "utils/progress_info.h"
 #include "utils/ui.h"
 #include "zrythm_app.h"
 
@@ -722,6 +724,180 @@ replace_main_window (MainWindowWidget * mww)
     }
 }
 
+/**
+ * Replays the actions done after the loaded project (or
+ * backup) was saved, if the previous session did not end
+ * normally, and starts a new journal.
+ */
+static void
+recover_from_autosave_journal (Project * self, bool use_backup)
+{
+  char * path =
+    project_get_path (self, PROJECT_PATH_AUTOSAVE_JOURNAL, F_NOT_BACKUP);
+  char * checkpoint =
+    use_backup ? g_path_get_basename (self->backup_dir) : g_strdup ("");
+  GPtrArray * records = autosave_journal_read_records (path, checkpoint);
+
+  /* the replayed actions are recorded again in the new
+   * journal */
+  GError * err = NULL;
+  object_free_w_func_and_null (autosave_journal_free, self->autosave_journal);
+  self->autosave_journal = autosave_journal_new (path, checkpoint, &err);
+  if (!self->autosave_journal)
+    {
+      g_warning ("%s", err->message);
+      g_error_free (err);
+      err = NULL;
+    }
+
+  if (records && records->len > 0)
+    {
+      g_message ("replaying %u actions from the autosave journal", records->len);
+      int  num_replayed = 0;
+      bool success = autosave_journal_replay_records (
+        records, self->undo_manager, &num_replayed, &err);
+      if (!success)
+        {
+          g_warning (
+            "Failed to replay the autosave journal: %s", err->message);
+          g_error_free (err);
+          err = NULL;
+        }
+      if (
+        self->autosave_journal
+        && !autosave_journal_flush (self->autosave_journal, &err))
+        {
+          g_warning ("%s", err->message);
+          g_error_free (err);
+        }
+      ui_show_notification_idle_printf (
+        _ ("Recovered %d of %u unsaved actions"), num_replayed, records->len);
+    }
+
+  object_free_w_func_and_null (g_ptr_array_unref, records);
+  g_free (checkpoint);
+  g_free (path);
+}
+
+/**
+ * Shows the error and exits when the audio pool of the
+ * loaded project could not be initialized.
+ */
+static void
+handle_failed_to_init_pool (GError * err)
+{
+  AdwDialog * err_win = error_handle_prv (
+    err, "%s", _ ("Failed to initialize the audio file pool"));
+  g_signal_connect (
+    err_win, "closed", G_CALLBACK (zrythm_exit_response_callback), NULL);
+}
+
+/**
+ * State of the project load while the clips in the pool
+ * are decoded.
+ */
+typedef struct InitPoolData
+{
+  ProjectInitFlowManager * flow_mgr;
+  Project *                project;
+  MainWindowWidget *       mww;
+  bool                     use_backup;
+  int                      yaml_schema_ver;
+
+  ProgressInfo *                progress_info;
+  GenericProgressDialogWidget * dialog;
+  GThread *                     thread;
+  bool                          successful;
+  GError *                      error;
+} InitPoolData;
+
+static void
+continue_load_after_init_pool (InitPoolData * data);
+
+/**
+ * Called on the GTK thread after the clips were
+ * decoded.
+ */
+static int
+on_pool_initialized (InitPoolData * data)
+{
+  if (data->thread)
+    {
+      g_thread_join (data->thread);
+    }
+  if (data->dialog)
+    {
+      adw_dialog_force_close (ADW_DIALOG (data->dialog));
+    }
+
+  progress_info_mark_completed (
+    data->progress_info,
+    data->successful
+      ? PROGRESS_COMPLETED_SUCCESS
+      : PROGRESS_COMPLETED_HAS_ERROR,
+    NULL);
+  progress_info_free (data->progress_info);
+
+  if (data->successful)
+    {
+      continue_load_after_init_pool (data);
+    }
+  else
+    {
+      GError * err = NULL;
+      PROPAGATE_PREFIXED_ERROR_LITERAL (
+        &err, data->error, _ ("Failed to load audio clips"));
+      handle_failed_to_init_pool (err);
+    }
+
+  object_zero_and_free (data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static gpointer
+init_pool_thread (InitPoolData * data)
+{
+  data->successful = audio_pool_init_loaded (
+    data->project->audio_engine->pool, data->progress_info, &data->error);
+  g_idle_add ((GSourceFunc) on_pool_initialized, data);
+
+  return NULL;
+}
+
+/**
+ * Decodes the clips in the pool of the loaded project
+ * and then continues loading it.
+ *
+ * When there is a UI, the clips are decoded in a
+ * separate thread while the progress is shown in a
+ * dialog, and loading continues from an idle callback
+ * when done.
+ */
+static void
+init_pool_and_continue_load (InitPoolData * data)
+{
+  data->progress_info = progress_info_new ();
+
+  if (ZRYTHM_HAVE_UI)
+    {
+      data->dialog = generic_progress_dialog_widget_new ();
+      generic_progress_dialog_widget_setup (
+        data->dialog, _ ("Loading Project"), data->progress_info,
+        _ ("Loading audio clips..."), true, NULL, NULL, false);
+      adw_dialog_present (ADW_DIALOG (data->dialog), NULL);
+
+      data->thread = g_thread_new (
+        "init_pool_thread", (GThreadFunc) init_pool_thread, data);
+    }
+  else
+    {
+      data->successful = audio_pool_init_loaded (
+        data->project->audio_engine->pool, data->progress_info, &data->error);
+      on_pool_initialized (data);
+    }
+}
+
 static void
 continue_load_from_file_after_open_backup_response (
   ProjectInitFlowManager * flow_mgr)
@@ -964,24 +1140,34 @@ continue_load_from_file_after_open_backup_response (
   bool success = engine_init_loaded (self->audio_engine, self, &err);
   if (!success)
     {
-on_failed_to_init_pool:
-  {
-    AdwDialog * err_win = error_handle_prv (
-      err, "%s", _ ("Failed to initialize the audio file pool"));
-    g_signal_connect (
-      err_win, "closed", G_CALLBACK (zrythm_exit_response_callback), NULL);
-    return;
-  }
+      handle_failed_to_init_pool (err);
+      return;
     }
   engine_pre_setup (self->audio_engine);
 
-  /* re-load clips because sample rate can change during engine pre setup */
-  err = NULL;
-  success = audio_pool_init_loaded (self->audio_engine->pool, &err);
-  if (!success)
-    {
-      goto on_failed_to_init_pool;
-    }
+  /* load the clips after engine pre setup because the
+   * sample rate can change */
+  InitPoolData * data = object_new (InitPoolData);
+  data->flow_mgr = flow_mgr;
+  data->project = self;
+  data->mww = mww;
+  data->use_backup = use_backup;
+  data->yaml_schema_ver = yaml_schema_ver;
+  init_pool_and_continue_load (data);
+}
+
+/**
+ * Finishes loading the project after the clips in the
+ * pool were decoded.
+ */
+static void
+continue_load_after_init_pool (InitPoolData * data)
+{
+  ProjectInitFlowManager * flow_mgr = data->flow_mgr;
+  Project *                self = data->project;
+  MainWindowWidget *       mww = data->mww;
+  bool                     use_backup = data->use_backup;
+  int                      yaml_schema_ver = data->yaml_schema_ver;
 
   clip_editor_init_loaded (self->clip_editor);
   timeline_init_loaded (self->timeline);
@@ -1073,6 +1259,11 @@ on_failed_to_init_pool:
   g_message ("setting up main window...");
   setup_main_window (self);
 
+  if (!flow_mgr->is_template)
+    {
+      recover_from_autosave_journal (self, use_backup);
+    }
+
   engine_set_run (self->audio_engine, true);
 
   if (self->format_minor != PROJECT_FORMAT_MINOR || yaml_schema_ver > 0)
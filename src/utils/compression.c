@@ -1,7 +1,13 @@
 // SPDX-FileCopyrightText: © 2023-2024 Alexandros Theodotou <alex@zrythm.org>
 // SPDX-License-Identifier: LicenseRef-ZrythmLicense
 
+#include <stdio.h>
+
 #include "utils/compression.h"
+#include "utils/io.h"
+#include "utils/objects.h"
+
+#include <glib/gstdio.h>
 
 #include <zstd.h>
 
@@ -15,6 +21,22 @@ GQuark
 z_utils_compression_error_quark (void);
 G_DEFINE_QUARK (z - utils - compression - error - quark, z_utils_compression_error)
 
+struct CompressionFileWriter
+{
+  ZSTD_CStream * stream;
+
+  /** Temporary file being written. */
+  FILE * file;
+  char * tmp_path;
+
+  /** Final path. */
+  char * path;
+
+  /** Buffer for the compressed output. */
+  char * out_buf;
+  size_t out_buf_size;
+};
+
 char *
 compression_compress_to_base64_str (const char * src, GError ** error)
 {
@@ -87,3 +109,206 @@ compression_decompress_from_base64_str (const char * b64, GError ** error)
 
   return dest;
 }
+
+char *
+compression_compress (
+  const char * src,
+  size_t       src_size,
+  size_t *     dest_size,
+  GError **    error)
+{
+  size_t compress_bound = ZSTD_compressBound (src_size);
+  char * dest = malloc (compress_bound);
+  size_t ret = ZSTD_compress (dest, compress_bound, src, src_size, 1);
+  if (ZSTD_isError (ret))
+    {
+      free (dest);
+
+      g_set_error (
+        error, Z_UTILS_COMPRESSION_ERROR, Z_UTILS_COMPRESSION_ERROR_FAILED,
+        "Failed to compress: %s", ZSTD_getErrorName (ret));
+      return NULL;
+    }
+
+  *dest_size = ret;
+  return dest;
+}
+
+char *
+compression_decompress_stream (
+  const char * src,
+  size_t       src_size,
+  size_t *     dest_size,
+  GError **    error)
+{
+  ZSTD_DStream * stream = ZSTD_createDStream ();
+  ZSTD_initDStream (stream);
+
+  /* grow the output as needed since the frame may not
+   * contain its decompressed size */
+  size_t         capacity = MAX (src_size * 4, ZSTD_DStreamOutSize ());
+  char *         dest = malloc (capacity);
+  ZSTD_inBuffer  in = { src, src_size, 0 };
+  ZSTD_outBuffer out = { dest, capacity, 0 };
+  size_t         ret = 1;
+  bool           success = true;
+  while (success && ret != 0)
+    {
+      if (out.pos == out.size)
+        {
+          capacity *= 2;
+          dest = realloc (dest, capacity);
+          out.dst = dest;
+          out.size = capacity;
+        }
+      ret = ZSTD_decompressStream (stream, &out, &in);
+      if (ZSTD_isError (ret))
+        {
+          g_set_error (
+            error, Z_UTILS_COMPRESSION_ERROR, Z_UTILS_COMPRESSION_ERROR_FAILED,
+            "Failed to decompress: %s", ZSTD_getErrorName (ret));
+          success = false;
+        }
+      else if (ret != 0 && in.pos == in.size && out.pos < out.size)
+        {
+          g_set_error_literal (
+            error, Z_UTILS_COMPRESSION_ERROR, Z_UTILS_COMPRESSION_ERROR_FAILED,
+            "Truncated zstd frame");
+          success = false;
+        }
+    }
+  ZSTD_freeDStream (stream);
+  if (!success)
+    {
+      free (dest);
+      return NULL;
+    }
+
+  *dest_size = out.pos;
+  return dest;
+}
+
+CompressionFileWriter *
+compression_file_writer_new (const char * path, GError ** error)
+{
+  CompressionFileWriter * self = object_new (CompressionFileWriter);
+  self->path = g_strdup (path);
+  self->tmp_path = g_strdup_printf ("%s.tmp", path);
+  self->file = g_fopen (self->tmp_path, "wb");
+  if (!self->file)
+    {
+      g_set_error (
+        error, Z_UTILS_COMPRESSION_ERROR, Z_UTILS_COMPRESSION_ERROR_FAILED,
+        "Failed to open %s for writing", self->tmp_path);
+      g_free (self->tmp_path);
+      g_free (self->path);
+      object_zero_and_free (self);
+      return NULL;
+    }
+
+  self->stream = ZSTD_createCStream ();
+  ZSTD_initCStream (self->stream, 1);
+  self->out_buf_size = ZSTD_CStreamOutSize ();
+  self->out_buf = malloc (self->out_buf_size);
+
+  return self;
+}
+
+/**
+ * Writes the compressed output in @p out to the file.
+ */
+static bool
+flush_output (
+  CompressionFileWriter * self,
+  ZSTD_outBuffer *        out,
+  GError **               error)
+{
+  if (fwrite (self->out_buf, 1, out->pos, self->file) != out->pos)
+    {
+      g_set_error (
+        error, Z_UTILS_COMPRESSION_ERROR, Z_UTILS_COMPRESSION_ERROR_FAILED,
+        "Failed to write to %s", self->tmp_path);
+      return false;
+    }
+  out->pos = 0;
+  return true;
+}
+
+bool
+compression_file_writer_write (
+  CompressionFileWriter * self,
+  const char *            data,
+  size_t                  size,
+  GError **               error)
+{
+  ZSTD_inBuffer  in = { data, size, 0 };
+  ZSTD_outBuffer out = { self->out_buf, self->out_buf_size, 0 };
+  while (in.pos < in.size)
+    {
+      size_t ret = ZSTD_compressStream (self->stream, &out, &in);
+      if (ZSTD_isError (ret))
+        {
+          g_set_error (
+            error, Z_UTILS_COMPRESSION_ERROR, Z_UTILS_COMPRESSION_ERROR_FAILED,
+            "Failed to compress: %s", ZSTD_getErrorName (ret));
+          return false;
+        }
+      if (!flush_output (self, &out, error))
+        return false;
+    }
+
+  return true;
+}
+
+bool
+compression_file_writer_close (
+  CompressionFileWriter * self,
+  bool                    discard,
+  GError **               error)
+{
+  bool success = !discard;
+
+  /* flush the rest of the frame */
+  ZSTD_outBuffer out = { self->out_buf, self->out_buf_size, 0 };
+  size_t         remaining = 1;
+  while (success && remaining != 0)
+    {
+      remaining = ZSTD_endStream (self->stream, &out);
+      if (ZSTD_isError (remaining))
+        {
+          g_set_error (
+            error, Z_UTILS_COMPRESSION_ERROR, Z_UTILS_COMPRESSION_ERROR_FAILED,
+            "Failed to compress: %s", ZSTD_getErrorName (remaining));
+          success = false;
+          break;
+        }
+      success = flush_output (self, &out, error);
+    }
+
+  if (fclose (self->file) != 0 && success)
+    {
+      g_set_error (
+        error, Z_UTILS_COMPRESSION_ERROR, Z_UTILS_COMPRESSION_ERROR_FAILED,
+        "Failed to close %s", self->tmp_path);
+      success = false;
+    }
+  if (success && g_rename (self->tmp_path, self->path) != 0)
+    {
+      g_set_error (
+        error, Z_UTILS_COMPRESSION_ERROR, Z_UTILS_COMPRESSION_ERROR_FAILED,
+        "Failed to move %s to %s", self->tmp_path, self->path);
+      success = false;
+    }
+  if (!success)
+    {
+      io_remove (self->tmp_path);
+    }
+
+  ZSTD_freeCStream (self->stream);
+  free (self->out_buf);
+  g_free (self->tmp_path);
+  g_free (self->path);
+  object_zero_and_free (self);
+
+  return success;
+}
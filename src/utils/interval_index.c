@@ -0,0 +1,286 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+/*
+ * This file incorporates work covered by the following copyright and
+ * permission notice:
+ *
+ * ---
+ *
+ * The MIT License
+ *
+ * Copyright (c) 2019 Dana-Farber Cancer Institute
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining
+ * a copy of this software and associated documentation files (the
+ * "Software"), to deal in the Software without restriction, including
+ * without limitation the rights to use, copy, modify, merge, publish,
+ * distribute, sublicense, and/or sell copies of the Software, and to
+ * permit persons to whom the Software is furnished to do so, subject to
+ * the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be
+ * included in all copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+ * EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+ * MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+ * NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+ * BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+ * ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ *
+ * SPDX-License-Identifier: MIT
+ *
+ * ---
+ */
+
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "utils/interval_index.h"
+#include "utils/objects.h"
+
+#include <glib.h>
+
+/** Subtrees at or below this level are scanned
+ * linearly. */
+#define LINEAR_SCAN_LEVEL 3
+
+/** Hits above this number are sorted with a heap sort
+ * instead of an insertion sort. */
+#define INSERTION_SORT_MAX_HITS 32
+
+typedef struct StackEntry
+{
+  int64_t x;
+  int     level;
+  bool    left_done;
+} StackEntry;
+
+IntervalIndex *
+interval_index_new (size_t num_items)
+{
+  IntervalIndex * self = object_new (IntervalIndex);
+
+  self->items_size = MAX (num_items, 1);
+  self->items = object_new_n (self->items_size, IntervalIndexItem);
+  self->hits = object_new_n (self->items_size, int);
+  self->root_level = -1;
+
+  return self;
+}
+
+void
+interval_index_add (IntervalIndex * self, int64_t start, int64_t end, int idx)
+{
+  if (self->num_items == self->items_size)
+    {
+      size_t new_size = self->items_size * 2;
+      self->items =
+        g_realloc_n (self->items, new_size, sizeof (IntervalIndexItem));
+      self->hits = g_realloc_n (self->hits, new_size, sizeof (int));
+      self->items_size = new_size;
+    }
+
+  IntervalIndexItem * item = &self->items[self->num_items++];
+  item->start = start;
+  item->end = end + 1;
+  item->max_end = item->end;
+  item->idx = idx;
+}
+
+static int
+item_cmp (const void * a, const void * b)
+{
+  const IntervalIndexItem * item_a = (const IntervalIndexItem *) a;
+  const IntervalIndexItem * item_b = (const IntervalIndexItem *) b;
+  if (item_a->start != item_b->start)
+    return item_a->start < item_b->start ? -1 : 1;
+  return item_a->idx - item_b->idx;
+}
+
+void
+interval_index_build (IntervalIndex * self)
+{
+  IntervalIndexItem * a = self->items;
+  int64_t             n = (int64_t) self->num_items;
+  if (n == 0)
+    {
+      self->root_level = -1;
+      return;
+    }
+
+  qsort (a, self->num_items, sizeof (IntervalIndexItem), item_cmp);
+
+  /* leaves (level 0) */
+  int64_t last_i = 0;
+  int64_t last = 0;
+  for (int64_t i = 0; i < n; i += 2)
+    {
+      last_i = i;
+      last = a[i].max_end = a[i].end;
+    }
+
+  /* internal nodes, bottom-up */
+  int k;
+  for (k = 1; (1LL << k) <= n; ++k)
+    {
+      int64_t x = 1LL << (k - 1);
+      int64_t i0 = (x << 1) - 1;
+      int64_t step = x << 2;
+      for (int64_t i = i0; i < n; i += step)
+        {
+          int64_t el = a[i - x].max_end;
+          int64_t er = i + x < n ? a[i + x].max_end : last;
+          int64_t e = a[i].end;
+          e = MAX (e, el);
+          e = MAX (e, er);
+          a[i].max_end = e;
+        }
+      /* last_i now points to the parent of the previous
+       * last_i */
+      last_i = (last_i >> k & 1) ? last_i - x : last_i + x;
+      if (last_i < n && a[last_i].max_end > last)
+        last = a[last_i].max_end;
+    }
+
+  self->root_level = k - 1;
+}
+
+static void
+sift_down (int * a, size_t root, size_t n)
+{
+  int val = a[root];
+  while (root * 2 + 1 < n)
+    {
+      size_t child = root * 2 + 1;
+      if (child + 1 < n && a[child + 1] > a[child])
+        child++;
+      if (a[child] <= val)
+        break;
+      a[root] = a[child];
+      root = child;
+    }
+  a[root] = val;
+}
+
+/**
+ * In-place heap sort (does not allocate).
+ */
+static void
+heap_sort (int * a, size_t n)
+{
+  for (size_t i = n / 2; i-- > 0;)
+    {
+      sift_down (a, i, n);
+    }
+  for (size_t i = n - 1; i > 0; i--)
+    {
+      int tmp = a[0];
+      a[0] = a[i];
+      a[i] = tmp;
+      sift_down (a, 0, i);
+    }
+}
+
+size_t
+interval_index_query (
+  IntervalIndex * self,
+  int64_t         start,
+  int64_t         end,
+  const int **    hits)
+{
+  *hits = self->hits;
+  if (self->root_level < 0)
+    return 0;
+
+  const IntervalIndexItem * a = self->items;
+  const int64_t             n = (int64_t) self->num_items;
+  const int64_t             st = start;
+  const int64_t             en = end + 1;
+  size_t                    num_hits = 0;
+
+  StackEntry stack[64];
+  int        t = 0;
+  stack[t++] = (StackEntry){
+    .x = (1LL << self->root_level) - 1,
+    .level = self->root_level,
+    .left_done = false
+  };
+  while (t)
+    {
+      StackEntry z = stack[--t];
+      if (z.level <= LINEAR_SCAN_LEVEL)
+        {
+          /* small subtree - scan linearly */
+          int64_t i0 = z.x >> z.level << z.level;
+          int64_t i1 = MIN (i0 + (1LL << (z.level + 1)) - 1, n);
+          for (int64_t i = i0; i < i1 && a[i].start < en; ++i)
+            {
+              if (st < a[i].end)
+                self->hits[num_hits++] = a[i].idx;
+            }
+        }
+      else if (!z.left_done)
+        {
+          /* re-add the node with the left child
+           * processed */
+          int64_t y = z.x - (1LL << (z.level - 1));
+          stack[t++] =
+            (StackEntry){ .x = z.x, .level = z.level, .left_done = true };
+
+          /* push the left child if it may overlap (y may
+           * be out of range) */
+          if (y >= n || a[y].max_end > st)
+            {
+              stack[t++] = (StackEntry){
+                .x = y, .level = z.level - 1, .left_done = false
+              };
+            }
+        }
+      else if (z.x < n && a[z.x].start < en)
+        {
+          if (st < a[z.x].end)
+            self->hits[num_hits++] = a[z.x].idx;
+
+          /* push the right child */
+          stack[t++] = (StackEntry){
+            .x = z.x + (1LL << (z.level - 1)),
+            .level = z.level - 1,
+            .left_done = false
+          };
+        }
+    }
+
+  /* return in the original order (insertion sort since
+   * there are normally very few hits, and qsort() may
+   * allocate) */
+  if (num_hits > INSERTION_SORT_MAX_HITS)
+    {
+      heap_sort (self->hits, num_hits);
+      return num_hits;
+    }
+  for (size_t i = 1; i < num_hits; i++)
+    {
+      int    val = self->hits[i];
+      size_t j = i;
+      while (j > 0 && self->hits[j - 1] > val)
+        {
+          self->hits[j] = self->hits[j - 1];
+          j--;
+        }
+      self->hits[j] = val;
+    }
+
+  return num_hits;
+}
+
+void
+interval_index_free (IntervalIndex * self)
+{
+  object_zero_and_free (self->items);
+  object_zero_and_free (self->hits);
+
+  object_zero_and_free (self);
+}
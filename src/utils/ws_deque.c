@@ -0,0 +1,142 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "utils/objects.h"
+#include "utils/ws_deque.h"
+
+#include <glib.h>
+
+CONST
+static size_t
+power_of_two_size (size_t sz)
+{
+  size_t ret = 2;
+  while (ret < sz)
+    ret <<= 1;
+  return ret;
+}
+
+void
+ws_deque_reserve (WorkStealingDeque * self, size_t buffer_size)
+{
+  buffer_size = power_of_two_size (buffer_size);
+
+  if (self->buffer && self->buffer_mask >= buffer_size - 1)
+    return;
+
+  if (self->buffer)
+    free (self->buffer);
+
+  self->buffer = (void * _Atomic *) object_new_n (buffer_size, void *);
+  self->buffer_mask = buffer_size - 1;
+
+  ws_deque_clear (self);
+}
+
+WorkStealingDeque *
+ws_deque_new (void)
+{
+  WorkStealingDeque * self = object_new (WorkStealingDeque);
+
+  ws_deque_reserve (self, 8);
+
+  return self;
+}
+
+void
+ws_deque_clear (WorkStealingDeque * self)
+{
+  atomic_store_explicit (&self->top, 0, memory_order_relaxed);
+  atomic_store_explicit (&self->bottom, 0, memory_order_relaxed);
+}
+
+bool
+ws_deque_push (WorkStealingDeque * self, void * data)
+{
+  long long b = atomic_load_explicit (&self->bottom, memory_order_relaxed);
+  long long t = atomic_load_explicit (&self->top, memory_order_acquire);
+  if (G_UNLIKELY ((size_t) (b - t) > self->buffer_mask))
+    {
+      return false;
+    }
+
+  atomic_store_explicit (
+    &self->buffer[(size_t) b & self->buffer_mask], data, memory_order_relaxed);
+  atomic_thread_fence (memory_order_release);
+  atomic_store_explicit (&self->bottom, b + 1, memory_order_relaxed);
+
+  return true;
+}
+
+bool
+ws_deque_pop (WorkStealingDeque * self, void ** data)
+{
+  long long b = atomic_load_explicit (&self->bottom, memory_order_relaxed) - 1;
+  atomic_store_explicit (&self->bottom, b, memory_order_relaxed);
+  atomic_thread_fence (memory_order_seq_cst);
+  long long t = atomic_load_explicit (&self->top, memory_order_relaxed);
+
+  if (t > b)
+    {
+      /* empty */
+      atomic_store_explicit (&self->bottom, b + 1, memory_order_relaxed);
+      return false;
+    }
+
+  *data = atomic_load_explicit (
+    &self->buffer[(size_t) b & self->buffer_mask], memory_order_relaxed);
+  if (t == b)
+    {
+      /* last element - race against thieves */
+      bool won = atomic_compare_exchange_strong_explicit (
+        &self->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed);
+      atomic_store_explicit (&self->bottom, b + 1, memory_order_relaxed);
+      return won;
+    }
+
+  return true;
+}
+
+bool
+ws_deque_steal (WorkStealingDeque * self, void ** data)
+{
+  long long t = atomic_load_explicit (&self->top, memory_order_acquire);
+  atomic_thread_fence (memory_order_seq_cst);
+  long long b = atomic_load_explicit (&self->bottom, memory_order_acquire);
+
+  if (t >= b)
+    {
+      return false;
+    }
+
+  void * elem = atomic_load_explicit (
+    &self->buffer[(size_t) t & self->buffer_mask], memory_order_relaxed);
+  if (!atomic_compare_exchange_strong_explicit (
+        &self->top, &t, t + 1, memory_order_seq_cst, memory_order_relaxed))
+    {
+      /* lost the race */
+      return false;
+    }
+
+  *data = elem;
+  return true;
+}
+
+size_t
+ws_deque_size (WorkStealingDeque * self)
+{
+  long long b = atomic_load_explicit (&self->bottom, memory_order_relaxed);
+  long long t = atomic_load_explicit (&self->top, memory_order_relaxed);
+  return b > t ? (size_t) (b - t) : 0;
+}
+
+void
+ws_deque_free (WorkStealingDeque * self)
+{
+  free (self->buffer);
+
+  free (self);
+}
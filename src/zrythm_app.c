@@ -347,15 +347,12 @@ on_setup_main_window (GSimpleAction * action, GVariant * parameter, gpointer dat
   /*router_recalc_graph (ROUTER);*/
   /*engine_set_run (AUDIO_ENGINE, true);*/
 
-  /* add timeout for auto-saving projects */
-  unsigned int autosave_interval =
-    g_settings_get_uint (S_P_PROJECTS_GENERAL, "autosave-interval");
-  if (autosave_interval > 0)
-    {
-      PROJECT->last_successful_autosave_time = g_get_monotonic_time ();
-      self->project_autosave_source_id =
-        g_timeout_add_seconds (3, project_autosave_cb, NULL);
-    }
+  /* add timeout for auto-saving projects (always added
+   * because it also flushes the autosave journal - the
+   * callback checks whether autosave is enabled) */
+  PROJECT->last_successful_autosave_time = g_get_monotonic_time ();
+  self->project_autosave_source_id =
+    g_timeout_add_seconds (3, project_autosave_cb, NULL);
 
   g_message ("done");
 }
@@ -3160,6 +3160,83 @@ test_move_region_from_lane_3_to_lane_1 (void)
   test_helper_zrythm_cleanup ();
 }
 
+static void
+test_content_version_bumps (void)
+{
+  rebootstrap_timeline ();
+
+  /* automation */
+  AutomationTrack * at = channel_get_automation_track (
+    P_MASTER_TRACK->channel, PORT_FLAG_STEREO_BALANCE);
+  g_assert_nonnull (at);
+  g_assert_cmpint (at->num_regions, ==, 1);
+  ZRegion * r = at->regions[0];
+
+  Position pos;
+  position_init (&pos);
+  guint             version = r->content_version;
+  AutomationPoint * ap = automation_point_new_float (0.5f, 0.5f, &pos);
+  automation_region_add_ap (r, ap, F_NO_PUBLISH_EVENTS);
+  g_assert_cmpuint (r->content_version, !=, version);
+
+  version = r->content_version;
+  automation_point_set_curviness (ap, 0.4);
+  g_assert_cmpuint (r->content_version, !=, version);
+
+  version = r->content_version;
+  automation_point_set_fvalue (ap, 0.2f, F_NORMALIZED, F_NO_PUBLISH_EVENTS);
+  g_assert_cmpuint (r->content_version, !=, version);
+
+  /* edit the curve algorithm the way the set-curve-algorithm
+   * action does (already edited before performing) */
+  arranger_object_select (
+    (ArrangerObject *) ap, F_SELECT, F_NO_APPEND, F_NO_PUBLISH_EVENTS);
+  arranger_selections_action_perform_create (AUTOMATION_SELECTIONS, NULL);
+  ap = r->aps[0];
+  ArrangerSelections * before =
+    arranger_selections_clone ((ArrangerSelections *) AUTOMATION_SELECTIONS);
+  version = r->content_version;
+  ap->curve_opts.algo = CURVE_ALGORITHM_PULSE;
+  arranger_selections_action_perform_edit (
+    before, (ArrangerSelections *) AUTOMATION_SELECTIONS,
+    ARRANGER_SELECTIONS_ACTION_EDIT_PRIMITIVE, F_ALREADY_EDITED, NULL);
+  arranger_selections_free_full (before);
+  g_assert_cmpuint (r->content_version, !=, version);
+
+  version = r->content_version;
+  undo_manager_undo (UNDO_MANAGER, NULL);
+  g_assert_cmpuint (r->content_version, !=, version);
+
+  version = r->content_version;
+  undo_manager_redo (UNDO_MANAGER, NULL);
+  g_assert_cmpuint (r->content_version, !=, version);
+
+  version = r->content_version;
+  automation_region_remove_ap (r, r->aps[0], false, F_FREE);
+  g_assert_cmpuint (r->content_version, !=, version);
+
+  /* midi */
+  Track * midi_track = tracklist_find_track_by_name (TRACKLIST, MIDI_TRACK_NAME);
+  g_assert_nonnull (midi_track);
+  r = midi_track->lanes[MIDI_REGION_LANE]->regions[0];
+  g_assert_cmpint (r->num_midi_notes, ==, 1);
+  MidiNote * mn = r->midi_notes[0];
+
+  version = r->content_version;
+  midi_note_set_val (mn, (uint8_t) (mn->val + 1));
+  g_assert_cmpuint (r->content_version, !=, version);
+
+  version = r->content_version;
+  arranger_object_set_muted ((ArrangerObject *) mn, true, F_NO_PUBLISH_EVENTS);
+  g_assert_cmpuint (r->content_version, !=, version);
+
+  version = r->content_version;
+  midi_region_remove_midi_note (r, mn, F_FREE, F_NO_PUBLISH_EVENTS);
+  g_assert_cmpuint (r->content_version, !=, version);
+
+  test_helper_zrythm_cleanup ();
+}
+
 static void
 test_stretch (void)
 {
@@ -3228,6 +3305,9 @@ main (int argc, char * argv[])
   g_test_add_func (
     TEST_PREFIX "test resize loop l", (GTestFunc) test_resize_loop_l);
   g_test_add_func (TEST_PREFIX "test stretch", (GTestFunc) test_stretch);
+  g_test_add_func (
+    TEST_PREFIX "test content version bumps",
+    (GTestFunc) test_content_version_bumps);
   g_test_add_func (
     TEST_PREFIX "test copy paste audio after bpm change",
     (GTestFunc) test_copy_paste_audio_after_bpm_change);
@@ -11,6 +11,7 @@
 #include "zrythm.h"
 
 #include <glib.h>
+#include <glib/gstdio.h>
 
 #include "tests/helpers/project.h"
 #include "tests/helpers/zrythm.h"
@@ -154,6 +155,108 @@ test_fill_stack (void)
   test_helper_zrythm_cleanup ();
 }
 
+static void
+test_mem_budget (void)
+{
+  test_helper_zrythm_init ();
+
+  /* keep only the newest action of each stack in
+   * memory */
+  UNDO_MANAGER->undo_stack->mem_budget = 1;
+  UNDO_MANAGER->redo_stack->mem_budget = 1;
+
+  Track *           track = TRACKLIST->tracks[TRACKLIST->num_tracks - 1];
+  AutomationTrack * at = track_get_automation_tracklist (track)->ats[0];
+  const int         num_actions = 6;
+  for (int i = 0; i < num_actions; i++)
+    {
+      perform_create_region_action ();
+    }
+  g_assert_cmpint (at->num_regions, ==, num_actions);
+  g_assert_cmpint (UNDO_MANAGER->undo_stack->stack->top, ==, 0);
+  g_assert_cmpuint (
+    UNDO_MANAGER->undo_stack->spilled->len, ==, num_actions - 1);
+  g_assert_nonnull (UNDO_MANAGER->undo_stack->spill_path);
+
+  /* spilled actions are restored one by one */
+  for (int i = 0; i < num_actions; i++)
+    {
+      undo_manager_undo (UNDO_MANAGER, NULL);
+      g_assert_cmpint (at->num_regions, ==, num_actions - i - 1);
+    }
+  g_assert_true (undo_stack_is_empty (UNDO_MANAGER->undo_stack));
+  g_assert_cmpuint (UNDO_MANAGER->undo_stack->spilled->len, ==, 0);
+  g_assert_null (UNDO_MANAGER->undo_stack->spill_path);
+  g_assert_cmpint (UNDO_MANAGER->redo_stack->stack->top, ==, 0);
+  g_assert_cmpuint (
+    UNDO_MANAGER->redo_stack->spilled->len, ==, num_actions - 1);
+
+  for (int i = 0; i < num_actions; i++)
+    {
+      undo_manager_redo (UNDO_MANAGER, NULL);
+      g_assert_cmpint (at->num_regions, ==, i + 1);
+    }
+  g_assert_true (undo_stack_is_empty (UNDO_MANAGER->redo_stack));
+  g_assert_cmpuint (
+    UNDO_MANAGER->undo_stack->spilled->len, ==, num_actions - 1);
+
+  test_project_save_and_reload ();
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_compact_spill_file (void)
+{
+  test_helper_zrythm_init ();
+
+  UndoStack * stack = UNDO_MANAGER->undo_stack;
+  stack->mem_budget = 1;
+
+  Track *           track = TRACKLIST->tracks[TRACKLIST->num_tracks - 1];
+  AutomationTrack * at = track_get_automation_tracklist (track)->ats[0];
+  const int         num_actions = 6;
+  for (int i = 0; i < num_actions; i++)
+    {
+      perform_create_region_action ();
+    }
+  g_assert_cmpuint (stack->spilled->len, ==, num_actions - 1);
+
+  /* dropping the oldest actions leaves unused bytes at
+   * the start of the file until most of it is unused */
+  undo_stack_remove_oldest (stack);
+  undo_stack_remove_oldest (stack);
+  g_assert_cmpuint (stack->spill_dead_size, >, 0);
+  g_assert_cmpint (
+    g_array_index (stack->spilled, UndoStackSpilledAction, 0).offset, >, 0);
+
+  undo_stack_remove_oldest (stack);
+  g_assert_cmpuint (stack->spilled->len, ==, 2);
+  g_assert_cmpuint (stack->spill_dead_size, ==, 0);
+  size_t live_size = 0;
+  for (guint i = 0; i < stack->spilled->len; i++)
+    {
+      UndoStackSpilledAction * spilled =
+        &g_array_index (stack->spilled, UndoStackSpilledAction, i);
+      g_assert_cmpint (spilled->offset, ==, (gint64) live_size);
+      live_size += spilled->size;
+    }
+  GStatBuf stat_buf;
+  g_assert_cmpint (g_stat (stack->spill_path, &stat_buf), ==, 0);
+  g_assert_cmpint (stat_buf.st_size, ==, (gint64) live_size);
+
+  /* the remaining actions are restored from the new file */
+  for (int i = 0; i < 3; i++)
+    {
+      undo_manager_undo (UNDO_MANAGER, NULL);
+      g_assert_cmpint (at->num_regions, ==, num_actions - i - 1);
+    }
+  g_assert_true (undo_stack_is_empty (stack));
+  g_assert_null (stack->spill_path);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char * argv[])
 {
@@ -167,6 +270,10 @@ main (int argc, char * argv[])
   g_test_add_func (
     TEST_PREFIX "test multi actions", (GTestFunc) test_multi_actions);
   g_test_add_func (TEST_PREFIX "test fill stack", (GTestFunc) test_fill_stack);
+  g_test_add_func (TEST_PREFIX "test mem budget", (GTestFunc) test_mem_budget);
+  g_test_add_func (
+    TEST_PREFIX "test compact spill file",
+    (GTestFunc) test_compact_spill_file);
 
   return g_test_run ();
 }
@@ -0,0 +1,127 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include "zrythm-test-config.h"
+
+#include "dsp/audio_region.h"
+#include "dsp/port.h"
+#include "dsp/track.h"
+#include "project.h"
+#include "utils/flags.h"
+#include "utils/math.h"
+#include "utils/objects.h"
+#include "zrythm.h"
+
+#include <glib.h>
+
+#include "tests/helpers/project.h"
+#include "tests/helpers/zrythm.h"
+
+/** Length of the clip in frames. */
+#define CLIP_FRAMES (48000 * 60)
+
+#define BUFFER_SIZE 256
+
+/** Number of passes over the whole region. */
+#define NUM_PASSES 5
+
+static ZRegion *
+create_region (void)
+{
+  Track * track = track_create_empty_with_action (TRACK_TYPE_AUDIO, NULL);
+
+  float * frames = object_new_n (CLIP_FRAMES * 2, float);
+  for (size_t i = 0; i < CLIP_FRAMES; i++)
+    {
+      float val = sinf ((float) i * 440.f * 2.f * (float) M_PI / 48000.f);
+      frames[i * 2] = val;
+      frames[i * 2 + 1] = val;
+    }
+
+  Position start;
+  position_init (&start);
+  ZRegion * r = audio_region_new (
+    -1, NULL, false, frames, CLIP_FRAMES, "clip", 2, BIT_DEPTH_32, &start,
+    track_get_name_hash (track), 0, 0, NULL);
+  g_assert_nonnull (r);
+  free (frames);
+
+  bool success =
+    track_add_region (track, r, NULL, 0, F_GEN_NAME, F_NO_PUBLISH_EVENTS, NULL);
+  g_assert_true (success);
+
+  return r;
+}
+
+/**
+ * Renders the whole region NUM_PASSES times and returns
+ * the time taken in microseconds.
+ */
+static gint64
+fill_region (ZRegion * r, StereoPorts * ports)
+{
+  gint64 start = g_get_monotonic_time ();
+  for (int pass = 0; pass < NUM_PASSES; pass++)
+    {
+      for (unsigned_frame_t i = 0; i + BUFFER_SIZE <= CLIP_FRAMES;
+           i += BUFFER_SIZE)
+        {
+          EngineProcessTimeInfo time_nfo = {
+            .g_start_frame = i,
+            .g_start_frame_w_offset = i,
+            .local_offset = 0,
+            .nframes = BUFFER_SIZE,
+          };
+          audio_region_fill_stereo_ports (r, &time_nfo, ports);
+        }
+    }
+  return g_get_monotonic_time () - start;
+}
+
+static void
+test_fill_stereo_ports (void)
+{
+  test_helper_zrythm_init ();
+
+  test_project_stop_dummy_engine ();
+
+  ZRegion * r = create_region ();
+
+  StereoPorts * ports = stereo_ports_new_generic (
+    false, "ports", "ports", PORT_OWNER_TYPE_AUDIO_ENGINE, NULL);
+  port_allocate_bufs (ports->l);
+  port_allocate_bufs (ports->r);
+
+  gint64 unity_gain_usec = fill_region (r, ports);
+  r->gain = 0.5f;
+  gint64 gain_usec = fill_region (r, ports);
+
+  const double audio_usec =
+    (double) CLIP_FRAMES * NUM_PASSES * 1000000.0 / 48000.0;
+  fprintf (
+    stderr,
+    "---- audio_region_fill_stereo_ports (%d frames, %d passes, "
+    "block size %d) ----\n"
+    "unity gain: %ldms (%.1fx realtime)\n"
+    "with gain: %ldms (%.1fx realtime)\n",
+    CLIP_FRAMES, NUM_PASSES, BUFFER_SIZE, unity_gain_usec / 1000,
+    audio_usec / (double) MAX (unity_gain_usec, 1), gain_usec / 1000,
+    audio_usec / (double) MAX (gain_usec, 1));
+
+  object_free_w_func_and_null (stereo_ports_free, ports);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char * argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/benchmarks/audio_region/"
+
+  g_test_add_func (
+    TEST_PREFIX "test fill stereo ports", (GTestFunc) test_fill_stereo_ports);
+
+  return g_test_run ();
+}
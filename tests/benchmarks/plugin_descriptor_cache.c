@@ -0,0 +1,143 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include "zrythm-test-config.h"
+
+#include "plugins/cached_plugin_descriptors.h"
+#include "plugins/collection.h"
+#include "utils/flags.h"
+#include "utils/io.h"
+#include "utils/objects.h"
+#include "utils/yaml.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "tests/helpers/zrythm.h"
+
+#define NUM_PLUGIN_FILES 1000
+
+/** Number of descriptors per plugin file (shells). */
+#define NUM_DESCRIPTORS_PER_FILE 4
+
+/**
+ * Gets the descriptors of every plugin file, like the
+ * scan at startup does.
+ */
+static void
+get_all_descriptors (CachedPluginDescriptors * cache, char ** paths)
+{
+  for (int i = 0; i < NUM_PLUGIN_FILES; i++)
+    {
+      PluginDescriptor ** descriptors =
+        cached_plugin_descriptors_get (cache, paths[i]);
+      g_assert_nonnull (descriptors);
+      for (int j = 0; descriptors[j]; j++)
+        {
+          plugin_descriptor_free (descriptors[j]);
+        }
+      free (descriptors);
+    }
+}
+
+static void
+test_load_cache (void)
+{
+  test_helper_zrythm_init ();
+
+  char * tmp_dir = g_dir_make_tmp ("zrythm_descr_cache_XXXXXX", NULL);
+  g_assert_nonnull (tmp_dir);
+
+  char **                   paths = object_new_n (NUM_PLUGIN_FILES, char *);
+  CachedPluginDescriptors * cache = cached_plugin_descriptors_new ();
+  PluginCollection *        collection = plugin_collection_new ();
+  for (int i = 0; i < NUM_PLUGIN_FILES; i++)
+    {
+      char * name = g_strdup_printf ("plugin%d.so", i);
+      char * path = g_build_filename (tmp_dir, name, NULL);
+      g_assert_true (g_file_set_contents (path, name, -1, NULL));
+      paths[i] = io_traverse_path (path);
+      g_free (path);
+      g_free (name);
+
+      for (int j = 0; j < NUM_DESCRIPTORS_PER_FILE; j++)
+        {
+          PluginDescriptor * descr = plugin_descriptor_new ();
+          descr->protocol = Z_PLUGIN_PROTOCOL_VST;
+          descr->path = g_strdup (paths[i]);
+          descr->name = g_strdup_printf ("Plugin %d-%d", i, j);
+          descr->author = g_strdup ("Zrythm DAW");
+          descr->category_str = g_strdup ("Synth");
+          descr->unique_id = j;
+          descr->num_audio_outs = 2;
+          cached_plugin_descriptors_add (cache, descr, F_NO_SERIALIZE);
+
+          /* the same descriptors in the old YAML format */
+          plugin_collection_add_descriptor (collection, descr);
+          plugin_descriptor_free (descr);
+        }
+    }
+
+  GError * err = NULL;
+  char *   yaml = yaml_serialize (collection, &plugin_collection_schema, &err);
+  g_assert_nonnull (yaml);
+  plugin_collection_free (collection);
+
+  guint num_descriptors = cache->descriptors->len;
+  cached_plugin_descriptors_serialize_to_file (cache);
+  cached_plugin_descriptors_free (cache);
+
+  gint64 start = g_get_monotonic_time ();
+  collection = yaml_deserialize (yaml, &plugin_collection_schema, &err);
+  g_assert_nonnull (collection);
+  gint64 yaml_usec = g_get_monotonic_time () - start;
+  plugin_collection_free (collection);
+
+  /* map the cache and get the descriptors of all the
+   * files (startup) */
+  start = g_get_monotonic_time ();
+  cache = cached_plugin_descriptors_new ();
+  get_all_descriptors (cache, paths);
+  gint64 mapped_usec = g_get_monotonic_time () - start;
+  g_assert_cmpuint (cache->descriptors->len, ==, num_descriptors);
+
+  /* get them again with the cache already mapped */
+  start = g_get_monotonic_time ();
+  get_all_descriptors (cache, paths);
+  gint64 lookup_usec = g_get_monotonic_time () - start;
+  cached_plugin_descriptors_free (cache);
+
+  fprintf (
+    stderr,
+    "---- plugin_descriptor_cache (%d descriptors in %d files) ----\n"
+    "yaml load: %ldms\n"
+    "mapped load + lookup all: %ldms\n"
+    "lookup all: %ldms\n",
+    NUM_PLUGIN_FILES * NUM_DESCRIPTORS_PER_FILE, NUM_PLUGIN_FILES,
+    yaml_usec / 1000, mapped_usec / 1000, lookup_usec / 1000);
+
+  for (int i = 0; i < NUM_PLUGIN_FILES; i++)
+    {
+      g_unlink (paths[i]);
+      g_free (paths[i]);
+    }
+  g_free (paths);
+  g_free (yaml);
+  g_rmdir (tmp_dir);
+  g_free (tmp_dir);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char * argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/benchmarks/plugin_descriptor_cache/"
+
+  g_test_add_func (
+    TEST_PREFIX "test load cache", (GTestFunc) test_load_cache);
+
+  return g_test_run ();
+}
@@ -0,0 +1,144 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include "zrythm-test-config.h"
+
+#include "dsp/midi_event.h"
+#include "dsp/midi_region.h"
+#include "dsp/track.h"
+#include "dsp/track_lane.h"
+#include "project.h"
+#include "utils/flags.h"
+#include "utils/interval_index.h"
+#include "zrythm.h"
+
+#include <glib.h>
+
+#include "tests/helpers/project.h"
+#include "tests/helpers/zrythm.h"
+
+#define NUM_LANES 2
+#define NUM_REGIONS_PER_LANE 10000
+
+/** Length of each region in frames. */
+#define REGION_FRAMES 4800
+
+#define BUFFER_SIZE 256
+
+/** Number of cycles to process. */
+#define NUM_CYCLES 2000
+
+static Track *
+create_track_with_regions (void)
+{
+  Track * track = track_create_empty_with_action (TRACK_TYPE_MIDI, NULL);
+
+  Position start, end;
+  for (int lane = 0; lane < NUM_LANES; lane++)
+    {
+      for (int i = 0; i < NUM_REGIONS_PER_LANE; i++)
+        {
+          position_from_frames (&start, (signed_frame_t) i * REGION_FRAMES);
+          position_from_frames (
+            &end, (signed_frame_t) (i + 1) * REGION_FRAMES - 1);
+          ZRegion * r =
+            midi_region_new (&start, &end, track_get_name_hash (track), lane, i);
+
+          /* one note in the first half of the region */
+          Position note_start, note_end;
+          position_init (&note_start);
+          position_from_frames (&note_end, REGION_FRAMES / 2);
+          MidiNote * mn = midi_note_new (&r->id, &note_start, &note_end, 60, 90);
+          midi_region_add_midi_note (r, mn, F_NO_PUBLISH_EVENTS);
+
+          bool success = track_add_region (
+            track, r, NULL, lane, F_GEN_NAME, F_NO_PUBLISH_EVENTS, NULL);
+          g_assert_true (success);
+        }
+    }
+
+  return track;
+}
+
+/**
+ * Processes NUM_CYCLES cycles spread over the whole
+ * timeline and returns the time taken in microseconds.
+ */
+static gint64
+fill_events (Track * track, MidiEvents * events)
+{
+  const unsigned_frame_t total_frames =
+    (unsigned_frame_t) NUM_REGIONS_PER_LANE * REGION_FRAMES;
+  const unsigned_frame_t step = total_frames / NUM_CYCLES;
+
+  gint64 start = g_get_monotonic_time ();
+  for (int i = 0; i < NUM_CYCLES; i++)
+    {
+      EngineProcessTimeInfo time_nfo = {
+        .g_start_frame = (unsigned_frame_t) i * step,
+        .g_start_frame_w_offset = (unsigned_frame_t) i * step,
+        .local_offset = 0,
+        .nframes = BUFFER_SIZE,
+      };
+      track_fill_events (track, &time_nfo, events, NULL);
+      midi_events_clear (events, F_QUEUED);
+    }
+  return g_get_monotonic_time () - start;
+}
+
+static void
+test_fill_events_many_regions (void)
+{
+  test_helper_zrythm_init ();
+
+  Track * track = create_track_with_regions ();
+
+  /* process manually */
+  engine_activate (AUDIO_ENGINE, false);
+  TRANSPORT->play_state = PLAYSTATE_ROLLING;
+  tracklist_set_caches (TRACKLIST, CACHE_TYPE_PLAYBACK_SNAPSHOTS);
+
+  MidiEvents * events = midi_events_new ();
+
+  gint64 indexed_usec = fill_events (track, events);
+
+  /* temporarily remove the indices to go through all the
+   * regions */
+  IntervalIndex * indices[NUM_LANES];
+  for (int i = 0; i < NUM_LANES; i++)
+    {
+      indices[i] = track->playback_snapshot->lanes[i]->region_index;
+      track->playback_snapshot->lanes[i]->region_index = NULL;
+    }
+  gint64 linear_usec = fill_events (track, events);
+  for (int i = 0; i < NUM_LANES; i++)
+    {
+      track->playback_snapshot->lanes[i]->region_index = indices[i];
+    }
+
+  fprintf (
+    stderr,
+    "---- track_fill_events (%d lanes x %d regions, %d cycles) ----\n"
+    "linear: %ldms\n"
+    "indexed: %ldms\n",
+    NUM_LANES, NUM_REGIONS_PER_LANE, NUM_CYCLES, linear_usec / 1000,
+    indexed_usec / 1000);
+
+  midi_events_free (events);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char * argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/benchmarks/track_fill_events/"
+
+  g_test_add_func (
+    TEST_PREFIX "test fill events many regions",
+    (GTestFunc) test_fill_events_many_regions);
+
+  return g_test_run ();
+}
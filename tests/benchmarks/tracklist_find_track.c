@@ -0,0 +1,113 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include "zrythm-test-config.h"
+
+#include "dsp/port.h"
+#include "dsp/track.h"
+#include "dsp/track_processor.h"
+#include "dsp/tracklist.h"
+#include "project.h"
+#include "utils/flags.h"
+#include "utils/objects.h"
+#include "zrythm.h"
+
+#include <glib.h>
+
+#include "tests/helpers/project.h"
+#include "tests/helpers/zrythm.h"
+
+#define NUM_TRACKS 1000
+
+/** Number of times to look up each track. */
+#define NUM_ROUNDS 100
+
+/**
+ * Looks up every track by name hash and one port of each
+ * track by identifier NUM_ROUNDS times, and returns the
+ * time taken in microseconds.
+ */
+static gint64
+find_tracks_and_ports (Track ** tracks)
+{
+  gint64 start = g_get_monotonic_time ();
+  for (int round = 0; round < NUM_ROUNDS; round++)
+    {
+      for (int i = 0; i < NUM_TRACKS; i++)
+        {
+          Track * track = tracks[i];
+          g_assert_true (
+            tracklist_find_track_by_name_hash (
+              TRACKLIST, track_get_name_hash (track))
+            == track);
+
+          Port * port = track->processor->stereo_in->l;
+          g_assert_true (port_find_from_identifier (&port->id) == port);
+        }
+    }
+  return g_get_monotonic_time () - start;
+}
+
+static void
+test_find_track_many_tracks (void)
+{
+  test_helper_zrythm_init ();
+
+  Track ** tracks = object_new_n (NUM_TRACKS, Track *);
+  for (int i = 0; i < NUM_TRACKS; i++)
+    {
+      char * name = g_strdup_printf ("Audio Track %d", i);
+      tracks[i] = track_new (
+        TRACK_TYPE_AUDIO, TRACKLIST->num_tracks, name, F_WITH_LANE);
+      tracklist_append_track (
+        TRACKLIST, tracks[i], F_NO_PUBLISH_EVENTS, F_NO_RECALC_GRAPH);
+      g_free (name);
+    }
+
+  /* renaming must keep the index up to date */
+  track_set_name (tracks[0], "Renamed Audio Track", F_NO_PUBLISH_EVENTS);
+  g_assert_true (
+    tracklist_find_track_by_name (TRACKLIST, "Renamed Audio Track")
+    == tracks[0]);
+
+  gint64 indexed_usec = find_tracks_and_ports (tracks);
+
+  /* temporarily remove the index to search the tracks
+   * linearly */
+  TracklistNameIndex * index = TRACKLIST->name_index;
+  TRACKLIST->name_index = NULL;
+  gint64 linear_usec = find_tracks_and_ports (tracks);
+  TRACKLIST->name_index = index;
+
+  fprintf (
+    stderr,
+    "---- tracklist_find_track (%d tracks, %d rounds) ----\n"
+    "linear: %ldms\n"
+    "indexed: %ldms\n",
+    NUM_TRACKS, NUM_ROUNDS, linear_usec / 1000, indexed_usec / 1000);
+
+  /* removing must keep the index up to date */
+  unsigned int removed_hash = track_get_name_hash (tracks[NUM_TRACKS - 1]);
+  tracklist_remove_track (
+    TRACKLIST, tracks[NUM_TRACKS - 1], F_REMOVE_PL, F_FREE,
+    F_NO_PUBLISH_EVENTS, F_NO_RECALC_GRAPH);
+  g_assert_null (tracklist_find_track_by_name_hash (TRACKLIST, removed_hash));
+
+  g_free (tracks);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char * argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/benchmarks/tracklist_find_track/"
+
+  g_test_add_func (
+    TEST_PREFIX "test find track many tracks",
+    (GTestFunc) test_find_track_many_tracks);
+
+  return g_test_run ();
+}
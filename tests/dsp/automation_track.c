@@ -10,6 +10,7 @@
 #include "dsp/master_track.h"
 #include "project.h"
 #include "utils/arrays.h"
+#include "utils/objects.h"
 #include "zrythm.h"
 
 #include <glib.h>
@@ -190,6 +191,100 @@ test_curve_value (void)
   test_helper_zrythm_cleanup ();
 }
 
+/**
+ * Checks that the values read from the segment cache match
+ * the values read by searching the automation points.
+ */
+static void
+test_get_vals_from_snapshots (void)
+{
+  test_helper_zrythm_init ();
+
+  test_project_stop_dummy_engine ();
+
+  Track *           master = P_MASTER_TRACK;
+  AutomationTrack * fader_at =
+    channel_get_automation_track (master->channel, PORT_FLAG_CHANNEL_FADER);
+  g_assert_nonnull (fader_at);
+
+  /* create a region with a few curves */
+  Position start, end;
+  position_set_to_bar (&start, 2);
+  position_set_to_bar (&end, 6);
+  ZRegion * region = automation_region_new (
+    &start, &end, track_get_name_hash (master), fader_at->index, 0);
+  bool success = track_add_region (
+    master, region, fader_at, -1, F_GEN_NAME, F_NO_PUBLISH_EVENTS, NULL);
+  g_assert_true (success);
+
+  const float vals[] = { 0.2f, 0.9f, 0.9f, 0.1f, 0.5f };
+  for (int i = 0; i < (int) G_N_ELEMENTS (vals); i++)
+    {
+      Position pos;
+      position_set_to_bar (&pos, 1 + i);
+      position_add_frames (&pos, i * 100);
+      AutomationPoint * ap =
+        automation_point_new_float (vals[i], vals[i], &pos);
+      ap->curve_opts.curviness = i % 2 ? 0.6 : -0.3;
+      automation_region_add_ap (region, ap, F_NO_PUBLISH_EVENTS);
+    }
+
+  /* add an overlapping region and one after a gap so
+   * that the region changes while walking the frames */
+  const int region_bars[][2] = { { 5, 9 }, { 10, 11 } };
+  for (int i = 0; i < (int) G_N_ELEMENTS (region_bars); i++)
+    {
+      position_set_to_bar (&start, region_bars[i][0]);
+      position_set_to_bar (&end, region_bars[i][1]);
+      region = automation_region_new (
+        &start, &end, track_get_name_hash (master), fader_at->index, i + 1);
+      success = track_add_region (
+        master, region, fader_at, -1, F_GEN_NAME, F_NO_PUBLISH_EVENTS, NULL);
+      g_assert_true (success);
+      for (int j = 0; j < 2; j++)
+        {
+          Position pos;
+          position_set_to_bar (&pos, 1 + j * 2);
+          AutomationPoint * ap =
+            automation_point_new_float (vals[i + j], vals[i + j], &pos);
+          automation_region_add_ap (region, ap, F_NO_PUBLISH_EVENTS);
+        }
+    }
+
+  engine_set_run (AUDIO_ENGINE, false);
+  tracklist_set_caches (TRACKLIST, CACHE_TYPE_PLAYBACK_SNAPSHOTS);
+  g_assert_nonnull (fader_at->playback_snapshot->segment_cache);
+
+  const nframes_t      step = 997;
+  const size_t         num_vals = 1000;
+  const signed_frame_t g_start = 0;
+  float *              cached_vals = object_new_n (num_vals, float);
+  for (int ends_after = 0; ends_after < 2; ends_after++)
+    {
+      automation_track_get_normalized_vals_from_snapshots (
+        fader_at, g_start, step, num_vals, ends_after, cached_vals);
+      for (size_t i = 0; i < num_vals; i++)
+        {
+          Position pos;
+          position_from_frames (
+            &pos, g_start + (signed_frame_t) i * (signed_frame_t) step);
+          if (!automation_track_get_ap_before_pos (
+                fader_at, &pos, ends_after, true))
+            {
+              g_assert_cmpfloat (cached_vals[i], <, 0.f);
+              continue;
+            }
+
+          float val = automation_track_get_val_at_pos (
+            fader_at, &pos, true, ends_after, true);
+          g_assert_cmpfloat_with_epsilon (cached_vals[i], val, 0.00001f);
+        }
+    }
+  free (cached_vals);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char * argv[])
 {
@@ -198,6 +293,9 @@ main (int argc, char * argv[])
 #define TEST_PREFIX "/audio/automation_track/"
 
   g_test_add_func (TEST_PREFIX "test curve value", (GTestFunc) test_curve_value);
+  g_test_add_func (
+    TEST_PREFIX "test get vals from snapshots",
+    (GTestFunc) test_get_vals_from_snapshots);
   g_test_add_func (
     TEST_PREFIX "test set at index", (GTestFunc) test_set_at_index);
   g_test_add_func (
@@ -0,0 +1,241 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include "zrythm-test-config.h"
+
+#include "dsp/clip_stream.h"
+#include "io/audio_file.h"
+#include "utils/math.h"
+#include "utils/objects.h"
+#include "zrythm.h"
+
+#include <glib.h>
+
+#include "tests/helpers/zrythm.h"
+
+#define BLOCK_SIZE 256
+
+#define READER_A 1
+#define READER_B 2
+
+typedef struct StreamFixture
+{
+  AudioClipStream * stream;
+
+  /** Frames read from the file directly, interleaved. */
+  float *           frames;
+  size_t            num_frames;
+  AudioFileMetadata metadata;
+
+  float lbuf[BLOCK_SIZE];
+  float rbuf[BLOCK_SIZE];
+} StreamFixture;
+
+static void
+fixture_set_up (StreamFixture * fixture)
+{
+  test_helper_zrythm_init ();
+
+  char * filepath = g_build_filename (TESTS_SRCDIR, "test.wav", NULL);
+  bool   success = audio_file_read_simple (
+    filepath, &fixture->frames, &fixture->num_frames, &fixture->metadata, 0,
+    NULL);
+  g_assert_true (success);
+
+  fixture->stream = audio_clip_stream_new (filepath, NULL);
+  g_assert_nonnull (fixture->stream);
+  g_assert_cmpuint (fixture->stream->num_frames, ==, fixture->num_frames);
+  g_free (filepath);
+
+  /* make sure the ring buffer wraps around */
+  g_assert_cmpuint (fixture->num_frames, >, AUDIO_CLIP_STREAM_RING_FRAMES);
+}
+
+static void
+fixture_tear_down (StreamFixture * fixture)
+{
+  audio_clip_stream_free (fixture->stream);
+  free (fixture->frames);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+assert_block_equal (StreamFixture * fixture, unsigned_frame_t start)
+{
+  int channels = fixture->metadata.channels;
+  for (size_t i = 0; i < BLOCK_SIZE; i++)
+    {
+      size_t idx = ((size_t) start + i) * (size_t) channels;
+      g_assert_true (math_floats_equal (fixture->lbuf[i], fixture->frames[idx]));
+      g_assert_true (math_floats_equal (
+        fixture->rbuf[i], fixture->frames[idx + (channels > 1 ? 1 : 0)]));
+    }
+}
+
+static bool
+read_block (
+  StreamFixture *  fixture,
+  uint64_t         reader,
+  uint64_t         cycle,
+  unsigned_frame_t start)
+{
+  return audio_clip_stream_read (
+    fixture->stream, reader, cycle, start, BLOCK_SIZE, fixture->lbuf,
+    fixture->rbuf);
+}
+
+static void
+test_read_sequentially (void)
+{
+  StreamFixture fixture = { 0 };
+  fixture_set_up (&fixture);
+
+  /* nothing is read from the file yet */
+  g_assert_false (read_block (&fixture, READER_A, 0, 0));
+  g_assert_cmpint (fixture.stream->num_misses, ==, 1);
+  for (size_t i = 0; i < BLOCK_SIZE; i++)
+    {
+      g_assert_true (math_floats_equal (fixture.lbuf[i], 0.f));
+    }
+
+  /* read the rest of the file, letting the disk thread
+   * catch up after each block */
+  uint64_t cycle = 1;
+  for (unsigned_frame_t start = BLOCK_SIZE;
+       start + BLOCK_SIZE <= fixture.num_frames; start += BLOCK_SIZE)
+    {
+      audio_clip_stream_process (fixture.stream, cycle);
+      g_assert_true (read_block (&fixture, READER_A, cycle, start));
+      assert_block_equal (&fixture, start);
+      cycle++;
+    }
+  g_assert_cmpint (fixture.stream->num_misses, ==, 1);
+
+  fixture_tear_down (&fixture);
+}
+
+static void
+test_seek (void)
+{
+  StreamFixture fixture = { 0 };
+  fixture_set_up (&fixture);
+
+  /* after a miss, the disk thread reads ahead from
+   * where the reader continues */
+  uint64_t         cycle = 0;
+  unsigned_frame_t pos = 1000;
+  audio_clip_stream_process (fixture.stream, cycle);
+  g_assert_false (read_block (&fixture, READER_A, cycle++, pos));
+  pos += BLOCK_SIZE;
+  audio_clip_stream_process (fixture.stream, cycle);
+  g_assert_true (read_block (&fixture, READER_A, cycle++, pos));
+  assert_block_equal (&fixture, pos);
+
+  /* jump past the read-ahead window */
+  pos = fixture.num_frames - 4 * BLOCK_SIZE;
+  g_assert_false (read_block (&fixture, READER_A, cycle++, pos));
+  pos += BLOCK_SIZE;
+  audio_clip_stream_process (fixture.stream, cycle);
+  g_assert_true (read_block (&fixture, READER_A, cycle++, pos));
+  assert_block_equal (&fixture, pos);
+
+  /* the previous position is not available anymore */
+  audio_clip_stream_process (fixture.stream, cycle);
+  g_assert_false (read_block (&fixture, READER_A, cycle++, 1000 + BLOCK_SIZE));
+
+  fixture_tear_down (&fixture);
+}
+
+static void
+test_prerolls (void)
+{
+  StreamFixture fixture = { 0 };
+  fixture_set_up (&fixture);
+
+  unsigned_frame_t anchors[] = { 0, fixture.num_frames - 4 * BLOCK_SIZE };
+  audio_clip_stream_set_anchors (fixture.stream, anchors, 2);
+  audio_clip_stream_process (fixture.stream, 0);
+
+  /* jumping between the anchors is served from the
+   * pre-rolls without waiting for the disk thread */
+  for (int i = 0; i < 4; i++)
+    {
+      unsigned_frame_t start = anchors[i % 2] + BLOCK_SIZE;
+      g_assert_true (read_block (&fixture, READER_A, (uint64_t) i, start));
+      assert_block_equal (&fixture, start);
+    }
+  g_assert_cmpint (fixture.stream->num_misses, ==, 0);
+
+  /* replacing the anchors keeps the previous pre-rolls
+   * until the engine is done with them */
+  audio_clip_stream_set_anchors (fixture.stream, anchors, 1);
+  audio_clip_stream_process (fixture.stream, 10);
+  g_assert_cmpuint (fixture.stream->retired_prerolls->len, ==, 1);
+  audio_clip_stream_process (fixture.stream, 12);
+  g_assert_cmpuint (fixture.stream->retired_prerolls->len, ==, 0);
+
+  fixture_tear_down (&fixture);
+}
+
+static void
+test_multiple_readers (void)
+{
+  StreamFixture fixture = { 0 };
+  fixture_set_up (&fixture);
+
+  unsigned_frame_t pos_a = 0;
+  unsigned_frame_t pos_b = fixture.num_frames - 16 * BLOCK_SIZE;
+  uint64_t         cycle = 0;
+  read_block (&fixture, READER_A, cycle, pos_a);
+  read_block (&fixture, READER_B, cycle, pos_b);
+  pos_a += BLOCK_SIZE;
+  pos_b += BLOCK_SIZE;
+  cycle++;
+
+  /* each reader gets its own ring buffer */
+  for (int i = 0; i < 8; i++)
+    {
+      audio_clip_stream_process (fixture.stream, cycle);
+      g_assert_true (read_block (&fixture, READER_A, cycle, pos_a));
+      assert_block_equal (&fixture, pos_a);
+      g_assert_true (read_block (&fixture, READER_B, cycle, pos_b));
+      assert_block_equal (&fixture, pos_b);
+      pos_a += BLOCK_SIZE;
+      pos_b += BLOCK_SIZE;
+      cycle++;
+    }
+
+  /* a third reader (at a position outside both ring
+   * buffers) can only take over a ring buffer not read
+   * from recently */
+  const uint64_t   reader_c = 3;
+  unsigned_frame_t pos_c = AUDIO_CLIP_STREAM_RING_FRAMES + 2 * BLOCK_SIZE;
+  g_assert_false (read_block (&fixture, reader_c, cycle, pos_c));
+  audio_clip_stream_process (fixture.stream, cycle);
+  g_assert_false (read_block (&fixture, reader_c, cycle, pos_c + BLOCK_SIZE));
+  cycle += 2;
+  g_assert_false (read_block (&fixture, reader_c, cycle, pos_c));
+  audio_clip_stream_process (fixture.stream, cycle);
+  g_assert_true (read_block (&fixture, reader_c, cycle, pos_c + BLOCK_SIZE));
+  assert_block_equal (&fixture, pos_c + BLOCK_SIZE);
+
+  fixture_tear_down (&fixture);
+}
+
+int
+main (int argc, char * argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/dsp/clip_stream/"
+
+  g_test_add_func (
+    TEST_PREFIX "test read sequentially", (GTestFunc) test_read_sequentially);
+  g_test_add_func (TEST_PREFIX "test seek", (GTestFunc) test_seek);
+  g_test_add_func (TEST_PREFIX "test prerolls", (GTestFunc) test_prerolls);
+  g_test_add_func (
+    TEST_PREFIX "test multiple readers", (GTestFunc) test_multiple_readers);
+
+  return g_test_run ();
+}
@@ -890,6 +890,194 @@ test_export_send (void)
   test_helper_zrythm_cleanup ();
 }
 
+/**
+ * Export stems of several tracks in a single pass and
+ * compare them with bouncing each track on its own.
+ */
+static void
+test_export_stems_single_pass (void)
+{
+  test_helper_zrythm_init ();
+
+  /* create an audio track */
+  char *          filepath = g_build_filename (TESTS_SRCDIR, "test.wav", NULL);
+  SupportedFile * file = supported_file_new_from_path (filepath);
+  track_create_with_action (
+    TRACK_TYPE_AUDIO, NULL, file, PLAYHEAD, TRACKLIST->num_tracks, 1, -1, NULL,
+    NULL);
+  Track * audio_track =
+    tracklist_get_last_track (TRACKLIST, TRACKLIST_PIN_OPTION_BOTH, false);
+  supported_file_free (file);
+  g_free (filepath);
+
+  /* create an empty audio FX track */
+  Track * audio_fx_track = track_create_empty_at_idx_with_action (
+    TRACK_TYPE_AUDIO_BUS, TRACKLIST->num_tracks, NULL);
+
+  Track * tracks[] = { audio_track, audio_fx_track, P_MASTER_TRACK };
+  char *  tmp_dir = g_dir_make_tmp ("zrythm_stems_XXXXXX", NULL);
+
+  /* export the stems in a single pass */
+  ExportSettings * settings = export_settings_new ();
+  settings->mode = EXPORT_MODE_FULL;
+  export_settings_set_bounce_defaults (
+    settings, EXPORT_FORMAT_WAV, NULL, __func__);
+  settings->time_range = TIME_RANGE_LOOP;
+  settings->bounce_with_parents = false;
+  settings->bounce_step = BOUNCE_STEP_POST_FADER;
+  settings->stems =
+    g_ptr_array_new_with_free_func ((GDestroyNotify) export_stem_free);
+  for (size_t i = 0; i < G_N_ELEMENTS (tracks); i++)
+    {
+      char * filename = g_strdup_printf ("stem%zu.wav", i);
+      char * stem_path = g_build_filename (tmp_dir, filename, NULL);
+      g_ptr_array_add (settings->stems, export_stem_new (tracks[i], stem_path));
+      g_free (stem_path);
+      g_free (filename);
+    }
+
+  tracklist_mark_all_tracks_for_bounce (TRACKLIST, false);
+
+  EngineState state;
+  GPtrArray * conns = exporter_prepare_tracks_for_export (settings, &state);
+
+  GThread * thread = g_thread_new (
+    "bounce_thread", (GThreadFunc) exporter_generic_export_thread, settings);
+
+  print_progress_and_sleep (settings->progress_info);
+
+  g_thread_join (thread);
+
+  exporter_post_export (settings, conns, &state);
+
+  g_assert_cmpint (
+    progress_info_get_completion_type (settings->progress_info), !=,
+    PROGRESS_COMPLETED_HAS_ERROR);
+
+  ExportStem * audio_stem = g_ptr_array_index (settings->stems, 0);
+  ExportStem * audio_fx_stem = g_ptr_array_index (settings->stems, 1);
+  ExportStem * master_stem = g_ptr_array_index (settings->stems, 2);
+  g_assert_false (audio_file_is_silent (audio_stem->file_uri));
+  g_assert_true (audio_file_is_silent (audio_fx_stem->file_uri));
+  g_assert_false (audio_file_is_silent (master_stem->file_uri));
+
+  /* bounce the audio track on its own */
+  ExportSettings * track_settings = export_settings_new ();
+  track_settings->mode = EXPORT_MODE_TRACKS;
+  export_settings_set_bounce_defaults (
+    track_settings, EXPORT_FORMAT_WAV, NULL, __func__);
+  track_settings->time_range = TIME_RANGE_LOOP;
+  track_settings->bounce_with_parents = false;
+  track_settings->bounce_step = BOUNCE_STEP_POST_FADER;
+
+  track_select (audio_track, F_SELECT, F_EXCLUSIVE, F_NO_PUBLISH_EVENTS);
+  tracklist_selections_mark_for_bounce (
+    TRACKLIST_SELECTIONS, track_settings->bounce_with_parents,
+    F_NO_MARK_MASTER);
+
+  conns = exporter_prepare_tracks_for_export (track_settings, &state);
+
+  thread = g_thread_new (
+    "bounce_thread", (GThreadFunc) exporter_generic_export_thread,
+    track_settings);
+
+  print_progress_and_sleep (track_settings->progress_info);
+
+  g_thread_join (thread);
+
+  exporter_post_export (track_settings, conns, &state);
+
+  g_assert_true (audio_files_equal (
+    audio_stem->file_uri, track_settings->file_uri, 120000, 0.01f));
+
+  for (guint i = 0; i < settings->stems->len; i++)
+    {
+      ExportStem * stem = g_ptr_array_index (settings->stems, i);
+      io_remove (stem->file_uri);
+    }
+  io_remove (track_settings->file_uri);
+  io_rmdir (tmp_dir, false);
+  g_free (tmp_dir);
+
+  export_settings_free (track_settings);
+  export_settings_free (settings);
+
+  test_helper_zrythm_cleanup ();
+}
+
+/**
+ * Export offline in large blocks and compare with
+ * exporting in the engine's block length.
+ */
+static void
+test_export_offline (void)
+{
+  test_helper_zrythm_init ();
+
+  char *          filepath = g_build_filename (TESTS_SRCDIR, "test.wav", NULL);
+  SupportedFile * file = supported_file_new_from_path (filepath);
+  track_create_with_action (
+    TRACK_TYPE_AUDIO, NULL, file, PLAYHEAD, TRACKLIST->num_tracks, 1, -1, NULL,
+    NULL);
+  supported_file_free (file);
+  g_free (filepath);
+
+  const nframes_t block_length = AUDIO_ENGINE->block_length;
+  char *          file_uris[2];
+  for (int i = 0; i < 2; i++)
+    {
+      ExportSettings * settings = export_settings_new ();
+      settings->mode = EXPORT_MODE_FULL;
+      export_settings_set_bounce_defaults (
+        settings, EXPORT_FORMAT_WAV, NULL, __func__);
+      settings->time_range = TIME_RANGE_LOOP;
+      settings->offline_block_length =
+        i == 0 ? 0 : EXPORT_OFFLINE_BLOCK_LENGTH;
+
+      tracklist_mark_all_tracks_for_bounce (TRACKLIST, false);
+
+      EngineState state;
+      GPtrArray * conns = exporter_prepare_tracks_for_export (settings, &state);
+      g_assert_cmpuint (
+        AUDIO_ENGINE->block_length, ==,
+        i == 0 ? block_length : EXPORT_OFFLINE_BLOCK_LENGTH);
+
+      GThread * thread = g_thread_new (
+        "bounce_thread", (GThreadFunc) exporter_generic_export_thread,
+        settings);
+
+      print_progress_and_sleep (settings->progress_info);
+
+      g_thread_join (thread);
+
+      exporter_post_export (settings, conns, &state);
+
+      /* the engine's block length is restored */
+      g_assert_cmpuint (AUDIO_ENGINE->block_length, ==, block_length);
+      g_assert_false (AUDIO_ENGINE->rendering_offline);
+
+      g_assert_cmpfloat (settings->realtime_factor, >, 0.0);
+      g_message (
+        "block length %u: %.1fx realtime",
+        i == 0 ? block_length : EXPORT_OFFLINE_BLOCK_LENGTH,
+        settings->realtime_factor);
+
+      file_uris[i] = g_strdup (settings->file_uri);
+      export_settings_free (settings);
+    }
+
+  g_assert_false (audio_file_is_silent (file_uris[1]));
+  g_assert_true (audio_files_equal (file_uris[0], file_uris[1], 120000, 0.01f));
+
+  for (int i = 0; i < 2; i++)
+    {
+      io_remove (file_uris[i]);
+      g_free (file_uris[i]);
+    }
+
+  test_helper_zrythm_cleanup ();
+}
+
 static void
 test_mixdown_midi (void)
 {
@@ -1088,6 +1276,11 @@ main (int argc, char * argv[])
   g_test_add_func (
     TEST_PREFIX "test mixdown midi", (GTestFunc) test_mixdown_midi);
   g_test_add_func (TEST_PREFIX "test export send", (GTestFunc) test_export_send);
+  g_test_add_func (
+    TEST_PREFIX "test export stems single pass",
+    (GTestFunc) test_export_stems_single_pass);
+  g_test_add_func (
+    TEST_PREFIX "test export offline", (GTestFunc) test_export_offline);
   g_test_add_func (
     TEST_PREFIX "test chord routed to instrument",
     (GTestFunc) test_chord_routed_to_instrument);
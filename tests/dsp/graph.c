@@ -0,0 +1,225 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include "zrythm-test-config.h"
+
+#include "dsp/engine.h"
+#include "dsp/graph.h"
+#include "dsp/graph_node.h"
+#include "dsp/router.h"
+#include "dsp/supported_file.h"
+#include "dsp/track.h"
+#include "project.h"
+#include "utils/audio.h"
+#include "utils/flags.h"
+#include "utils/io.h"
+#include "zrythm.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "tests/helpers/exporter.h"
+#include "tests/helpers/project.h"
+#include "tests/helpers/zrythm.h"
+
+#define NUM_TRACKS 6
+
+/**
+ * Creates a few audio tracks playing the same file so
+ * that the graph has independent chains that can be
+ * processed in parallel.
+ */
+static void
+create_parallel_tracks (void)
+{
+  char * filepath = g_build_filename (TESTS_SRCDIR, "test.wav", NULL);
+  for (int i = 0; i < NUM_TRACKS; i++)
+    {
+      SupportedFile * file = supported_file_new_from_path (filepath);
+      track_create_with_action (
+        TRACK_TYPE_AUDIO, NULL, file, PLAYHEAD, TRACKLIST->num_tracks, 1, -1,
+        NULL, NULL);
+      supported_file_free (file);
+    }
+  g_free (filepath);
+}
+
+/**
+ * Exports the mixdown and moves it to @p dest_path.
+ */
+static void
+export_mixdown (const char * dest_path)
+{
+  char * file = test_exporter_export_audio (TIME_RANGE_LOOP, EXPORT_MODE_FULL);
+  g_assert_false (audio_file_is_silent (file));
+  g_assert_cmpint (g_rename (file, dest_path), ==, 0);
+  g_free (file);
+}
+
+static void
+test_work_stealing (void)
+{
+  char * tmp_dir = g_dir_make_tmp ("zrythm_graph_XXXXXX", NULL);
+  char * shared_queue_path =
+    g_build_filename (tmp_dir, "shared_queue.wav", NULL);
+  char * work_stealing_path =
+    g_build_filename (tmp_dir, "work_stealing.wav", NULL);
+
+  g_setenv ("ZRYTHM_DSP_THREADS", "4", true);
+
+  /* render with the shared queue */
+  g_setenv ("ZRYTHM_GRAPH_SCHEDULER", "0", true);
+  test_helper_zrythm_init ();
+  g_assert_cmpint (ROUTER->graph->scheduler, ==, GRAPH_SCHEDULER_SHARED_QUEUE);
+  create_parallel_tracks ();
+  export_mixdown (shared_queue_path);
+  test_helper_zrythm_cleanup ();
+
+  /* render with work stealing */
+  g_setenv ("ZRYTHM_GRAPH_SCHEDULER", "1", true);
+  test_helper_zrythm_init ();
+  Graph * graph = ROUTER->graph;
+  g_assert_cmpint (graph->scheduler, ==, GRAPH_SCHEDULER_WORK_STEALING);
+  g_assert_cmpint (graph->num_threads, ==, 4);
+  create_parallel_tracks ();
+
+  guint64 num_cycles = graph->num_cycles;
+  export_mixdown (work_stealing_path);
+
+  /* the cycles were processed by the DSP threads */
+  g_assert_cmpuint (graph->num_cycles, >, num_cycles);
+  g_assert_cmpuint (graph->last_cycle_stats.num_processed, >, 0);
+  g_assert_cmpuint (graph->last_cycle_stats.num_active_threads, >=, 1);
+  g_assert_cmpuint (
+    graph->last_cycle_stats.num_active_threads, <=,
+    (guint) graph->num_threads + 1);
+  g_assert_cmpuint (
+    graph->total_cycle_stats.num_processed, >=,
+    graph->last_cycle_stats.num_processed);
+  graph_print_cycle_stats (graph);
+  test_helper_zrythm_cleanup ();
+
+  g_unsetenv ("ZRYTHM_GRAPH_SCHEDULER");
+  g_unsetenv ("ZRYTHM_DSP_THREADS");
+
+  /* both schedulers produce the same output */
+  g_assert_true (
+    audio_files_equal (shared_queue_path, work_stealing_path, 0, 0.0001f));
+
+  io_remove (shared_queue_path);
+  io_remove (work_stealing_path);
+  io_rmdir (tmp_dir, false);
+  g_free (shared_queue_path);
+  g_free (work_stealing_path);
+  g_free (tmp_dir);
+}
+
+static void
+test_static_schedule_topological_order (void)
+{
+  test_helper_zrythm_init ();
+  create_parallel_tracks ();
+
+  Graph * graph = ROUTER->graph;
+  g_assert_cmpuint (graph->n_static_schedule, >, 0);
+  g_assert_cmpuint (
+    graph->n_static_schedule, ==, g_hash_table_size (graph->graph_nodes));
+
+  /* map each node to its position in the schedule */
+  GHashTable * positions = g_hash_table_new (g_direct_hash, g_direct_equal);
+  for (size_t i = 0; i < graph->n_static_schedule; i++)
+    {
+      GraphNode * node = graph->static_schedule[i];
+      g_assert_false (g_hash_table_contains (positions, node));
+      g_hash_table_insert (positions, node, GSIZE_TO_POINTER (i + 1));
+
+      /* levels never decrease */
+      if (i > 0)
+        {
+          g_assert_cmpint (
+            graph->static_schedule[i - 1]->sched_level, <=, node->sched_level);
+        }
+    }
+
+  /* every node comes before its children */
+  for (size_t i = 0; i < graph->n_static_schedule; i++)
+    {
+      GraphNode * node = graph->static_schedule[i];
+      if (node->init_refcount == 0)
+        {
+          g_assert_cmpint (node->sched_level, ==, 0);
+        }
+      for (int j = 0; j < node->n_childnodes; j++)
+        {
+          GraphNode * child = node->childnodes[j];
+          gsize       child_pos =
+            GPOINTER_TO_SIZE (g_hash_table_lookup (positions, child));
+          g_assert_cmpuint (child_pos, >, i + 1);
+          g_assert_cmpint (child->sched_level, >, node->sched_level);
+        }
+    }
+
+  g_hash_table_destroy (positions);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_static_schedule_matches_dynamic (void)
+{
+  char * tmp_dir = g_dir_make_tmp ("zrythm_graph_XXXXXX", NULL);
+  char * dynamic_path = g_build_filename (tmp_dir, "dynamic.wav", NULL);
+  char * static_path = g_build_filename (tmp_dir, "static.wav", NULL);
+
+  /* render with the DSP threads */
+  g_setenv ("ZRYTHM_DSP_THREADS", "2", true);
+  test_helper_zrythm_init ();
+  g_assert_cmpint (ROUTER->graph->num_threads, ==, 2);
+  g_assert_cmpuint (ROUTER->graph->static_schedule_max_nframes, ==, 0);
+  create_parallel_tracks ();
+  g_assert_false (
+    graph_can_use_static_schedule (ROUTER->graph, AUDIO_ENGINE->block_length));
+  export_mixdown (dynamic_path);
+  test_helper_zrythm_cleanup ();
+
+  /* render with the static schedule on the calling
+   * thread */
+  g_setenv ("ZRYTHM_DSP_THREADS", "0", true);
+  test_helper_zrythm_init ();
+  g_assert_cmpint (ROUTER->graph->num_threads, ==, 0);
+  create_parallel_tracks ();
+  g_assert_true (
+    graph_can_use_static_schedule (ROUTER->graph, AUDIO_ENGINE->block_length));
+  export_mixdown (static_path);
+  test_helper_zrythm_cleanup ();
+
+  g_unsetenv ("ZRYTHM_DSP_THREADS");
+
+  g_assert_true (audio_files_equal (dynamic_path, static_path, 0, 0.0001f));
+
+  io_remove (dynamic_path);
+  io_remove (static_path);
+  io_rmdir (tmp_dir, false);
+  g_free (dynamic_path);
+  g_free (static_path);
+  g_free (tmp_dir);
+}
+
+int
+main (int argc, char * argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/dsp/graph/"
+
+  g_test_add_func (
+    TEST_PREFIX "test work stealing", (GTestFunc) test_work_stealing);
+  g_test_add_func (
+    TEST_PREFIX "test static schedule topological order",
+    (GTestFunc) test_static_schedule_topological_order);
+  g_test_add_func (
+    TEST_PREFIX "test static schedule matches dynamic",
+    (GTestFunc) test_static_schedule_matches_dynamic);
+
+  return g_test_run ();
+}
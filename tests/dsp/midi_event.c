@@ -61,6 +61,87 @@ test_add_pitchbend (void)
   midi_events_free (events);
 }
 
+static void
+test_add_external_events (void)
+{
+  MidiEvents * events = midi_events_new ();
+
+  /* events from other threads are only visible after
+   * dequeueing, sorted by time */
+  g_assert_true (midi_events_add_external_note_on (events, 1, 60, 100, 20));
+  g_assert_true (midi_events_add_external_note_off (events, 1, 60, 10));
+  g_assert_cmpint (events->num_queued_events, ==, 0);
+  g_assert_cmpint (events->num_events, ==, 0);
+
+  midi_events_dequeue (events);
+  g_assert_cmpint (events->num_events, ==, 2);
+  g_assert_cmpuint (events->events[0].time, ==, 10);
+  g_assert_true (midi_is_note_off (events->events[0].raw_buffer));
+  g_assert_cmpuint (events->events[1].time, ==, 20);
+  g_assert_true (midi_is_note_on (events->events[1].raw_buffer));
+  g_assert_cmpuint (midi_get_velocity (events->events[1].raw_buffer), ==, 100);
+
+  /* events are dropped when the engine does not keep
+   * up */
+  for (int i = 0; i < MAX_EXTERNAL_MIDI_EVENTS; i++)
+    {
+      g_assert_true (midi_events_add_external_note_on (events, 1, 60, 100, 0));
+    }
+  g_assert_false (midi_events_add_external_note_on (events, 1, 60, 100, 0));
+  midi_events_dequeue (events);
+  g_assert_cmpint (events->num_events, ==, MAX_EXTERNAL_MIDI_EVENTS);
+  g_assert_true (midi_events_add_external_note_on (events, 1, 60, 100, 0));
+
+  g_assert_cmpint (midi_events_get_num_external_contentions (), ==, 0);
+
+  midi_events_free (events);
+}
+
+static void
+test_add_external_chord_notes (void)
+{
+  test_helper_zrythm_init ();
+
+  ChordDescriptor * descr = CHORD_EDITOR->chords[0];
+  MidiEvents *      events = midi_events_new ();
+
+  int num_notes = 0;
+  for (int i = 0; i < CHORD_DESCRIPTOR_MAX_NOTES; i++)
+    {
+      if (descr->notes[i])
+        num_notes++;
+    }
+  g_assert_cmpint (num_notes, >=, 3);
+
+  g_assert_true (midi_events_add_external_note_ons_from_chord_descr (
+    events, descr, 1, 121, 5));
+  midi_events_dequeue (events);
+  g_assert_cmpint (events->num_events, ==, num_notes);
+  for (int i = 0; i < num_notes; i++)
+    {
+      MidiEvent * ev = &events->events[i];
+      g_assert_cmpuint (ev->time, ==, 5);
+      g_assert_true (midi_is_note_on (ev->raw_buffer));
+      g_assert_cmpuint (midi_get_velocity (ev->raw_buffer), ==, 121);
+    }
+
+  midi_events_clear (events, F_NOT_QUEUED);
+  g_assert_true (
+    midi_events_add_external_note_offs_from_chord_descr (events, descr, 1, 7));
+  midi_events_dequeue (events);
+  g_assert_cmpint (events->num_events, ==, num_notes);
+  for (int i = 0; i < num_notes; i++)
+    {
+      MidiEvent * ev = &events->events[i];
+      g_assert_cmpuint (ev->time, ==, 7);
+      g_assert_true (midi_is_note_off (ev->raw_buffer));
+    }
+
+  midi_events_free (events);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char * argv[])
 {
@@ -72,6 +153,12 @@ main (int argc, char * argv[])
     TEST_PREFIX "test add pitchbend", (GTestFunc) test_add_pitchbend);
   g_test_add_func (
     TEST_PREFIX "test add note ons", (GTestFunc) test_add_note_ons);
+  g_test_add_func (
+    TEST_PREFIX "test add external events",
+    (GTestFunc) test_add_external_events);
+  g_test_add_func (
+    TEST_PREFIX "test add external chord notes",
+    (GTestFunc) test_add_external_chord_notes);
 
   return g_test_run ();
 }
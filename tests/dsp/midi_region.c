@@ -5,8 +5,10 @@
 #include "zrythm-test-config.h"
 
 #include "actions/tracklist_selections.h"
+#include "dsp/midi_event.h"
 #include "dsp/midi_region.h"
 #include "dsp/region.h"
+#include "dsp/track.h"
 #include "dsp/transport.h"
 #include "project.h"
 #include "utils/flags.h"
@@ -195,6 +197,111 @@ test_full_export (void)
   g_free (base_midi_file);
 }
 
+/**
+ * Asserts that both have the same queued events, regardless of
+ * their order.
+ */
+static void
+assert_events_equal (MidiEvents * a, MidiEvents * b)
+{
+  g_assert_cmpint (a->num_queued_events, ==, b->num_queued_events);
+  bool * matched = g_new0 (bool, (size_t) b->num_queued_events + 1);
+  for (int i = 0; i < a->num_queued_events; i++)
+    {
+      MidiEvent * ev_a = &a->queued_events[i];
+      bool        found = false;
+      for (int j = 0; j < b->num_queued_events; j++)
+        {
+          if (!matched[j] && midi_events_are_equal (ev_a, &b->queued_events[j]))
+            {
+              matched[j] = true;
+              found = true;
+              break;
+            }
+        }
+      g_assert_true (found);
+    }
+  g_free (matched);
+  midi_events_clear (a, F_QUEUED);
+  midi_events_clear (b, F_QUEUED);
+}
+
+/**
+ * Checks that filling events using the note timeline gives the
+ * same results as going through all the notes.
+ */
+static void
+test_fill_midi_events_from_timeline (void)
+{
+  test_helper_zrythm_init ();
+
+  Track * track = track_create_empty_with_action (TRACK_TYPE_MIDI, NULL);
+
+  const signed_frame_t region_frames = 96000;
+  Position             start, end;
+  position_init (&start);
+  position_from_frames (&end, region_frames);
+  ZRegion * r = midi_region_new (&start, &end, track->name_hash, 0, 0);
+  bool      success =
+    track_add_region (track, r, NULL, 0, F_GEN_NAME, F_NO_PUBLISH_EVENTS, NULL);
+  g_assert_true (success);
+
+  /* add overlapping notes at random positions */
+  GRand * rand = g_rand_new_with_seed (42);
+  for (int i = 0; i < 400; i++)
+    {
+      signed_frame_t start_frames = g_rand_int_range (rand, 0, region_frames);
+      signed_frame_t end_frames =
+        MIN (start_frames + g_rand_int_range (rand, 1, 4000), region_frames);
+      position_from_frames (&start, start_frames);
+      position_from_frames (&end, end_frames);
+      MidiNote * mn = midi_note_new (
+        &r->id, &start, &end, (midi_byte_t) g_rand_int_range (rand, 30, 90),
+        90);
+      midi_region_add_midi_note (r, mn, F_NO_PUBLISH_EVENTS);
+    }
+  g_rand_free (rand);
+
+  ZRegion * with_timeline =
+    (ZRegion *) arranger_object_clone ((ArrangerObject *) r);
+  midi_region_gen_note_timeline (with_timeline);
+  g_assert_nonnull (with_timeline->note_timeline);
+
+  MidiEvents * events = midi_events_new ();
+  MidiEvents * expected_events = midi_events_new ();
+
+  /* process contiguous cycles, then seek backwards and
+   * process again */
+  const nframes_t  cycle_size = 256;
+  unsigned_frame_t starts[] = { 0, 40000, 1000 };
+  for (size_t k = 0; k < G_N_ELEMENTS (starts); k++)
+    {
+      for (unsigned_frame_t g_start = starts[k];
+           g_start + cycle_size < (unsigned_frame_t) region_frames
+           && g_start < starts[k] + 20000;
+           g_start += cycle_size)
+        {
+          EngineProcessTimeInfo time_nfo = {
+            .g_start_frame = g_start,
+            .g_start_frame_w_offset = g_start,
+            .local_offset = 0,
+            .nframes = cycle_size,
+          };
+          midi_region_fill_midi_events (
+            r, &time_nfo, false, false, expected_events);
+          midi_region_fill_midi_events (
+            with_timeline, &time_nfo, false, false, events);
+          assert_events_equal (events, expected_events);
+        }
+    }
+
+  midi_events_free (events);
+  midi_events_free (expected_events);
+  arranger_object_free ((ArrangerObject *) with_timeline);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char * argv[])
 {
@@ -204,6 +311,9 @@ main (int argc, char * argv[])
 
   g_test_add_func (TEST_PREFIX "test full export", (GTestFunc) test_full_export);
   g_test_add_func (TEST_PREFIX "test export", (GTestFunc) test_export);
+  g_test_add_func (
+    TEST_PREFIX "test fill midi events from timeline",
+    (GTestFunc) test_fill_midi_events_from_timeline);
 
   return g_test_run ();
 }
@@ -3,10 +3,15 @@
 
 #include "zrythm-test-config.h"
 
+#include "dsp/clip_cache.h"
+#include "dsp/clip_peaks.h"
 #include "dsp/tempo_track.h"
 #include "dsp/track.h"
 #include "project.h"
+#include "utils/audio.h"
+#include "utils/dsp.h"
 #include "utils/flags.h"
+#include "utils/progress_info.h"
 #include "zrythm.h"
 
 #include <glib.h>
@@ -131,6 +136,229 @@ test_remove_unused (void)
     }
 }
 
+static void
+test_load_from_cache (void)
+{
+  test_helper_zrythm_init ();
+
+  char * filepath =
+    g_build_filename (TESTS_SRCDIR, "test_start_with_signal.mp3", NULL);
+  SupportedFile * file = supported_file_new_from_path (filepath);
+  track_create_with_action (
+    TRACK_TYPE_AUDIO, NULL, file, PLAYHEAD, TRACKLIST->num_tracks, 1, -1, NULL,
+    NULL);
+  AudioClip * clip = AUDIO_POOL->clips[0];
+  g_assert_null (clip->mapped_file);
+  AudioClip * orig_clip = audio_clip_new_from_float_array (
+    clip->frames, clip->num_frames, clip->channels, clip->bit_depth,
+    clip->name);
+
+  /* the first load decodes the file and caches the
+   * frames */
+  test_project_save_and_reload ();
+  clip = AUDIO_POOL->clips[0];
+  g_assert_nonnull (clip->mapped_file);
+  char * cache_path =
+    audio_clip_cache_get_path (clip->file_hash, clip->samplerate);
+  g_assert_true (g_file_test (cache_path, G_FILE_TEST_EXISTS));
+
+  /* subsequent loads map the cached frames */
+  test_project_save_and_reload ();
+  clip = AUDIO_POOL->clips[0];
+  g_assert_nonnull (clip->mapped_file);
+  g_assert_cmpuint (clip->num_frames, ==, orig_clip->num_frames);
+  g_assert_cmpuint (clip->channels, ==, orig_clip->channels);
+  for (unsigned int i = 0; i < clip->channels; i++)
+    {
+      g_assert_true (audio_frames_equal (
+        clip->ch_frames[i], orig_clip->ch_frames[i],
+        (size_t) clip->num_frames, 0.0001f));
+    }
+  g_assert_true (audio_frames_equal (
+    clip->frames, orig_clip->frames,
+    (size_t) clip->num_frames * clip->channels, 0.0001f));
+
+  /* the frames are copied before modifying them */
+  audio_clip_update_channel_caches (clip, 0);
+  g_assert_null (clip->mapped_file);
+  g_assert_true (audio_frames_equal (
+    clip->ch_frames[0], orig_clip->ch_frames[0], (size_t) clip->num_frames,
+    0.0001f));
+
+  /* stale cache files are removed on load */
+  char * stale_path = audio_clip_cache_get_path ("0123456789abcdef", 44100);
+  g_assert_true (g_file_set_contents (stale_path, "", -1, NULL));
+  test_project_save_and_reload ();
+  g_assert_false (g_file_test (stale_path, G_FILE_TEST_EXISTS));
+  g_assert_true (g_file_test (cache_path, G_FILE_TEST_EXISTS));
+
+  audio_clip_free (orig_clip);
+  g_free (stale_path);
+  g_free (cache_path);
+  g_free (filepath);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_init_loaded_in_parallel (void)
+{
+  test_helper_zrythm_init ();
+
+  char * filepath =
+    g_build_filename (TESTS_SRCDIR, "test_start_with_signal.mp3", NULL);
+  SupportedFile * file = supported_file_new_from_path (filepath);
+  for (int i = 0; i < 6; i++)
+    {
+      track_create_with_action (
+        TRACK_TYPE_AUDIO, NULL, file, PLAYHEAD, TRACKLIST->num_tracks, 1, -1,
+        NULL, NULL);
+    }
+  test_project_save_and_reload ();
+  g_assert_cmpint (AUDIO_POOL->num_clips, ==, 6);
+
+  /* all clips are loaded and progress is reported */
+  ProgressInfo * info = progress_info_new ();
+  GError *       err = NULL;
+  bool success = audio_pool_init_loaded (AUDIO_POOL, info, &err);
+  g_assert_true (success);
+  g_assert_no_error (err);
+  double progress;
+  progress_info_get_progress (info, &progress, NULL);
+  g_assert_cmpfloat_with_epsilon (progress, 1.0, 0.0001);
+  for (int i = 0; i < AUDIO_POOL->num_clips; i++)
+    {
+      AudioClip * clip = AUDIO_POOL->clips[i];
+      g_assert_nonnull (clip->frames);
+      g_assert_cmpuint (clip->num_frames, >, 0);
+    }
+  progress_info_free (info);
+
+  /* loading stops when cancelled */
+  info = progress_info_new ();
+  progress_info_update_progress (info, 0.0, NULL);
+  progress_info_request_cancellation (info);
+  success = audio_pool_init_loaded (AUDIO_POOL, info, &err);
+  g_assert_false (success);
+  g_assert_error (err, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_clear_error (&err);
+  progress_info_free (info);
+
+  g_free (filepath);
+
+  test_helper_zrythm_cleanup ();
+}
+
+/**
+ * Waits for the background job to publish the peaks of
+ * the clip.
+ */
+static const AudioClipPeaks *
+wait_for_peaks (AudioClip * clip)
+{
+  for (int i = 0; i < 1000; i++)
+    {
+      const AudioClipPeaks * peaks = g_atomic_pointer_get (&clip->peaks);
+      if (peaks)
+        return peaks;
+
+      g_usleep (10000);
+    }
+  g_assert_not_reached ();
+}
+
+static void
+assert_peaks_match_frames (const AudioClipPeaks * peaks, AudioClip * clip)
+{
+  g_assert_cmpuint (peaks->num_frames, ==, clip->num_frames);
+  g_assert_cmpuint (peaks->channels, ==, clip->channels);
+  g_assert_cmpuint (peaks->levels[peaks->num_levels - 1].num_peaks, ==, 1);
+  for (int i = 0; i < peaks->num_levels; i++)
+    {
+      const AudioClipPeaksLevel * level = &peaks->levels[i];
+      g_assert_cmpuint (
+        level->frames_per_peak, ==,
+        (unsigned_frame_t) AUDIO_CLIP_PEAKS_BASE_FRAMES << i);
+      for (channels_t ch = 0; ch < clip->channels; ch++)
+        {
+          /* check the last peak, which may cover less
+           * frames */
+          size_t           idx = level->num_peaks - 1;
+          unsigned_frame_t start = idx * level->frames_per_peak;
+          size_t           nframes = (size_t) (clip->num_frames - start);
+          g_assert_cmpfloat_with_epsilon (
+            level->ch_peaks[ch][idx].min,
+            dsp_min (&clip->ch_frames[ch][start], nframes), 0.0001f);
+          g_assert_cmpfloat_with_epsilon (
+            level->ch_peaks[ch][idx].max,
+            dsp_max (&clip->ch_frames[ch][start], nframes), 0.0001f);
+        }
+    }
+
+  /* the range covers whole peaks */
+  const AudioClipPeaksLevel * level =
+    audio_clip_peaks_get_level (peaks, AUDIO_CLIP_PEAKS_BASE_FRAMES * 4 + 1);
+  g_assert_true (level == &peaks->levels[2]);
+  g_assert_null (
+    audio_clip_peaks_get_level (peaks, AUDIO_CLIP_PEAKS_BASE_FRAMES - 1));
+  float min, max;
+  audio_clip_peaks_get_min_max (
+    level, 0, 0, level->frames_per_peak * 2, &min, &max);
+  g_assert_cmpfloat_with_epsilon (
+    min,
+    dsp_min (clip->ch_frames[0], (size_t) level->frames_per_peak * 2),
+    0.0001f);
+  g_assert_cmpfloat_with_epsilon (
+    max,
+    dsp_max (clip->ch_frames[0], (size_t) level->frames_per_peak * 2),
+    0.0001f);
+}
+
+static void
+test_gen_clip_peaks (void)
+{
+  test_helper_zrythm_init ();
+
+  char * filepath =
+    g_build_filename (TESTS_SRCDIR, "test_start_with_signal.mp3", NULL);
+  SupportedFile * file = supported_file_new_from_path (filepath);
+  track_create_with_action (
+    TRACK_TYPE_AUDIO, NULL, file, PLAYHEAD, TRACKLIST->num_tracks, 1, -1, NULL,
+    NULL);
+
+  /* the peaks are generated when the clip is added */
+  AudioClip * clip = AUDIO_POOL->clips[0];
+  assert_peaks_match_frames (wait_for_peaks (clip), clip);
+
+  /* the peaks are stored when loading the project */
+  test_project_save_and_reload ();
+  clip = AUDIO_POOL->clips[0];
+  const AudioClipPeaks * peaks = wait_for_peaks (clip);
+  g_assert_null (peaks->mapped_file);
+  assert_peaks_match_frames (peaks, clip);
+  char * peaks_path =
+    audio_clip_peaks_get_path (clip->file_hash, clip->samplerate);
+  g_assert_true (g_file_test (peaks_path, G_FILE_TEST_EXISTS));
+
+  /* and mapped on subsequent loads */
+  test_project_save_and_reload ();
+  clip = AUDIO_POOL->clips[0];
+  peaks = wait_for_peaks (clip);
+  g_assert_nonnull (peaks->mapped_file);
+  assert_peaks_match_frames (peaks, clip);
+  g_assert_true (g_file_test (peaks_path, G_FILE_TEST_EXISTS));
+
+  /* changing the frames discards the peaks */
+  audio_clip_discard_peaks (clip);
+  g_assert_null (clip->peaks);
+  g_assert_null (clip->peaks_job);
+
+  g_free (peaks_path);
+  g_free (filepath);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char * argv[])
 {
@@ -140,6 +368,13 @@ main (int argc, char * argv[])
 
   g_test_add_func (
     TEST_PREFIX "test remove unused", (GTestFunc) test_remove_unused);
+  g_test_add_func (
+    TEST_PREFIX "test load from cache", (GTestFunc) test_load_from_cache);
+  g_test_add_func (
+    TEST_PREFIX "test init loaded in parallel",
+    (GTestFunc) test_init_loaded_in_parallel);
+  g_test_add_func (
+    TEST_PREFIX "test gen clip peaks", (GTestFunc) test_gen_clip_peaks);
 
   return g_test_run ();
 }
@@ -0,0 +1,117 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include "zrythm-test-config.h"
+
+#include "dsp/recording_disk_writer.h"
+#include "io/audio_file.h"
+#include "utils/objects.h"
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include "tests/helpers/zrythm.h"
+
+#define BLOCK_SIZE 256
+#define SAMPLERATE 48000
+
+/** Enough blocks to fill a few chunks. */
+#define NUM_BLOCKS \
+  (RECORDING_DISK_WRITER_CHUNK_FRAMES * 3 / BLOCK_SIZE + 7)
+
+static float
+get_value (size_t frame, channels_t ch)
+{
+  return (float) (frame % 1000) / 1000.f * (ch == 0 ? 1.f : -1.f);
+}
+
+static void
+assert_file_frames (const char * filepath, size_t expected_frames)
+{
+  float *           frames = NULL;
+  size_t            num_frames = 0;
+  AudioFileMetadata metadata;
+  bool              success = audio_file_read_simple (
+    filepath, &frames, &num_frames, &metadata, 0, NULL);
+  g_assert_true (success);
+  g_assert_cmpint (metadata.channels, ==, 2);
+  g_assert_cmpuint (num_frames, ==, expected_frames);
+  for (size_t i = 0; i < num_frames; i++)
+    {
+      g_assert_cmpfloat_with_epsilon (
+        frames[i * 2], get_value (i, 0), 0.0001f);
+      g_assert_cmpfloat_with_epsilon (
+        frames[i * 2 + 1], get_value (i, 1), 0.0001f);
+    }
+  free (frames);
+}
+
+static void
+test_write_take (void)
+{
+  test_helper_zrythm_init ();
+
+  char * tmp_dir = g_dir_make_tmp ("zrythm_recording_XXXXXX", NULL);
+  g_assert_nonnull (tmp_dir);
+  char * filepath = g_build_filename (tmp_dir, "take.wav", NULL);
+
+  RecordingDiskWriter * writer = recording_disk_writer_new ();
+  RecordingTake *       take = recording_disk_writer_start_take (
+    writer, filepath, 2, SAMPLERATE, BIT_DEPTH_32);
+  g_assert_nonnull (take);
+
+  float         lbuf[BLOCK_SIZE];
+  float         rbuf[BLOCK_SIZE];
+  const float * ch_bufs[] = { lbuf, rbuf };
+  size_t        frames_added = 0;
+  for (int i = 0; i < NUM_BLOCKS; i++)
+    {
+      for (size_t j = 0; j < BLOCK_SIZE; j++)
+        {
+          lbuf[j] = get_value (frames_added + j, 0);
+          rbuf[j] = get_value (frames_added + j, 1);
+        }
+      recording_disk_writer_add_frames (writer, take, ch_bufs, BLOCK_SIZE);
+      frames_added += BLOCK_SIZE;
+
+      /* the file can be read while recording */
+      if (i == NUM_BLOCKS / 2)
+        {
+          recording_disk_writer_flush (writer);
+          g_assert_cmpuint (take->frames_written, ==, frames_added);
+          assert_file_frames (filepath, frames_added);
+        }
+    }
+  g_assert_cmpuint (take->frames_added, ==, frames_added);
+
+  GError * err = NULL;
+  g_assert_true (recording_disk_writer_finish_take (writer, take, &err));
+  g_assert_no_error (err);
+  assert_file_frames (filepath, frames_added);
+
+  /* chunks are reused */
+  g_assert_cmpuint (
+    writer->free_chunks->len, ==, RECORDING_DISK_WRITER_NUM_CHUNKS);
+
+  recording_disk_writer_free (writer);
+
+  g_unlink (filepath);
+  g_rmdir (tmp_dir);
+  g_free (filepath);
+  g_free (tmp_dir);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char * argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/dsp/recording_disk_writer/"
+
+  g_test_add_func (
+    TEST_PREFIX "test write take", (GTestFunc) test_write_take);
+
+  return g_test_run ();
+}
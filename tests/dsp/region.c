@@ -6,9 +6,11 @@
 #include "actions/tracklist_selections.h"
 #include "dsp/midi_region.h"
 #include "dsp/region.h"
+#include "dsp/track_lane.h"
 #include "dsp/transport.h"
 #include "project.h"
 #include "utils/flags.h"
+#include "utils/interval_index.h"
 #include "zrythm.h"
 
 #include "tests/helpers/zrythm.h"
@@ -176,6 +178,60 @@ test_timeline_frames_to_local (void)
   g_assert_cmpint (localp, ==, 13000);
 }
 
+/**
+ * Returns the number of regions of the lane whose
+ * interval in the arranger index overlaps the given bar.
+ */
+static size_t
+query_lane_index (TrackLane * lane, int bar)
+{
+  Position pos;
+  position_set_to_bar (&pos, bar);
+  IntervalIndex * index = arranger_object_get_index (
+    (ArrangerObject **) lane->regions, lane->num_regions,
+    &lane->arranger_index);
+  const int * hits;
+  return interval_index_query (
+    index, (int64_t) pos.ticks, (int64_t) pos.ticks, &hits);
+}
+
+static void
+test_arranger_index (void)
+{
+  track_create_empty_with_action (TRACK_TYPE_MIDI, NULL);
+  Track *     track = TRACKLIST->tracks[TRACKLIST->num_tracks - 1];
+  TrackLane * lane = track->lanes[0];
+
+  ZRegion * regions[3];
+  for (int i = 0; i < 3; i++)
+    {
+      Position pos, end_pos;
+      position_set_to_bar (&pos, 1 + i * 4);
+      position_set_to_bar (&end_pos, 3 + i * 4);
+      regions[i] =
+        midi_region_new (&pos, &end_pos, track_get_name_hash (track), 0, i);
+      bool success = track_add_region (
+        track, regions[i], NULL, 0, F_GEN_NAME, F_NO_PUBLISH_EVENTS, NULL);
+      g_assert_true (success);
+    }
+
+  g_assert_cmpuint (query_lane_index (lane, 2), ==, 1);
+  g_assert_cmpuint (query_lane_index (lane, 4), ==, 0);
+  g_assert_nonnull (lane->arranger_index);
+
+  /* moving must update the index */
+  arranger_object_move (
+    (ArrangerObject *) regions[0], 2 * TRANSPORT->ticks_per_bar);
+  g_assert_cmpuint (query_lane_index (lane, 2), ==, 0);
+  g_assert_cmpuint (query_lane_index (lane, 4), ==, 1);
+
+  /* removing must update the index */
+  track_remove_region (track, regions[1], F_NO_PUBLISH_EVENTS, F_FREE);
+  g_assert_null (lane->arranger_index);
+  g_assert_cmpuint (query_lane_index (lane, 6), ==, 0);
+  g_assert_cmpuint (query_lane_index (lane, 10), ==, 1);
+}
+
 int
 main (int argc, char * argv[])
 {
@@ -194,6 +250,8 @@ main (int argc, char * argv[])
   g_test_add_func (
     TEST_PREFIX "test_timeline_frames_to_local",
     (GTestFunc) test_timeline_frames_to_local);
+  g_test_add_func (
+    TEST_PREFIX "test arranger index", (GTestFunc) test_arranger_index);
 
   return g_test_run ();
 }
@@ -0,0 +1,158 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include "zrythm-test-config.h"
+
+#include "actions/mixer_selections_action.h"
+#include "dsp/automation_track.h"
+#include "dsp/channel_send.h"
+#include "dsp/graph.h"
+#include "dsp/router.h"
+#include "dsp/recording_manager.h"
+#include "dsp/track_processor.h"
+#include "dsp/transport.h"
+#include "plugins/plugin_manager.h"
+#include "project.h"
+#include "utils/flags.h"
+#include "zrythm.h"
+
+#include <glib.h>
+
+#include "tests/helpers/plugin_manager.h"
+#include "tests/helpers/project.h"
+#include "tests/helpers/zrythm.h"
+
+static void
+assert_setup_cleared (Graph * graph)
+{
+  g_assert_cmpuint (g_hash_table_size (graph->setup_graph_nodes), ==, 0);
+  g_assert_cmpuint (graph->setup_port_connections->len, ==, 0);
+  g_assert_cmpint (
+    g_atomic_int_get (&ROUTER->graph_swap_state), ==, ROUTER_GRAPH_SWAP_NONE);
+}
+
+static void
+test_recalc_while_running (void)
+{
+  test_helper_zrythm_init ();
+
+  track_create_empty_with_action (TRACK_TYPE_AUDIO, NULL);
+  track_create_empty_with_action (TRACK_TYPE_AUDIO_BUS, NULL);
+  Track * track = TRACKLIST->tracks[TRACKLIST->num_tracks - 2];
+  Track * fx_track = TRACKLIST->tracks[TRACKLIST->num_tracks - 1];
+  g_assert_true (fx_track->type == TRACK_TYPE_AUDIO_BUS);
+
+  /* the dummy engine keeps running while the graph is
+   * rebuilt */
+  g_assert_true (g_atomic_int_get (&AUDIO_ENGINE->run));
+
+  Graph *     graph = ROUTER->graph;
+  GraphNode * track_node = graph_find_node_from_track (graph, track, false);
+  g_assert_nonnull (track_node);
+
+  /* the current nodes are kept if nothing changed */
+  router_recalc_graph (ROUTER, F_NOT_SOFT);
+  g_assert_true (
+    graph_find_node_from_track (graph, track, false) == track_node);
+  assert_setup_cleared (graph);
+
+  /* connect a send and check that the engine switched
+   * to the new graph */
+  Port *   fx_in = fx_track->processor->stereo_in->l;
+  int      num_srcs = fx_in->num_srcs;
+  GError * err = NULL;
+  bool     ret = channel_send_connect_stereo (
+    track->channel->sends[0], fx_track->processor->stereo_in, NULL, NULL,
+    false, F_RECALC_GRAPH, F_NO_VALIDATE, &err);
+  g_assert_true (ret);
+  g_assert_true (g_atomic_int_get (&AUDIO_ENGINE->run));
+  g_assert_cmpint (fx_in->num_srcs, ==, num_srcs + 1);
+  assert_setup_cleared (graph);
+
+  track_node = graph_find_node_from_track (graph, track, false);
+  g_assert_nonnull (track_node);
+  g_assert_true (
+    g_hash_table_lookup (graph->graph_nodes, track->channel->sends[0]));
+  g_assert_cmpuint (
+    graph->n_static_schedule, ==, g_hash_table_size (graph->graph_nodes));
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_add_plugin_while_running (void)
+{
+  test_helper_zrythm_init ();
+
+  track_create_empty_with_action (TRACK_TYPE_AUDIO_BUS, NULL);
+  Track *               track = TRACKLIST->tracks[TRACKLIST->num_tracks - 1];
+  AutomationTracklist * atl = track_get_automation_tracklist (track);
+  int                   num_ats = atl->num_ats;
+
+  /* add a plugin while the engine is running */
+  g_assert_true (g_atomic_int_get (&AUDIO_ENGINE->run));
+  PluginSetting * setting = test_plugin_manager_get_plugin_setting (
+    EG_AMP_BUNDLE_URI, EG_AMP_URI, false);
+  g_assert_nonnull (setting);
+  setting = plugin_setting_clone (setting, F_NO_VALIDATE);
+  bool ret = mixer_selections_action_perform_create (
+    PLUGIN_SLOT_INSERT, track_get_name_hash (track), 0, setting, 1, NULL);
+  g_assert_true (ret);
+  plugin_setting_free (setting);
+  g_assert_true (g_atomic_int_get (&AUDIO_ENGINE->run));
+  assert_setup_cleared (ROUTER->graph);
+
+  /* the caches of the new automation tracks are set */
+  Plugin * pl = track->channel->inserts[0];
+  g_assert_nonnull (pl);
+  g_assert_cmpint (atl->num_ats, >, num_ats);
+  g_assert_cmpuint (atl->ats_in_record_mode_size, >=, (size_t) atl->num_ats);
+  for (int i = 0; i < atl->num_ats; i++)
+    {
+      g_assert_nonnull (atl->ats[i]->port);
+    }
+  Port *            gain = plugin_get_port_by_symbol (pl, "gain");
+  AutomationTrack * gain_at =
+    automation_track_find_from_port (gain, track, true);
+  g_assert_nonnull (gain_at);
+  g_assert_true (gain_at->port == gain);
+
+  /* record automation on all the lanes */
+  test_project_stop_dummy_engine ();
+  for (int i = 0; i < atl->num_ats; i++)
+    {
+      automation_track_set_automation_mode (
+        atl->ats[i], AUTOMATION_MODE_RECORD, F_NO_PUBLISH_EVENTS);
+    }
+  g_assert_cmpint (atl->num_ats_in_record_mode, ==, atl->num_ats);
+  gain_at->record_mode = AUTOMATION_RECORD_MODE_LATCH;
+
+  TRANSPORT->recording = true;
+  transport_request_roll (TRANSPORT, true);
+  engine_set_run (AUDIO_ENGINE, false);
+  tracklist_set_caches (TRACKLIST, CACHE_TYPE_PLAYBACK_SNAPSHOTS);
+  engine_set_run (AUDIO_ENGINE, true);
+  engine_process (AUDIO_ENGINE, AUDIO_ENGINE->block_length);
+  recording_manager_process_events (RECORDING_MANAGER);
+
+  g_assert_cmpint (gain_at->num_regions, ==, 1);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char * argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/dsp/router/"
+
+  g_test_add_func (
+    TEST_PREFIX "test recalc while running",
+    (GTestFunc) test_recalc_while_running);
+  g_test_add_func (
+    TEST_PREFIX "test add plugin while running",
+    (GTestFunc) test_add_plugin_while_running);
+
+  return g_test_run ();
+}
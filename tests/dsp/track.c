@@ -3,6 +3,9 @@
 
 #include "zrythm-test-config.h"
 
+#include "actions/arranger_selections.h"
+#include "dsp/engine.h"
+#include "dsp/midi_region.h"
 #include "dsp/track.h"
 #include "project.h"
 #include "utils/flags.h"
@@ -67,6 +70,75 @@ test_get_direct_folder_parent (void)
   test_helper_zrythm_cleanup ();
 }
 
+static ZRegion *
+add_midi_region (Track * track, int start_bar)
+{
+  Position start, end;
+  position_set_to_bar (&start, start_bar);
+  position_set_to_bar (&end, start_bar + 2);
+  ZRegion * r = midi_region_new (
+    &start, &end, track_get_name_hash (track), 0,
+    track->lanes[0]->num_regions);
+  bool success = track_add_region (
+    track, r, NULL, 0, F_GEN_NAME, F_NO_PUBLISH_EVENTS, NULL);
+  g_assert_true (success);
+
+  position_set_to_bar (&start, 1);
+  position_set_to_bar (&end, 2);
+  MidiNote * mn = midi_note_new (&r->id, &start, &end, 60, 90);
+  midi_region_add_midi_note (r, mn, F_NO_PUBLISH_EVENTS);
+
+  return r;
+}
+
+static void
+test_update_playback_snapshot_while_running (void)
+{
+  test_helper_zrythm_init ();
+
+  Track * track = track_create_empty_with_action (TRACK_TYPE_MIDI, NULL);
+  g_assert_nonnull (track);
+  add_midi_region (track, 1);
+  ZRegion * r2 = add_midi_region (track, 5);
+  tracklist_set_caches (TRACKLIST, CACHE_TYPE_PLAYBACK_SNAPSHOTS);
+  engine_free_retired_objects (AUDIO_ENGINE, true);
+
+  const TrackPlaybackSnapshot * snapshot = track_get_playback_snapshot (track);
+  g_assert_nonnull (snapshot);
+  g_assert_cmpint (snapshot->lanes[0]->num_regions, ==, 2);
+  ZRegion * r1_snapshot = snapshot->lanes[0]->regions[0];
+  ZRegion * r2_snapshot = snapshot->lanes[0]->regions[1];
+
+  /* move a note in the second region - this doesn't pause
+   * the engine */
+  arranger_object_select (
+    (ArrangerObject *) r2->midi_notes[0], F_SELECT, F_NO_APPEND,
+    F_NO_PUBLISH_EVENTS);
+  bool success = arranger_selections_action_perform_move_midi (
+    MA_SELECTIONS, 0, 1, F_NOT_ALREADY_MOVED, NULL);
+  g_assert_true (success);
+  g_assert_true (g_atomic_int_get (&AUDIO_ENGINE->run));
+
+  /* only the touched region is cloned again */
+  const TrackPlaybackSnapshot * new_snapshot =
+    track_get_playback_snapshot (track);
+  g_assert_true (new_snapshot != snapshot);
+  g_assert_cmpint (new_snapshot->lanes[0]->num_regions, ==, 2);
+  g_assert_true (new_snapshot->lanes[0]->regions[0] == r1_snapshot);
+  ZRegion * new_r2_snapshot = new_snapshot->lanes[0]->regions[1];
+  g_assert_true (new_r2_snapshot != r2_snapshot);
+  g_assert_cmpuint (new_r2_snapshot->midi_notes[0]->val, ==, 61);
+
+  /* the previous snapshot is freed once the engine is
+   * done with it */
+  g_assert_cmpuint (AUDIO_ENGINE->retired_objects->len, >, 0);
+  engine_wait_n_cycles (AUDIO_ENGINE, 3);
+  engine_free_retired_objects (AUDIO_ENGINE, false);
+  g_assert_cmpuint (AUDIO_ENGINE->retired_objects->len, ==, 0);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char * argv[])
 {
@@ -78,6 +150,9 @@ main (int argc, char * argv[])
   g_test_add_func (
     TEST_PREFIX "test get_direct folder parent",
     (GTestFunc) test_get_direct_folder_parent);
+  g_test_add_func (
+    TEST_PREFIX "test update playback snapshot while running",
+    (GTestFunc) test_update_playback_snapshot_while_running);
 
   return g_test_run ();
 }
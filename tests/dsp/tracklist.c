@@ -5,6 +5,7 @@
 
 #include <math.h>
 
+#include "actions/tracklist_selections.h"
 #include "dsp/automation_region.h"
 #include "dsp/tracklist.h"
 #include "project.h"
@@ -107,6 +108,80 @@ test_handle_drop_empty_midi_file (void)
   test_helper_zrythm_cleanup ();
 }
 
+/**
+ * Asserts that every track can be found by its name
+ * hash.
+ */
+static void
+assert_all_tracks_found_by_name_hash (void)
+{
+  for (int i = 0; i < TRACKLIST->num_tracks; i++)
+    {
+      Track * track = TRACKLIST->tracks[i];
+      g_assert_true (
+        tracklist_find_track_by_name_hash (
+          TRACKLIST, track_get_name_hash (track))
+        == track);
+    }
+}
+
+static void
+test_find_track_by_name_hash (void)
+{
+  test_helper_zrythm_init ();
+
+  for (int i = 0; i < 4; i++)
+    {
+      track_create_empty_with_action (TRACK_TYPE_MIDI, NULL);
+    }
+  assert_all_tracks_found_by_name_hash ();
+
+  /* rename */
+  Track *      track = TRACKLIST->tracks[TRACKLIST->num_tracks - 2];
+  unsigned int old_hash = track_get_name_hash (track);
+  track_set_name_with_action (track, "Renamed Track");
+  g_assert_cmpuint (track_get_name_hash (track), !=, old_hash);
+  g_assert_null (tracklist_find_track_by_name_hash (TRACKLIST, old_hash));
+  assert_all_tracks_found_by_name_hash ();
+
+  undo_manager_undo (UNDO_MANAGER, NULL);
+  g_assert_true (
+    tracklist_find_track_by_name_hash (TRACKLIST, old_hash) == track);
+  assert_all_tracks_found_by_name_hash ();
+
+  /* insert in the middle */
+  int pos = TRACKLIST->num_tracks - 2;
+  track_create_empty_at_idx_with_action (TRACK_TYPE_AUDIO, pos, NULL);
+  Track * inserted = TRACKLIST->tracks[pos];
+  g_assert_true (
+    tracklist_find_track_by_name_hash (
+      TRACKLIST, track_get_name_hash (inserted))
+    == inserted);
+  assert_all_tracks_found_by_name_hash ();
+
+  /* remove */
+  unsigned int inserted_hash = track_get_name_hash (inserted);
+  track_select (inserted, F_SELECT, F_EXCLUSIVE, F_NO_PUBLISH_EVENTS);
+  tracklist_selections_action_perform_delete (
+    TRACKLIST_SELECTIONS, PORT_CONNECTIONS_MGR, NULL);
+  g_assert_null (
+    tracklist_find_track_by_name_hash (TRACKLIST, inserted_hash));
+  assert_all_tracks_found_by_name_hash ();
+
+  undo_manager_undo (UNDO_MANAGER, NULL);
+  g_assert_nonnull (
+    tracklist_find_track_by_name_hash (TRACKLIST, inserted_hash));
+  assert_all_tracks_found_by_name_hash ();
+
+  /* after reloading */
+  test_project_save_and_reload ();
+  g_assert_nonnull (
+    tracklist_find_track_by_name_hash (TRACKLIST, inserted_hash));
+  assert_all_tracks_found_by_name_hash ();
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char * argv[])
 {
@@ -122,6 +197,9 @@ main (int argc, char * argv[])
   g_test_add_func (
     TEST_PREFIX "test swap with automation regions",
     (GTestFunc) test_swap_with_automation_regions);
+  g_test_add_func (
+    TEST_PREFIX "test find track by name hash",
+    (GTestFunc) test_find_track_by_name_hash);
 
   return g_test_run ();
 }
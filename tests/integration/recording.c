@@ -917,8 +917,9 @@ test_long_audio_recording (void)
             r_clip->ch_frames[1][i], clip->ch_frames[1][i], 0.000001f);
         }
 
-      /* load the region file and check that
-       * frames are correct */
+      /* wait for the disk writer, then load the region
+       * file and check that frames are correct */
+      g_assert_true (recording_manager_flush_take (RECORDING_MANAGER, r_clip));
       AudioClip * new_clip = audio_clip_new_from_file (
         audio_clip_get_path_in_pool (r_clip, F_NOT_BACKUP), NULL);
       if (r_clip->num_frames < new_clip->num_frames)
@@ -0,0 +1,192 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include "zrythm-test-config.h"
+
+#include "plugins/cached_plugin_descriptors.h"
+#include "utils/flags.h"
+#include "utils/io.h"
+
+#include <glib/gstdio.h>
+
+#include "tests/helpers/zrythm.h"
+
+/**
+ * Creates a fake plugin file and returns its traversed
+ * path.
+ */
+static char *
+create_plugin_file (const char * dir, const char * name)
+{
+  char * path = g_build_filename (dir, name, NULL);
+  g_assert_true (g_file_set_contents (path, "plugin", -1, NULL));
+  char * traversed_path = io_traverse_path (path);
+  g_free (path);
+  return traversed_path;
+}
+
+/**
+ * Frees the NULL-terminated array of descriptors
+ * returned by cached_plugin_descriptors_get().
+ */
+static void
+free_descriptors (PluginDescriptor ** descriptors)
+{
+  for (int i = 0; descriptors[i]; i++)
+    {
+      plugin_descriptor_free (descriptors[i]);
+    }
+  free (descriptors);
+}
+
+static void
+test_get_and_blacklist (void)
+{
+  test_helper_zrythm_init ();
+
+  char * tmp_dir = g_dir_make_tmp ("zrythm_cached_descr_XXXXXX", NULL);
+  g_assert_nonnull (tmp_dir);
+  char * plugin_path = create_plugin_file (tmp_dir, "plugin.so");
+  char * bad_plugin_path = create_plugin_file (tmp_dir, "bad_plugin.so");
+
+  CachedPluginDescriptors * cache = cached_plugin_descriptors_new ();
+  guint num_descriptors_at_start = cache->descriptors->len;
+
+  PluginDescriptor * descr = plugin_descriptor_new ();
+  descr->protocol = Z_PLUGIN_PROTOCOL_VST;
+  descr->path = g_strdup (plugin_path);
+  descr->name = g_strdup ("Plugin");
+  cached_plugin_descriptors_add (cache, descr, F_NO_SERIALIZE);
+  g_free (descr->name);
+  descr->name = g_strdup ("Plugin 2");
+  descr->unique_id = 2;
+  cached_plugin_descriptors_add (cache, descr, F_NO_SERIALIZE);
+  plugin_descriptor_free (descr);
+  cached_plugin_descriptors_blacklist (cache, bad_plugin_path, F_NO_SERIALIZE);
+
+  PluginDescriptor ** descriptors =
+    cached_plugin_descriptors_get (cache, plugin_path);
+  g_assert_nonnull (descriptors);
+  g_assert_nonnull (descriptors[0]);
+  g_assert_nonnull (descriptors[1]);
+  g_assert_null (descriptors[2]);
+  free_descriptors (descriptors);
+  g_assert_null (cached_plugin_descriptors_get (cache, bad_plugin_path));
+  g_assert_true (
+    cached_plugin_descriptors_is_blacklisted (cache, bad_plugin_path));
+  g_assert_false (
+    cached_plugin_descriptors_is_blacklisted (cache, plugin_path));
+
+  /* changed plugins are no longer found in the cache */
+  g_assert_true (
+    g_file_set_contents (plugin_path, "updated plugin", -1, NULL));
+  g_assert_true (
+    g_file_set_contents (bad_plugin_path, "fixed plugin", -1, NULL));
+  g_assert_null (cached_plugin_descriptors_get (cache, plugin_path));
+  g_assert_cmpuint (cache->descriptors->len, ==, num_descriptors_at_start);
+  g_assert_false (
+    cached_plugin_descriptors_is_blacklisted (cache, bad_plugin_path));
+
+  cached_plugin_descriptors_free (cache);
+
+  g_unlink (plugin_path);
+  g_unlink (bad_plugin_path);
+  g_rmdir (tmp_dir);
+  g_free (plugin_path);
+  g_free (bad_plugin_path);
+  g_free (tmp_dir);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_serialize_and_load (void)
+{
+  test_helper_zrythm_init ();
+
+  char * tmp_dir = g_dir_make_tmp ("zrythm_cached_descr_XXXXXX", NULL);
+  g_assert_nonnull (tmp_dir);
+  char * plugin_path = create_plugin_file (tmp_dir, "plugin.so");
+  char * bad_plugin_path = create_plugin_file (tmp_dir, "bad_plugin.so");
+
+  CachedPluginDescriptors * cache = cached_plugin_descriptors_new ();
+  PluginDescriptor *        descr = plugin_descriptor_new ();
+  descr->protocol = Z_PLUGIN_PROTOCOL_VST;
+  descr->path = g_strdup (plugin_path);
+  descr->name = g_strdup ("Plugin");
+  descr->unique_id = 42;
+  descr->num_audio_outs = 2;
+  cached_plugin_descriptors_add (cache, descr, F_NO_SERIALIZE);
+  cached_plugin_descriptors_blacklist (cache, bad_plugin_path, F_NO_SERIALIZE);
+  guint num_descriptors = cache->descriptors->len;
+  cached_plugin_descriptors_serialize_to_file (cache);
+  g_assert_false (cache->dirty);
+  cached_plugin_descriptors_free (cache);
+
+  /* the cached descriptors are not created when
+   * getting the descriptors of a path (like when
+   * scanning) */
+  cache = cached_plugin_descriptors_new ();
+  g_assert_nonnull (cache->mapped_file);
+  g_assert_false (cache->dirty);
+  g_assert_cmpuint (cache->descriptors->len, ==, num_descriptors);
+  g_assert_true (
+    cached_plugin_descriptors_is_blacklisted (cache, bad_plugin_path));
+
+  PluginDescriptor ** descriptors =
+    cached_plugin_descriptors_get (cache, plugin_path);
+  g_assert_nonnull (descriptors);
+  g_assert_nonnull (descriptors[0]);
+  g_assert_null (descriptors[1]);
+  g_assert_true (plugin_descriptor_is_same_plugin (descriptors[0], descr));
+  g_assert_cmpstr (descriptors[0]->name, ==, "Plugin");
+  g_assert_cmpint (descriptors[0]->num_audio_outs, ==, 2);
+  free_descriptors (descriptors);
+  for (guint i = 0; i < cache->descriptors->len; i++)
+    {
+      CachedPluginDescriptor * entry =
+        g_ptr_array_index (cache->descriptors, i);
+      g_assert_nonnull (entry->record);
+      g_assert_null (entry->descr);
+    }
+
+  g_assert_nonnull (
+    cached_plugin_descriptors_find (cache, descr, true, false));
+  plugin_descriptor_free (descr);
+
+  /* unchanged caches are not written again */
+  cached_plugin_descriptors_serialize_to_file (cache);
+  g_assert_nonnull (cache->mapped_file);
+
+  cached_plugin_descriptors_clear (cache);
+  g_assert_cmpuint (cache->descriptors->len, ==, 0);
+  g_assert_null (cache->mapped_file);
+  g_assert_true (
+    cached_plugin_descriptors_is_blacklisted (cache, bad_plugin_path));
+  cached_plugin_descriptors_free (cache);
+
+  g_unlink (plugin_path);
+  g_unlink (bad_plugin_path);
+  g_rmdir (tmp_dir);
+  g_free (plugin_path);
+  g_free (bad_plugin_path);
+  g_free (tmp_dir);
+
+  test_helper_zrythm_cleanup ();
+}
+
+int
+main (int argc, char * argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/plugins/cached_plugin_descriptors/"
+
+  g_test_add_func (
+    TEST_PREFIX "test get and blacklist", (GTestFunc) test_get_and_blacklist);
+  g_test_add_func (
+    TEST_PREFIX "test serialize and load",
+    (GTestFunc) test_serialize_and_load);
+
+  return g_test_run ();
+}
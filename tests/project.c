@@ -5,6 +5,7 @@
 
 #include "dsp/tempo_track.h"
 #include "dsp/track.h"
+#include "io/serialization/project.h"
 #include "project.h"
 #include "utils/dsp.h"
 #include "utils/flags.h"
@@ -372,6 +373,120 @@ test_exposed_ports_after_load (void)
 #endif // HAVE_PIPEWIRE
 }
 
+static void
+test_save_async_in_chunks (void)
+{
+  test_helper_zrythm_init ();
+
+  Position p1, p2;
+  test_project_rebootstrap_timeline (&p1, &p2);
+
+  /* the file written in chunks while serializing must be
+   * the same as the whole serialized project */
+  bool success =
+    project_save (PROJECT, PROJECT->dir, F_NOT_BACKUP, 0, F_ASYNC, NULL);
+  g_assert_true (success);
+  GError * err = NULL;
+  char *   text = project_get_existing_uncompressed_text (PROJECT, false, &err);
+  g_assert_nonnull (text);
+  char * json = project_serialize_to_json_str (PROJECT, &err);
+  g_assert_nonnull (json);
+  g_assert_cmpstr (text, ==, json);
+  g_free (text);
+  g_free (json);
+
+  /* and load */
+  test_project_save_and_reload ();
+  test_project_check_vs_original_state (&p1, &p2, 0);
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_load_many_tracks (void)
+{
+  test_helper_zrythm_init ();
+
+  /* tracks and actions are parsed in parallel when
+   * loading but must keep their order */
+  int num_tracks = TRACKLIST->num_tracks;
+  for (int i = 0; i < 40; i++)
+    {
+      track_create_empty_with_action (
+        i % 2 ? TRACK_TYPE_MIDI : TRACK_TYPE_AUDIO, NULL);
+      char * name = g_strdup_printf ("track %d", i);
+      track_set_name_with_action (TRACKLIST->tracks[num_tracks + i], name);
+      g_free (name);
+    }
+  int num_undo = undo_stack_size (UNDO_MANAGER->undo_stack);
+
+  test_project_save_and_reload ();
+
+  g_assert_cmpint (TRACKLIST->num_tracks, ==, num_tracks + 40);
+  for (int i = 0; i < 40; i++)
+    {
+      Track * track = TRACKLIST->tracks[num_tracks + i];
+      char *  name = g_strdup_printf ("track %d", i);
+      g_assert_cmpstr (track->name, ==, name);
+      g_assert_true (
+        track->type == (i % 2 ? TRACK_TYPE_MIDI : TRACK_TYPE_AUDIO));
+      g_free (name);
+    }
+  g_assert_cmpint (undo_stack_size (UNDO_MANAGER->undo_stack), ==, num_undo);
+
+  /* the loaded actions still work */
+  int ret = undo_manager_undo (UNDO_MANAGER, NULL);
+  g_assert_cmpint (ret, ==, 0);
+  g_assert_cmpstr (TRACKLIST->tracks[num_tracks + 39]->name, !=, "track 39");
+
+  test_helper_zrythm_cleanup ();
+}
+
+static void
+test_recover_from_autosave_journal (void)
+{
+  test_helper_zrythm_init ();
+
+  /* saving starts a new journal */
+  char * prj_file = test_project_save ();
+  g_assert_nonnull (prj_file);
+  g_assert_nonnull (PROJECT->autosave_journal);
+  int num_tracks = TRACKLIST->num_tracks;
+  int num_undo = undo_stack_size (UNDO_MANAGER->undo_stack);
+
+  track_create_empty_with_action (TRACK_TYPE_AUDIO_BUS, NULL);
+  track_create_empty_with_action (TRACK_TYPE_MIDI, NULL);
+  int ret = undo_manager_undo (UNDO_MANAGER, NULL);
+  g_assert_cmpint (ret, ==, 0);
+  g_assert_cmpint (PROJECT->autosave_journal->num_records, ==, 3);
+  GError * err = NULL;
+  bool     success = autosave_journal_flush (PROJECT->autosave_journal, &err);
+  g_assert_true (success);
+
+  /* simulate a crash by leaving the journal file behind
+   * and reload */
+  object_free_w_func_and_null (autosave_journal_free, PROJECT->autosave_journal);
+  test_project_reload (prj_file);
+  g_free (prj_file);
+
+  g_assert_cmpint (TRACKLIST->num_tracks, ==, num_tracks + 1);
+  g_assert_true (TRACKLIST->tracks[num_tracks]->type == TRACK_TYPE_AUDIO_BUS);
+  g_assert_cmpint (undo_stack_size (UNDO_MANAGER->undo_stack), ==, num_undo + 1);
+  g_assert_cmpint (undo_stack_size (UNDO_MANAGER->redo_stack), ==, 1);
+
+  /* the replayed actions are kept in the new journal */
+  g_assert_nonnull (PROJECT->autosave_journal);
+  g_assert_cmpint (PROJECT->autosave_journal->num_records, ==, 3);
+
+  /* the undone action can still be redone */
+  ret = undo_manager_redo (UNDO_MANAGER, NULL);
+  g_assert_cmpint (ret, ==, 0);
+  g_assert_cmpint (TRACKLIST->num_tracks, ==, num_tracks + 2);
+  g_assert_true (TRACKLIST->tracks[num_tracks + 1]->type == TRACK_TYPE_MIDI);
+
+  test_helper_zrythm_cleanup ();
+}
+
 int
 main (int argc, char * argv[])
 {
@@ -398,6 +513,14 @@ main (int argc, char * argv[])
   g_test_add_func (
     TEST_PREFIX "test save load with data",
     (GTestFunc) test_save_load_with_data);
+  g_test_add_func (
+    TEST_PREFIX "test save async in chunks",
+    (GTestFunc) test_save_async_in_chunks);
+  g_test_add_func (
+    TEST_PREFIX "test load many tracks", (GTestFunc) test_load_many_tracks);
+  g_test_add_func (
+    TEST_PREFIX "test recover from autosave journal",
+    (GTestFunc) test_recover_from_autosave_journal);
   g_test_add_func (
     TEST_PREFIX "test save as load w pool",
     (GTestFunc) test_save_as_load_w_pool);
@@ -6,6 +6,7 @@
 #include "utils/compression.h"
 
 #include <glib.h>
+#include <glib/gstdio.h>
 
 static void
 test_decompression (void)
@@ -20,6 +21,70 @@ test_decompression (void)
   g_free (res_str);
 }
 
+static void
+test_file_writer (void)
+{
+  char * tmp_dir = g_dir_make_tmp ("zrythm_compression_XXXXXX", NULL);
+  char * path = g_build_filename (tmp_dir, "file.zst", NULL);
+
+  /* write many small chunks */
+  GError *                err = NULL;
+  GString *               expected = g_string_new (NULL);
+  CompressionFileWriter * writer = compression_file_writer_new (path, &err);
+  g_assert_nonnull (writer);
+  for (int i = 0; i < 10000; i++)
+    {
+      char * chunk = g_strdup_printf ("{\"idx\":%d},", i);
+      g_string_append (expected, chunk);
+      bool success =
+        compression_file_writer_write (writer, chunk, strlen (chunk), &err);
+      g_assert_true (success);
+      g_free (chunk);
+    }
+  g_assert_false (g_file_test (path, G_FILE_TEST_EXISTS));
+  bool success = compression_file_writer_close (writer, false, &err);
+  g_assert_true (success);
+  g_assert_no_error (err);
+
+  char * contents;
+  gsize  contents_size;
+  success = g_file_get_contents (path, &contents, &contents_size, &err);
+  g_assert_true (success);
+  size_t size;
+  char * res =
+    compression_decompress_stream (contents, contents_size, &size, &err);
+  g_assert_nonnull (res);
+  g_assert_cmpuint (size, ==, expected->len);
+  g_assert_cmpmem (res, size, expected->str, expected->len);
+  free (res);
+
+  /* a truncated file is rejected */
+  res =
+    compression_decompress_stream (contents, contents_size / 2, &size, &err);
+  g_assert_null (res);
+  g_assert_nonnull (err);
+  g_clear_error (&err);
+  g_free (contents);
+
+  /* discarding keeps the previous file */
+  writer = compression_file_writer_new (path, &err);
+  compression_file_writer_write (writer, "abc", 3, &err);
+  success = compression_file_writer_close (writer, true, &err);
+  g_assert_false (success);
+  success = g_file_get_contents (path, &contents, &contents_size, &err);
+  g_assert_true (success);
+  res = compression_decompress_stream (contents, contents_size, &size, &err);
+  g_assert_cmpuint (size, ==, expected->len);
+  free (res);
+  g_free (contents);
+
+  g_string_free (expected, true);
+  g_unlink (path);
+  g_rmdir (tmp_dir);
+  g_free (path);
+  g_free (tmp_dir);
+}
+
 int
 main (int argc, char * argv[])
 {
@@ -29,6 +94,8 @@ main (int argc, char * argv[])
 
   g_test_add_func (
     TEST_PREFIX "test decompression", (GTestFunc) test_decompression);
+  g_test_add_func (
+    TEST_PREFIX "test file writer", (GTestFunc) test_file_writer);
 
   return g_test_run ();
 }
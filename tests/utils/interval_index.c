@@ -0,0 +1,165 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include "zrythm-test-config.h"
+
+#include "utils/interval_index.h"
+
+#include <glib.h>
+
+#define NUM_INTERVALS 1000
+#define NUM_QUERIES 1000
+#define MAX_EXHAUSTIVE_INTERVALS 64
+
+static void
+test_query (void)
+{
+  IntervalIndex * index = interval_index_new (2);
+  interval_index_add (index, 10, 19, 0);
+  interval_index_add (index, 0, 9, 1);
+  interval_index_add (index, 5, 14, 2);
+  interval_index_build (index);
+
+  const int * hits;
+  size_t      num_hits = interval_index_query (index, 9, 10, &hits);
+  g_assert_cmpuint (num_hits, ==, 3);
+  g_assert_cmpint (hits[0], ==, 0);
+  g_assert_cmpint (hits[1], ==, 1);
+  g_assert_cmpint (hits[2], ==, 2);
+
+  /* end points are inclusive */
+  num_hits = interval_index_query (index, 19, 30, &hits);
+  g_assert_cmpuint (num_hits, ==, 1);
+  g_assert_cmpint (hits[0], ==, 0);
+  num_hits = interval_index_query (index, 20, 30, &hits);
+  g_assert_cmpuint (num_hits, ==, 0);
+  num_hits = interval_index_query (index, -5, 0, &hits);
+  g_assert_cmpuint (num_hits, ==, 1);
+  g_assert_cmpint (hits[0], ==, 1);
+
+  interval_index_free (index);
+
+  /* empty index */
+  index = interval_index_new (0);
+  interval_index_build (index);
+  num_hits = interval_index_query (index, 0, 100, &hits);
+  g_assert_cmpuint (num_hits, ==, 0);
+  interval_index_free (index);
+}
+
+static void
+test_query_random (void)
+{
+  GRand * rand = g_rand_new_with_seed (42);
+
+  int64_t starts[NUM_INTERVALS];
+  int64_t ends[NUM_INTERVALS];
+
+  IntervalIndex * index = interval_index_new (NUM_INTERVALS);
+  for (int i = 0; i < NUM_INTERVALS; i++)
+    {
+      starts[i] = g_rand_int_range (rand, 0, 100000);
+      ends[i] = starts[i] + g_rand_int_range (rand, 0, 2000);
+      interval_index_add (index, starts[i], ends[i], i);
+    }
+  interval_index_build (index);
+
+  for (int i = 0; i < NUM_QUERIES; i++)
+    {
+      int64_t start = g_rand_int_range (rand, 0, 100000);
+      /* also query wide ranges with many hits */
+      int64_t end = start + g_rand_int_range (rand, 0, i % 2 ? 500 : 20000);
+
+      const int * hits;
+      size_t      num_hits = interval_index_query (index, start, end, &hits);
+
+      /* compare with brute force */
+      size_t cur_hit = 0;
+      for (int j = 0; j < NUM_INTERVALS; j++)
+        {
+          if (starts[j] <= end && ends[j] >= start)
+            {
+              g_assert_cmpuint (cur_hit, <, num_hits);
+              g_assert_cmpint (hits[cur_hit], ==, j);
+              cur_hit++;
+            }
+        }
+      g_assert_cmpuint (cur_hit, ==, num_hits);
+    }
+
+  interval_index_free (index);
+  g_rand_free (rand);
+}
+
+/**
+ * Checks every possible query against a brute-force
+ * search for indices of every size up to 64 items, so
+ * that all tree shapes (including incomplete right
+ * subtrees) are covered.
+ */
+static void
+test_query_all_sizes (void)
+{
+  GRand * rand = g_rand_new_with_seed (7);
+
+  for (int n = 0; n <= MAX_EXHAUSTIVE_INTERVALS; n++)
+    {
+      const int span = 2 * n + 8;
+      int64_t   starts[MAX_EXHAUSTIVE_INTERVALS];
+      int64_t   ends[MAX_EXHAUSTIVE_INTERVALS];
+
+      IntervalIndex * index = interval_index_new ((size_t) n);
+      for (int i = 0; i < n; i++)
+        {
+          starts[i] = g_rand_int_range (rand, 0, span);
+          /* mix short intervals with long ones that
+           * overlap many others */
+          ends[i] =
+            starts[i] + g_rand_int_range (rand, 0, i % 5 == 0 ? span : 4);
+          interval_index_add (index, starts[i], ends[i], i);
+        }
+      interval_index_build (index);
+
+      for (int64_t start = -1; start <= 2 * span; start++)
+        {
+          for (int64_t end = start; end <= 2 * span; end++)
+            {
+              const int * hits;
+              size_t      num_hits =
+                interval_index_query (index, start, end, &hits);
+
+              size_t cur_hit = 0;
+              for (int j = 0; j < n; j++)
+                {
+                  if (starts[j] <= end && ends[j] >= start)
+                    {
+                      g_assert_cmpuint (cur_hit, <, num_hits);
+                      g_assert_cmpint (hits[cur_hit], ==, j);
+                      cur_hit++;
+                    }
+                }
+              g_assert_cmpuint (cur_hit, ==, num_hits);
+            }
+        }
+
+      interval_index_free (index);
+    }
+
+  g_rand_free (rand);
+}
+
+int
+main (int argc, char * argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/utils/interval_index/"
+
+  g_test_add_func (TEST_PREFIX "test query", (GTestFunc) test_query);
+  g_test_add_func (
+    TEST_PREFIX "test query random", (GTestFunc) test_query_random);
+  g_test_add_func (
+    TEST_PREFIX "test query all sizes", (GTestFunc) test_query_all_sizes);
+
+  return g_test_run ();
+}
@@ -0,0 +1,129 @@
+// SPDX-FileCopyrightText: © 2024 Alexandros Theodotou <alex@zrythm.org>
+// SPDX-License-Identifier: LicenseRef-ZrythmLicense
+
+#include "zrythm-test-config.h"
+
+#include "utils/objects.h"
+#include "utils/ws_deque.h"
+
+#include <glib.h>
+
+#define NUM_ELEMENTS 100000
+#define NUM_THIEVES 4
+
+typedef struct StealData
+{
+  WorkStealingDeque * deque;
+  gint *              taken;
+  volatile gint *     done;
+} StealData;
+
+static void
+test_push_pop (void)
+{
+  WorkStealingDeque * deque = ws_deque_new ();
+  ws_deque_reserve (deque, 4);
+
+  int    a = 1, b = 2, c = 3;
+  void * data = NULL;
+  g_assert_true (ws_deque_push (deque, &a));
+  g_assert_true (ws_deque_push (deque, &b));
+  g_assert_true (ws_deque_push (deque, &c));
+  g_assert_cmpuint (ws_deque_size (deque), ==, 3);
+
+  /* owner pops from the bottom (LIFO) */
+  g_assert_true (ws_deque_pop (deque, &data));
+  g_assert_true (data == &c);
+
+  /* thieves steal from the top (FIFO) */
+  g_assert_true (ws_deque_steal (deque, &data));
+  g_assert_true (data == &a);
+
+  g_assert_true (ws_deque_pop (deque, &data));
+  g_assert_true (data == &b);
+  g_assert_false (ws_deque_pop (deque, &data));
+  g_assert_false (ws_deque_steal (deque, &data));
+
+  /* test full */
+  for (int i = 0; i < 4; i++)
+    {
+      g_assert_true (ws_deque_push (deque, &a));
+    }
+  g_assert_false (ws_deque_push (deque, &a));
+
+  ws_deque_free (deque);
+}
+
+static gpointer
+steal_thread (gpointer user_data)
+{
+  StealData * data = (StealData *) user_data;
+  void *      elem;
+  while (!g_atomic_int_get (data->done) || ws_deque_size (data->deque) > 0)
+    {
+      if (ws_deque_steal (data->deque, &elem))
+        {
+          g_atomic_int_inc (&data->taken[GPOINTER_TO_INT (elem)]);
+        }
+    }
+  return NULL;
+}
+
+static void
+test_concurrent_steal (void)
+{
+  WorkStealingDeque * deque = ws_deque_new ();
+  ws_deque_reserve (deque, NUM_ELEMENTS);
+  gint *        taken = object_new_n (NUM_ELEMENTS, gint);
+  volatile gint done = 0;
+  StealData     data = { .deque = deque, .taken = taken, .done = &done };
+
+  GThread * threads[NUM_THIEVES];
+  for (int i = 0; i < NUM_THIEVES; i++)
+    {
+      threads[i] = g_thread_new ("thief", steal_thread, &data);
+    }
+
+  void * elem;
+  for (int i = 0; i < NUM_ELEMENTS; i++)
+    {
+      g_assert_true (ws_deque_push (deque, GINT_TO_POINTER (i)));
+      if (i % 3 == 0 && ws_deque_pop (deque, &elem))
+        {
+          g_atomic_int_inc (&taken[GPOINTER_TO_INT (elem)]);
+        }
+    }
+  while (ws_deque_pop (deque, &elem))
+    {
+      g_atomic_int_inc (&taken[GPOINTER_TO_INT (elem)]);
+    }
+  g_atomic_int_set (&done, 1);
+
+  for (int i = 0; i < NUM_THIEVES; i++)
+    {
+      g_thread_join (threads[i]);
+    }
+
+  /* every element must be taken exactly once */
+  for (int i = 0; i < NUM_ELEMENTS; i++)
+    {
+      g_assert_cmpint (taken[i], ==, 1);
+    }
+
+  free (taken);
+  ws_deque_free (deque);
+}
+
+int
+main (int argc, char * argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+#define TEST_PREFIX "/utils/ws_deque/"
+
+  g_test_add_func (TEST_PREFIX "test push pop", (GTestFunc) test_push_pop);
+  g_test_add_func (
+    TEST_PREFIX "test concurrent steal", (GTestFunc) test_concurrent_steal);
+
+  return g_test_run ();
+}